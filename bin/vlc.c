@@ -182,6 +182,8 @@ int main(int argc, const char *argv[])
     sigaddset (&set, SIGHUP);
     sigaddset (&set, SIGQUIT);
     sigaddset (&set, SIGTERM);
+    /* SIGUSR1 dumps the flight recorder */
+    sigaddset (&set, SIGUSR1);
 
     /* SIGPIPE can happen and would crash the process. On modern systems,
      * the MSG_NOSIGNAL flag protects socket write operations against SIGPIPE.
@@ -258,7 +260,8 @@ int main(int argc, const char *argv[])
     sigdelset (&set, SIGPIPE);
 
     int signum;
-    sigwait (&set, &signum);
+    while (sigwait (&set, &signum) == 0 && signum == SIGUSR1)
+        libvlc_trace_dump (vlc, NULL);
 
     /* Restore default signal behaviour after 3 seconds */
     sigemptyset (&set);
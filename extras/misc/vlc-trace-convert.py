@@ -0,0 +1,265 @@
+#!/usr/bin/env python3
+#####################################################################
+# Copyright (C) 2025 VLC authors and VideoLAN
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation; either version 2.1 of the License, or
+# (at your option) any later version.
+#####################################################################
+#
+# Converts the output of the binary tracer (--tracer=binary_tracer) to
+# the layout of the JSON tracer, one object per line, or to the Chrome
+# trace event format, that can be loaded in chrome://tracing or Perfetto.
+#
+#   vlc-trace-convert.py vlc-trace.bin > vlc-log.json
+#   vlc-trace-convert.py --chrome vlc-trace.bin > trace.json
+#
+# See modules/logger/binary.c for the description of the format.
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = b"VLCBTRC"
+VERSION = 1
+
+RECORD_TRACE = 0x01
+RECORD_LOST = 0x02
+
+TRACER_INT = 0
+TRACER_DOUBLE = 1
+TRACER_STRING = 2
+TRACER_UINT = 3
+
+
+class FormatError(Exception):
+    pass
+
+
+class Reader:
+    def __init__(self, data, pos=0, end=None):
+        self.data = data
+        self.pos = pos
+        self.end = len(data) if end is None else end
+
+    def at_end(self):
+        return self.pos >= self.end
+
+    def byte(self):
+        if self.pos >= self.end:
+            raise FormatError("truncated record")
+        value = self.data[self.pos]
+        self.pos += 1
+        return value
+
+    def bytes(self, length):
+        if self.pos + length > self.end:
+            raise FormatError("truncated record")
+        value = self.data[self.pos:self.pos + length]
+        self.pos += length
+        return value
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            byte = self.byte()
+            value |= (byte & 0x7F) << shift
+            if byte < 0x80:
+                return value
+            shift += 7
+
+    def svarint(self):
+        value = self.varint()
+        return (value >> 1) ^ -(value & 1)
+
+    def double(self):
+        return struct.unpack("<d", self.bytes(8))[0]
+
+
+class Chunk:
+    """Decoding state of the records written by one chunk"""
+
+    def __init__(self):
+        self.strings = {}
+        self.timestamp = 0
+
+    def string(self, reader):
+        ref = reader.varint()
+        if ref == 0:
+            return reader.bytes(reader.varint())
+        if ref & 1:
+            value = reader.bytes(reader.varint())
+            self.strings[ref >> 1] = value
+            return value
+        try:
+            return self.strings[ref >> 1]
+        except KeyError:
+            raise FormatError("unknown string %d" % (ref >> 1))
+
+
+def read_traces(data):
+    """Yields (timestamp in ns, thread, [(key, type, value)]) tuples"""
+    if data[:len(MAGIC)] != MAGIC:
+        raise FormatError("not a VLC binary trace")
+    if data[len(MAGIC)] != VERSION:
+        raise FormatError("unsupported version %d" % data[len(MAGIC)])
+
+    chunks = {}
+    reader = Reader(data, len(MAGIC) + 1)
+    while not reader.at_end():
+        chunk_id = reader.varint()
+        thread = reader.varint()
+        size = reader.varint()
+        block = Reader(data, reader.pos, reader.pos + size)
+        if block.end > len(data):
+            # the tracer was interrupted while writing
+            print("warning: truncated trace file", file=sys.stderr)
+            break
+        reader.pos = block.end
+
+        chunk = chunks.setdefault(chunk_id, Chunk())
+        while not block.at_end():
+            kind = block.byte()
+            if kind == RECORD_LOST:
+                print("warning: %d traces lost by thread %d" %
+                      (block.varint(), thread), file=sys.stderr)
+                continue
+            if kind != RECORD_TRACE:
+                raise FormatError("unknown record %d" % kind)
+
+            chunk.timestamp += block.svarint()
+            entries = []
+            for _ in range(block.varint()):
+                type = block.byte()
+                key = chunk.string(block)
+                if type == TRACER_INT:
+                    value = block.svarint()
+                elif type == TRACER_UINT:
+                    value = block.varint()
+                elif type == TRACER_DOUBLE:
+                    value = block.double()
+                elif type == TRACER_STRING:
+                    value = chunk.string(block)
+                else:
+                    raise FormatError("unknown value type %d" % type)
+                entries.append((key, type, value))
+            yield chunk.timestamp, thread, entries
+
+
+def json_string(value):
+    """Escapes like JsonPrintString() in modules/logger/json.c"""
+    try:
+        text = value.decode("utf-8")
+    except UnicodeDecodeError:
+        return '"invalid string"'
+
+    out = ['"']
+    for c in text:
+        code = ord(c)
+        if c == '/':
+            out.append('\\/')
+        elif c == '\b':
+            out.append('\\b')
+        elif c == '\f':
+            out.append('\\f')
+        elif c == '\n':
+            out.append('\\n')
+        elif c == '\r':
+            out.append('\\r')
+        elif c == '\t':
+            out.append('\\t')
+        elif c in '\\"':
+            out.append('\\' + c)
+        elif code <= 0x1F or code == 0x7F:
+            out.append('\\u%04x' % code)
+        elif code < 0x80:
+            out.append(c)
+        elif code < 0x10000:
+            out.append('\\u%04x' % code)
+        else:
+            code -= 0x10000
+            out.append('\\u%04x\\u%04x' % (0xD800 | (code >> 10),
+                                           0xDC00 | (code & 0x3FF)))
+    out.append('"')
+    return ''.join(out)
+
+
+def json_value(type, value):
+    if type == TRACER_STRING:
+        return json_string(value)
+    if type == TRACER_DOUBLE:
+        return '"%e"' % value
+    return '"%d"' % value
+
+
+def write_json(traces, out):
+    for timestamp, _, entries in traces:
+        body = ','.join('%s: %s' % (json_string(key), json_value(type, value))
+                        for key, type, value in entries)
+        out.write('{"Timestamp": "%d","Body": {%s}}\n' % (timestamp, body))
+
+
+def write_chrome(traces, out):
+    """Maps traces like the chrome_tracer module"""
+    events = [{"name": "process_name", "ph": "M", "pid": 1,
+               "args": {"name": "VLC"}}]
+    for timestamp, thread, entries in traces:
+        args = {}
+        for key, type, value in entries:
+            if type == TRACER_STRING:
+                value = value.decode("utf-8", "replace")
+            args[key.decode("utf-8", "replace")] = value
+        event = {"ts": timestamp / 1000, "pid": 1, "tid": thread}
+        if "type" in args:
+            event["cat"] = args["type"]
+        if "span" in args and "phase" in args:
+            event["name"] = args["span"]
+            event["ph"] = "B" if args["phase"] == "begin" else "E"
+        elif "event" in args:
+            event["name"] = args["event"]
+            event["ph"] = "i"
+            event["s"] = "t"
+        else:
+            event["name"] = args.get("type", "trace")
+            event["ph"] = "C"
+            if "id" in args:
+                event["id"] = args["id"]
+            args = {k: v for k, v in args.items() if not isinstance(v, str)}
+        if event["ph"] != "C":
+            for key in ("type", "span", "phase", "event"):
+                args.pop(key, None)
+        event["args"] = args
+        events.append(event)
+    json.dump(events, out)
+    out.write('\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Convert VLC binary traces to JSON")
+    parser.add_argument("input", help="binary trace file")
+    parser.add_argument("--chrome", action="store_true",
+                        help="output the Chrome trace event format")
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+
+    try:
+        # Blocks of different threads are interleaved, the JSON tracer
+        # output is in trace order.
+        traces = sorted(read_traces(data), key=lambda trace: trace[0])
+    except FormatError as e:
+        sys.exit("%s: %s" % (args.input, e))
+
+    if args.chrome:
+        write_chrome(traces, sys.stdout)
+    else:
+        write_json(traces, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
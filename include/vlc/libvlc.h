@@ -457,6 +457,20 @@ LIBVLC_API void libvlc_log_set( libvlc_instance_t *p_instance,
  */
 LIBVLC_API void libvlc_log_set_file( libvlc_instance_t *p_instance, FILE *stream );
 
+/**
+ * Writes the traces kept by the flight recorder to a file.
+ *
+ * The flight recorder keeps the traces of the last seconds in memory when
+ * enabled with the "--tracer-recorder" option.
+ *
+ * \param p_instance libvlc instance
+ * \param path file to write, or NULL for the default location
+ * \return 0 on success, -1 on error or if the flight recorder is disabled
+ * \version LibVLC 4.0.0 or later
+ */
+LIBVLC_API int libvlc_trace_dump( libvlc_instance_t *p_instance,
+                                  const char *path );
+
 /** @} */
 
 /**
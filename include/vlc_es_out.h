@@ -113,6 +113,11 @@ enum es_out_query_e
     ES_OUT_SPU_SET_HIGHLIGHT, /* arg1= es_out_id_t* (spu es),
                                  arg2= const vlc_spu_highlight_t *, res=can fail  */
 
+    /* Speed up or slow down the playback, ie. for live latency catch-up.
+     * The factor applies over the rate set by the user, 1.0 to stop.
+     * Only honoured for the master source. */
+    ES_OUT_REQUEST_RATE, /* arg1= double (factor), res=can fail */
+
     /* First value usable for private control */
     ES_OUT_PRIVATE_START = 0x10000,
 };
@@ -59,6 +59,7 @@ struct filter_audio_callbacks
 struct filter_subpicture_callbacks
 {
     subpicture_t *(*buffer_new)(filter_t *);
+    vlc_tick_t (*convert_ts)(filter_t *, vlc_tick_t system_now, vlc_tick_t ts);
 };
 
 typedef struct filter_owner_t
@@ -349,6 +350,26 @@ static inline subpicture_t *filter_NewSubpicture( filter_t *p_filter )
     return subpic;
 }
 
+/**
+ * This function converts a timestamp of the stream being displayed to the
+ * system date at which it will be (or was) displayed, so that subpicture
+ * sources can time their subpictures against the media instead of the wall
+ * clock. It must be called from the ops->source_sub callback.
+ *
+ * \param p_filter filter_t object
+ * \param system_now date given to ops->source_sub
+ * \param ts stream timestamp
+ * \return the system date, or VLC_TICK_INVALID if the owner has no clock
+ */
+static inline vlc_tick_t filter_ConvertSubpictureTs( filter_t *p_filter,
+                                                     vlc_tick_t system_now,
+                                                     vlc_tick_t ts )
+{
+    if( p_filter->owner.sub->convert_ts == NULL )
+        return VLC_TICK_INVALID;
+    return p_filter->owner.sub->convert_ts( p_filter, system_now, ts );
+}
+
 /**
  * This function gives all input attachments at once.
  *
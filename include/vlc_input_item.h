@@ -530,6 +530,8 @@ struct input_stats_t
     uint64_t i_read_packets;
     uint64_t i_read_bytes;
     float f_input_bitrate;
+    uint64_t i_prefetch_window; /**< read-ahead window (bytes) */
+    uint64_t i_prefetch_stalls; /**< reads that waited for the read-ahead */
 
     /* Demux */
     uint64_t i_demux_read_packets;
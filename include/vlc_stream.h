@@ -278,6 +278,8 @@ enum stream_query_e
     /* XXX only data read through vlc_stream_Read/Block will be recorded */
     STREAM_SET_RECORD_STATE,                /**< arg1=bool, arg2=const char *dir_path (if arg1 is true),
                                                  arg3=const char *psz_ext (if arg1 is true) res=can fail */
+    /* sent by the prefetch filter to its source, for the input statistics */
+    STREAM_SET_PREFETCH_STATS,              /**< arg1=(uint64_t) window bytes, arg2=(uint64_t) stalls res=can fail */
 
     STREAM_SET_PRIVATE_ID_STATE = 0x1000,   /**< arg1=(int i_private_data) arg2=(bool b_selected) res=can fail */
     STREAM_SET_PRIVATE_ID_CA,               /**< arg1=(void *) */
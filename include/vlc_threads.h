@@ -1042,6 +1042,7 @@ enum
    VLC_GCRYPT_MUTEX,
    VLC_XLIB_MUTEX,
    VLC_MOSAIC_MUTEX,
+   VLC_WHISPER_MUTEX,
 #ifdef _WIN32
    VLC_MTA_MUTEX,
 #endif
@@ -171,6 +171,21 @@ VLC_API void vlc_tracer_TraceWithTs(struct vlc_tracer *tracer, vlc_tick_t ts,
 #define vlc_tracer_Trace(tracer, ...) \
     vlc_tracer_TraceWithTs(tracer, vlc_tick_now(), __VA_ARGS__)
 
+/**
+ * Dump the flight recorder
+ *
+ * When enabled with the tracer-recorder option, the tracer keeps the last
+ * traces of each thread in memory. This function writes the ones of the
+ * configured time window to a file, in the layout of the JSON tracer.
+ *
+ * \param tracer tracer recording the traces
+ * \param path file to write, or NULL to use the tracer-recorder-file option
+ *             or a new file in the cache directory
+ * \return VLC_SUCCESS, or an error if the recorder is disabled or the file
+ *         cannot be written
+ */
+VLC_API int vlc_tracer_Dump(struct vlc_tracer *tracer, const char *path);
+
 static inline struct vlc_tracer_entry vlc_tracer_entry_FromInt(const char *key, int64_t value)
 {
     vlc_tracer_value_t tracer_value;
@@ -242,6 +257,12 @@ static inline struct vlc_tracer_entry VLC_TRACE(const char *key, const char *val
 
 #define VLC_TRACE_TICK_NS(key, tick) VLC_TRACE((key), NS_FROM_VLC_TICK((tick)))
 
+/**
+ * Values of the "phase" entry of span traces
+ */
+#define VLC_TRACE_SPAN_BEGIN "begin"
+#define VLC_TRACE_SPAN_END "end"
+
 /**
  * @}
  *
@@ -283,6 +304,42 @@ static inline void vlc_tracer_TraceEvent(struct vlc_tracer *tracer, const char *
                              VLC_TRACE_END);
 }
 
+/**
+ * Trace the beginning of a span
+ *
+ * Spans measure how long a stage takes. Each begin must be followed by a
+ * matching vlc_tracer_TraceEnd() on the same thread; spans of a thread can
+ * be nested but must not overlap.
+ *
+ * \param type type of the traced object, as for the other traces
+ * \param id identifier of the traced object
+ * \param span name of the stage
+ */
+static inline void vlc_tracer_TraceBegin(struct vlc_tracer *tracer,
+                                         const char *type, const char *id,
+                                         const char *span)
+{
+    vlc_tracer_Trace(tracer, VLC_TRACE("type", type),
+                             VLC_TRACE("id", id),
+                             VLC_TRACE("span", span),
+                             VLC_TRACE("phase", VLC_TRACE_SPAN_BEGIN),
+                             VLC_TRACE_END);
+}
+
+/**
+ * Trace the end of a span started with vlc_tracer_TraceBegin()
+ */
+static inline void vlc_tracer_TraceEnd(struct vlc_tracer *tracer,
+                                       const char *type, const char *id,
+                                       const char *span)
+{
+    vlc_tracer_Trace(tracer, VLC_TRACE("type", type),
+                             VLC_TRACE("id", id),
+                             VLC_TRACE("span", span),
+                             VLC_TRACE("phase", VLC_TRACE_SPAN_END),
+                             VLC_TRACE_END);
+}
+
 static inline void vlc_tracer_TracePCR( struct vlc_tracer *tracer, const char *type,
                                     const char *id, vlc_tick_t pcr)
 {
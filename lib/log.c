@@ -30,6 +30,7 @@
 #include "libvlc_internal.h"
 #include <vlc_common.h>
 #include <vlc_interface.h>
+#include <vlc_tracer.h>
 
 /*** Logging core dispatcher ***/
 
@@ -110,3 +111,13 @@ void libvlc_log_set_file (libvlc_instance_t *inst, FILE *stream)
 {
     libvlc_log_set (inst, libvlc_log_file, stream);
 }
+
+int libvlc_trace_dump (libvlc_instance_t *inst, const char *path)
+{
+    struct vlc_tracer *tracer =
+        vlc_object_get_tracer (VLC_OBJECT(inst->p_libvlc_int));
+
+    if (tracer == NULL)
+        return -1;
+    return (vlc_tracer_Dump (tracer, path) == VLC_SUCCESS) ? 0 : -1;
+}
@@ -50,6 +50,9 @@
 #else
 #   include <unistd.h>
 #endif
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include "fs.h"
@@ -60,12 +63,25 @@
 #endif
 #include <vlc_fs.h>
 #include <vlc_url.h>
+#include <vlc_block.h>
+#include <vlc_atomic.h>
+
+#ifdef HAVE_MMAP
+typedef struct file_map_t file_map_t;
+#endif
 
 typedef struct
 {
     int fd;
 
     bool b_pace_control;
+#ifdef HAVE_MMAP
+    /* memory mapped reading */
+    file_map_t *map; /* window of the last block */
+    uint64_t i_pos;
+    uint64_t i_size;
+    size_t i_page_mask;
+#endif
 } access_sys_t;
 
 #if !defined (_WIN32) && !defined (__OS2__)
@@ -169,6 +185,12 @@ static ssize_t Read (stream_t *, void *, size_t);
 static int FileSeek (stream_t *, uint64_t);
 static int FileControl (stream_t *, int, va_list);
 
+#ifdef HAVE_MMAP
+static block_t *MmapBlock (stream_t *, bool *);
+static int MmapSeek (stream_t *, uint64_t);
+static void MapRelease (file_map_t *);
+#endif
+
 /*****************************************************************************
  * FileOpen: open the file
  *****************************************************************************/
@@ -252,6 +274,9 @@ int FileOpen( vlc_object_t *p_this )
     p_access->pf_control = FileControl;
     p_access->p_sys = p_sys;
     p_sys->fd = fd;
+#ifdef HAVE_MMAP
+    p_sys->map = NULL;
+#endif
 
     if (S_ISREG (st.st_mode) || S_ISBLK (st.st_mode))
     {
@@ -270,6 +295,21 @@ int FileOpen( vlc_object_t *p_this )
             fcntl (fd, F_RDAHEAD, 0);
         else
             fcntl (fd, F_RDAHEAD, 1);
+#endif
+#ifdef HAVE_MMAP
+        /* Blocks are then views of the file, read without copies. */
+        if (S_ISREG (st.st_mode) && st.st_size > 0
+         && var_InheritBool (p_access, "file-mmap")
+         && !IsRemote(fd, p_access->psz_filepath))
+        {
+            msg_Dbg (p_access, "memory mapping the file");
+            p_access->pf_read = NULL;
+            p_access->pf_block = MmapBlock;
+            p_access->pf_seek = MmapSeek;
+            p_sys->i_pos = 0;
+            p_sys->i_size = st.st_size;
+            p_sys->i_page_mask = sysconf (_SC_PAGESIZE) - 1;
+        }
 #endif
     }
     else
@@ -292,7 +332,7 @@ void FileClose (vlc_object_t * p_this)
 {
     stream_t     *p_access = (stream_t*)p_this;
 
-    if (p_access->pf_read == NULL)
+    if (p_access->pf_readdir != NULL)
     {
         DirClose (p_this);
         return;
@@ -300,6 +340,11 @@ void FileClose (vlc_object_t * p_this)
 
     access_sys_t *p_sys = p_access->p_sys;
 
+#ifdef HAVE_MMAP
+    /* the blocks still in use keep their window mapped */
+    if (p_sys->map != NULL)
+        MapRelease (p_sys->map);
+#endif
     vlc_close (p_sys->fd);
 }
 
@@ -338,6 +383,169 @@ static int FileSeek (stream_t *p_access, uint64_t i_pos)
     return VLC_SUCCESS;
 }
 
+#ifdef HAVE_MMAP
+/*****************************************************************************
+ * Memory mapped reading
+ *****************************************************************************
+ * The file is mapped by windows, as it is read, and the blocks point to the
+ * window they are in. A window is unmapped once the access moved to another
+ * one and the last of its blocks is released. Mappings are private, so that
+ * the blocks can be modified like any other.
+ *****************************************************************************/
+/* Address space is scarce on 32-bits systems, where files over 4 GiB could
+ * not be mapped at once anyway. */
+#define MMAP_WINDOW    ((SIZE_MAX > UINT32_MAX) ? (UINT64_C(1) << 30) \
+                                                : (UINT64_C(1) << 25))
+#define MMAP_BLOCK     (1 << 18)
+#define MMAP_READAHEAD (1 << 21)
+
+struct file_map_t
+{
+    vlc_atomic_rc_t rc;
+    uint8_t *p_base;
+    size_t i_length;
+    uint64_t i_offset; /* file position of p_base */
+};
+
+typedef struct
+{
+    block_t b;
+    file_map_t *map;
+} file_map_view_t;
+
+static void MapRelease (file_map_t *map)
+{
+    if (vlc_atomic_rc_dec (&map->rc))
+    {
+        munmap (map->p_base, map->i_length);
+        free (map);
+    }
+}
+
+static void MapViewRelease (block_t *p_block)
+{
+    file_map_view_t *view = container_of (p_block, file_map_view_t, b);
+
+    MapRelease (view->map);
+    free (view);
+}
+
+static const struct vlc_block_callbacks map_view_cbs =
+{
+    MapViewRelease,
+};
+
+static file_map_t *MapWindow (stream_t *p_access, uint64_t i_pos)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    file_map_t *map = malloc (sizeof (*map));
+    if (unlikely(map == NULL))
+        return NULL;
+
+    map->i_offset = i_pos - (i_pos % MMAP_WINDOW);
+    map->i_length = __MIN(MMAP_WINDOW, p_sys->i_size - map->i_offset);
+    map->p_base = mmap (NULL, map->i_length, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE, p_sys->fd, map->i_offset);
+    if (map->p_base == MAP_FAILED)
+    {
+        msg_Err (p_access, "cannot map the file at %"PRIu64": %s",
+                 map->i_offset, vlc_strerror_c(errno));
+        free (map);
+        return NULL;
+    }
+
+    posix_madvise (map->p_base, map->i_length, POSIX_MADV_SEQUENTIAL);
+    vlc_atomic_rc_init (&map->rc);
+    return map;
+}
+
+/* Fallback for the windows that cannot be mapped */
+static block_t *FileBlock (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    size_t i_len = __MIN(MMAP_BLOCK, p_sys->i_size - p_sys->i_pos);
+    block_t *p_block = block_Alloc (i_len);
+    if (unlikely(p_block == NULL))
+        return NULL;
+
+    ssize_t val = pread (p_sys->fd, p_block->p_buffer, i_len, p_sys->i_pos);
+    if (val <= 0)
+    {
+        if (val < 0)
+            msg_Err (p_access, "read error: %s", vlc_strerror_c(errno));
+        block_Release (p_block);
+        *eof = true;
+        return NULL;
+    }
+
+    p_block->i_buffer = val;
+    p_sys->i_pos += val;
+    return p_block;
+}
+
+static block_t *MmapBlock (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    if (p_sys->i_pos >= p_sys->i_size)
+    {
+        /* The file may be growing */
+        struct stat st;
+
+        if (fstat (p_sys->fd, &st) == 0 && (uint64_t)st.st_size > p_sys->i_size)
+            p_sys->i_size = st.st_size;
+        if (p_sys->i_pos >= p_sys->i_size)
+        {
+            *eof = true;
+            return NULL;
+        }
+    }
+
+    file_map_t *map = p_sys->map;
+    if (map == NULL || p_sys->i_pos < map->i_offset
+     || p_sys->i_pos - map->i_offset >= map->i_length)
+    {
+        if (map != NULL)
+            MapRelease (map);
+        p_sys->map = map = MapWindow (p_access, p_sys->i_pos);
+        if (map == NULL)
+            return FileBlock (p_access, eof);
+    }
+
+    file_map_view_t *view = malloc (sizeof (*view));
+    if (unlikely(view == NULL))
+        return NULL;
+
+    size_t i_offset = p_sys->i_pos - map->i_offset;
+    size_t i_len = __MIN(MMAP_BLOCK, map->i_length - i_offset);
+
+    block_Init (&view->b, &map_view_cbs, &map->p_base[i_offset], i_len);
+    view->map = map;
+    vlc_atomic_rc_inc (&map->rc);
+    p_sys->i_pos += i_len;
+
+    /* Page in the next blocks before they are needed */
+    i_offset += i_len;
+    if (i_offset < map->i_length)
+    {
+        size_t i_ahead = i_offset & ~p_sys->i_page_mask;
+        posix_madvise (&map->p_base[i_ahead],
+                       __MIN(MMAP_READAHEAD, map->i_length - i_ahead),
+                       POSIX_MADV_WILLNEED);
+    }
+
+    return &view->b;
+}
+
+static int MmapSeek (stream_t *p_access, uint64_t i_pos)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    p_sys->i_pos = i_pos;
+    return VLC_SUCCESS;
+}
+#endif
+
 /*****************************************************************************
  * Control:
  *****************************************************************************/
@@ -38,6 +38,11 @@ vlc_module_begin ()
     add_shortcut( "file", "fd", "stream" )
     set_callbacks( FileOpen, FileClose )
 
+    add_bool("file-mmap", false, N_("Memory map files"),
+             N_("Read local files through memory mappings, without copying "
+                "their data. A file truncated while it is played crashes "
+                "the player then."))
+
     add_submodule()
     set_section( N_("Directory" ), NULL )
     set_capability( "access", 55 )
@@ -17,11 +17,25 @@
 #include <vlc_variables.h>
 #include <vlc_threads.h>
 
+#include <math.h>
 #include <string.h>
 #include <stdatomic.h>
 
 #include "whisper_shared_vlc.h"
 
+// Voice activity is decided on 30 ms frames
+#define VAD_FRAME (WHISPER_SAMPLE_RATE * 30 / 1000)
+// Silence kept before the speech onset, so that first syllables are not cut
+#define VAD_PREROLL 8
+// Quietest level considered as speech, in dBFS
+#define VAD_MIN_LEVEL (-55.f)
+
+struct vad_frame
+{
+    float samples[VAD_FRAME];
+    vlc_tick_t pts;
+};
+
 struct filter_sys_t
 {
     // For resampling
@@ -33,8 +47,20 @@ struct filter_sys_t
     float *mono_buffer;
     size_t mono_buffer_size;
     
-    // Shared buffer
-    whisper_shared_buffer_t *shared_buffer;
+    // Shared ring, written by this filter only
+    whisper_ring_t *ring;
+    
+    // Voice activity detection, only speech is written to the ring
+    bool b_vad;
+    float f_vad_threshold;      // dB above the noise floor
+    unsigned i_vad_hangover;    // frames kept after the last speech frame
+    float f_noise_level;        // estimated noise floor, in dBFS
+    unsigned i_vad_active;      // frames left before going back to silence
+    struct vad_frame frame;     // frame being filled
+    size_t i_frame_len;
+    struct vad_frame preroll[VAD_PREROLL];
+    unsigned i_preroll_start, i_preroll_count;
+    uint64_t i_frames, i_speech_frames;
 };
 
 /*****************************************************************************
@@ -43,99 +69,51 @@ struct filter_sys_t
 static int OpenFilter(vlc_object_t *);
 static void CloseFilter(filter_t *);
 static block_t *Process(filter_t *, block_t *);
+static void Flush(filter_t *);
 
 static const struct vlc_filter_operations filter_ops = {
     .filter_audio = Process,
+    .flush = Flush,
     .close = CloseFilter,
 };
 
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
+#define CHANNEL_TEXT N_("Capture channel")
+#define CHANNEL_LONGTEXT N_("Name of the shared audio ring to write to. " \
+    "Readers such as the Whisper transcriber attach to the ring by name, so " \
+    "players capturing different audio must use different channels.")
+
+#define VAD_TEXT N_("Voice activity detection")
+#define VAD_LONGTEXT N_("Only send speech to the transcriber. Silence and " \
+    "quiet background are skipped, which saves most of the transcription " \
+    "work on sparse dialogue.")
+
+#define VAD_THRESHOLD_TEXT N_("Speech threshold (dB)")
+#define VAD_THRESHOLD_LONGTEXT N_("Level above the estimated background " \
+    "noise from which audio is considered as speech.")
+
+#define VAD_HANGOVER_TEXT N_("Speech hangover (ms)")
+#define VAD_HANGOVER_LONGTEXT N_("Audio still sent after the end of speech, " \
+    "so that pauses between words do not split sentences.")
+
+#define CFG_PREFIX "livetranslate-whisper-audio-"
+
 vlc_module_begin()
     set_description(N_("Whisper audio capture"))
     set_shortname(N_("Whisper Audio"))
     set_capability("audio filter", 0)
     set_subcategory(SUBCAT_AUDIO_AFILTER)
     set_callback(OpenFilter)
-vlc_module_end()
-
-/*****************************************************************************
- * Shared buffer management using VLC variables
- *****************************************************************************/
-static whisper_shared_buffer_t *whisper_shared_get_buffer(vlc_object_t *obj)
-{
-    // Get the root libvlc object
-    libvlc_int_t *p_libvlc = vlc_object_instance(obj);
-    if (!p_libvlc)
-        return NULL;
-        
-    // Check if buffer already exists
-    var_Create(p_libvlc, "whisper-shared-buffer", VLC_VAR_ADDRESS);
-    void *ptr = var_GetAddress(p_libvlc, "whisper-shared-buffer");
-    
-    if (ptr) {
-        whisper_shared_buffer_t *buffer = (whisper_shared_buffer_t *)ptr;
-        atomic_fetch_add(&buffer->ref_count, 1);
-        return buffer;
-    }
-    
-    // Create new buffer
-    whisper_shared_buffer_t *buffer = malloc(sizeof(whisper_shared_buffer_t));
-    if (!buffer)
-        return NULL;
-        
-    buffer->samples = malloc(WHISPER_BUFFER_SIZE * sizeof(float));
-    if (!buffer->samples) {
-        free(buffer);
-        return NULL;
-    }
-    
-    memset(buffer->samples, 0, WHISPER_BUFFER_SIZE * sizeof(float));
-    atomic_init(&buffer->write_pos, 0);
-    atomic_init(&buffer->read_pos, 0);
-    atomic_init(&buffer->active, true);
-    atomic_init(&buffer->ref_count, 1);
-    var_SetAddress(p_libvlc, "whisper-shared-buffer", buffer);
-    
-    return buffer;
-}
-
-static void whisper_shared_release_buffer(vlc_object_t *obj, whisper_shared_buffer_t *buffer)
-{
-    if (!buffer)
-        return;
-        
-    int count = atomic_fetch_sub(&buffer->ref_count, 1);
-    if (count == 1) {
-        // Last reference, clean up
-        libvlc_int_t *p_libvlc = vlc_object_instance(obj);
-        if (p_libvlc) {
-            var_SetAddress(p_libvlc, "whisper-shared-buffer", NULL);
-            var_Destroy(p_libvlc, "whisper-shared-buffer");
-        }
-        
-        atomic_store(&buffer->active, false);
-        free(buffer->samples);
-        free(buffer);
-    }
-}
 
-static int whisper_shared_write_buffer(whisper_shared_buffer_t *buffer, const float *samples, size_t count)
-{
-    if (!buffer || !atomic_load(&buffer->active))
-        return -1;
-        
-    size_t write_pos = atomic_load(&buffer->write_pos);
-    
-    for (size_t i = 0; i < count; i++) {
-        buffer->samples[write_pos] = samples[i];
-        write_pos = (write_pos + 1) % WHISPER_BUFFER_SIZE;
-    }
-    
-    atomic_store(&buffer->write_pos, write_pos);
-    return 0;
-}
+    add_string(CFG_PREFIX "channel", WHISPER_RING_DEFAULT_NAME, CHANNEL_TEXT, CHANNEL_LONGTEXT)
+    add_bool(CFG_PREFIX "vad", true, VAD_TEXT, VAD_LONGTEXT)
+    add_integer_with_range(CFG_PREFIX "vad-threshold", 10, 3, 40,
+                           VAD_THRESHOLD_TEXT, VAD_THRESHOLD_LONGTEXT)
+    add_integer_with_range(CFG_PREFIX "vad-hangover", 500, 0, 5000,
+                           VAD_HANGOVER_TEXT, VAD_HANGOVER_LONGTEXT)
+vlc_module_end()
 
 /*****************************************************************************
  * OpenFilter: initialize audio filter
@@ -152,7 +130,7 @@ static int OpenFilter(vlc_object_t *p_this)
         return VLC_EGENERIC;
     }
     
-    struct filter_sys_t *p_sys = malloc(sizeof(*p_sys));
+    struct filter_sys_t *p_sys = calloc(1, sizeof(*p_sys));
     if (!p_sys)
         return VLC_ENOMEM;
     
@@ -178,15 +156,36 @@ static int OpenFilter(vlc_object_t *p_this)
         return VLC_ENOMEM;
     }
     
-    // Get shared buffer
-    p_sys->shared_buffer = whisper_shared_get_buffer(VLC_OBJECT(p_filter));
-    if (!p_sys->shared_buffer) {
+    // Get shared ring and become its writer
+    char *channel = var_InheritString(p_filter, CFG_PREFIX "channel");
+    p_sys->ring = whisper_ring_Acquire(VLC_OBJECT(p_filter), channel);
+    if (!p_sys->ring) {
         msg_Err(p_filter, "Failed to get shared audio buffer");
+        free(channel);
         free(p_sys->mono_buffer);
         free(p_sys->resample_buffer);
         free(p_sys);
         return VLC_ENOMEM;
     }
+
+    if (whisper_ring_AttachWriter(p_sys->ring) != VLC_SUCCESS) {
+        msg_Err(p_filter, "Audio channel \"%s\" is already captured, "
+                "use --" CFG_PREFIX "channel to select another one",
+                channel ? channel : WHISPER_RING_DEFAULT_NAME);
+        whisper_ring_Release(p_sys->ring);
+        free(channel);
+        free(p_sys->mono_buffer);
+        free(p_sys->resample_buffer);
+        free(p_sys);
+        return VLC_EGENERIC;
+    }
+    free(channel);
+    
+    p_sys->b_vad = var_InheritBool(p_filter, CFG_PREFIX "vad");
+    p_sys->f_vad_threshold = var_InheritInteger(p_filter, CFG_PREFIX "vad-threshold");
+    p_sys->i_vad_hangover = var_InheritInteger(p_filter, CFG_PREFIX "vad-hangover")
+                          * WHISPER_SAMPLE_RATE / 1000 / VAD_FRAME;
+    p_sys->f_noise_level = VAD_MIN_LEVEL;
     
     // Set output format same as input
     p_filter->fmt_out.audio = p_filter->fmt_in.audio;
@@ -206,13 +205,120 @@ static void CloseFilter(filter_t *p_filter)
 {
     struct filter_sys_t *p_sys = p_filter->p_sys;
     
-    whisper_shared_release_buffer(VLC_OBJECT(p_filter), p_sys->shared_buffer);
+    if (p_sys->b_vad && p_sys->i_frames > 0)
+        msg_Dbg(p_filter, "%"PRIu64" of %"PRIu64" frames detected as speech",
+                p_sys->i_speech_frames, p_sys->i_frames);
+    
+    whisper_ring_DetachWriter(p_sys->ring);
+    whisper_ring_Release(p_sys->ring);
     
     free(p_sys->mono_buffer);
     free(p_sys->resample_buffer);
     free(p_sys);
 }
 
+/*****************************************************************************
+ * Voice activity detection
+ *****************************************************************************/
+static bool IsSpeech(struct filter_sys_t *p_sys, const float *samples)
+{
+    float energy = 0.f;
+    unsigned crossings = 0;
+
+    for (size_t i = 0; i < VAD_FRAME; i++) {
+        energy += samples[i] * samples[i];
+        if (i > 0 && (samples[i] >= 0.f) != (samples[i - 1] >= 0.f))
+            crossings++;
+    }
+
+    float level = 10.f * log10f(energy / VAD_FRAME + 1e-10f);
+    float zcr = (float)crossings / VAD_FRAME;
+
+    // Track the noise floor: follow drops at once, rises slowly so that
+    // speech does not raise it (about 1 dB per second)
+    if (level < p_sys->f_noise_level)
+        p_sys->f_noise_level = level;
+    else
+        p_sys->f_noise_level += .03f;
+
+    // Voiced speech is loud with few zero crossings, hiss crosses zero at
+    // almost every sample
+    return level > VAD_MIN_LEVEL
+        && level > p_sys->f_noise_level + p_sys->f_vad_threshold
+        && zcr < .5f;
+}
+
+static void VadReset(struct filter_sys_t *p_sys)
+{
+    p_sys->i_frame_len = 0;
+    p_sys->i_preroll_count = 0;
+    p_sys->i_vad_active = 0;
+}
+
+static void VadFrame(struct filter_sys_t *p_sys)
+{
+    struct vad_frame *frame = &p_sys->frame;
+    const vlc_tick_t length = vlc_tick_from_samples(VAD_FRAME, WHISPER_SAMPLE_RATE);
+
+    p_sys->i_frames++;
+    if (IsSpeech(p_sys, frame->samples)) {
+        // Speech onset: send what preceded it first
+        for (unsigned i = 0; i < p_sys->i_preroll_count; i++) {
+            const struct vad_frame *old =
+                &p_sys->preroll[(p_sys->i_preroll_start + i) % VAD_PREROLL];
+            whisper_ring_Write(p_sys->ring, old->samples, VAD_FRAME,
+                               old->pts, length);
+        }
+        p_sys->i_preroll_count = 0;
+        p_sys->i_vad_active = p_sys->i_vad_hangover + 1;
+        p_sys->i_speech_frames++;
+    }
+
+    if (p_sys->i_vad_active > 0) {
+        p_sys->i_vad_active--;
+        whisper_ring_Write(p_sys->ring, frame->samples, VAD_FRAME,
+                           frame->pts, length);
+        return;
+    }
+
+    // Silence: keep the last frames in case speech starts
+    unsigned index = (p_sys->i_preroll_start + p_sys->i_preroll_count) % VAD_PREROLL;
+    if (p_sys->i_preroll_count == VAD_PREROLL)
+        p_sys->i_preroll_start = (p_sys->i_preroll_start + 1) % VAD_PREROLL;
+    else
+        p_sys->i_preroll_count++;
+    p_sys->preroll[index] = *frame;
+}
+
+static void VadWrite(struct filter_sys_t *p_sys, const float *samples,
+                     size_t count, vlc_tick_t pts, vlc_tick_t length)
+{
+    for (size_t i = 0; i < count; ) {
+        if (p_sys->i_frame_len == 0)
+            p_sys->frame.pts = pts != VLC_TICK_INVALID
+                             ? pts + length * i / count : VLC_TICK_INVALID;
+
+        size_t chunk = __MIN(count - i, VAD_FRAME - p_sys->i_frame_len);
+        memcpy(p_sys->frame.samples + p_sys->i_frame_len, samples + i,
+               chunk * sizeof(float));
+        p_sys->i_frame_len += chunk;
+        i += chunk;
+
+        if (p_sys->i_frame_len == VAD_FRAME) {
+            VadFrame(p_sys);
+            p_sys->i_frame_len = 0;
+        }
+    }
+}
+
+static void Flush(filter_t *p_filter)
+{
+    struct filter_sys_t *p_sys = p_filter->p_sys;
+
+    // Do not glue audio from before a seek to the audio after it
+    VadReset(p_sys);
+}
+
 /*****************************************************************************
  * Process: capture and forward audio
  *****************************************************************************/
@@ -271,13 +377,17 @@ static block_t *Process(filter_t *p_filter, block_t *p_block)
         }
     }
     
-    // Write to shared buffer
-    if (whisper_shared_write_buffer(p_sys->shared_buffer, p_sys->resample_buffer, output_count) == 0) {
-        static int log_counter = 0;
-        if (log_counter++ % 100 == 0) { // Log every 100th call to avoid spam
-            msg_Info(p_filter, "Wrote %zu audio samples to shared buffer", output_count);
-        }
-    }
+    // Write to shared ring along with the stream timing of the block, this
+    // never blocks on the readers
+    vlc_tick_t length = p_block->i_length;
+    if (length <= 0)
+        length = vlc_tick_from_samples(input_count, p_filter->fmt_in.audio.i_rate);
+    if (p_sys->b_vad)
+        VadWrite(p_sys, p_sys->resample_buffer, output_count,
+                 p_block->i_pts, length);
+    else
+        whisper_ring_Write(p_sys->ring, p_sys->resample_buffer, output_count,
+                           p_block->i_pts, length);
     
     // Pass through the audio unchanged
     return p_block;
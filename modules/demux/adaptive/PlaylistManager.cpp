@@ -36,6 +36,7 @@
 #include "logic/AlwaysLowestAdaptationLogic.hpp"
 #include "logic/PredictiveAdaptationLogic.hpp"
 #include "logic/NearOptimalAdaptationLogic.hpp"
+#include "logic/HybridAdaptationLogic.hpp"
 #include "logic/BufferingLogic.hpp"
 #include "tools/Debug.hpp"
 #ifdef ADAPTIVE_DEBUGGING_LOGIC
@@ -46,7 +47,9 @@
 #include <vlc_threads.h>
 
 #include <algorithm>
+#include <cmath>
 #include <ctime>
+#include <limits>
 
 using namespace adaptive::http;
 using namespace adaptive::logic;
@@ -85,6 +88,9 @@ PlaylistManager::PlaylistManager( demux_t *p_demux_,
     cached.playlistEnd = 0;
     cached.playlistLength = 0;
     cached.lastupdate = 0;
+    catchup.b_enabled = var_InheritBool(p_demux, "adaptive-catchup");
+    catchup.rate = 1.f;
+    catchup.lastcheck = VLC_TICK_INVALID;
 }
 
 PlaylistManager::~PlaylistManager   ()
@@ -155,6 +161,13 @@ bool PlaylistManager::init(bool b_preparsing)
     if(!setupPeriod())
         return false;
 
+    /* Let segments data flow as soon as received */
+    resources->getConnManager()->setLowLatency(playlist->isLive() &&
+                                               bufferingLogic->isLowLatency(playlist));
+    if(playlist->minPlaybackRate.Get() || playlist->maxPlaybackRate.Get())
+        catchup.controller.setPlaybackRateRange(playlist->minPlaybackRate.Get(),
+                                                playlist->maxPlaybackRate.Get());
+
     playlist->playbackStart.Set(time(nullptr));
     nextPlaylistupdate = playlist->playbackStart.Get();
 
@@ -489,6 +502,7 @@ int PlaylistManager::doDemux(vlc_tick_t increment)
     vlc_mutex_unlock(&demux.lock);
 
     updateControlsPosition();
+    updatePlaybackRate();
 
     switch(status)
     {
@@ -686,7 +700,7 @@ int PlaylistManager::doControl(int i_query, va_list args)
         }
 
         case DEMUX_GET_PTS_DELAY:
-            *va_arg (args, vlc_tick_t *) = VLC_TICK_FROM_SEC(1);
+            *va_arg (args, vlc_tick_t *) = getPtsDelay();
             break;
 
         default:
@@ -854,6 +868,70 @@ void PlaylistManager::updateControlsPosition()
                             startTimes.segment.demux, cached.f_position));
 }
 
+vlc_tick_t PlaylistManager::getPtsDelay() const
+{
+    if(playlist->isLive() && bufferingLogic->isLowLatency(playlist))
+        return VLC_TICK_FROM_MS(500);
+    return VLC_TICK_FROM_SEC(1);
+}
+
+void PlaylistManager::updatePlaybackRate()
+{
+    if(!catchup.b_enabled || !playlist->isLive() ||
+       !bufferingLogic->isLowLatency(playlist))
+    {
+        /* low latency can be detected then lost as renditions load */
+        if(catchup.rate != 1.f)
+        {
+            es_out_Control(p_demux->out, ES_OUT_REQUEST_RATE, 1.0);
+            catchup.rate = 1.f;
+        }
+        return;
+    }
+
+    const vlc_tick_t now = vlc_tick_now();
+    if(catchup.lastcheck != VLC_TICK_INVALID &&
+       now - catchup.lastcheck < VLC_TICK_FROM_MS(500))
+        return;
+    catchup.lastcheck = now;
+
+    vlc_mutex_lock(&demux.lock);
+    const Times times = demux.times;
+    vlc_mutex_unlock(&demux.lock);
+    if(times.segment.media == VLC_TICK_INVALID)
+        return;
+
+    vlc_tick_t edge = VLC_TICK_INVALID;
+    vlc_tick_t buffering = std::numeric_limits<vlc_tick_t>::max();
+    for(AbstractStream *st : streams)
+    {
+        if(!st->isValid() || st->isDisabled() || !st->isSelected())
+            continue;
+        vlc_tick_t stedge;
+        if(edge == VLC_TICK_INVALID && st->getMediaLiveEdge(&stedge))
+            edge = stedge;
+        buffering = std::min(buffering, st->getDemuxedAmount(times));
+    }
+    if(edge == VLC_TICK_INVALID)
+        return;
+
+    /* what is output is still delayed by the decoders/output buffering */
+    const vlc_tick_t latency = edge - times.segment.media + getPtsDelay();
+    catchup.controller.setTargetLatency(bufferingLogic->getLiveDelay(playlist));
+    const float rate = catchup.controller.getPlaybackRate(latency, buffering);
+    if(std::abs(rate - catchup.rate) < 0.005f)
+        return;
+
+    if(es_out_Control(p_demux->out, ES_OUT_REQUEST_RATE, (double) rate) == VLC_SUCCESS)
+    {
+        msg_Dbg(p_demux, "live latency %" PRId64 "ms target %" PRId64 "ms, catch-up rate %.3f",
+                MS_FROM_VLC_TICK(latency),
+                MS_FROM_VLC_TICK(catchup.controller.getTargetLatency()), rate);
+        catchup.rate = rate;
+    }
+    else catchup.rate = 1.f; /* refused, or reset while timeshifting */
+}
+
 AbstractAdaptationLogic *PlaylistManager::createLogic(AbstractAdaptationLogic::LogicType type, AbstractConnectionManager *conn)
 {
     vlc_object_t *obj = VLC_OBJECT(p_demux);
@@ -903,6 +981,16 @@ AbstractAdaptationLogic *PlaylistManager::createLogic(AbstractAdaptationLogic::L
             if(predictivelogic)
                 conn->setDownloadRateObserver(predictivelogic);
             logic = predictivelogic;
+            break;
+        }
+        case AbstractAdaptationLogic::LogicType::Hybrid:
+        {
+            HybridAdaptationLogic *hybridlogic =
+                    new (std::nothrow) HybridAdaptationLogic(obj);
+            if(hybridlogic)
+                conn->setDownloadRateObserver(hybridlogic);
+            logic = hybridlogic;
+            break;
         }
 
         default:
@@ -940,6 +1028,9 @@ AbstractBufferingLogic *PlaylistManager::createBufferingLogic() const
         v = var_InheritInteger(p_demux, "adaptive-maxbuffer");
         if(v)
             bl->setUserMaxBuffering(VLC_TICK_FROM_MS(v));
+        int lowlatency = var_InheritInteger(p_demux, "adaptive-lowlatency");
+        if(lowlatency != -1)
+            bl->setLowDelay(lowlatency != 0);
     }
     return bl;
 }
@@ -23,6 +23,7 @@
 #define PLAYLISTMANAGER_H_
 
 #include "logic/AbstractAdaptationLogic.h"
+#include "logic/CatchupController.hpp"
 #include "Streams.hpp"
 #include <vector>
 
@@ -94,6 +95,8 @@ namespace adaptive
             void unsetPeriod();
 
             void updateControlsPosition();
+            void updatePlaybackRate();
+            vlc_tick_t getPtsDelay() const;
 
             /* local factories */
             virtual AbstractAdaptationLogic *createLogic(AbstractAdaptationLogic::LogicType,
@@ -144,6 +147,15 @@ namespace adaptive
                 time_t      lastupdate;
             } cached;
 
+            /* Live latency catch-up */
+            struct
+            {
+                bool        b_enabled;
+                float       rate;
+                vlc_tick_t  lastcheck;
+                CatchupController controller;
+            } catchup;
+
             SynchronizationReferences synchronizationReferences;
 
         private:
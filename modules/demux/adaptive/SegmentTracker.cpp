@@ -29,11 +29,14 @@
 #include "playlist/BaseAdaptationSet.h"
 #include "playlist/Segment.h"
 #include "playlist/SegmentChunk.hpp"
+#include "playlist/SegmentTemplate.h"
 #include "logic/AbstractAdaptationLogic.h"
 #include "logic/BufferingLogic.hpp"
+#include "http/HTTPConnectionManager.h"
 
 #include <cassert>
 #include <limits>
+#include <ctime>
 
 using namespace adaptive;
 using namespace adaptive::logic;
@@ -149,9 +152,12 @@ SegmentTracker::~SegmentTracker()
     reset();
 }
 
+const size_t SegmentTracker::Position::NOPART = std::numeric_limits<size_t>::max();
+
 SegmentTracker::Position::Position()
 {
     number = std::numeric_limits<uint64_t>::max();
+    part = NOPART;
     rep = nullptr;
     init_sent = false;
     index_sent = false;
@@ -161,6 +167,7 @@ SegmentTracker::Position::Position(BaseRepresentation *rep, uint64_t number)
 {
     this->rep = rep;
     this->number = number;
+    part = NOPART;
     init_sent = false;
     index_sent = false;
 }
@@ -176,10 +183,14 @@ std::string SegmentTracker::Position::toString() const
     std::stringstream ss;
     ss.imbue(std::locale("C"));
     if(isValid())
-        ss << "seg# " << number
-           << " " << init_sent
+    {
+        ss << "seg# " << number;
+        if(part != NOPART)
+            ss << "." << part;
+        ss << " " << init_sent
            << ":" << index_sent
            << " " << rep->getID().str();
+    }
     else
         ss << "invalid";
     return ss.str();
@@ -190,7 +201,12 @@ SegmentTracker::Position & SegmentTracker::Position::operator ++()
     if(isValid())
     {
         if(index_sent)
-            ++number;
+        {
+            if(part != NOPART)
+                ++part;
+            else
+                ++number;
+        }
         else if(init_sent)
             index_sent = true;
         else
@@ -264,7 +280,24 @@ SegmentTracker::prepareChunk(bool switch_allowed, Position pos) const
     }
     else /* continuing, or seek */
     {
-        if(!adaptationSet->isSegmentAligned() || !pos.init_sent || !pos.index_sent)
+        /* all the parts were read, go on with the next segment */
+        if(pos.part != Position::NOPART && pos.index_sent)
+        {
+            const Segment *seg = pos.rep->getMediaSegment(pos.number);
+            if(!seg)
+            {
+                pos.part = 0;
+            }
+            else if(!seg->isPartial() && pos.part >= seg->getParts().size())
+            {
+                ++pos.number;
+                pos.part = 0;
+            }
+        }
+
+        /* representations can only be switched on segments boundaries */
+        if(!adaptationSet->isSegmentAligned() || !pos.init_sent || !pos.index_sent ||
+           (pos.part != Position::NOPART && pos.part > 0))
             switch_allowed = false;
 
         if(switch_allowed)
@@ -275,6 +308,7 @@ SegmentTracker::prepareChunk(bool switch_allowed, Position pos) const
             {
                 /* Convert our segment number if we need to */
                 temp.number = temp.rep->translateSegmentNumber(pos.number, pos.rep);
+                temp.part = pos.part;
 
                 /* Ensure ephemere content is updated/loaded */
                 if(temp.rep->needsUpdate(temp.number))
@@ -285,7 +319,7 @@ SegmentTracker::prepareChunk(bool switch_allowed, Position pos) const
                     temp.number = temp.rep->translateSegmentNumber(pos.number, pos.rep);
 
                 /* cancel switch that would go past playlist */
-                if(temp.isValid() && temp.rep->getMinAheadTime(temp.number) == 0)
+                if(temp.isValid() && getAheadTime(temp.rep, temp.number, temp.part) == 0)
                     temp = Position();
             }
             if(temp.isValid())
@@ -294,11 +328,28 @@ SegmentTracker::prepareChunk(bool switch_allowed, Position pos) const
     }
 
     bool b_gap = true;
-    ISegment *datasegment = pos.rep->getNextMediaSegment(pos.number, &pos.number, &b_gap);
+    Segment *datasegment = pos.rep->getNextMediaSegment(pos.number, &pos.number, &b_gap);
 
     if(!datasegment && (!pos.rep->needsIndex() || pos.index_sent))
         return ChunkEntry();
 
+    /* segments still being published can only be read by parts */
+    ISegment *datapart = nullptr;
+    if(datasegment && datasegment->isPartial() && pos.part == Position::NOPART)
+        pos.part = 0;
+    if(datasegment && pos.part != Position::NOPART)
+    {
+        const std::vector<Segment *> &parts = datasegment->getParts();
+        if(b_gap && !datasegment->isPartial())
+            pos.part = Position::NOPART; /* restart from a whole segment */
+        else if(pos.part < parts.size())
+            datapart = parts.at(pos.part);
+        else if(datasegment->isPartial())
+            return ChunkEntry(); /* not yet published */
+        else
+            pos.part = Position::NOPART; /* no parts, read it whole */
+    }
+
     ISegment *segment = nullptr;
     if(!pos.init_sent)
     {
@@ -316,7 +367,7 @@ SegmentTracker::prepareChunk(bool switch_allowed, Position pos) const
     }
 
     if(!segment)
-        segment = datasegment;
+        segment = datapart ? datapart : datasegment;
 
     SegmentChunk *segmentChunk = segment->toChunk(resources, pos.number, pos.rep);
     if(!segmentChunk)
@@ -331,6 +382,13 @@ SegmentTracker::prepareChunk(bool switch_allowed, Position pos) const
     /* timings belong to timeline and are not set on the segment or need profile timescale */
     if(pos.rep->getPlaybackTimeDurationBySegmentNumber(pos.number, &startTime, &duration))
         startTime += VLC_TICK_0;
+    if(datapart && segment == datapart)
+    {
+        const Timescale timescale = pos.rep->inheritTimescale();
+        if(startTime != VLC_TICK_INVALID)
+            startTime += timescale.ToTime(datapart->startTime.Get());
+        duration = timescale.ToTime(datapart->duration.Get());
+    }
 
     return ChunkEntry(segmentChunk, pos, startTime, duration, displayTime);
 }
@@ -365,6 +423,9 @@ ChunkInterface * SegmentTracker::getNextChunk(bool switch_allowed)
 
     /* here next == wanted chunk pos */
     bool b_gap = (next.number != chunk.pos.number);
+    /* or the segment following the one we did read by parts */
+    if(b_gap && next.part != Position::NOPART && chunk.pos.number == next.number + 1)
+        b_gap = false;
     const bool b_switched = (current.rep != chunk.pos.rep) || !current.rep;
     bool b_discontinuity = chunk.chunk->discontinuity && current.isValid();
     if(b_discontinuity && current.number == next.number)
@@ -491,7 +552,9 @@ SegmentTracker::Position SegmentTracker::getStartPosition() const
     {
         /* Ensure ephemere content is updated/loaded */
         bool b_updated = pos.rep->needsUpdate(pos.number) && pos.rep->runLocalUpdates(resources);
-        pos.number = bufferingLogic->getStartSegmentNumber(pos.rep);
+        /* start closer to the live edge with parts */
+        if(!bufferingLogic->getStartPart(pos.rep, &pos.number, &pos.part))
+            pos.number = bufferingLogic->getStartSegmentNumber(pos.rep);
         pos.rep->scheduleNextUpdate(pos.number, b_updated);
         if(b_updated)
             notify(RepresentationUpdatedEvent(pos.rep));
@@ -536,6 +599,33 @@ bool SegmentTracker::getMediaPlaybackRange(vlc_tick_t *start, vlc_tick_t *end,
     return current.rep->getMediaPlaybackRange(start, end, length);
 }
 
+bool SegmentTracker::getMediaLiveEdge(vlc_tick_t *edge) const
+{
+    const BaseRepresentation *rep = current.rep;
+    if(!rep || !adaptationSet->getPlaylist()->isLive())
+        return false;
+
+    /* Templated segments are not listed, the edge is
+     * derived from the wall clock, as for their numbers */
+    const SegmentTemplate *templ = rep->inheritSegmentTemplate();
+    if(templ && !templ->inheritSegmentTimeline() && templ->inheritDuration())
+    {
+        struct timespec now;
+        timespec_get(&now, TIME_UTC);
+        *edge = vlc_tick_from_timespec(&now)
+              - rep->getPlaylist()->availabilityStartTime.Get()
+              - rep->getPeriodStart();
+    }
+    else
+    {
+        vlc_tick_t start, length;
+        if(!rep->getMediaPlaybackRange(&start, edge, &length))
+            return false;
+    }
+    *edge += VLC_TICK_0;
+    return true;
+}
+
 vlc_tick_t SegmentTracker::getMinAheadTime() const
 {
     BaseRepresentation *rep = current.rep;
@@ -555,11 +645,33 @@ vlc_tick_t SegmentTracker::getMinAheadTime() const
         if(startnumber == std::numeric_limits<uint64_t>::max())
             startnumber = bufferingLogic->getStartSegmentNumber(rep);
         if(startnumber != std::numeric_limits<uint64_t>::max())
+        {
+            /* remaining parts of the segment being read */
+            if(startnumber == current.number && current.part != Position::NOPART)
+                return getAheadTime(rep, startnumber, current.part + 1);
             return rep->getMinAheadTime(startnumber);
+        }
     }
     return 0;
 }
 
+vlc_tick_t SegmentTracker::getAheadTime(const BaseRepresentation *rep,
+                                        uint64_t number, size_t part) const
+{
+    vlc_tick_t ahead = rep->getMinAheadTime(number);
+    if(part == Position::NOPART)
+        return ahead;
+    const Segment *seg = rep->getMediaSegment(number);
+    if(seg)
+    {
+        const Timescale timescale = rep->inheritTimescale();
+        const std::vector<Segment *> &parts = seg->getParts();
+        for(size_t i = part; i < parts.size(); i++)
+            ahead += timescale.ToTime(parts[i]->duration.Get());
+    }
+    return ahead;
+}
+
 bool SegmentTracker::getSynchronizationReference(uint64_t discontinuitysequence,
                                                  vlc_tick_t time,
                                                  SynchronizationReference &r) const
@@ -582,6 +694,10 @@ void SegmentTracker::notifyBufferingLevel(vlc_tick_t min, vlc_tick_t max,
                                           vlc_tick_t current, vlc_tick_t target) const
 {
     notify(BufferingLevelChangedEvent(adaptationSet->getID(), min, max, current, target));
+    /* lets the downloads of the most starving stream go first */
+    http::AbstractConnectionManager *connManager = resources->getConnManager();
+    if(connManager)
+        connManager->updateBufferLevel(adaptationSet->getID(), current);
 }
 
 void SegmentTracker::registerListener(SegmentTrackerListenerInterface *listener)
@@ -214,9 +214,11 @@ namespace adaptive
                     bool isValid() const;
                     std::string toString() const;
                     uint64_t number;
+                    size_t part; /* reading the segment part by part */
                     BaseRepresentation *rep;
                     bool init_sent;
                     bool index_sent;
+                    static const size_t NOPART;
             };
 
             void getCodecsDesc(CodecDescriptionList *) const;
@@ -229,6 +231,7 @@ namespace adaptive
             Position getStartPosition() const;
             vlc_tick_t getPlaybackTime(bool = false) const; /* Current segment start time if selected */
             bool getMediaPlaybackRange(vlc_tick_t *, vlc_tick_t *, vlc_tick_t *) const;
+            bool getMediaLiveEdge(vlc_tick_t *) const;
             vlc_tick_t getMinAheadTime() const;
             bool getSynchronizationReference(uint64_t, vlc_tick_t, SynchronizationReference &) const;
             void updateSynchronizationReference(uint64_t, const Times &);
@@ -254,6 +257,7 @@ namespace adaptive
             std::list<ChunkEntry> chunkssequence;
             ChunkEntry prepareChunk(bool switch_allowed, Position pos) const;
             void resetChunksSequence();
+            vlc_tick_t getAheadTime(const BaseRepresentation *, uint64_t, size_t) const;
             void setAdaptationLogic(AbstractAdaptationLogic *);
             void notify(const TrackerEvent &) const;
             bool first;
@@ -25,21 +25,27 @@
 #include "http/AuthStorage.hpp"
 #include "http/HTTPConnectionManager.h"
 #include "http/HTTPConnection.hpp"
+#include "http/SegmentCache.hpp"
 #include "encryption/Keyring.hpp"
 
 using namespace adaptive;
 
 SharedResources::SharedResources(AuthStorage *auth, Keyring *ring,
-                                 AbstractConnectionManager *conn)
+                                 AbstractConnectionManager *conn,
+                                 SegmentCache *cache, const std::string &cachekey)
 {
     authStorage = auth;
     encryptionKeyring = ring;
     connManager = conn;
+    segmentCache = cache;
+    segmentCacheKey = cachekey;
 }
 
 SharedResources::~SharedResources()
 {
     delete connManager;
+    if(segmentCache)
+        segmentCache->release(segmentCacheKey);
     delete encryptionKeyring;
     delete authStorage;
 }
@@ -59,8 +65,14 @@ AbstractConnectionManager * SharedResources::getConnManager()
     return connManager;
 }
 
+SegmentCache * SharedResources::getSegmentCache()
+{
+    return segmentCache;
+}
+
 SharedResources * SharedResources::createDefault(vlc_object_t *obj,
-                                                 const std::string & playlisturl)
+                                                 const std::string & playlisturl,
+                                                 bool b_preparsing)
 {
     AuthStorage *auth = new AuthStorage(obj);
     Keyring *keyring = new Keyring(obj);
@@ -71,5 +83,14 @@ SharedResources * SharedResources::createDefault(vlc_object_t *obj,
     ConnectionParams params(playlisturl);
     if(params.isLocal())
         m->setLocalConnectionsAllowed();
-    return new SharedResources(auth, keyring, m);
+    /* shared with the other adaptive instances of the process
+     * playing the same playlist, preparsing won't play it */
+    SegmentCache *cache = nullptr;
+    if(!b_preparsing)
+    {
+        cache = SegmentCache::acquire(
+                var_InheritInteger(obj, "adaptive-cachesize") * 1024 * 1024, playlisturl);
+        m->setSegmentCache(cache, playlisturl);
+    }
+    return new SharedResources(auth, keyring, m, cache, playlisturl);
 }
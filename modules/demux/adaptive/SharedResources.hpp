@@ -29,6 +29,7 @@ namespace adaptive
     {
         class AuthStorage;
         class AbstractConnectionManager;
+        class SegmentCache;
     }
 
     namespace encryption
@@ -42,18 +43,23 @@ namespace adaptive
     class SharedResources
     {
         public:
-            SharedResources(AuthStorage *, Keyring *, AbstractConnectionManager *);
+            SharedResources(AuthStorage *, Keyring *, AbstractConnectionManager *,
+                            SegmentCache * = nullptr, const std::string & = std::string());
             ~SharedResources();
             AuthStorage *getAuthStorage();
             Keyring     *getKeyring();
             AbstractConnectionManager *getConnManager();
+            SegmentCache *getSegmentCache();
             /* Helper */
-            static SharedResources * createDefault(vlc_object_t *, const std::string &);
+            static SharedResources * createDefault(vlc_object_t *, const std::string &,
+                                                   bool = false);
 
         private:
             AuthStorage *authStorage;
             Keyring *encryptionKeyring;
             AbstractConnectionManager *connManager;
+            SegmentCache *segmentCache;
+            std::string segmentCacheKey;
     };
 }
 
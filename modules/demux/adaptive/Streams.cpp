@@ -715,6 +715,11 @@ bool AbstractStream::getMediaPlaybackTimes(vlc_tick_t *start, vlc_tick_t *end,
     return segmentTracker->getMediaPlaybackRange(start, end, length);
 }
 
+bool AbstractStream::getMediaLiveEdge(vlc_tick_t *edge) const
+{
+    return segmentTracker->getMediaLiveEdge(edge);
+}
+
 bool AbstractStream::getMediaAdvanceAmount(vlc_tick_t *duration) const
 {
     if(startTimeContext.media == VLC_TICK_INVALID)
@@ -35,6 +35,8 @@
 #include "SharedResources.hpp"
 #include "logic/BufferingLogic.hpp"
 #include "xml/DOMParser.h"
+#include "http/Downloader.hpp"
+#include "http/SegmentCache.hpp"
 
 #include "../dash/DASHManager.h"
 #include "../dash/DASHStream.hpp"
@@ -81,13 +83,25 @@ static void Close   (vlc_object_t *);
 #define ADAPT_ACCESS_TEXT N_("Use regular HTTP modules")
 #define ADAPT_ACCESS_LONGTEXT N_("Connect using HTTP access instead of custom HTTP code")
 
+#define ADAPT_DOWNLOADS_TEXT N_("Concurrent downloads")
+#define ADAPT_DOWNLOADS_LONGTEXT N_("Maximum number of segments downloaded at once")
+
 #define ADAPT_LOWLATENCY_TEXT N_("Low latency")
 #define ADAPT_LOWLATENCY_LONGTEXT N_("Overrides low latency parameters")
 
+#define ADAPT_CATCHUP_TEXT N_("Live latency catch-up")
+#define ADAPT_CATCHUP_LONGTEXT N_("Slightly changes the playback rate to hold " \
+                                  "the target latency of low latency live streams")
+
+#define ADAPT_CACHESIZE_TEXT N_("Shared segments cache (MiB)")
+#define ADAPT_CACHESIZE_LONGTEXT N_("Memory used to download only once the segments " \
+                                    "of streams played several times at once. 0 disables it")
+
 static const AbstractAdaptationLogic::LogicType pi_logics[] = {
                                 AbstractAdaptationLogic::LogicType::Default,
                                 AbstractAdaptationLogic::LogicType::Predictive,
                                 AbstractAdaptationLogic::LogicType::NearOptimal,
+                                AbstractAdaptationLogic::LogicType::Hybrid,
                                 AbstractAdaptationLogic::LogicType::RateBased,
                                 AbstractAdaptationLogic::LogicType::FixedRate,
                                 AbstractAdaptationLogic::LogicType::AlwaysLowest,
@@ -97,6 +111,7 @@ static const char *const ppsz_logics_values[] = {
                                 "",
                                 "predictive",
                                 "nearoptimal",
+                                "hybrid",
                                 "rate",
                                 "fixedrate",
                                 "lowest",
@@ -105,6 +120,7 @@ static const char *const ppsz_logics_values[] = {
 static const char *const ppsz_logics[] = { N_("Default"),
                                            N_("Predictive"),
                                            N_("Near Optimal"),
+                                           N_("Hybrid Bandwidth/Buffering"),
                                            N_("Bandwidth Adaptive"),
                                            N_("Fixed Bandwidth"),
                                            N_("Lowest Bandwidth/Quality"),
@@ -135,6 +151,8 @@ vlc_module_begin ()
                      ADAPT_HEIGHT_TEXT, nullptr )
         add_integer( "adaptive-bw",     250, ADAPT_BW_TEXT,     ADAPT_BW_LONGTEXT )
         add_bool   ( "adaptive-use-access", false, ADAPT_ACCESS_TEXT, ADAPT_ACCESS_LONGTEXT )
+        add_integer_with_range( "adaptive-downloads", 3, 1, Downloader::MAX_TRANSFERS,
+                                ADAPT_DOWNLOADS_TEXT, ADAPT_DOWNLOADS_LONGTEXT )
         add_integer( "adaptive-livedelay",
                      MS_FROM_VLC_TICK(AbstractBufferingLogic::DEFAULT_LIVE_BUFFERING),
                      ADAPT_BUFFER_TEXT, ADAPT_BUFFER_LONGTEXT )
@@ -143,6 +161,9 @@ vlc_module_begin ()
                      ADAPT_MAXBUFFER_TEXT, nullptr )
         add_integer( "adaptive-lowlatency", -1, ADAPT_LOWLATENCY_TEXT, ADAPT_LOWLATENCY_LONGTEXT )
             change_integer_list(rgi_latency, ppsz_latency)
+        add_bool   ( "adaptive-catchup", true, ADAPT_CATCHUP_TEXT, ADAPT_CATCHUP_LONGTEXT )
+        add_integer_with_range( "adaptive-cachesize", SegmentCache::DEFAULT_MAX_SIZE / (1024 * 1024),
+                                0, 1024, ADAPT_CACHESIZE_TEXT, ADAPT_CACHESIZE_LONGTEXT )
         set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -297,7 +318,8 @@ static PlaylistManager * HandleDash(demux_t *p_demux, DOMParser &xmlParser,
     }
 
     SharedResources *resources =
-            SharedResources::createDefault(VLC_OBJECT(p_demux), playlisturl);
+            SharedResources::createDefault(VLC_OBJECT(p_demux), playlisturl,
+                                           p_demux->b_preparsing);
     DASHStreamFactory *factory = new (std::nothrow) DASHStreamFactory;
     DASHManager *manager = nullptr;
     if(!resources || !factory ||
@@ -330,7 +352,8 @@ static PlaylistManager * HandleSmooth(demux_t *p_demux, DOMParser &xmlParser,
     }
 
     SharedResources *resources =
-            SharedResources::createDefault(VLC_OBJECT(p_demux), playlisturl);
+            SharedResources::createDefault(VLC_OBJECT(p_demux), playlisturl,
+                                           p_demux->b_preparsing);
     SmoothStreamFactory *factory = new (std::nothrow) SmoothStreamFactory;
     SmoothManager *manager = nullptr;
     if(!resources || !factory ||
@@ -349,7 +372,8 @@ static PlaylistManager * HandleHLS(demux_t *p_demux,
                                    AbstractAdaptationLogic::LogicType logic)
 {
     SharedResources *resources =
-            SharedResources::createDefault(VLC_OBJECT(p_demux), playlisturl);
+            SharedResources::createDefault(VLC_OBJECT(p_demux), playlisturl,
+                                           p_demux->b_preparsing);
     if(!resources)
         return nullptr;
 
@@ -29,15 +29,21 @@
 #include "HTTPConnection.hpp"
 #include "HTTPConnectionManager.h"
 #include "Downloader.hpp"
+#include "SegmentCache.hpp"
 
 #include <vlc_common.h>
 #include <vlc_block.h>
 
 #include <algorithm>
+#include <new>
 
 using namespace adaptive::http;
 using vlc::threads::mutex_locker;
 
+/* reads of low latency transfers waiting longer were waiting for the
+ * encoder to output the next part of the segment */
+#define IDLE_READ_TIME VLC_TICK_FROM_MS(100)
+
 static std::string EmptyStr = "";
 
 AbstractChunkSource::AbstractChunkSource(ChunkType t, const BytesRange &range)
@@ -262,7 +268,7 @@ void HTTPChunkSource::recycle()
 
 StorageID HTTPChunkSource::makeStorageID(const std::string &s, const BytesRange &r)
 {
-    return std::to_string(r.getStartByte())+ std::to_string(r.getEndByte()) + '@' + s;
+    return std::to_string(r.getStartByte()) + '-' + std::to_string(r.getEndByte()) + '@' + s;
 }
 
 const std::string & HTTPChunkSource::getContentType() const
@@ -345,6 +351,11 @@ HTTPChunkBufferedSource::HTTPChunkBufferedSource(const std::string& url, Abstrac
     held = false;
     p_read = nullptr;
     inblockreadoffset = 0;
+    segmentCache = nullptr;
+    cacheEntry = nullptr;
+    activeBytes = 0;
+    activeTime = 0;
+    lastReadTime = VLC_TICK_INVALID;
 }
 
 HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
@@ -365,6 +376,13 @@ HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
         pp_tail = &p_head;
     }
     buffered = 0;
+
+    if(cacheEntry)
+    {
+        /* cancelled before the end, others will have to fetch it */
+        segmentCache->finish(cacheEntry, false);
+        segmentCache->release(cacheEntry);
+    }
 }
 
 bool HTTPChunkBufferedSource::isDone() const
@@ -386,16 +404,60 @@ void HTTPChunkBufferedSource::release()
     avail.signal();
 }
 
+void HTTPChunkBufferedSource::setCacheEntry(SegmentCache *cache, SegmentCacheEntry *entry)
+{
+    segmentCache = cache;
+    cacheEntry = entry;
+}
+
+void HTTPChunkBufferedSource::publish(block_t *p_block, bool b_done, bool b_success)
+{
+    if(!cacheEntry)
+        return;
+
+    if(p_block)
+    {
+        block_t *p_copy = block_Duplicate(p_block);
+        if(!p_copy)
+        {
+            b_done = true;
+            b_success = false;
+        }
+        else
+        {
+            mutex_locker locker {lock};
+            segmentCache->append(cacheEntry, p_copy,
+                                 connection ? connection->getContentType() : EmptyStr);
+        }
+    }
+
+    if(b_done)
+    {
+        /* the other instances report their hits at the rate of this transfer */
+        vlc_tick_t time = 0;
+        if(b_success)
+        {
+            time = downloadEndTime - requestStartTime;
+            if(activeTime > 0)
+                time = activeTime * buffered / activeBytes;
+        }
+        segmentCache->finish(cacheEntry, b_success, time);
+        segmentCache->release(cacheEntry);
+        cacheEntry = nullptr;
+    }
+}
+
 void HTTPChunkBufferedSource::bufferize(size_t readsize)
 {
+    bool b_prepared;
     {
         mutex_locker locker {lock};
-        if(!prepare())
+        b_prepared = prepare();
+        if(!b_prepared)
         {
             done = true;
             eof = true;
             avail.signal();
-            return;
         }
 
         if(readsize < HTTPChunkSource::CHUNK_SIZE)
@@ -405,6 +467,12 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
             readsize = contentLength - buffered;
     }
 
+    if(!b_prepared)
+    {
+        publish(nullptr, true, false);
+        return;
+    }
+
     block_t *p_block = block_Alloc(readsize);
     if(!p_block)
     {
@@ -412,14 +480,31 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         return;
     }
 
-    struct
+    bool b_done = false;
+    bool b_complete = false;
+
+    /* Low latency segments are produced while being transferred:
+     * pass the data as soon as it is received, without waiting to fill
+     * the block */
+    const bool b_partial = type == ChunkType::Segment && connManager->isLowLatency();
+    const vlc_tick_t readStart = vlc_tick_now();
+    ssize_t ret = b_partial ? connection->readPartial(p_block->p_buffer, readsize)
+                            : connection->read(p_block->p_buffer, readsize);
+    if(b_partial && ret > 0)
     {
-        size_t size;
-        vlc_tick_t time;
-        vlc_tick_t latency;
-    } rate = {0,0,0};
+        /* The transfer pauses between the parts the encoder outputs.
+         * Only measure it while data is flowing, skipping the reads
+         * which waited for the next part. */
+        const vlc_tick_t readEnd = vlc_tick_now();
+        if(readEnd - readStart < IDLE_READ_TIME)
+        {
+            activeBytes += ret;
+            activeTime += readEnd - (lastReadTime != VLC_TICK_INVALID ? lastReadTime
+                                                                      : responseTime);
+        }
+        lastReadTime = readEnd;
+    }
 
-    ssize_t ret = connection->read(p_block->p_buffer, readsize);
     if(ret <= 0)
     {
         block_Release(p_block);
@@ -427,10 +512,9 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         mutex_locker locker {lock};
         done = true;
         downloadEndTime = vlc_tick_now();
-        rate.size = buffered;
-        rate.time = downloadEndTime - requestStartTime;
-        rate.latency = responseTime - requestStartTime;
         avail.signal();
+        b_done = true;
+        b_complete = ret == 0 && buffered && (!contentLength || buffered >= contentLength);
     }
     else
     {
@@ -443,21 +527,31 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
             p_read = p_block;
             inblockreadoffset = 0;
         }
-        if((size_t) ret < readsize)
+        if(b_partial ? (contentLength && buffered >= contentLength)
+                     : (size_t) ret < readsize)
         {
             done = true;
             downloadEndTime = vlc_tick_now();
-            rate.size = buffered;
-            rate.time = downloadEndTime - requestStartTime;
-            rate.latency = responseTime - requestStartTime;
+            b_done = b_complete = true;
         }
         avail.signal();
     }
 
-    if(rate.size && rate.time && type == ChunkType::Segment)
+    publish(p_block, b_done, b_complete);
+
+    if(b_done && type == ChunkType::Segment)
     {
-        connManager->updateDownloadRate(sourceid, rate.size,
-                                        rate.time, rate.latency);
+        /* only this thread updates the transfer */
+        size_t size = buffered;
+        vlc_tick_t time = downloadEndTime - requestStartTime;
+        if(b_partial && activeTime > 0)
+        {
+            size = activeBytes;
+            time = activeTime;
+        }
+        if(size && time)
+            connManager->updateDownloadRate(sourceid, size, time,
+                                            responseTime - requestStartTime);
     }
 }
 
@@ -542,6 +636,170 @@ block_t * HTTPChunkBufferedSource::read(size_t readsize)
     return p_block;
 }
 
+HTTPChunkCachedSource::HTTPChunkCachedSource(const std::string &url_, AbstractConnectionManager *manager,
+                                             const adaptive::ID &id, ChunkType type,
+                                             const BytesRange &range,
+                                             SegmentCache *cache, SegmentCacheEntry *entry) :
+    AbstractChunkSource(type, range),
+    url          (url_),
+    sourceid     (id),
+    connManager  (manager),
+    segmentCache (cache),
+    cacheEntry   (entry),
+    fallback     (nullptr),
+    consumed     (0),
+    eof          (false),
+    requestStartTime (VLC_TICK_INVALID),
+    responseTime (VLC_TICK_INVALID)
+{
+    storeid = HTTPChunkSource::makeStorageID(url, range);
+}
+
+HTTPChunkCachedSource::~HTTPChunkCachedSource()
+{
+    segmentCache->release(cacheEntry);
+}
+
+bool HTTPChunkCachedSource::startFallback()
+{
+    if(consumed == 0)
+    {
+        fallback = connManager->makeSource(url, sourceid, type, bytesRange);
+    }
+    else
+    {
+        /* resume after what was received, without publishing a partial segment */
+        size_t start = consumed;
+        size_t end = 0;
+        if(bytesRange.isValid())
+        {
+            start += bytesRange.getStartByte();
+            end = bytesRange.getEndByte();
+        }
+        fallback = new (std::nothrow) HTTPChunkBufferedSource(url, connManager, sourceid,
+                                                              type, BytesRange(start, end));
+    }
+    if(!fallback)
+        return false;
+    connManager->start(fallback);
+    return true;
+}
+
+block_t * HTTPChunkCachedSource::doRead(size_t readsize, bool b_partial)
+{
+    if(fallback)
+        return b_partial ? fallback->readBlock() : fallback->read(readsize);
+
+    if(eof || !readsize)
+        return nullptr;
+
+    block_t *p_block = block_Alloc(readsize);
+    if(!p_block)
+    {
+        eof = true;
+        return nullptr;
+    }
+
+    if(requestStartTime == VLC_TICK_INVALID)
+        requestStartTime = vlc_tick_now();
+
+    size_t copied = 0;
+    while(copied < readsize)
+    {
+        ssize_t ret = segmentCache->read(cacheEntry, consumed,
+                                         &p_block->p_buffer[copied], readsize - copied);
+        if(ret < 0)
+        {
+            /* the shared download was cancelled, failed or stalled, or this
+             * read was interrupted: pass what we have */
+            if(copied)
+                break;
+            /* then request the rest ourselves */
+            block_Release(p_block);
+            if(!startFallback())
+            {
+                eof = true;
+                requeststatus = RequestStatus::GenericError;
+                return nullptr;
+            }
+            return doRead(readsize, b_partial);
+        }
+        else if(ret == 0)
+        {
+            eof = true;
+            /* the segment went through the network once, at the owner's rate */
+            const vlc_tick_t time = segmentCache->getTransferTime(cacheEntry);
+            if(consumed && time > 0)
+                connManager->updateDownloadRate(sourceid, consumed, time,
+                                                responseTime - requestStartTime);
+            break;
+        }
+
+        if(responseTime == VLC_TICK_INVALID)
+            responseTime = vlc_tick_now();
+        if(contentType.empty())
+            contentType = segmentCache->getContentType(cacheEntry);
+        copied += ret;
+        consumed += ret;
+        if(b_partial)
+            break;
+    }
+
+    if(copied == 0)
+    {
+        block_Release(p_block);
+        return nullptr;
+    }
+
+    p_block->i_buffer = copied;
+    return p_block;
+}
+
+block_t * HTTPChunkCachedSource::readBlock()
+{
+    return doRead(HTTPChunkSource::CHUNK_SIZE, true);
+}
+
+block_t * HTTPChunkCachedSource::read(size_t readsize)
+{
+    return doRead(readsize, false);
+}
+
+bool HTTPChunkCachedSource::hasMoreData() const
+{
+    if(fallback)
+        return fallback->hasMoreData();
+    return !eof;
+}
+
+size_t HTTPChunkCachedSource::getBytesRead() const
+{
+    if(fallback)
+        return consumed + fallback->getBytesRead();
+    return consumed;
+}
+
+const std::string & HTTPChunkCachedSource::getContentType() const
+{
+    if(fallback)
+        return fallback->getContentType();
+    return contentType;
+}
+
+RequestStatus HTTPChunkCachedSource::getRequestStatus() const
+{
+    if(fallback)
+        return fallback->getRequestStatus();
+    return requeststatus;
+}
+
+void HTTPChunkCachedSource::recycle()
+{
+    if(fallback)
+        fallback->recycle();
+    delete this;
+}
+
 HTTPChunk::HTTPChunk(const std::string &url, AbstractConnectionManager *manager,
                      const adaptive::ID &id, ChunkType type, const BytesRange &range):
     AbstractChunk(manager->makeSource(url, id, type, range))
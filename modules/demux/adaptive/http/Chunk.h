@@ -43,6 +43,8 @@ namespace adaptive
         class AbstractConnection;
         class AbstractConnectionManager;
         class AbstractChunk;
+        class SegmentCache;
+        class SegmentCacheEntry;
 
         enum class ChunkType
         {
@@ -159,6 +161,7 @@ namespace adaptive
         {
             friend class HTTPConnectionManager;
             friend class Downloader;
+            friend class HTTPChunkCachedSource;
 
             public:
                 virtual ~HTTPChunkBufferedSource();
@@ -166,17 +169,21 @@ namespace adaptive
                 block_t *  read            (size_t)  override;
                 bool       hasMoreData     () const  override;
                 void        recycle() override;
+                bool               isDone() const;
 
             protected:
                 HTTPChunkBufferedSource(const std::string &url, AbstractConnectionManager *,
                                         const ID &, ChunkType, const BytesRange &,
                                         bool = false);
                 void               bufferize(size_t);
-                bool               isDone() const;
                 void               hold();
                 void               release();
+                void               setCacheEntry(SegmentCache *, SegmentCacheEntry *);
 
             private:
+                void               publish(block_t *, bool, bool);
+                SegmentCache       *segmentCache;
+                SegmentCacheEntry  *cacheEntry;
                 block_t            *p_head; /* read cache buffer */
                 block_t           **pp_tail;
                 const block_t      *p_read;
@@ -186,6 +193,48 @@ namespace adaptive
                 bool                eof;
                 vlc::threads::condition_variable avail;
                 bool                held;
+                /* low latency transfers, while data is flowing */
+                size_t              activeBytes;
+                vlc_tick_t          activeTime;
+                vlc_tick_t          lastReadTime;
+        };
+
+        /* Reads the data of a segment from the process wide cache,
+         * possibly while it is downloaded by another instance */
+        class HTTPChunkCachedSource : public AbstractChunkSource
+        {
+            friend class HTTPConnectionManager;
+
+            public:
+                virtual ~HTTPChunkCachedSource();
+
+                block_t *   readBlock       ()  override;
+                block_t *   read            (size_t)  override;
+                bool        hasMoreData     () const  override;
+                size_t      getBytesRead    () const  override;
+                const std::string & getContentType() const override;
+                RequestStatus getRequestStatus() const override;
+                void        recycle() override;
+
+            protected:
+                HTTPChunkCachedSource(const std::string &url, AbstractConnectionManager *,
+                                      const ID &, ChunkType, const BytesRange &,
+                                      SegmentCache *, SegmentCacheEntry *);
+
+            private:
+                block_t *           doRead(size_t, bool);
+                bool                startFallback();
+                std::string         url;
+                ID                  sourceid;
+                AbstractConnectionManager *connManager;
+                SegmentCache       *segmentCache;
+                SegmentCacheEntry  *cacheEntry;
+                AbstractChunkSource *fallback; /* if the shared download failed */
+                std::string         contentType;
+                size_t              consumed; /* from the cache, before any fallback */
+                bool                eof;
+                vlc_tick_t          requestStartTime;
+                vlc_tick_t          responseTime;
         };
 
         class HTTPChunk : public AbstractChunk
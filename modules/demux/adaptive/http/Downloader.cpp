@@ -25,42 +25,59 @@
 
 #include <vlc_threads.h>
 
-#include <atomic>
+#include <algorithm>
+#include <new>
 
 using namespace adaptive::http;
 
-Downloader::Downloader()
+Downloader::Worker::Worker(Downloader *owner_)
 {
-    killed = false;
-    thread_handle_valid = false;
+    owner = owner_;
     current = nullptr;
     cancel_current = false;
 }
 
+Downloader::Downloader(unsigned transfers_)
+{
+    killed = false;
+    transfers = std::max(1U, std::min(transfers_, MAX_TRANSFERS));
+}
+
 bool Downloader::start()
 {
-    if(!thread_handle_valid &&
-       vlc_clone(&thread_handle, downloaderThread, static_cast<void *>(this)))
+    while(workers.size() < transfers)
     {
-        return false;
+        Worker *worker = new (std::nothrow) Worker(this);
+        if(!worker)
+            break;
+        if(vlc_clone(&worker->thread_handle, downloaderThread,
+                     static_cast<void *>(worker)))
+        {
+            delete worker;
+            break;
+        }
+        vlc::threads::mutex_locker locker {lock};
+        workers.push_back(worker);
     }
-    thread_handle_valid = true;
-    return true;
+    return !workers.empty();
 }
 
 Downloader::~Downloader()
 {
     kill();
 
-    if(thread_handle_valid)
-        vlc_join(thread_handle, nullptr);
+    for(Worker *worker : workers)
+    {
+        vlc_join(worker->thread_handle, nullptr);
+        delete worker;
+    }
 }
 
 void Downloader::kill()
 {
     vlc::threads::mutex_locker locker {lock};
     killed = true;
-    wait_cond.signal();
+    wait_cond.broadcast();
 }
 
 void Downloader::schedule(HTTPChunkBufferedSource *source)
@@ -74,9 +91,15 @@ void Downloader::schedule(HTTPChunkBufferedSource *source)
 void Downloader::cancel(HTTPChunkBufferedSource *source)
 {
     vlc::threads::mutex_locker locker {lock};
-    while (current == source)
+    for(;;)
     {
-        cancel_current = true;
+        Worker *serving = nullptr;
+        for(Worker *worker : workers)
+            if(worker->current == source)
+                serving = worker;
+        if(!serving)
+            break;
+        serving->cancel_current = true;
         updated_cond.wait(lock);
     }
 
@@ -87,41 +110,84 @@ void Downloader::cancel(HTTPChunkBufferedSource *source)
     }
 }
 
+void Downloader::setBufferLevel(const ID &id, vlc_tick_t level)
+{
+    vlc::threads::mutex_locker locker {lock};
+    levels[id] = level;
+}
+
+bool Downloader::isActive(const HTTPChunkBufferedSource *source) const
+{
+    for(const Worker *worker : workers)
+        if(worker->current == source)
+            return true;
+    return false;
+}
+
+HTTPChunkBufferedSource * Downloader::pick() const
+{
+    /* count the transfers in progress per stream */
+    std::map<ID, unsigned> active;
+    for(const Worker *worker : workers)
+        if(worker->current)
+            active[worker->current->sourceid]++;
+
+    HTTPChunkBufferedSource *best = nullptr;
+    unsigned bestactive = 0;
+    vlc_tick_t bestlevel = 0;
+    for(HTTPChunkBufferedSource *source : chunks)
+    {
+        if(isActive(source))
+            continue;
+        auto itactive = active.find(source->sourceid);
+        const unsigned count = itactive != active.end() ? itactive->second : 0;
+        auto itlevel = levels.find(source->sourceid);
+        const vlc_tick_t level = itlevel != levels.end() ? itlevel->second : 0;
+        /* queue order breaks ties, and keeps each stream's sequence */
+        if(!best || count < bestactive ||
+           (count == bestactive && level < bestlevel))
+        {
+            best = source;
+            bestactive = count;
+            bestlevel = level;
+        }
+    }
+    return best;
+}
+
 void * Downloader::downloaderThread(void *opaque)
 {
     vlc_thread_set_name("vlc-adapt-dl");
-    Downloader *instance = static_cast<Downloader *>(opaque);
-    instance->Run();
+    Worker *worker = static_cast<Worker *>(opaque);
+    worker->owner->Run(worker);
     return nullptr;
 }
 
-void Downloader::Run()
+void Downloader::Run(Worker *worker)
 {
-    while(1)
+    vlc::threads::mutex_locker locker {lock};
+    for(;;)
     {
-        lock.lock();
-
-        while(chunks.empty() && !killed)
+        HTTPChunkBufferedSource *source = nullptr;
+        while(!killed && !(source = pick()))
             wait_cond.wait(lock);
 
         if(killed)
-        {
-            lock.unlock();
             break;
-        }
 
-        current = chunks.front();
+        worker->current = source;
         lock.unlock();
-        current->bufferize(HTTPChunkSource::CHUNK_SIZE);
+        source->bufferize(HTTPChunkSource::CHUNK_SIZE);
         lock.lock();
-        if(current->isDone() || cancel_current)
+        if(source->isDone() || worker->cancel_current)
         {
-            chunks.pop_front();
-            current->release();
+            chunks.remove(source);
+            source->release();
         }
-        cancel_current = false;
-        current = nullptr;
-        updated_cond.signal();
-        lock.unlock();
+        worker->cancel_current = false;
+        worker->current = nullptr;
+        updated_cond.broadcast();
+        /* the stream may have another source an idle worker can serve */
+        wait_cond.signal();
     }
 }
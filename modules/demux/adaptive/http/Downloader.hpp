@@ -21,11 +21,14 @@
 #define DOWNLOADER_HPP
 
 #include "Chunk.h"
+#include "../ID.hpp"
 
 #include <vlc_common.h>
 #include <vlc_threads.h>
 #include <vlc_cxx_helpers.hpp>
 #include <list>
+#include <map>
+#include <vector>
 
 namespace adaptive
 {
@@ -33,28 +36,44 @@ namespace adaptive
     namespace http
     {
 
+        /* Pool of threads serving the scheduled sources by steps of
+         * CHUNK_SIZE. Each step goes to the stream with the fewest transfers
+         * in progress, then to the one with the lowest buffer level. */
         class Downloader
         {
             public:
-                Downloader();
+                Downloader(unsigned = 1);
                 ~Downloader();
                 bool start();
                 void schedule(HTTPChunkBufferedSource *);
                 void cancel(HTTPChunkBufferedSource *);
+                void setBufferLevel(const ID &, vlc_tick_t);
+
+                static const unsigned MAX_TRANSFERS = 8;
 
             private:
+                class Worker
+                {
+                    public:
+                        Worker(Downloader *);
+                        Downloader *owner;
+                        vlc_thread_t thread_handle;
+                        HTTPChunkBufferedSource *current;
+                        bool cancel_current;
+                };
                 static void * downloaderThread(void *);
-                void Run();
+                void Run(Worker *);
                 void kill();
-                vlc_thread_t thread_handle;
+                bool isActive(const HTTPChunkBufferedSource *) const;
+                HTTPChunkBufferedSource * pick() const;
                 vlc::threads::mutex lock;
                 vlc::threads::condition_variable wait_cond;
                 vlc::threads::condition_variable updated_cond;
-                bool         thread_handle_valid;
+                unsigned     transfers;
                 bool         killed;
-                bool         cancel_current;
+                std::vector<Worker *> workers;
                 std::list<HTTPChunkBufferedSource *> chunks;
-                HTTPChunkBufferedSource *current;
+                std::map<ID, vlc_tick_t> levels;
         };
 
     }
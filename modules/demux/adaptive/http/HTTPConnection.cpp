@@ -63,6 +63,11 @@ bool AbstractConnection::prepare(const ConnectionParams &params_)
     return true;
 }
 
+ssize_t AbstractConnection::readPartial(void *p_buffer, size_t len)
+{
+    return read(p_buffer, len);
+}
+
 size_t AbstractConnection::getContentLength() const
 {
     return contentLength;
@@ -424,6 +429,13 @@ ssize_t LibVLCHTTPConnection::read(void *p_buffer, size_t len)
     return read;
 }
 
+ssize_t LibVLCHTTPConnection::readPartial(void *p_buffer, size_t len)
+{
+    ssize_t read = vlc_stream_ReadPartial(stream, p_buffer, len);
+    bytesRead = source->totalRead;
+    return read;
+}
+
 void LibVLCHTTPConnection::setUsed( bool b )
 {
     available = !b;
@@ -539,6 +551,32 @@ ssize_t StreamUrlConnection::read(void *p_buffer, size_t len)
     return ret;
 }
 
+ssize_t StreamUrlConnection::readPartial(void *p_buffer, size_t len)
+{
+    if( !p_streamurl )
+        return VLC_EGENERIC;
+
+    if(len == 0)
+        return VLC_SUCCESS;
+
+    const size_t toRead = (contentLength) ? contentLength - bytesRead : len;
+    if (toRead == 0)
+        return VLC_SUCCESS;
+
+    if(len > toRead)
+        len = toRead;
+
+    ssize_t ret = vlc_stream_ReadPartial(p_streamurl, p_buffer, len);
+    if(ret > 0)
+        bytesRead += ret;
+
+    /* a short read is not the end of a chunked transfer */
+    if(ret <= 0 || contentLength == bytesRead)
+        reset();
+
+    return ret;
+}
+
 void StreamUrlConnection::setUsed( bool b )
 {
     available = !b;
@@ -29,19 +29,27 @@
 #include "HTTPConnection.hpp"
 #include "ConnectionParams.hpp"
 #include "Downloader.hpp"
+#include "SegmentCache.hpp"
 #include "../tools/Debug.hpp"
 #include <vlc_url.h>
 #include <vlc_http.h>
 
+#include <algorithm>
 #include <cassert>
 
 using namespace adaptive::http;
 
+#define RATE_WINDOW VLC_TICK_FROM_SEC(10)
+
 AbstractConnectionManager::AbstractConnectionManager(vlc_object_t *p_object_)
     : IDownloadRateObserver()
 {
     p_object = p_object_;
+    b_lowlatency = false;
     rateObserver = nullptr;
+    vlc_mutex_init(&rateLock);
+    rateStart = rateEnd = VLC_TICK_INVALID;
+    rateBytes = 0;
 }
 
 AbstractConnectionManager::~AbstractConnectionManager()
@@ -52,6 +60,39 @@ AbstractConnectionManager::~AbstractConnectionManager()
 void AbstractConnectionManager::updateDownloadRate(const adaptive::ID &sourceid, size_t size,
                                                    vlc_tick_t time, vlc_tick_t latency)
 {
+    /* Transfers run in parallel and report from their own thread, sharing
+     * the bandwidth. Report each one at the throughput of the transfers it
+     * overlaps: their bytes over the wall time of their union. */
+    vlc_mutex_locker locker(&rateLock);
+    const vlc_tick_t now = vlc_tick_now();
+    const vlc_tick_t start = time > 0 ? now - time : now;
+    if(rateEnd == VLC_TICK_INVALID || start > rateEnd)
+    {
+        /* bytes of instant transfers are not reported yet, keep them */
+        if(rateEnd > rateStart)
+            rateBytes = 0;
+        rateStart = start;
+    }
+    else
+    {
+        rateStart = std::min(rateStart, start);
+        /* forget the beginning of long lasting overlaps, as if it was
+         * received at a steady rate */
+        const vlc_tick_t from = now - std::max(time, RATE_WINDOW);
+        if(from > rateStart)
+        {
+            rateBytes = (uint64_t) rateBytes * (rateEnd - from) / (rateEnd - rateStart);
+            rateStart = from;
+        }
+    }
+    rateEnd = now;
+    rateBytes += size;
+    if(rateEnd <= rateStart || size == 0)
+        return; /* reported with the next overlapping transfer */
+    time = (rateEnd - rateStart) * size / rateBytes;
+    if(time <= 0)
+        time = 1;
+
     if(rateObserver)
     {
         BwDebug(msg_Dbg(p_object,
@@ -67,6 +108,16 @@ void AbstractConnectionManager::setDownloadRateObserver(IDownloadRateObserver *o
     rateObserver = obs;
 }
 
+void AbstractConnectionManager::setLowLatency(bool b)
+{
+    b_lowlatency = b;
+}
+
+bool AbstractConnectionManager::isLowLatency() const
+{
+    return b_lowlatency;
+}
+
 void AbstractConnectionManager::deleteSource(AbstractChunkSource *source)
 {
     delete source;
@@ -77,12 +128,13 @@ HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_)
       localAllowed(false)
 {
     vlc_mutex_init(&lock);
-    downloader = new Downloader();
+    downloader = new Downloader(var_InheritInteger(p_object, "adaptive-downloads"));
     downloaderhp = new Downloader();
     downloader->start();
     downloaderhp->start();
     cache_total = 0;
     cache_max = 1 << 19;
+    segmentCache = nullptr;
 }
 
 HTTPConnectionManager::~HTTPConnectionManager   ()
@@ -189,13 +241,38 @@ AbstractChunkSource *HTTPConnectionManager::makeSource(const std::string &url,
                     return s;
                 }
             }
-            // fallthrough
+            break;
         case ChunkType::Segment:
+            /* only worth it when another instance plays the same playlist */
+            if(segmentCache && segmentCache->isShared(segmentCacheKey))
+            {
+                bool b_new;
+                size_t expected = range.isValid() && range.getEndByte()
+                                ? range.getEndByte() - range.getStartByte() : 0;
+                SegmentCacheEntry *entry = segmentCache->get(storageid, expected, &b_new);
+                if(entry && !b_new)
+                {
+                    CacheDebug(msg_Dbg(p_object, "Shared cache HIT '%s'", storageid.c_str()));
+                    return new HTTPChunkCachedSource(url, this, id, type, range,
+                                                     segmentCache, entry);
+                }
+                else if(entry)
+                {
+                    CacheDebug(msg_Dbg(p_object, "Shared cache MISS '%s'", storageid.c_str()));
+                    HTTPChunkBufferedSource *source =
+                            new HTTPChunkBufferedSource(url, this, id, type, range);
+                    source->setCacheEntry(segmentCache, entry);
+                    return source;
+                }
+            }
+            break;
         case ChunkType::Key:
         case ChunkType::Playlist:
         default:
-            return new HTTPChunkBufferedSource(url, this, id, type, range);
+            break;
     }
+
+    return new HTTPChunkBufferedSource(url, this, id, type, range);
 }
 
 void HTTPConnectionManager::recycleSource(AbstractChunkSource *source)
@@ -267,6 +344,11 @@ void HTTPConnectionManager::cancel(AbstractChunkSource *source)
         getDownloadQueue(src)->cancel(src);
 }
 
+void HTTPConnectionManager::updateBufferLevel(const ID &id, vlc_tick_t level)
+{
+    downloader->setBufferLevel(id, level);
+}
+
 void HTTPConnectionManager::setLocalConnectionsAllowed()
 {
     localAllowed = true;
@@ -276,3 +358,9 @@ void HTTPConnectionManager::addFactory(AbstractConnectionFactory *factory)
 {
     factories.push_back(factory);
 }
+
+void HTTPConnectionManager::setSegmentCache(SegmentCache *c, const std::string &key)
+{
+    segmentCache = c;
+    segmentCacheKey = key;
+}
@@ -45,6 +45,7 @@ namespace adaptive
         class Downloader;
         class AbstractChunkSource;
         class HTTPChunkBufferedSource;
+        class SegmentCache;
         enum class ChunkType;
 
         class AbstractConnectionManager : public IDownloadRateObserver
@@ -65,13 +66,22 @@ namespace adaptive
                 virtual void updateDownloadRate(const ID &, size_t,
                                                 vlc_tick_t, vlc_tick_t) override;
                 void setDownloadRateObserver(IDownloadRateObserver *);
+                virtual void updateBufferLevel(const ID &, vlc_tick_t) {}
+                void setLowLatency(bool);
+                bool isLowLatency() const;
 
             protected:
                 void deleteSource(AbstractChunkSource *);
                 vlc_object_t                                       *p_object;
 
             private:
+                bool                                                b_lowlatency;
                 IDownloadRateObserver                              *rateObserver;
+                vlc_mutex_t                                         rateLock;
+                /* union of the overlapping transfers reported last */
+                vlc_tick_t                                          rateStart;
+                vlc_tick_t                                          rateEnd;
+                size_t                                              rateBytes;
         };
 
         class HTTPConnectionManager : public AbstractConnectionManager
@@ -89,8 +99,10 @@ namespace adaptive
 
                 void start(AbstractChunkSource *)  override;
                 void cancel(AbstractChunkSource *)  override;
+                void updateBufferLevel(const ID &, vlc_tick_t) override;
                 void         setLocalConnectionsAllowed();
                 void         addFactory(AbstractConnectionFactory *);
+                void         setSegmentCache(SegmentCache *, const std::string &);
 
             private:
                 void    releaseAllConnections ();
@@ -105,6 +117,8 @@ namespace adaptive
                 std::list<HTTPChunkBufferedSource *> cache;
                 size_t cache_total;
                 size_t cache_max;
+                SegmentCache *segmentCache;
+                std::string segmentCacheKey;
         };
     }
 }
@@ -0,0 +1,301 @@
+/*
+ * SegmentCache.cpp
+ *****************************************************************************
+ * Copyright (C) 2025 - VideoLAN and VLC authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "SegmentCache.hpp"
+
+#include <vlc_block.h>
+#include <vlc_interrupt.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <new>
+
+using namespace adaptive::http;
+using vlc::threads::mutex_locker;
+
+namespace adaptive
+{
+    namespace http
+    {
+        class SegmentCacheEntry
+        {
+            friend class SegmentCache;
+
+            private:
+                enum class State
+                {
+                    Pending,
+                    Complete,
+                    Failed,
+                };
+
+                SegmentCacheEntry(const StorageID &id_)
+                    : id(id_), p_head(nullptr), pp_tail(&p_head), size(0),
+                      state(State::Pending), time(0), refs(1), listed(false) {}
+                ~SegmentCacheEntry()
+                {
+                    block_ChainRelease(p_head);
+                }
+
+                StorageID id;
+                block_t *p_head;
+                block_t **pp_tail;
+                size_t size;
+                std::string contentType;
+                State state;
+                vlc_tick_t time;
+                unsigned refs;
+                bool listed;
+                std::list<SegmentCacheEntry *>::iterator lruit;
+        };
+    }
+}
+
+static vlc::threads::mutex instanceLock;
+SegmentCache * SegmentCache::instance = nullptr;
+
+SegmentCache::SegmentCache(size_t max_)
+{
+    total = 0;
+    max = max_;
+}
+
+SegmentCache::~SegmentCache()
+{
+    while(!lru.empty())
+        unlist(lru.front());
+}
+
+SegmentCache * SegmentCache::acquire(size_t max, const std::string &playlisturl)
+{
+    if(max == 0)
+        return nullptr;
+
+    mutex_locker locker {instanceLock};
+    if(instance == nullptr)
+        instance = new (std::nothrow) SegmentCache(max);
+    if(instance)
+    {
+        mutex_locker locker2 {instance->lock};
+        instance->max = std::max(instance->max, max);
+        instance->users[playlisturl]++;
+    }
+    return instance;
+}
+
+void SegmentCache::release(const std::string &playlisturl)
+{
+    mutex_locker locker {instanceLock};
+    {
+        mutex_locker locker2 {lock};
+        auto it = users.find(playlisturl);
+        assert(it != users.end());
+        if(--(*it).second == 0)
+            users.erase(it);
+        if(!users.empty())
+            return;
+    }
+    assert(instance == this);
+    instance = nullptr;
+    delete this;
+}
+
+bool SegmentCache::isShared(const std::string &playlisturl) const
+{
+    mutex_locker locker {lock};
+    auto it = users.find(playlisturl);
+    return it != users.end() && (*it).second > 1;
+}
+
+SegmentCacheEntry * SegmentCache::get(const StorageID &id, size_t expected, bool *pb_new)
+{
+    mutex_locker locker {lock};
+
+    auto it = entries.find(id);
+    if(it != entries.end())
+    {
+        SegmentCacheEntry *entry = (*it).second;
+        lru.splice(lru.begin(), lru, entry->lruit);
+        entry->refs++;
+        *pb_new = false;
+        return entry;
+    }
+
+    /* would evict too much, or everything */
+    if(expected > max / 4)
+        return nullptr;
+
+    SegmentCacheEntry *entry = new (std::nothrow) SegmentCacheEntry(id);
+    if(entry)
+    {
+        entries.insert(std::make_pair(id, entry));
+        entry->lruit = lru.insert(lru.begin(), entry);
+        entry->listed = true;
+        entry->refs++; /* the cache's own */
+        *pb_new = true;
+    }
+    return entry;
+}
+
+void SegmentCache::release(SegmentCacheEntry *entry)
+{
+    mutex_locker locker {lock};
+    assert(entry->refs > 0);
+    if(--entry->refs == 0)
+        delete entry;
+}
+
+void SegmentCache::unlist(SegmentCacheEntry *entry)
+{
+    assert(entry->listed);
+    entries.erase(entry->id);
+    lru.erase(entry->lruit);
+    entry->listed = false;
+    assert(total >= entry->size);
+    total -= entry->size;
+    if(--entry->refs == 0)
+        delete entry;
+}
+
+void SegmentCache::evict()
+{
+    auto it = lru.end();
+    while(total > max && it != lru.begin())
+    {
+        SegmentCacheEntry *entry = *(--it);
+        /* keep the in flight ones for coalescing */
+        if(entry->state == SegmentCacheEntry::State::Pending)
+            continue;
+        it = lru.erase(it);
+        entries.erase(entry->id);
+        entry->listed = false;
+        assert(total >= entry->size);
+        total -= entry->size;
+        if(--entry->refs == 0)
+            delete entry;
+    }
+}
+
+void SegmentCache::append(SegmentCacheEntry *entry, block_t *p_block,
+                          const std::string &contentType)
+{
+    mutex_locker locker {lock};
+    if(entry->contentType.empty())
+        entry->contentType = contentType;
+    entry->size += p_block->i_buffer;
+    block_ChainLastAppend(&entry->pp_tail, p_block);
+    if(entry->listed)
+    {
+        total += p_block->i_buffer;
+        /* turned out too large, readers already along still get it */
+        if(entry->size > max / 4)
+            unlist(entry);
+        else
+            evict();
+    }
+    avail.broadcast();
+}
+
+void SegmentCache::finish(SegmentCacheEntry *entry, bool b_success, vlc_tick_t time)
+{
+    mutex_locker locker {lock};
+    entry->state = b_success ? SegmentCacheEntry::State::Complete
+                             : SegmentCacheEntry::State::Failed;
+    entry->time = time;
+    /* must be requested again */
+    if(!b_success && entry->listed)
+        unlist(entry);
+    avail.broadcast();
+}
+
+struct SegmentCache::Waiter
+{
+    SegmentCache *cache;
+    bool interrupted;
+};
+
+void SegmentCache::interrupted(void *data)
+{
+    Waiter *waiter = static_cast<Waiter *>(data);
+    mutex_locker locker {waiter->cache->lock};
+    waiter->interrupted = true;
+    waiter->cache->avail.broadcast();
+}
+
+ssize_t SegmentCache::read(SegmentCacheEntry *entry, size_t offset,
+                           uint8_t *p_buf, size_t len, vlc_tick_t timeout)
+{
+    /* the owner transfer can stall, or this reader be closed. The
+     * interrupt callback locks too: (un)register without the lock held */
+    const vlc_tick_t deadline = vlc_tick_now() + timeout;
+    Waiter waiter = { this, false };
+    bool b_stalled = false;
+    vlc_interrupt_register(interrupted, &waiter);
+    {
+        mutex_locker locker {lock};
+        while(offset >= entry->size && entry->state == SegmentCacheEntry::State::Pending)
+        {
+            if(waiter.interrupted || avail.timedwait(lock, deadline))
+            {
+                b_stalled = true;
+                break;
+            }
+        }
+    }
+    vlc_interrupt_unregister();
+
+    mutex_locker locker {lock};
+    /* what was received before the failure is still valid */
+    if(offset >= entry->size &&
+       (entry->state == SegmentCacheEntry::State::Failed ||
+        (b_stalled && entry->state == SegmentCacheEntry::State::Pending)))
+        return -1;
+
+    size_t copied = 0;
+    for(const block_t *p = entry->p_head; p && copied < len; p = p->p_next)
+    {
+        if(offset >= p->i_buffer)
+        {
+            offset -= p->i_buffer;
+            continue;
+        }
+        const size_t tocopy = std::min(p->i_buffer - offset, len - copied);
+        memcpy(&p_buf[copied], &p->p_buffer[offset], tocopy);
+        copied += tocopy;
+        offset = 0;
+    }
+    return copied;
+}
+
+std::string SegmentCache::getContentType(SegmentCacheEntry *entry) const
+{
+    mutex_locker locker {lock};
+    return entry->contentType;
+}
+
+vlc_tick_t SegmentCache::getTransferTime(SegmentCacheEntry *entry) const
+{
+    mutex_locker locker {lock};
+    return entry->time;
+}
@@ -0,0 +1,96 @@
+/*
+ * SegmentCache.hpp
+ *****************************************************************************
+ * Copyright (C) 2025 - VideoLAN and VLC authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef SEGMENTCACHE_HPP
+#define SEGMENTCACHE_HPP
+
+#include <vlc_common.h>
+#include <vlc_threads.h>
+#include <vlc_cxx_helpers.hpp>
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+namespace adaptive
+{
+    namespace http
+    {
+        using StorageID = std::string;
+
+        class SegmentCacheEntry;
+
+        /* Segments data shared by all the adaptive instances of the process,
+         * so that players of the same stream only download it once.
+         * Entries are published while being downloaded: a request for
+         * a segment already in flight reads along with the first one. */
+        class SegmentCache
+        {
+            public:
+                /* held per playlist url */
+                static SegmentCache * acquire(size_t, const std::string &);
+                void release(const std::string &);
+                /* only worth the copies if several instances play that playlist */
+                bool isShared(const std::string &) const;
+
+                /* returns a held entry, or nullptr if not cacheable. *pb_new
+                 * is set if the entry is new and has to be filled by the caller */
+                SegmentCacheEntry * get(const StorageID &, size_t, bool *pb_new);
+                void release(SegmentCacheEntry *);
+
+                /* filling, takes the block ownership */
+                void append(SegmentCacheEntry *, block_t *, const std::string &);
+                /* with the transfer time of a complete entry */
+                void finish(SegmentCacheEntry *, bool, vlc_tick_t = 0);
+
+                /* returns the amount read at that offset, waiting for data if needed,
+                 * 0 at the end of the entry, and -1 past the data received before
+                 * its download failed, or if no data came within the timeout or
+                 * the calling thread was interrupted */
+                ssize_t read(SegmentCacheEntry *, size_t, uint8_t *, size_t,
+                             vlc_tick_t = STALL_TIMEOUT);
+                std::string getContentType(SegmentCacheEntry *) const;
+                vlc_tick_t getTransferTime(SegmentCacheEntry *) const;
+
+                static const size_t DEFAULT_MAX_SIZE = 64 * 1024 * 1024;
+                /* how long a reader waits for the owner's next data */
+                static constexpr vlc_tick_t STALL_TIMEOUT = VLC_TICK_FROM_SEC(10);
+
+            private:
+                SegmentCache(size_t);
+                ~SegmentCache();
+                void unlist(SegmentCacheEntry *);
+                void evict();
+                struct Waiter;
+                static void interrupted(void *);
+
+                mutable vlc::threads::mutex lock;
+                vlc::threads::condition_variable avail;
+                std::unordered_map<StorageID, SegmentCacheEntry *> entries;
+                std::list<SegmentCacheEntry *> lru; /* most recent first */
+                size_t total;
+                size_t max;
+                std::unordered_map<std::string, unsigned> users;
+
+                static SegmentCache *instance;
+        };
+    }
+}
+
+#endif // SEGMENTCACHE_HPP
@@ -99,6 +99,43 @@ uint64_t DefaultBufferingLogic::getStartSegmentNumber(BaseRepresentation *rep) c
     return num;
 }
 
+bool DefaultBufferingLogic::getStartPart(BaseRepresentation *rep,
+                                         uint64_t *number, size_t *part) const
+{
+    BasePlaylist *playlist = rep->getPlaylist();
+    const SegmentList *segmentList = rep->inheritSegmentList();
+    if(!playlist->isLive() || !segmentList)
+        return false;
+
+    const std::vector<Segment *> &list = segmentList->getSegments();
+    if(list.empty() || list.back()->getParts().empty())
+        return false;
+
+    /* Walk back the parts from the live edge until we have the live delay,
+     * then start on the closest independent one */
+    const Timescale timescale = segmentList->inheritTimescale();
+    const stime_t delay = timescale.ToScaled(getLiveDelay(playlist));
+    stime_t buffered = 0;
+    for(auto it = list.crbegin(); it != list.crend(); ++it)
+    {
+        const std::vector<Segment *> &parts = (*it)->getParts();
+        if(parts.empty())
+            break;
+        for(size_t i = parts.size(); i > 0; i--)
+        {
+            buffered += parts[i - 1]->duration.Get();
+            if(buffered >= delay && parts[i - 1]->independent)
+            {
+                *number = (*it)->getSequenceNumber();
+                *part = i - 1;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 vlc_tick_t DefaultBufferingLogic::getMinBuffering(const BasePlaylist *p) const
 {
     if(isLowLatency(p))
@@ -128,10 +165,16 @@ vlc_tick_t DefaultBufferingLogic::getMaxBuffering(const BasePlaylist *p) const
 vlc_tick_t DefaultBufferingLogic::getLiveDelay(const BasePlaylist *p) const
 {
     if(isLowLatency(p))
-        return getMinBuffering(p);
+    {
+        vlc_tick_t delay = p->targetLatency.Get() ? p->targetLatency.Get()
+                                                  : p->suggestedPresentationDelay.Get();
+        return std::max(delay, getMinBuffering(p));
+    }
     vlc_tick_t delay = userLiveDelay ? userLiveDelay
                                      : DEFAULT_LIVE_BUFFERING;
-    if(p->suggestedPresentationDelay.Get())
+    if(p->targetLatency.Get())
+        delay = p->targetLatency.Get();
+    else if(p->suggestedPresentationDelay.Get())
         delay = p->suggestedPresentationDelay.Get();
     else if(p->presentationStartOffset.Get())
         delay = p->presentationStartOffset.Get();
@@ -239,8 +282,10 @@ uint64_t DefaultBufferingLogic::getLiveStartSegmentNumber(BaseRepresentation *re
         stime_t scaledduration = mediaSegmentTemplate->inheritDuration();
         if(scaledduration)
         {
-            /* Compute playback offset and effective finished segment from wall time */
+            /* Compute playback offset and effective finished segment from wall time,
+               segments being available early when delivered in chunks */
             vlc_tick_t now = vlc_tick_from_sec(time(nullptr));
+            now += mediaSegmentTemplate->inheritAvailabilityTimeOffset();
             vlc_tick_t playbacktime = now - i_buffering;
             vlc_tick_t minavailtime = playlist->availabilityStartTime.Get() + rep->getPeriodStart();
             const uint64_t startnumber = mediaSegmentTemplate->inheritStartNumber();
@@ -44,10 +44,12 @@ namespace adaptive
                 virtual ~AbstractBufferingLogic() {}
 
                 virtual uint64_t getStartSegmentNumber(BaseRepresentation *) const = 0;
+                virtual bool getStartPart(BaseRepresentation *, uint64_t *, size_t *) const = 0;
                 virtual vlc_tick_t getMinBuffering(const BasePlaylist *) const = 0;
                 virtual vlc_tick_t getMaxBuffering(const BasePlaylist *) const = 0;
                 virtual vlc_tick_t getLiveDelay(const BasePlaylist *) const = 0;
                 virtual vlc_tick_t getStableBuffering(const BasePlaylist *) const = 0;
+                virtual bool isLowLatency(const BasePlaylist *) const = 0;
                 void setUserMinBuffering(vlc_tick_t);
                 void setUserMaxBuffering(vlc_tick_t);
                 void setUserLiveDelay(vlc_tick_t);
@@ -70,17 +72,18 @@ namespace adaptive
                 DefaultBufferingLogic();
                 virtual ~DefaultBufferingLogic() {}
                 uint64_t getStartSegmentNumber(BaseRepresentation *) const override;
+                bool getStartPart(BaseRepresentation *, uint64_t *, size_t *) const override;
                 vlc_tick_t getMinBuffering(const BasePlaylist *) const override;
                 vlc_tick_t getMaxBuffering(const BasePlaylist *) const override;
                 vlc_tick_t getLiveDelay(const BasePlaylist *) const override;
                 vlc_tick_t getStableBuffering(const BasePlaylist *) const override;
+                bool isLowLatency(const BasePlaylist *) const override;
                 static const unsigned SAFETY_BUFFERING_EDGE_OFFSET;
                 static const unsigned SAFETY_EXPURGING_OFFSET;
 
             protected:
                 vlc_tick_t getBufferingOffset(const BasePlaylist *) const;
                 uint64_t getLiveStartSegmentNumber(BaseRepresentation *) const;
-                bool isLowLatency(const BasePlaylist *) const;
         };
     }
 }
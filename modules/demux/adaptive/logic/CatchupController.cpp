@@ -0,0 +1,80 @@
+/*
+ * CatchupController.cpp
+ *****************************************************************************
+ * Copyright (C) 2025 - VideoLAN and VLC authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "CatchupController.hpp"
+
+#include <cmath>
+
+using namespace adaptive::logic;
+
+const float CatchupController::DEFAULT_MIN_PLAYBACK_RATE = 0.95f;
+const float CatchupController::DEFAULT_MAX_PLAYBACK_RATE = 1.05f;
+const vlc_tick_t CatchupController::LATENCY_TOLERANCE = VLC_TICK_FROM_MS(100);
+const vlc_tick_t CatchupController::MIN_CATCHUP_BUFFERING = VLC_TICK_FROM_MS(500);
+
+CatchupController::CatchupController()
+{
+    targetLatency = 0;
+    minRate = DEFAULT_MIN_PLAYBACK_RATE;
+    maxRate = DEFAULT_MAX_PLAYBACK_RATE;
+}
+
+void CatchupController::setTargetLatency(vlc_tick_t target)
+{
+    targetLatency = target;
+}
+
+vlc_tick_t CatchupController::getTargetLatency() const
+{
+    return targetLatency;
+}
+
+void CatchupController::setPlaybackRateRange(float min, float max)
+{
+    /* only accept ranges around the normal rate */
+    if(min > 0.f && min <= 1.f)
+        minRate = min;
+    if(max >= 1.f)
+        maxRate = max;
+}
+
+float CatchupController::getPlaybackRate(vlc_tick_t latency, vlc_tick_t buffering) const
+{
+    if(targetLatency == 0)
+        return 1.f;
+
+    const vlc_tick_t delta = latency - targetLatency;
+    if(delta >= -LATENCY_TOLERANCE && delta <= LATENCY_TOLERANCE)
+        return 1.f;
+
+    /* Would empty the buffer and stall, which only adds latency */
+    if(delta > 0 && buffering < MIN_CATCHUP_BUFFERING)
+        return 1.f;
+
+    /* Smooth and saturating correction: gentle for small drifts,
+     * reaching the bounds for drifts of a second or more */
+    const float correction = std::tanh(2.5 * secf_from_vlc_tick(delta));
+    if(delta > 0)
+        return 1.f + (maxRate - 1.f) * correction;
+    return 1.f + (1.f - minRate) * correction;
+}
@@ -0,0 +1,56 @@
+/*
+ * CatchupController.hpp
+ *****************************************************************************
+ * Copyright (C) 2025 - VideoLAN and VLC authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef CATCHUPCONTROLLER_HPP
+#define CATCHUPCONTROLLER_HPP
+
+#include <vlc_common.h>
+#include <vlc_tick.h>
+
+namespace adaptive
+{
+    namespace logic
+    {
+        /* Computes the playback rate holding the live latency
+         * around the target, by slightly speeding up or slowing down */
+        class CatchupController
+        {
+            public:
+                CatchupController();
+
+                void setTargetLatency(vlc_tick_t);
+                vlc_tick_t getTargetLatency() const;
+                void setPlaybackRateRange(float, float);
+                float getPlaybackRate(vlc_tick_t latency,
+                                      vlc_tick_t buffering) const;
+
+                static const float DEFAULT_MIN_PLAYBACK_RATE;
+                static const float DEFAULT_MAX_PLAYBACK_RATE;
+                static const vlc_tick_t LATENCY_TOLERANCE;
+                static const vlc_tick_t MIN_CATCHUP_BUFFERING;
+
+            private:
+                vlc_tick_t targetLatency;
+                float minRate;
+                float maxRate;
+        };
+    }
+}
+
+#endif // CATCHUPCONTROLLER_HPP
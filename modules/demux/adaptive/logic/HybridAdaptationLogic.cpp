@@ -0,0 +1,194 @@
+/*
+ * HybridAdaptationLogic.cpp
+ *****************************************************************************
+ * Copyright (C) 2025 - VideoLAN and VLC authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "HybridAdaptationLogic.hpp"
+#include "Representationselectors.hpp"
+
+#include "../playlist/BaseAdaptationSet.h"
+#include "../playlist/BaseRepresentation.h"
+#include "../tools/Debug.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace adaptive::logic;
+using namespace adaptive;
+
+/*
+ * Throughput and buffer hybrid, as the DYNAMIC rule of dash.js
+ * https://arxiv.org/abs/1910.08710
+ *
+ * While the buffer is building up, the throughput estimate drives the choice.
+ * Once the buffer has reached its target, the BOLA utility takes over, with
+ * upswitches capped by the throughput (BOLA-O), until the buffer falls back
+ * under the minimum.
+ */
+
+#define bufferPerLevelS VLC_TICK_FROM_SEC(2)
+#define safetyFactor    0.9
+#define panicFactor     0.5 /* when the buffer is under half the minimum */
+
+HybridAdaptationLogic::HybridAdaptationLogic(vlc_object_t *obj)
+    : NearOptimalAdaptationLogic(obj)
+{
+}
+
+HybridAdaptationLogic::~HybridAdaptationLogic()
+{
+}
+
+void HybridAdaptationLogic::getBufferParameters(BaseAdaptationSet *adaptSet, RepresentationSelector &selector,
+                                                const NearOptimalContext &ctx,
+                                                float *pgammaP, float *pVp)
+{
+    /* BOLA parameters as in dash.js: utility = log(S/Smin) + 1, and the
+     * highest quality is reached when the buffer gets close to bufferTime */
+    const BaseRepresentation *lowest = selector.lowest(adaptSet);
+    const BaseRepresentation *highest = selector.highest(adaptSet);
+    unsigned count = 0;
+    for(BaseRepresentation *rep = selector.lowest(adaptSet), *prev = nullptr;
+                            rep && rep != prev; rep = selector.higher(adaptSet, rep))
+    {
+        count++;
+        prev = rep;
+    }
+    const vlc_tick_t bufferTime = std::min(std::max(ctx.buffering_target,
+                                                    ctx.buffering_min + bufferPerLevelS * count),
+                                           ctx.buffering_max);
+    /* > 1, as the rule only applies to different bitrates */
+    const float umax = std::log((float)highest->getBandwidth() / lowest->getBandwidth()) + 1.0;
+    const float gammaP = (umax - 1.0) / ((float)bufferTime / ctx.buffering_min - 1.0);
+    *pVp = secf_from_vlc_tick(ctx.buffering_min) / gammaP;
+    /* for the log(S) utility */
+    *pgammaP = gammaP + 1.0 - std::log((float)lowest->getBandwidth());
+}
+
+BaseRepresentation *HybridAdaptationLogic::getNextRepresentation(BaseAdaptationSet *adaptSet, BaseRepresentation *prevRep)
+{
+    RepresentationSelector selector(maxwidth, maxheight);
+
+    BaseRepresentation *lowest = selector.lowest(adaptSet);
+    BaseRepresentation *highest = selector.highest(adaptSet);
+    if(lowest == nullptr || highest == nullptr)
+        return nullptr;
+
+    if(lowest == highest)
+        return lowest;
+
+    vlc_mutex_lock(&lock);
+
+    std::map<ID, NearOptimalContext>::iterator it = streams.find(adaptSet->getID());
+    if(it == streams.end())
+    {
+        vlc_mutex_unlock(&lock);
+        return lowest;
+    }
+    const NearOptimalContext ctxcopy = (*it).second;
+
+    /* BOLA needs some room between its minimum and target levels,
+     * and bitrates to weigh */
+    bool &b_buffer_rule = bufferRules[adaptSet->getID()];
+    if(ctxcopy.buffering_min <= VLC_TICK_FROM_SEC(1) ||
+       ctxcopy.buffering_target <= ctxcopy.buffering_min ||
+       ctxcopy.buffering_max <= ctxcopy.buffering_min ||
+       highest->getBandwidth() <= lowest->getBandwidth())
+        b_buffer_rule = false;
+    else if(b_buffer_rule &&
+            ctxcopy.buffering_level < std::min(ctxcopy.buffering_min, ctxcopy.buffering_target / 2))
+        b_buffer_rule = false;
+    else if(!b_buffer_rule && ctxcopy.buffering_level >= ctxcopy.buffering_target)
+        b_buffer_rule = true;
+    const bool b_buffer = b_buffer_rule;
+
+    /* never more than measured, even when the other streams use more */
+    const unsigned bps = std::min(getAvailableBw(currentBps, prevRep), currentBps);
+
+    vlc_mutex_unlock(&lock);
+
+    BaseRepresentation *m;
+    if(prevRep == nullptr) /* Starting */
+    {
+        m = getStartRepresentation(adaptSet, selector, bps * safetyFactor);
+    }
+    else if(b_buffer)
+    {
+        m = getBufferRepresentation(adaptSet, selector, ctxcopy, bps, prevRep);
+        if(m->getBandwidth() > prevRep->getBandwidth() && m->getBandwidth() > bps)
+        {
+            /* don't go higher than what the throughput can sustain */
+            m = selector.select(adaptSet, bps);
+            if(m->getBandwidth() < prevRep->getBandwidth())
+                m = prevRep;
+        }
+    }
+    else
+    {
+        double factor = safetyFactor;
+        if(ctxcopy.buffering_level < ctxcopy.buffering_min / 2)
+            factor = panicFactor;
+        m = selector.select(adaptSet, bps * factor);
+    }
+
+    BwDebug( msg_Info(p_obj, "%s rule, buffering level %.2f%% rep %" PRId64 " kBps %u kBps",
+             b_buffer ? "buffer" : "throughput",
+             (float) 100 * ctxcopy.buffering_level / ctxcopy.buffering_target,
+             m->getBandwidth()/8000, bps / 8000); );
+
+    return m;
+}
+
+void HybridAdaptationLogic::trackerEvent(const TrackerEvent &ev)
+{
+    NearOptimalAdaptationLogic::trackerEvent(ev);
+
+    switch(ev.getType())
+    {
+    case TrackerEvent::Type::BufferingStateUpdate:
+        {
+            const BufferingStateUpdatedEvent &event =
+                    static_cast<const BufferingStateUpdatedEvent &>(ev);
+            vlc_mutex_locker locker(&lock);
+            if(!event.enabled)
+                bufferRules.erase(*event.id);
+        }
+        break;
+
+    case TrackerEvent::Type::BufferingLevelChange:
+        {
+            /* the rules switch on the levels of the buffering logic */
+            const BufferingLevelChangedEvent &event =
+                    static_cast<const BufferingLevelChangedEvent &>(ev);
+            vlc_mutex_locker locker(&lock);
+            std::map<ID, NearOptimalContext>::iterator it = streams.find(*event.id);
+            if(it != streams.end())
+            {
+                (*it).second.buffering_min = event.minimum;
+                (*it).second.buffering_max = event.maximum;
+            }
+        }
+        break;
+
+    default:
+            break;
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ * HybridAdaptationLogic.hpp
+ *****************************************************************************
+ * Copyright (C) 2025 - VideoLAN and VLC authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef HYBRIDADAPTATIONLOGIC_HPP
+#define HYBRIDADAPTATIONLOGIC_HPP
+
+#include "NearOptimalAdaptationLogic.hpp"
+#include <map>
+
+namespace adaptive
+{
+    namespace logic
+    {
+        /* Switches between a throughput rule and the BOLA buffer rule */
+        class HybridAdaptationLogic : public NearOptimalAdaptationLogic
+        {
+            public:
+                HybridAdaptationLogic(vlc_object_t *);
+                virtual ~HybridAdaptationLogic();
+
+                BaseRepresentation* getNextRepresentation(BaseAdaptationSet *,
+                                                          BaseRepresentation *) override;
+                void                trackerEvent           (const TrackerEvent &) override;
+
+            protected:
+                void                getBufferParameters(BaseAdaptationSet *, RepresentationSelector &,
+                                                        const NearOptimalContext &,
+                                                        float *, float *) override;
+
+            private:
+                std::map<adaptive::ID, bool> bufferRules; /* BOLA in use, per stream */
+        };
+    }
+}
+
+#endif // HYBRIDADAPTATIONLOGIC_HPP
@@ -46,6 +46,7 @@ NearOptimalContext::NearOptimalContext()
     : buffering_min( minimumBufferS )
     , buffering_level( 0 )
     , buffering_target( bufferTargetS )
+    , buffering_max( bufferTargetS )
     , last_download_rate( 0 )
 { }
 
@@ -82,6 +83,64 @@ NearOptimalAdaptationLogic::getNextQualityIndex( BaseAdaptationSet *adaptSet, Re
     return ret;
 }
 
+BaseRepresentation *
+NearOptimalAdaptationLogic::getStartRepresentation(BaseAdaptationSet *adaptSet, RepresentationSelector &selector,
+                                                   unsigned bps)
+{
+    BaseRepresentation *m = selector.select(adaptSet, bps);
+    if(m == selector.lowest(adaptSet))
+    {
+        /* Handle HLS specific cases where the lowest is audio only. Try to pick first A+V */
+        BaseRepresentation *n = selector.higher(adaptSet, m);
+        if(m != n  && m->getCodecs().size() == 1 && n->getCodecs().size() > 1)
+            m = n;
+    }
+    return m;
+}
+
+void NearOptimalAdaptationLogic::getBufferParameters(BaseAdaptationSet *adaptSet, RepresentationSelector &selector,
+                                                     const NearOptimalContext &ctx,
+                                                     float *pgammaP, float *pVd)
+{
+    const float umin = getUtility(selector.lowest(adaptSet));
+    const float umax = getUtility(selector.highest(adaptSet));
+
+    const float gammaP = 1.0 + (umax - umin) / ((float)ctx.buffering_target / ctx.buffering_min - 1.0);
+    *pVd = (secf_from_vlc_tick(ctx.buffering_min) - 1.0) / (umin + gammaP);
+    *pgammaP = gammaP - umin; /* umin == Sm, utility = std::log(S/Sm) */
+}
+
+BaseRepresentation *
+NearOptimalAdaptationLogic::getBufferRepresentation(BaseAdaptationSet *adaptSet, RepresentationSelector &selector,
+                                                    const NearOptimalContext &ctx, unsigned bps,
+                                                    BaseRepresentation *prevRep)
+{
+    float gammaP, Vd;
+    getBufferParameters(adaptSet, selector, ctx, &gammaP, &Vd);
+
+    /* noted m* */
+    BaseRepresentation *m = getNextQualityIndex(adaptSet, selector, gammaP, Vd,
+                                                secf_from_vlc_tick(ctx.buffering_level));
+    if(m->getBandwidth() < prevRep->getBandwidth()) /* m*[n] < m*[n-1] */
+    {
+        BaseRepresentation *mp = selector.select(adaptSet, bps); /* m' */
+        if(mp->getBandwidth() <= m->getBandwidth())
+        {
+            mp = m;
+        }
+        else if(mp->getBandwidth() > prevRep->getBandwidth())
+        {
+            mp = prevRep;
+        }
+        else
+        {
+            mp = selector.lower(adaptSet, mp);
+        }
+        m = mp;
+    }
+    return m;
+}
+
 BaseRepresentation *NearOptimalAdaptationLogic::getNextRepresentation(BaseAdaptationSet *adaptSet, BaseRepresentation *prevRep)
 {
     RepresentationSelector selector(maxwidth, maxheight);
@@ -94,9 +153,6 @@ BaseRepresentation *NearOptimalAdaptationLogic::getNextRepresentation(BaseAdapta
     if(lowest == highest)
         return lowest;
 
-    const float umin = getUtility(lowest);
-    const float umax = getUtility(highest);
-
     vlc_mutex_lock(&lock);
 
     std::map<ID, NearOptimalContext>::iterator it = streams.find(adaptSet->getID());
@@ -111,44 +167,11 @@ BaseRepresentation *NearOptimalAdaptationLogic::getNextRepresentation(BaseAdapta
 
     vlc_mutex_unlock(&lock);
 
-    const float gammaP = 1.0 + (umax - umin) / ((float)ctxcopy.buffering_target / ctxcopy.buffering_min - 1.0);
-    const float Vd = (secf_from_vlc_tick(ctxcopy.buffering_min) - 1.0) / (umin + gammaP);
-
     BaseRepresentation *m;
     if(prevRep == nullptr) /* Starting */
-    {
-        m = selector.select(adaptSet, bps);
-        if(m == lowest)
-        {
-            /* Handle HLS specific cases where the lowest is audio only. Try to pick first A+V */
-            BaseRepresentation *n = selector.higher(adaptSet, m);
-            if(m != n  && m->getCodecs().size() == 1 && n->getCodecs().size() > 1)
-                m = n;
-        }
-    }
+        m = getStartRepresentation(adaptSet, selector, bps);
     else
-    {
-        /* noted m* */
-        m = getNextQualityIndex(adaptSet, selector, gammaP - umin /* umin == Sm, utility = std::log(S/Sm) */,
-                                Vd, secf_from_vlc_tick(ctxcopy.buffering_level));
-        if(m->getBandwidth() < prevRep->getBandwidth()) /* m*[n] < m*[n-1] */
-        {
-            BaseRepresentation *mp = selector.select(adaptSet, bps); /* m' */
-            if(mp->getBandwidth() <= m->getBandwidth())
-            {
-                mp = m;
-            }
-            else if(mp->getBandwidth() > prevRep->getBandwidth())
-            {
-                mp = prevRep;
-            }
-            else
-            {
-                mp = selector.lower(adaptSet, mp);
-            }
-            m = mp;
-        }
-    }
+        m = getBufferRepresentation(adaptSet, selector, ctxcopy, bps, prevRep);
 
     BwDebug( msg_Info(p_obj, "buffering level %.2f%% rep %" PRId64 " kBps %u kBps",
              (float) 100 * ctxcopy.buffering_level / ctxcopy.buffering_target, m->getBandwidth()/8000, bps / 8000); );
@@ -34,6 +34,7 @@ namespace adaptive
         class NearOptimalContext
         {
             friend class NearOptimalAdaptationLogic;
+            friend class HybridAdaptationLogic;
 
             public:
                 NearOptimalContext();
@@ -42,6 +43,7 @@ namespace adaptive
                 vlc_tick_t buffering_min;
                 vlc_tick_t buffering_level;
                 vlc_tick_t buffering_target;
+                vlc_tick_t buffering_max;
                 unsigned last_download_rate;
                 MovingAverage<unsigned> average;
         };
@@ -58,18 +60,29 @@ namespace adaptive
                                                             vlc_tick_t, vlc_tick_t) override;
                 void                trackerEvent           (const TrackerEvent &) override;
 
+            protected:
+                BaseRepresentation *        getStartRepresentation(BaseAdaptationSet *, RepresentationSelector &,
+                                                                   unsigned);
+                BaseRepresentation *        getBufferRepresentation(BaseAdaptationSet *, RepresentationSelector &,
+                                                                    const NearOptimalContext &, unsigned,
+                                                                    BaseRepresentation *);
+                /* BOLA utility loop parameters, for the log(S) utility */
+                virtual void                getBufferParameters(BaseAdaptationSet *, RepresentationSelector &,
+                                                                const NearOptimalContext &,
+                                                                float *gammaP, float *Vd);
+                unsigned                    getAvailableBw(unsigned, const BaseRepresentation *) const;
+                std::map<adaptive::ID, NearOptimalContext> streams;
+                unsigned                    currentBps;
+                vlc_mutex_t                 lock;
+
             private:
                 BaseRepresentation *        getNextQualityIndex( BaseAdaptationSet *, RepresentationSelector &,
                                                                  float gammaP, float VD,
                                                                  float Q /*current buffer level*/);
                 float                       getUtility(const BaseRepresentation *);
-                unsigned                    getAvailableBw(unsigned, const BaseRepresentation *) const;
                 unsigned                    getMaxCurrentBw() const;
-                std::map<adaptive::ID, NearOptimalContext> streams;
                 std::map<uint64_t, float>   utilities;
-                unsigned                    currentBps;
                 unsigned                    usedBps;
-                vlc_mutex_t                 lock;
         };
     }
 }
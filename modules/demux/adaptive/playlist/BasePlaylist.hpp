@@ -75,6 +75,9 @@ namespace adaptive
                 Property<vlc_tick_t>                   timeShiftBufferDepth;
                 Property<vlc_tick_t>                   suggestedPresentationDelay;
                 Property<vlc_tick_t>                   presentationStartOffset;
+                Property<vlc_tick_t>                   targetLatency;
+                Property<float>                        minPlaybackRate;
+                Property<float>                        maxPlaybackRate;
 
             protected:
                 vlc_object_t                       *p_object;
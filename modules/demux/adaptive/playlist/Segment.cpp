@@ -52,6 +52,7 @@ ISegment::ISegment(const ICanonicalUrl *parent):
     discontinuitySequenceNumber = std::numeric_limits<uint64_t>::max();
     templated = false;
     discontinuity = false;
+    independent = true;
     displayTime = VLC_TICK_INVALID;
 }
 
@@ -201,6 +202,7 @@ vlc_tick_t ISegment::getDisplayTime() const
 Segment::Segment(ICanonicalUrl *parent) :
         ISegment(parent)
 {
+    b_partial = false;
 }
 
 SegmentChunk* Segment::createChunk(AbstractChunkSource *source, BaseRepresentation *rep)
@@ -220,11 +222,33 @@ void Segment::addSubSegment(SubSegment *subsegment)
     subsegments.push_back(subsegment);
 }
 
+void Segment::addPart(Segment *part)
+{
+    parts.push_back(part);
+}
+
+const std::vector<Segment*> & Segment::getParts() const
+{
+    return parts;
+}
+
+void Segment::setPartial(bool b)
+{
+    b_partial = b;
+}
+
+bool Segment::isPartial() const
+{
+    return b_partial;
+}
+
 Segment::~Segment()
 {
     std::vector<Segment*>::iterator it;
     for(it=subsegments.begin();it!=subsegments.end();++it)
         delete *it;
+    for(it=parts.begin();it!=parts.end();++it)
+        delete *it;
 }
 
 void                    Segment::setSourceUrl   ( const std::string &url )
@@ -238,6 +262,9 @@ void Segment::debug(vlc_object_t *obj, int indent) const
     if (subsegments.empty())
     {
         ISegment::debug(obj, indent);
+        std::vector<Segment *>::const_iterator l;
+        for(l = parts.begin(); l != parts.end(); ++l)
+            (*l)->debug(obj, indent + 1);
     }
     else
     {
@@ -75,6 +75,7 @@ namespace adaptive
                 Property<stime_t>       startTime;
                 Property<stime_t>       duration;
                 bool                    discontinuity;
+                bool                    independent;
 
             protected:
                 virtual bool                            prepareChunk    (SharedResources *,
@@ -101,10 +102,18 @@ namespace adaptive
                 virtual const std::vector<Segment*> & subSegments() const;
                 void debug(vlc_object_t *,int = 0) const override;
                 virtual void addSubSegment(SubSegment *);
+                /* Parts can be fetched before the whole segment is published,
+                 * their start times are relative to the segment's one */
+                virtual void addPart(Segment *);
+                virtual const std::vector<Segment*> & getParts() const;
+                void setPartial(bool);
+                bool isPartial() const;
 
             protected:
                 std::vector<Segment *> subsegments;
+                std::vector<Segment *> parts;
                 Url sourceUrl;
+                bool b_partial;
         };
 
         class InitSegment : public Segment
@@ -112,11 +112,30 @@ void SegmentList::updateWith(AbstractMultipleSegmentBaseType *updated_,
     }
     else
     {
-        const Segment * prevSegment = segments.back();
         const uint64_t oldest = updated->segments.front()->getSequenceNumber();
 
+        /* the segment which was still being published gets replaced, even
+         * when it is the only one, and the update continues from its start */
+        uint64_t prevNumber = segments.back()->getSequenceNumber();
+        stime_t prevEnd = segments.back()->startTime.Get() + segments.back()->duration.Get();
+        if(segments.back()->isPartial())
+        {
+            Segment *partial = segments.back();
+            for(auto it = updated->segments.begin(); it != updated->segments.end(); ++it)
+            {
+                if((*it)->getSequenceNumber() != partial->getSequenceNumber())
+                    continue;
+                prevNumber = partial->getSequenceNumber() - 1;
+                prevEnd = partial->startTime.Get();
+                totalLength -= partial->duration.Get();
+                segments.pop_back();
+                delete partial;
+                break;
+            }
+        }
+
         /* filter out known segments from the update */
-        updated->pruneBySegmentNumber(prevSegment->getSequenceNumber() + 1);
+        updated->pruneBySegmentNumber(prevNumber + 1);
 
         if(updated->segments.empty())
             return;
@@ -125,16 +144,17 @@ void SegmentList::updateWith(AbstractMultipleSegmentBaseType *updated_,
         for(auto it = updated->segments.begin(); it != updated->segments.end(); ++it)
         {
             Segment *cur = *it;
-            cur->startTime.Set(prevSegment->startTime.Get() + prevSegment->duration.Get());
+            cur->startTime.Set(prevEnd);
             /* not continuous */
-            if(cur->getSequenceNumber() != prevSegment->getSequenceNumber() + 1)
+            if(cur->getSequenceNumber() != prevNumber + 1)
             {
-                assert(prevSegment->getSequenceNumber() < cur->getSequenceNumber());
+                assert(prevNumber < cur->getSequenceNumber());
                 assert(duration);
-                uint64_t gap = cur->getSequenceNumber() - prevSegment->getSequenceNumber() - 1;
+                uint64_t gap = cur->getSequenceNumber() - prevNumber - 1;
                 cur->startTime.Set(cur->startTime.Get() + duration * gap);
             }
-            prevSegment = cur;
+            prevNumber = cur->getSequenceNumber();
+            prevEnd = cur->startTime.Get() + cur->duration.Get();
             addSegment(cur);
         }
         updated->segments.clear();
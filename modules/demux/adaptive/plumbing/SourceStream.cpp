@@ -165,6 +165,9 @@ ssize_t ChunksSourceStream::Read(uint8_t *buf, size_t size)
             i_toread -= p_block->i_buffer;
             block_Release(p_block);
             p_block = nullptr;
+            /* don't wait for the next block, which could be still in transfer */
+            if(i_copied)
+                break;
         }
     }
 
@@ -0,0 +1,177 @@
+/*****************************************************************************
+ *
+ *****************************************************************************
+ * Copyright (C) 2025 VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../http/SegmentCache.hpp"
+
+#include "../test.hpp"
+
+#include <vlc_block.h>
+#include <vlc_interrupt.h>
+
+#include <cstring>
+
+using namespace adaptive::http;
+
+static void Append(SegmentCache *cache, SegmentCacheEntry *entry, size_t size, char c)
+{
+    block_t *p_block = block_Alloc(size);
+    if(!p_block)
+        throw 1;
+    memset(p_block->p_buffer, c, size);
+    cache->append(entry, p_block, "video/mp4");
+}
+
+static void Fill(SegmentCache *cache, const StorageID &id, size_t size)
+{
+    bool b_new;
+    SegmentCacheEntry *entry = cache->get(id, size, &b_new);
+    Expect(entry != nullptr);
+    Expect(b_new);
+    Append(cache, entry, size, 0);
+    cache->finish(entry, true);
+    cache->release(entry);
+}
+
+static bool Cached(SegmentCache *cache, const StorageID &id)
+{
+    bool b_new;
+    SegmentCacheEntry *entry = cache->get(id, 0, &b_new);
+    if(entry == nullptr)
+        return false;
+    if(b_new) /* was not, drop it */
+        cache->finish(entry, false);
+    cache->release(entry);
+    return !b_new;
+}
+
+int SegmentCache_test()
+{
+    SegmentCache *cache = SegmentCache::acquire(4096, "playlist1");
+    if(!cache)
+        return 1;
+
+    try
+    {
+        Expect(SegmentCache::acquire(0, "playlist1") == nullptr);
+        Expect(!cache->isShared("playlist1"));
+        /* only shared between the players of the same playlist */
+        SegmentCache *other = SegmentCache::acquire(4096, "playlist2");
+        Expect(other == cache);
+        Expect(!cache->isShared("playlist1"));
+        Expect(!cache->isShared("playlist2"));
+        SegmentCache *same = SegmentCache::acquire(4096, "playlist1");
+        Expect(same == cache);
+        Expect(cache->isShared("playlist1"));
+        same->release("playlist1");
+        other->release("playlist2");
+        Expect(!cache->isShared("playlist1"));
+
+        /* too large for the budget */
+        bool b_new;
+        Expect(cache->get("large", 2048, &b_new) == nullptr);
+
+        /* coalescing: the second request gets the pending entry */
+        SegmentCacheEntry *entry = cache->get("0-599@seg1", 0, &b_new);
+        Expect(entry != nullptr);
+        Expect(b_new);
+        SegmentCacheEntry *reader = cache->get("0-599@seg1", 0, &b_new);
+        Expect(reader == entry);
+        Expect(!b_new);
+
+        uint8_t buf[1000];
+        Append(cache, entry, 400, 'a');
+        Expect(cache->read(reader, 0, buf, sizeof(buf)) == 400);
+        Expect(buf[0] == 'a' && buf[399] == 'a');
+        Expect(cache->getContentType(reader) == "video/mp4");
+        Append(cache, entry, 200, 'b');
+        Expect(cache->read(reader, 300, buf, 200) == 200);
+        Expect(buf[0] == 'a' && buf[99] == 'a' && buf[100] == 'b' && buf[199] == 'b');
+        cache->finish(entry, true, VLC_TICK_FROM_MS(300));
+        cache->release(entry);
+        Expect(cache->getTransferTime(reader) == VLC_TICK_FROM_MS(300));
+        Expect(cache->read(reader, 400, buf, sizeof(buf)) == 200);
+        Expect(cache->read(reader, 600, buf, sizeof(buf)) == 0);
+        cache->release(reader);
+        Expect(Cached(cache, "0-599@seg1"));
+
+        /* failed downloads are not kept, their readers get what was
+         * received and are then told */
+        entry = cache->get("seg2", 0, &b_new);
+        reader = cache->get("seg2", 0, &b_new);
+        Append(cache, entry, 100, 'c');
+        cache->finish(entry, false);
+        cache->release(entry);
+        Expect(cache->read(reader, 0, buf, sizeof(buf)) == 100);
+        Expect(buf[0] == 'c' && buf[99] == 'c');
+        Expect(cache->read(reader, 100, buf, sizeof(buf)) == -1);
+        cache->release(reader);
+        Expect(!Cached(cache, "seg2"));
+
+        /* readers stop waiting for an owner which never finishes */
+        entry = cache->get("seg9", 0, &b_new);
+        reader = cache->get("seg9", 0, &b_new);
+        Append(cache, entry, 100, 'e');
+        Expect(cache->read(reader, 0, buf, sizeof(buf), VLC_TICK_FROM_MS(10)) == 100);
+        Expect(cache->read(reader, 100, buf, sizeof(buf), VLC_TICK_FROM_MS(10)) == -1);
+        /* or when they are interrupted */
+        vlc_interrupt_t *ctx = vlc_interrupt_create();
+        Expect(ctx != nullptr);
+        vlc_interrupt_t *oldctx = vlc_interrupt_set(ctx);
+        vlc_interrupt_kill(ctx);
+        const ssize_t ret = cache->read(reader, 100, buf, sizeof(buf));
+        vlc_interrupt_set(oldctx);
+        vlc_interrupt_destroy(ctx);
+        Expect(ret == -1);
+        cache->release(reader);
+        cache->finish(entry, false);
+        cache->release(entry);
+
+        /* least recently used ones go first */
+        Fill(cache, "seg3", 1000);
+        Fill(cache, "seg4", 1000);
+        Expect(Cached(cache, "0-599@seg1"));
+        Fill(cache, "seg5", 1000);
+        Fill(cache, "seg6", 1000); /* over 4096 */
+        Expect(!Cached(cache, "seg3"));
+        Expect(Cached(cache, "0-599@seg1"));
+        Expect(Cached(cache, "seg4"));
+        Expect(Cached(cache, "seg6"));
+
+        /* in flight ones are kept */
+        entry = cache->get("seg7", 0, &b_new);
+        Append(cache, entry, 1000, 'd');
+        Fill(cache, "seg8", 1000);
+        Expect(Cached(cache, "seg7"));
+        /* and stop being cached when they grow too large */
+        Append(cache, entry, 100, 'd');
+        Expect(!Cached(cache, "seg7"));
+        cache->finish(entry, true);
+        cache->release(entry);
+    } catch(...) {
+        cache->release("playlist1");
+        return 1;
+    }
+
+    cache->release("playlist1");
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*****************************************************************************
+ *
+ *****************************************************************************
+ * Copyright (C) 2025 VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../logic/CatchupController.hpp"
+
+#include "../test.hpp"
+
+using namespace adaptive::logic;
+
+int CatchupController_test()
+{
+    try
+    {
+        const vlc_tick_t buffering = VLC_TICK_FROM_SEC(1);
+        CatchupController controller;
+
+        /* no target, no correction */
+        Expect(controller.getPlaybackRate(VLC_TICK_FROM_SEC(10), buffering) == 1.f);
+
+        controller.setTargetLatency(VLC_TICK_FROM_SEC(3));
+        Expect(controller.getTargetLatency() == VLC_TICK_FROM_SEC(3));
+
+        /* within tolerance */
+        Expect(controller.getPlaybackRate(VLC_TICK_FROM_SEC(3), buffering) == 1.f);
+        Expect(controller.getPlaybackRate(VLC_TICK_FROM_SEC(3) + CatchupController::LATENCY_TOLERANCE,
+                                          buffering) == 1.f);
+
+        /* behind: speeds up, more for larger drifts, bounded */
+        float small = controller.getPlaybackRate(VLC_TICK_FROM_MS(3200), buffering);
+        float large = controller.getPlaybackRate(VLC_TICK_FROM_SEC(5), buffering);
+        float huge = controller.getPlaybackRate(VLC_TICK_FROM_SEC(60), buffering);
+        Expect(small > 1.f);
+        Expect(large > small);
+        Expect(huge <= CatchupController::DEFAULT_MAX_PLAYBACK_RATE);
+        Expect(huge > CatchupController::DEFAULT_MAX_PLAYBACK_RATE - 0.001f);
+
+        /* ahead: slows down, bounded */
+        small = controller.getPlaybackRate(VLC_TICK_FROM_MS(2800), buffering);
+        huge = controller.getPlaybackRate(0, buffering);
+        Expect(small < 1.f);
+        Expect(huge < small);
+        Expect(huge >= CatchupController::DEFAULT_MIN_PLAYBACK_RATE);
+
+        /* never speeds up when close to starvation */
+        Expect(controller.getPlaybackRate(VLC_TICK_FROM_SEC(5),
+                                          CatchupController::MIN_CATCHUP_BUFFERING / 2) == 1.f);
+        Expect(controller.getPlaybackRate(0, 0) < 1.f);
+
+        /* rate range from the manifest */
+        controller.setPlaybackRateRange(0.9f, 1.2f);
+        Expect(controller.getPlaybackRate(VLC_TICK_FROM_SEC(60), buffering) > 1.19f);
+        Expect(controller.getPlaybackRate(0, buffering) < 0.91f);
+        controller.setPlaybackRateRange(1.1f, 0.5f); /* rejected */
+        Expect(controller.getPlaybackRate(VLC_TICK_FROM_SEC(60), buffering) > 1.19f);
+        Expect(controller.getPlaybackRate(0, buffering) < 0.91f);
+    }
+    catch (...)
+    {
+        return 1;
+    }
+
+    return 0;
+}
@@ -543,5 +543,123 @@ int M3U8Playlist_test()
         return 1;
     }
 
+    /* Manifest 6 */
+    const char manifest6[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=3.5\n"
+    "#EXT-X-PART-INF:PART-TARGET=1.0\n"
+    "#EXT-X-MEDIA-SEQUENCE:10\n"
+    "#EXTINF:4\n"
+    "foobar10.ts\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar11.0.ts\",INDEPENDENT=YES\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar11.1.ts\"\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar11.2.ts\",INDEPENDENT=YES\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar11.3.ts\"\n"
+    "#EXTINF:4\n"
+    "foobar11.ts\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar12.0.ts\",INDEPENDENT=YES\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar12.1.ts\"\n"
+    "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"foobar12.2.ts\"\n";
+
+    m3u = ParseM3U8(obj, manifest6, sizeof(manifest6));
+    try
+    {
+        bufferingLogic = DefaultBufferingLogic();
+        Expect(m3u);
+        Expect(m3u->isLive() == true);
+        Expect(m3u->isLowLatency() == true);
+        Expect(m3u->suggestedPresentationDelay.Get() == vlc_tick_from_sec(3.5));
+        HLSRepresentation *rep = static_cast<HLSRepresentation *>(
+                    m3u->getFirstPeriod()->getAdaptationSets().front()->getRepresentations().front());
+        Expect(rep->getUpdateUrl().find("_HLS_msn=12&_HLS_part=2") != std::string::npos);
+
+        /* completed segment keeps its parts */
+        Segment *seg = rep->getMediaSegment(11);
+        Expect(seg);
+        Expect(!seg->isPartial());
+        Expect(seg->getParts().size() == 4);
+        Expect(seg->getParts().at(2)->startTime.Get() ==
+               rep->inheritTimescale().ToScaled(vlc_tick_from_sec(2)));
+
+        /* segment being published, with the preload hint */
+        seg = rep->getMediaSegment(12);
+        Expect(seg);
+        Expect(seg->isPartial());
+        Expect(seg->getParts().size() == 3);
+        Expect(rep->getMinAheadTime(11) == vlc_tick_from_sec(3));
+
+        /* closest independent part past the hold back */
+        uint64_t number;
+        size_t part;
+        Expect(bufferingLogic.getStartPart(rep, &number, &part));
+        Expect(number == 11);
+        Expect(part == 2);
+
+        delete m3u;
+    }
+    catch (...)
+    {
+        delete m3u;
+        return 1;
+    }
+
+    /* Manifest 7 */
+    const char manifest7[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-PART-INF:PART-TARGET=1.0\n"
+    "#EXT-X-MEDIA-SEQUENCE:20\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar20.0.ts\",INDEPENDENT=YES\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar20.1.ts\"\n";
+
+    const char manifest7update[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-PART-INF:PART-TARGET=1.0\n"
+    "#EXT-X-MEDIA-SEQUENCE:20\n"
+    "#EXTINF:4\n"
+    "foobar20.ts\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar21.0.ts\",INDEPENDENT=YES\n";
+
+    m3u = ParseM3U8(obj, manifest7, sizeof(manifest7));
+    M3U8 *update = ParseM3U8(obj, manifest7update, sizeof(manifest7update));
+    try
+    {
+        Expect(m3u);
+        Expect(update);
+        BaseRepresentation *rep = m3u->getFirstPeriod()->getAdaptationSets().front()->
+                                  getRepresentations().front();
+        BaseRepresentation *updatedRep = update->getFirstPeriod()->getAdaptationSets().front()->
+                                         getRepresentations().front();
+        SegmentList *segmentList = rep->inheritSegmentList();
+        Expect(segmentList->getSegments().size() == 1);
+        Expect(segmentList->getSegments().front()->isPartial());
+
+        /* the only segment, still being published, gets completed */
+        segmentList->updateWith(updatedRep->inheritSegmentList(), true);
+        Expect(segmentList->getSegments().size() == 2);
+        const Timescale timescale = rep->inheritTimescale();
+        Segment *seg = rep->getMediaSegment(20);
+        Expect(seg);
+        Expect(!seg->isPartial());
+        Expect(seg->startTime.Get() == 0);
+        Expect(seg->duration.Get() == timescale.ToScaled(vlc_tick_from_sec(4)));
+        seg = rep->getMediaSegment(21);
+        Expect(seg);
+        Expect(seg->isPartial());
+        Expect(seg->startTime.Get() == timescale.ToScaled(vlc_tick_from_sec(4)));
+        Expect(segmentList->getTotalLength() == timescale.ToScaled(vlc_tick_from_sec(5)));
+
+        delete update;
+        delete m3u;
+    }
+    catch (...)
+    {
+        delete update;
+        delete m3u;
+        return 1;
+    }
+
     return 0;
 }
@@ -0,0 +1,442 @@
+/*****************************************************************************
+ * Simulator.cpp: trace driven evaluation of the adaptation logics
+ *****************************************************************************
+ * Copyright (C) 2025 VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../playlist/BasePlaylist.hpp"
+#include "../../playlist/BasePeriod.h"
+#include "../../playlist/BaseAdaptationSet.h"
+#include "../../playlist/BaseRepresentation.h"
+#include "../../logic/AlwaysBestAdaptationLogic.h"
+#include "../../logic/AlwaysLowestAdaptationLogic.hpp"
+#include "../../logic/BufferingLogic.hpp"
+#include "../../logic/HybridAdaptationLogic.hpp"
+#include "../../logic/NearOptimalAdaptationLogic.hpp"
+#include "../../logic/PredictiveAdaptationLogic.hpp"
+#include "../../logic/RateBasedAdaptationLogic.h"
+#include "../../SegmentTracker.hpp"
+
+#include "../test.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+/*
+ * Replays bandwidth traces against a synthetic single adaptation set VOD
+ * manifest, for every adaptation logic, and reports the rebuffering ratio,
+ * mean bitrate and number of switches.
+ *
+ * Without arguments, runs the built-in traces and checks the results are
+ * sane. Otherwise, each argument is a trace file made of
+ * "<duration in ms> <bandwidth in kbps>" lines, '#' starting a comment.
+ * Traces loop when the playback outlasts them.
+ */
+
+extern const char vlc_module_name[] = "foobar";
+
+using namespace adaptive;
+using namespace adaptive::playlist;
+using namespace adaptive::logic;
+
+struct TraceSample
+{
+    unsigned duration; /* ms */
+    unsigned bandwidth; /* kbps */
+};
+
+struct Trace
+{
+    std::string name;
+    std::vector<TraceSample> samples;
+};
+
+struct Results
+{
+    double rebuffer_ratio;
+    uint64_t mean_bitrate;
+    unsigned switches;
+    vlc_tick_t startup;
+};
+
+struct SimulatedLogic
+{
+    const char *name;
+    AbstractAdaptationLogic::LogicType type;
+};
+
+static const SimulatedLogic logics[] =
+{
+    { "lowest",      AbstractAdaptationLogic::LogicType::AlwaysLowest },
+    { "highest",     AbstractAdaptationLogic::LogicType::AlwaysBest },
+    { "fixedrate",   AbstractAdaptationLogic::LogicType::FixedRate },
+    { "rate",        AbstractAdaptationLogic::LogicType::RateBased },
+    { "predictive",  AbstractAdaptationLogic::LogicType::Predictive },
+    { "nearoptimal", AbstractAdaptationLogic::LogicType::NearOptimal },
+    { "hybrid",      AbstractAdaptationLogic::LogicType::Hybrid },
+};
+
+static const uint64_t representations[] = /* bps */
+{
+    250000, 500000, 1000000, 2000000, 3500000, 6000000,
+};
+
+#define SEGMENT_DURATION VLC_TICK_FROM_SEC(4)
+#define SEGMENT_COUNT    150 /* 10 minutes */
+#define REQUEST_LATENCY  VLC_TICK_FROM_MS(50)
+#define FIXED_RATE       1500000
+
+static const TraceSample trace_steady[] =
+{
+    { 1000, 8000 },
+};
+
+static const TraceSample trace_stepdown[] =
+{
+    { 60000, 8000 },
+    { 90000, 1200 },
+    { 60000, 8000 },
+};
+
+static const TraceSample trace_oscillating[] =
+{
+    { 10000, 4000 },
+    { 10000,  800 },
+};
+
+/* 3G/4G like commute: bursts, fades and a short outage */
+static const TraceSample trace_mobile[] =
+{
+    { 2000, 3100 }, { 2000, 4200 }, { 2000, 5600 }, { 2000, 2900 },
+    { 2000, 1800 }, { 2000, 2400 }, { 2000, 3800 }, { 2000, 6100 },
+    { 2000, 7400 }, { 2000, 5200 }, { 2000, 1200 }, { 2000,  600 },
+    { 2000,  350 }, { 3000,    0 }, { 2000,  900 }, { 2000, 2100 },
+    { 2000, 3300 }, { 2000, 4700 }, { 2000, 4100 }, { 2000, 2600 },
+    { 2000, 1500 }, { 2000, 2200 }, { 2000, 3900 }, { 2000, 5100 },
+    { 2000, 6800 }, { 2000, 5900 }, { 2000, 3600 }, { 2000, 2000 },
+    { 2000, 1100 }, { 2000, 1700 },
+};
+
+#define BUILTIN_TRACE(t) { #t, std::vector<TraceSample>(trace_##t, trace_##t + ARRAY_SIZE(trace_##t)) }
+
+class SimulatedPlaylist : public BasePlaylist
+{
+    public:
+        SimulatedPlaylist() : BasePlaylist(nullptr) {}
+        virtual ~SimulatedPlaylist() {}
+
+        bool isLive() const override
+        {
+            return false;
+        }
+
+        bool isLowLatency() const override
+        {
+            return false;
+        }
+};
+
+static AbstractAdaptationLogic *createLogic(AbstractAdaptationLogic::LogicType type)
+{
+    switch(type)
+    {
+        case AbstractAdaptationLogic::LogicType::AlwaysLowest:
+            return new AlwaysLowestAdaptationLogic(nullptr);
+        case AbstractAdaptationLogic::LogicType::AlwaysBest:
+            return new AlwaysBestAdaptationLogic(nullptr);
+        case AbstractAdaptationLogic::LogicType::FixedRate:
+            return new FixedRateAdaptationLogic(nullptr, FIXED_RATE);
+        case AbstractAdaptationLogic::LogicType::RateBased:
+            return new RateBasedAdaptationLogic(nullptr);
+        case AbstractAdaptationLogic::LogicType::Predictive:
+            return new PredictiveAdaptationLogic(nullptr);
+        case AbstractAdaptationLogic::LogicType::NearOptimal:
+            return new NearOptimalAdaptationLogic(nullptr);
+        case AbstractAdaptationLogic::LogicType::Hybrid:
+            return new HybridAdaptationLogic(nullptr);
+        default:
+            return nullptr;
+    }
+}
+
+/* time to receive bits over the trace, starting at time start */
+static vlc_tick_t transferTime(const Trace &trace, vlc_tick_t start, uint64_t bits)
+{
+    vlc_tick_t period = 0;
+    for(const TraceSample &s : trace.samples)
+        period += VLC_TICK_FROM_MS(s.duration);
+
+    size_t i = 0;
+    vlc_tick_t offset = start % period;
+    while(offset >= VLC_TICK_FROM_MS(trace.samples[i].duration))
+        offset -= VLC_TICK_FROM_MS(trace.samples[i++].duration);
+
+    vlc_tick_t elapsed = 0;
+    for(;;)
+    {
+        const TraceSample &s = trace.samples[i];
+        const uint64_t bps = (uint64_t) s.bandwidth * 1000;
+        const vlc_tick_t remain = VLC_TICK_FROM_MS(s.duration) - offset;
+        const uint64_t capacity = bps * remain / CLOCK_FREQ;
+        if(bps && capacity >= bits)
+            return elapsed + bits * CLOCK_FREQ / bps;
+        bits -= capacity;
+        elapsed += remain;
+        offset = 0;
+        i = (i + 1) % trace.samples.size();
+    }
+}
+
+static Results simulate(AbstractAdaptationLogic *logic, BaseAdaptationSet *set,
+                        const BasePlaylist *playlist, const Trace &trace)
+{
+    DefaultBufferingLogic bufferinglogic;
+    const vlc_tick_t minbuffering = bufferinglogic.getMinBuffering(playlist);
+    const vlc_tick_t maxbuffering = bufferinglogic.getMaxBuffering(playlist);
+    const vlc_tick_t targetbuffering = bufferinglogic.getStableBuffering(playlist);
+    const ID &id = set->getID();
+
+    Results results = { 0, 0, 0, VLC_TICK_INVALID };
+    vlc_tick_t now = 0, buffering = 0, played = 0, stalled = 0;
+    uint64_t bitrates = 0;
+    bool playing = false;
+    BaseRepresentation *current = nullptr;
+
+    logic->trackerEvent(BufferingStateUpdatedEvent(id, true));
+
+    for(unsigned i=0; i<SEGMENT_COUNT; i++)
+    {
+        logic->trackerEvent(BufferingLevelChangedEvent(id, minbuffering, maxbuffering,
+                                                       buffering, targetbuffering));
+        BaseRepresentation *rep = logic->getNextRepresentation(set, current);
+        if(rep != current)
+        {
+            logic->trackerEvent(RepresentationSwitchEvent(current, rep));
+            if(current)
+                results.switches++;
+            current = rep;
+        }
+        bitrates += rep->getBandwidth();
+
+        const size_t size = rep->getBandwidth() * SEGMENT_DURATION / CLOCK_FREQ / 8;
+        const vlc_tick_t duration = REQUEST_LATENCY +
+                                    transferTime(trace, now + REQUEST_LATENCY, size * 8);
+        if(playing)
+        {
+            if(buffering >= duration)
+            {
+                buffering -= duration;
+                played += duration;
+            }
+            else /* underrun */
+            {
+                played += buffering;
+                stalled += duration - buffering;
+                buffering = 0;
+                playing = false;
+            }
+        }
+        else if(results.startup != VLC_TICK_INVALID)
+        {
+            stalled += duration;
+        }
+        now += duration;
+        logic->updateDownloadRate(id, size, duration, REQUEST_LATENCY);
+
+        buffering += SEGMENT_DURATION;
+        if(!playing && (buffering >= minbuffering || i + 1 == SEGMENT_COUNT))
+        {
+            playing = true;
+            if(results.startup == VLC_TICK_INVALID)
+                results.startup = now;
+        }
+
+        /* no more downloads until we're under the maximum */
+        if(playing && buffering > maxbuffering)
+        {
+            played += buffering - maxbuffering;
+            now += buffering - maxbuffering;
+            buffering = maxbuffering;
+        }
+    }
+    played += buffering;
+
+    logic->trackerEvent(RepresentationSwitchEvent(current, nullptr));
+    logic->trackerEvent(BufferingStateUpdatedEvent(id, false));
+
+    results.rebuffer_ratio = (double) stalled / (played + stalled);
+    results.mean_bitrate = bitrates / SEGMENT_COUNT;
+    return results;
+}
+
+static bool loadTrace(const char *psz_path, Trace &trace)
+{
+    std::ifstream file(psz_path);
+    if(!file.is_open())
+        return false;
+
+    bool b_valid = false;
+    std::string line;
+    while(std::getline(file, line))
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        TraceSample s;
+        if(!(fields >> s.duration >> s.bandwidth))
+            continue;
+        if(s.duration == 0)
+            continue;
+        b_valid |= (s.bandwidth > 0);
+        trace.samples.push_back(s);
+    }
+    trace.name = psz_path;
+    return b_valid;
+}
+
+static void checkResults(const Results *results)
+{
+    uint64_t lowest = UINT64_MAX, highest = 0;
+    for(size_t i=0; i<ARRAY_SIZE(logics); i++)
+    {
+        Expect(results[i].rebuffer_ratio >= 0.0 && results[i].rebuffer_ratio < 1.0);
+        Expect(results[i].startup != VLC_TICK_INVALID);
+        lowest = std::min(lowest, results[i].mean_bitrate);
+        highest = std::max(highest, results[i].mean_bitrate);
+    }
+    for(size_t i=0; i<ARRAY_SIZE(logics); i++)
+    {
+        switch(logics[i].type)
+        {
+            case AbstractAdaptationLogic::LogicType::AlwaysLowest:
+                Expect(results[i].mean_bitrate == lowest);
+                Expect(results[i].switches == 0);
+                break;
+            case AbstractAdaptationLogic::LogicType::AlwaysBest:
+                Expect(results[i].mean_bitrate == highest);
+                Expect(results[i].switches == 0);
+                break;
+            case AbstractAdaptationLogic::LogicType::Hybrid:
+                /* regression check, it copes with all the built-in traces */
+                Expect(results[i].rebuffer_ratio == 0.0);
+                Expect(results[i].mean_bitrate > lowest);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static int run(const std::vector<Trace> &traces, bool b_check)
+{
+    SimulatedPlaylist *playlist = nullptr;
+    try
+    {
+        playlist = new SimulatedPlaylist();
+        BasePeriod *period = nullptr;
+        BaseAdaptationSet *set = nullptr;
+        try
+        {
+            period = new BasePeriod(playlist);
+            set = new BaseAdaptationSet(period);
+        } catch(...) {
+            delete period;
+            std::rethrow_exception(std::current_exception());
+        }
+        set->setID(ID("video"));
+        period->addAdaptationSet(set);
+        playlist->addPeriod(period);
+
+        for(size_t i=0; i<ARRAY_SIZE(representations); i++)
+        {
+            BaseRepresentation *rep = new BaseRepresentation(set);
+            rep->setBandwidth(representations[i]);
+            set->addRepresentation(rep);
+        }
+
+        std::printf("%-16s %-12s %9s %14s %9s %11s\n", "trace", "logic",
+                    "rebuffer", "bitrate(kbps)", "switches", "startup(s)");
+
+        for(const Trace &trace : traces)
+        {
+            Results results[ARRAY_SIZE(logics)];
+            for(size_t i=0; i<ARRAY_SIZE(logics); i++)
+            {
+                AbstractAdaptationLogic *logic = createLogic(logics[i].type);
+                results[i] = simulate(logic, set, playlist, trace);
+                delete logic;
+
+                std::printf("%-16s %-12s %8.2f%% %14" PRIu64 " %9u %11.2f\n",
+                            trace.name.c_str(), logics[i].name,
+                            results[i].rebuffer_ratio * 100.0,
+                            results[i].mean_bitrate / 1000,
+                            results[i].switches,
+                            secf_from_vlc_tick(results[i].startup));
+            }
+
+            if(b_check)
+            {
+                checkResults(results);
+                /* plenty of bandwidth, nothing should stall */
+                if(trace.name == "steady")
+                {
+                    for(size_t i=0; i<ARRAY_SIZE(logics); i++)
+                        Expect(results[i].rebuffer_ratio == 0.0);
+                }
+            }
+        }
+    } catch (...) {
+        delete playlist;
+        return 1;
+    }
+
+    delete playlist;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<Trace> traces;
+
+    if(argc < 2)
+    {
+        traces.push_back(BUILTIN_TRACE(steady));
+        traces.push_back(BUILTIN_TRACE(stepdown));
+        traces.push_back(BUILTIN_TRACE(oscillating));
+        traces.push_back(BUILTIN_TRACE(mobile));
+        return run(traces, true);
+    }
+
+    for(int i=1; i<argc; i++)
+    {
+        Trace trace;
+        if(!loadTrace(argv[i], trace))
+        {
+            std::cerr << "Invalid trace " << argv[i] << std::endl;
+            return 1;
+        }
+        traces.push_back(trace);
+    }
+
+    return run(traces, false);
+}
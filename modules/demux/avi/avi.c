@@ -30,12 +30,14 @@
 #include <assert.h>
 #include <ctype.h>
 #include <limits.h>
+#include <stdatomic.h>
 
 #include <vlc_common.h>
 #include <vlc_arrays.h>
 #include <vlc_plugin.h>
 #include <vlc_demux.h>
 #include <vlc_input.h>
+#include <vlc_interrupt.h>
 #include <vlc_aout.h>
 
 #include <vlc_dialog.h>
@@ -46,6 +48,7 @@
 #include <vlc_arrays.h>
 
 #include "libavi.h"
+#include "../index_cache.h"
 #include "../rawdv.h"
 #include "bitmapinfoheader.h"
 #include "../../packetizer/h264_nal.h"
@@ -62,6 +65,11 @@
     "Recreate a index for the AVI file. Use this if your AVI file is damaged "\
     "or incomplete (not seekable)." )
 
+#define INDEX_CACHE_TEXT N_("Cache created indexes")
+#define INDEX_CACHE_LONGTEXT N_( \
+    "Keep the indexes created for broken or incomplete AVI files, so that " \
+    "they are not created again the next times these files are played." )
+
 static int  Open ( vlc_object_t * );
 static void Close( vlc_object_t * );
 
@@ -84,6 +92,8 @@ vlc_module_begin ()
     add_integer( "avi-index", 0,
               INDEX_TEXT, INDEX_LONGTEXT )
         change_integer_list( pi_index, ppsz_indexes )
+    add_bool( "avi-index-cache", true,
+              INDEX_CACHE_TEXT, INDEX_CACHE_LONGTEXT )
 
     set_callbacks( Open, Close )
 vlc_module_end ()
@@ -141,6 +151,8 @@ static void avi_index_Init( avi_index_t * );
 static void avi_index_Clean( avi_index_t * );
 static int64_t avi_index_Append( avi_index_t *, uint64_t *, avi_entry_t * );
 
+typedef struct avi_indexer_t avi_indexer_t;
+
 typedef struct
 {
     bool            b_activated;
@@ -204,6 +216,8 @@ typedef struct
     uint64_t i_movi_begin;
     uint64_t i_movi_lastchunk_pos;   /* XXX position of last valid chunk */
 
+    avi_indexer_t *p_indexer; /* index being created in the background */
+
     /* number of streams and information */
     unsigned int i_track;
     avi_track_t  **track;
@@ -231,13 +245,18 @@ static int AVI_StreamBytesSet ( demux_t *, avi_track_t *, uint64_t i_byte );
 vlc_fourcc_t AVI_FourccGetCodec( unsigned int i_cat, vlc_fourcc_t );
 static int   AVI_GetKeyFlag    ( const avi_track_t *, const uint8_t * );
 
-static int AVI_PacketGetHeader( demux_t *, avi_packet_t *p_pk );
-static int AVI_PacketNext     ( demux_t * );
+static void AVI_PacketParseHeader( const uint8_t *, uint64_t i_pos, avi_packet_t *p_pk );
+static int AVI_PacketGetHeader( stream_t *, avi_packet_t *p_pk );
+static int AVI_PacketSkipSize ( const avi_packet_t *p_pk, uint32_t *pi_skip );
+static int AVI_PacketNext     ( stream_t * );
 static int AVI_PacketSearch   ( demux_t * );
 
 static void AVI_IndexLoad    ( demux_t * );
 static void AVI_IndexCreate  ( demux_t * );
 
+static void AVI_IndexerPoll  ( demux_t *, bool b_wait );
+static void AVI_IndexerDelete( avi_indexer_t * );
+
 static void AVI_ExtractSubtitle( demux_t *, unsigned int i_stream, avi_chunk_list_t *, avi_chunk_STRING_t * );
 static avi_track_t * AVI_GetVideoTrackForXsub( demux_sys_t * );
 static int AVI_SeekSubtitleTrack( demux_sys_t *, avi_track_t * );
@@ -331,6 +350,9 @@ static void Close ( vlc_object_t * p_this )
     demux_t *    p_demux = (demux_t *)p_this;
     demux_sys_t *p_sys = p_demux->p_sys  ;
 
+    if( p_sys->p_indexer )
+        AVI_IndexerDelete( p_sys->p_indexer );
+
     for( unsigned int i = 0; i < p_sys->i_track; i++ )
     {
         if( p_sys->track[i] )
@@ -1083,6 +1105,9 @@ static int Demux_Seekable( demux_t *p_demux )
 
     unsigned int i_track_count = 0;
 
+    /* use the created index as soon as it is complete */
+    AVI_IndexerPoll( p_demux, false );
+
     /* detect new selected/unselected streams */
     for( unsigned int i = 0; i < p_sys->i_track; i++ )
     {
@@ -1244,7 +1269,7 @@ static int Demux_Seekable( demux_t *p_demux )
                 if (vlc_stream_Seek(p_demux->s, p_sys->i_movi_lastchunk_pos))
                     return VLC_DEMUXER_EGENERIC;
 
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return( AVI_TrackStopFinishedStreams( p_demux ) ? 0 : 1 );
                 }
@@ -1259,7 +1284,7 @@ static int Demux_Seekable( demux_t *p_demux )
             {
                 avi_packet_t avi_pk;
 
-                if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+                if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
                 {
                     msg_Warn( p_demux,
                              "cannot get packet header, track disabled" );
@@ -1268,7 +1293,7 @@ static int Demux_Seekable( demux_t *p_demux )
                 if( avi_pk.i_stream >= p_sys->i_track ||
                     ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
                 {
-                    if( AVI_PacketNext( p_demux ) )
+                    if( AVI_PacketNext( p_demux->s ) )
                     {
                         msg_Warn( p_demux,
                                   "cannot skip packet, track disabled" );
@@ -1302,7 +1327,7 @@ static int Demux_Seekable( demux_t *p_demux )
                     }
                     else
                     {
-                        if( AVI_PacketNext( p_demux ) )
+                        if( AVI_PacketNext( p_demux->s ) )
                         {
                             msg_Warn( p_demux,
                                       "cannot skip packet, track disabled" );
@@ -1488,7 +1513,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
     {
         avi_packet_t    avi_pk;
 
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             return VLC_DEMUXER_EOF;
         }
@@ -1505,11 +1530,11 @@ static int Demux_UnSeekable( demux_t *p_demux )
                 case AVIFOURCC_JUNK:
                 case AVIFOURCC_LIST:
                 case AVIFOURCC_RIFF:
-                    return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                    return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                 case AVIFOURCC_idx1:
                     if( p_sys->b_odml )
                     {
-                        return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                        return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                     }
                     return VLC_DEMUXER_EOF;
                 default:
@@ -1547,7 +1572,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
             }
             else
             {
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return VLC_DEMUXER_EOF;
                 }
@@ -1587,6 +1612,10 @@ static int Seek( demux_t *p_demux, vlc_tick_t i_date, double f_ratio, bool b_acc
     {
         uint64_t i_pos_backup = vlc_stream_Tell( p_demux->s );
 
+        /* the index being created is faster to complete than reading
+         * up to the position without it */
+        AVI_IndexerPoll( p_demux, true );
+
         /* Check and lazy load indexes if it was not done (not fastseekable) */
         if ( !p_sys->b_indexloaded && ( p_sys->i_avih_flags & AVIF_HASINDEX ) )
         {
@@ -1960,7 +1989,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, avi_track_t *tk )
     {
         if (vlc_stream_Seek(p_demux->s, p_sys->i_movi_lastchunk_pos))
             return VLC_EGENERIC;
-        if( AVI_PacketNext( p_demux ) )
+        if( AVI_PacketNext( p_demux->s ) )
         {
             return VLC_EGENERIC;
         }
@@ -1973,7 +2002,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, avi_track_t *tk )
 
     for( ;; )
     {
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             msg_Warn( p_demux, "cannot get packet header" );
             return VLC_EGENERIC;
@@ -1981,7 +2010,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, avi_track_t *tk )
         if( avi_pk.i_stream >= p_sys->i_track ||
             ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
         {
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -2006,7 +2035,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, avi_track_t *tk )
                 return VLC_SUCCESS;
             }
 
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -2318,17 +2347,12 @@ static void AVI_ParseStreamHeader( vlc_fourcc_t i_id,
 /****************************************************************************
  *
  ****************************************************************************/
-static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
+static void AVI_PacketParseHeader( const uint8_t *p_peek, uint64_t i_pos,
+                                   avi_packet_t *p_pk )
 {
-    const uint8_t *p_peek;
-
-    if( vlc_stream_Peek( p_demux->s, &p_peek, 16 ) < 16 )
-    {
-        return VLC_EGENERIC;
-    }
     p_pk->i_fourcc  = VLC_FOURCC( p_peek[0], p_peek[1], p_peek[2], p_peek[3] );
     p_pk->i_size    = GetDWLE( p_peek + 4 );
-    p_pk->i_pos     = vlc_stream_Tell( p_demux->s );
+    p_pk->i_pos     = i_pos;
     if( p_pk->i_fourcc == AVIFOURCC_LIST || p_pk->i_fourcc == AVIFOURCC_RIFF )
     {
         p_pk->i_type = VLC_FOURCC( p_peek[8],  p_peek[9],
@@ -2342,34 +2366,51 @@ static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
     memcpy( p_pk->i_peek, p_peek + 8, 8 );
 
     AVI_ParseStreamHeader( p_pk->i_fourcc, &p_pk->i_stream, &p_pk->i_cat );
-    return VLC_SUCCESS;
 }
 
-static int AVI_PacketNext( demux_t *p_demux )
+static int AVI_PacketGetHeader( stream_t *s, avi_packet_t *p_pk )
 {
-    avi_packet_t    avi_ck;
-    uint32_t        i_skip = 0;
+    const uint8_t *p_peek;
 
-    if( AVI_PacketGetHeader( p_demux, &avi_ck ) )
+    if( vlc_stream_Peek( s, &p_peek, 16 ) < 16 )
     {
         return VLC_EGENERIC;
     }
+    AVI_PacketParseHeader( p_peek, vlc_stream_Tell( s ), p_pk );
+    return VLC_SUCCESS;
+}
 
-    if( avi_ck.i_fourcc == AVIFOURCC_LIST &&
-        ( avi_ck.i_type == AVIFOURCC_rec || avi_ck.i_type == AVIFOURCC_movi ) )
+/* bytes from the packet start to the next packet */
+static int AVI_PacketSkipSize( const avi_packet_t *p_pk, uint32_t *pi_skip )
+{
+    if( p_pk->i_fourcc == AVIFOURCC_LIST &&
+        ( p_pk->i_type == AVIFOURCC_rec || p_pk->i_type == AVIFOURCC_movi ) )
     {
-        i_skip = 12;
+        *pi_skip = 12;
     }
-    else if( avi_ck.i_fourcc == AVIFOURCC_RIFF &&
-             avi_ck.i_type == AVIFOURCC_AVIX )
+    else if( p_pk->i_fourcc == AVIFOURCC_RIFF &&
+             p_pk->i_type == AVIFOURCC_AVIX )
     {
-        i_skip = 24;
+        *pi_skip = 24;
     }
     else
     {
-        if( avi_ck.i_size > UINT32_MAX - 9 )
+        if( p_pk->i_size > UINT32_MAX - 9 )
             return VLC_EGENERIC;
-        i_skip = __EVEN( avi_ck.i_size ) + 8;
+        *pi_skip = __EVEN( p_pk->i_size ) + 8;
+    }
+    return VLC_SUCCESS;
+}
+
+static int AVI_PacketNext( stream_t *s )
+{
+    avi_packet_t    avi_ck;
+    uint32_t        i_skip = 0;
+
+    if( AVI_PacketGetHeader( s, &avi_ck ) ||
+        AVI_PacketSkipSize( &avi_ck, &i_skip ) )
+    {
+        return VLC_EGENERIC;
     }
 
 #if SSIZE_MAX < UINT32_MAX // otherwise i_skip can't be bigger than SSIZE_MAX
@@ -2377,7 +2418,7 @@ static int AVI_PacketNext( demux_t *p_demux )
         return VLC_EGENERIC;
 #endif
 
-    if( vlc_stream_Read( p_demux->s, NULL, i_skip ) != i_skip )
+    if( vlc_stream_Read( s, NULL, i_skip ) != i_skip )
     {
         return VLC_EGENERIC;
     }
@@ -2396,7 +2437,7 @@ static int AVI_PacketSearch( demux_t *p_demux )
         {
             return VLC_EGENERIC;
         }
-        AVI_PacketGetHeader( p_demux, &avi_pk );
+        AVI_PacketGetHeader( p_demux->s, &avi_pk );
         if( avi_pk.i_stream < p_sys->i_track &&
             ( avi_pk.i_cat == AUDIO_ES || avi_pk.i_cat == VIDEO_ES ) )
         {
@@ -2750,6 +2791,614 @@ static void AVI_IndexLoad( demux_t *p_demux )
     }
 }
 
+/*****************************************************************************
+ * Created index cache
+ *****************************************************************************
+ * One file per location, all little endian:
+ *  "VLCAVIDX", u32 version, u64 file size, u64 file mtime, u32 tracks count,
+ *  then for each track: u32 codec, u32 entries count,
+ *   entries: u64 position, u32 flags, u32 length
+ *****************************************************************************/
+#define INDEX_CACHE_MAGIC    "VLCAVIDX"
+#define INDEX_CACHE_VERSION  1
+#define INDEX_CACHE_DIR      "aviindex"
+#define INDEX_CACHE_HEADER   (8 + 4 + 8 + 8 + 4)
+#define INDEX_CACHE_ENTRY    (8 + 4 + 4)
+
+static bool AVI_IndexCacheLoad( demux_t *p_demux, const char *psz_file,
+                                uint64_t i_size, uint64_t i_mtime )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    size_t i_data;
+    uint8_t *p_data = index_cache_Read( psz_file, SIZE_MAX, &i_data );
+    if( p_data == NULL )
+        return false;
+    if( i_data < INDEX_CACHE_HEADER )
+    {
+        free( p_data );
+        return false;
+    }
+
+    const uint8_t *p = p_data;
+    bool b_valid = !memcmp( p, INDEX_CACHE_MAGIC, 8 ) &&
+                   GetDWLE( &p[8] ) == INDEX_CACHE_VERSION &&
+                   GetQWLE( &p[12] ) == i_size && GetQWLE( &p[20] ) == i_mtime &&
+                   GetDWLE( &p[28] ) == p_sys->i_track;
+    size_t i_left = i_data - INDEX_CACHE_HEADER;
+    p += INDEX_CACHE_HEADER;
+
+    for( unsigned i = 0; b_valid && i < p_sys->i_track; i++ )
+    {
+        avi_track_t *tk = p_sys->track[i];
+        uint64_t i_last_pos = p_sys->i_movi_lastchunk_pos;
+
+        if( i_left < 8 || GetDWLE( p ) != tk->fmt.i_codec )
+        {
+            b_valid = false;
+            break;
+        }
+        const uint32_t i_entries = GetDWLE( &p[4] );
+        p += 8;
+        i_left -= 8;
+        if( i_entries > i_left / INDEX_CACHE_ENTRY )
+        {
+            b_valid = false;
+            break;
+        }
+
+        for( uint32_t j = 0; b_valid && j < i_entries; j++ )
+        {
+            avi_entry_t index;
+            index.i_pos     = GetQWLE( p );
+            index.i_flags   = GetDWLE( &p[8] );
+            index.i_length  = GetDWLE( &p[12] );
+            index.i_lengthtotal = index.i_length;
+            p += INDEX_CACHE_ENTRY;
+            i_left -= INDEX_CACHE_ENTRY;
+            b_valid = index.i_pos < i_size &&
+                      avi_index_Append( &tk->idx, &i_last_pos, &index ) >= 0;
+        }
+        p_sys->i_movi_lastchunk_pos = i_last_pos;
+    }
+    free( p_data );
+
+    if( !b_valid )
+    {
+        msg_Dbg( p_demux, "created index cache is outdated" );
+        for( unsigned i = 0; i < p_sys->i_track; i++ )
+        {
+            avi_index_Clean( &p_sys->track[i]->idx );
+            avi_index_Init( &p_sys->track[i]->idx );
+        }
+        return false;
+    }
+
+    msg_Dbg( p_demux, "loaded created index from %s", psz_file );
+    return true;
+}
+
+static void AVI_IndexCacheSave( vlc_object_t *p_obj, const char *psz_file,
+                                uint64_t i_size, uint64_t i_mtime,
+                                avi_track_t **track, unsigned i_track,
+                                const avi_index_t *p_idx )
+{
+    size_t i_data = INDEX_CACHE_HEADER;
+    for( unsigned i = 0; i < i_track; i++ )
+        i_data += 8 + (size_t) p_idx[i].i_size * INDEX_CACHE_ENTRY;
+
+    uint8_t *p_data = malloc( i_data );
+    if( unlikely(p_data == NULL) )
+        return;
+
+    uint8_t *p = p_data;
+    memcpy( p, INDEX_CACHE_MAGIC, 8 );
+    SetDWLE( &p[8], INDEX_CACHE_VERSION );
+    SetQWLE( &p[12], i_size );
+    SetQWLE( &p[20], i_mtime );
+    SetDWLE( &p[28], i_track );
+    p += INDEX_CACHE_HEADER;
+    for( unsigned i = 0; i < i_track; i++ )
+    {
+        SetDWLE( p, track[i]->fmt.i_codec );
+        SetDWLE( &p[4], p_idx[i].i_size );
+        p += 8;
+        for( uint32_t j = 0; j < p_idx[i].i_size; j++ )
+        {
+            SetQWLE( p, p_idx[i].p_entry[j].i_pos );
+            SetDWLE( &p[8], p_idx[i].p_entry[j].i_flags );
+            SetDWLE( &p[12], p_idx[i].p_entry[j].i_length );
+            p += INDEX_CACHE_ENTRY;
+        }
+    }
+    assert( (size_t)(p - p_data) == i_data );
+
+    if( index_cache_Write( p_obj, psz_file, p_data, i_data ) == VLC_SUCCESS )
+        msg_Dbg( p_obj, "saved created index to %s", psz_file );
+    free( p_data );
+}
+
+/*****************************************************************************
+ * Index creation in the background
+ *****************************************************************************
+ * The movi list is split in byte ranges scanned concurrently, each with its
+ * own stream. Except the first one, ranges start at the first chunk that is
+ * followed by another chunk. They are then joined where the previous range
+ * ended, and rescanned from there when they did not find that same chunk.
+ *****************************************************************************/
+#define INDEXER_MAX_RANGES  8
+#define INDEXER_RANGE_SIZE  (INT64_C(64) << 20) /* minimum */
+#define INDEXER_PEEK_SIZE   4096
+
+typedef struct
+{
+    avi_indexer_t *p_indexer;
+    vlc_thread_t   thread;
+    vlc_interrupt_t *p_interrupt;
+    stream_t      *s;
+    uint64_t       i_start;
+    uint64_t       i_end;
+    bool           b_synced;  /* i_start is known to be a chunk */
+    uint64_t       i_first;   /* first chunk scanned, UINT64_MAX if none */
+    uint64_t       i_next;    /* first chunk after the range, UINT64_MAX
+                                 if the movi list ends in the range */
+    avi_index_t   *p_idx;     /* one per track */
+} avi_indexer_range_t;
+
+struct avi_indexer_t
+{
+    vlc_thread_t  thread;
+    demux_t      *p_demux;
+    /* only the fields set on opening are read */
+    avi_track_t **track;
+    unsigned      i_track;
+    bool          b_odml;
+    uint64_t      i_movi_begin;
+    uint64_t      i_movi_end;
+    uint64_t      i_size;
+    uint64_t      i_mtime;
+    char         *psz_cache; /* where to save the index, or NULL */
+
+    /* one per thread, the first one scans the first range and joins them */
+    vlc_interrupt_t *interrupts[INDEXER_MAX_RANGES];
+    atomic_bool   b_done;
+
+    /* valid once done */
+    bool          b_complete;
+    avi_index_t  *p_idx;     /* one per track */
+    uint64_t      i_last_pos;
+};
+
+static bool AVI_IndexerIsChunk( const avi_indexer_t *p_indexer,
+                                const avi_packet_t *p_pk )
+{
+    if( p_pk->i_stream < p_indexer->i_track )
+        return p_pk->i_cat == p_indexer->track[p_pk->i_stream]->fmt.i_cat &&
+               p_pk->i_size < p_indexer->i_size;
+
+    switch( p_pk->i_fourcc )
+    {
+        case AVIFOURCC_LIST:
+            return p_pk->i_type == AVIFOURCC_rec || p_pk->i_type == AVIFOURCC_movi;
+        case AVIFOURCC_RIFF:
+            return p_pk->i_type == AVIFOURCC_AVIX;
+        case AVIFOURCC_JUNK:
+        case AVIFOURCC_idx1:
+            return p_pk->i_size < p_indexer->i_size;
+        default:
+            /* OpenDML standard index */
+            return ( p_pk->i_fourcc & 0xFFFF ) == VLC_TWOCC( 'i', 'x' ) &&
+                   p_pk->i_size < p_indexer->i_size;
+    }
+}
+
+/* Returns the position of the first chunk from i_pos followed by another
+ * one, or UINT64_MAX */
+static uint64_t AVI_IndexerResync( avi_indexer_t *p_indexer, stream_t *s,
+                                   uint64_t i_pos )
+{
+    while( i_pos + 16 <= p_indexer->i_size && !vlc_killed() )
+    {
+        const uint8_t *p_peek;
+        if( vlc_stream_Seek( s, i_pos ) )
+            break;
+        ssize_t i_peek = vlc_stream_Peek( s, &p_peek, INDEXER_PEEK_SIZE );
+        if( i_peek < 16 )
+            break;
+
+        uint64_t i_chunk = UINT64_MAX;
+        uint32_t i_skip = 0;
+        for( ssize_t i = 0; i + 16 <= i_peek; i++ )
+        {
+            avi_packet_t pk;
+            AVI_PacketParseHeader( &p_peek[i], i_pos + i, &pk );
+            if( AVI_IndexerIsChunk( p_indexer, &pk ) &&
+                AVI_PacketSkipSize( &pk, &i_skip ) == VLC_SUCCESS )
+            {
+                i_chunk = i_pos + i;
+                break;
+            }
+        }
+        if( i_chunk == UINT64_MAX )
+        {
+            i_pos += i_peek - 15;
+            continue;
+        }
+
+        /* confirm with the next chunk, unless this is the last one */
+        const uint64_t i_next = i_chunk + i_skip;
+        if( i_next <= p_indexer->i_size && i_next + 16 > p_indexer->i_size )
+            return i_chunk;
+
+        avi_packet_t pk;
+        if( i_next <= p_indexer->i_size &&
+            vlc_stream_Seek( s, i_next ) == VLC_SUCCESS &&
+            AVI_PacketGetHeader( s, &pk ) == VLC_SUCCESS &&
+            AVI_IndexerIsChunk( p_indexer, &pk ) )
+            return i_chunk;
+
+        i_pos = i_chunk + 1;
+    }
+    return UINT64_MAX;
+}
+
+static void AVI_IndexerScan( avi_indexer_t *p_indexer,
+                             avi_indexer_range_t *p_range, stream_t *s )
+{
+    uint64_t i_pos = p_range->b_synced ? p_range->i_start
+                   : AVI_IndexerResync( p_indexer, s, p_range->i_start );
+    uint64_t i_last_pos = 0;
+
+    p_range->i_first = i_pos;
+    p_range->i_next = UINT64_MAX;
+
+    while( i_pos != UINT64_MAX && !vlc_killed() )
+    {
+        if( i_pos >= p_range->i_end )
+        {
+            p_range->i_next = i_pos;
+            break;
+        }
+
+        avi_packet_t pk;
+        uint32_t i_skip;
+        if( vlc_stream_Seek( s, i_pos ) || AVI_PacketGetHeader( s, &pk ) )
+            break;
+
+        if( !AVI_IndexerIsChunk( p_indexer, &pk ) ||
+            AVI_PacketSkipSize( &pk, &i_skip ) )
+        {
+            i_pos = AVI_IndexerResync( p_indexer, s, i_pos + 1 );
+            continue;
+        }
+
+        if( pk.i_stream < p_indexer->i_track )
+        {
+            avi_entry_t index;
+            index.i_flags   = AVI_GetKeyFlag( p_indexer->track[pk.i_stream], pk.i_peek );
+            index.i_pos     = pk.i_pos;
+            index.i_length  = pk.i_size;
+            index.i_lengthtotal = pk.i_size;
+            avi_index_Append( &p_range->p_idx[pk.i_stream], &i_last_pos, &index );
+        }
+        else if( pk.i_fourcc == AVIFOURCC_idx1 && !p_indexer->b_odml )
+            break;
+
+        if( !p_indexer->b_odml && pk.i_pos + pk.i_size >= p_indexer->i_movi_end )
+            break;
+        i_pos += i_skip;
+    }
+}
+
+static void *AVI_IndexerRangeThread( void *data )
+{
+    avi_indexer_range_t *p_range = data;
+
+    vlc_thread_set_name( "vlc-avi-index" );
+
+    vlc_interrupt_set( p_range->p_interrupt );
+    AVI_IndexerScan( p_range->p_indexer, p_range, p_range->s );
+    return NULL;
+}
+
+static void *AVI_IndexerThread( void *data )
+{
+    avi_indexer_t *p_indexer = data;
+    demux_t *p_demux = p_indexer->p_demux;
+    avi_indexer_range_t ranges[INDEXER_MAX_RANGES];
+    bool pb_scanned[INDEXER_MAX_RANGES] = { false };
+
+    vlc_thread_set_name( "vlc-avi-index" );
+    vlc_interrupt_set( p_indexer->interrupts[0] );
+
+    const uint64_t i_begin = p_indexer->i_movi_begin + 12;
+    const uint64_t i_end = p_indexer->b_odml ? p_indexer->i_size
+                         : __MIN( p_indexer->i_movi_end, p_indexer->i_size );
+    unsigned i_ranges = __MIN( vlc_GetCPUCount(), INDEXER_MAX_RANGES );
+    if( i_end > i_begin )
+        i_ranges = __MIN( i_ranges, (i_end - i_begin) / INDEXER_RANGE_SIZE );
+    i_ranges = __MAX( i_ranges, 1 );
+
+    vlc_tick_t i_start_time = vlc_tick_now();
+
+    for( unsigned i = 0; i < i_ranges; i++ )
+    {
+        avi_indexer_range_t *p_range = &ranges[i];
+        p_range->p_indexer = p_indexer;
+        p_range->p_interrupt = p_indexer->interrupts[i];
+        p_range->i_start = i_begin + (i_end - i_begin) / i_ranges * i;
+        p_range->i_end = i + 1 < i_ranges ? p_range->i_start + (i_end - i_begin) / i_ranges
+                                          : i_end;
+        p_range->b_synced = i == 0;
+        p_range->i_first = p_range->i_next = UINT64_MAX;
+        p_range->p_idx = calloc( p_indexer->i_track, sizeof(*p_range->p_idx) );
+
+        /* the file is opened again for each range */
+        uint64_t i_size;
+        p_range->s = vlc_stream_NewURL( VLC_OBJECT(p_demux), p_demux->psz_url );
+        if( p_range->s &&
+            ( vlc_stream_GetSize( p_range->s, &i_size ) || i_size != p_indexer->i_size ) )
+        {
+            vlc_stream_Delete( p_range->s );
+            p_range->s = NULL;
+        }
+        if( unlikely(p_range->p_idx == NULL) || p_range->s == NULL )
+            continue;
+
+        if( i > 0 )
+            pb_scanned[i] = !vlc_clone( &p_range->thread, AVI_IndexerRangeThread, p_range );
+    }
+
+    stream_t *s = ranges[0].s;
+    bool b_valid = s != NULL;
+    for( unsigned i = 0; b_valid && i < i_ranges; i++ )
+        b_valid = ranges[i].p_idx != NULL;
+
+    if( b_valid )
+    {
+        AVI_IndexerScan( p_indexer, &ranges[0], s );
+        pb_scanned[0] = true;
+    }
+
+    for( unsigned i = 1; i < i_ranges; i++ )
+    {
+        if( pb_scanned[i] )
+            vlc_join( ranges[i].thread, NULL );
+    }
+
+    /* join the ranges */
+    uint64_t i_next = i_begin;
+    for( unsigned i = 0; b_valid && i < i_ranges && i_next != UINT64_MAX; i++ )
+    {
+        avi_indexer_range_t *p_range = &ranges[i];
+
+        if( i_next >= p_range->i_end )
+            continue; /* covered by a chunk of the previous range */
+
+        if( !pb_scanned[i] || p_range->i_first != i_next )
+        {
+            if( i > 0 )
+                msg_Dbg( p_demux, "index range %u not synchronized, scanning it again", i );
+            for( unsigned j = 0; j < p_indexer->i_track; j++ )
+            {
+                avi_index_Clean( &p_range->p_idx[j] );
+                avi_index_Init( &p_range->p_idx[j] );
+            }
+            p_range->i_start = i_next;
+            p_range->b_synced = true;
+            AVI_IndexerScan( p_indexer, p_range, s );
+        }
+
+        for( unsigned j = 0; j < p_indexer->i_track; j++ )
+        {
+            const avi_index_t *p_index = &p_range->p_idx[j];
+            for( uint32_t k = 0; k < p_index->i_size; k++ )
+            {
+                avi_entry_t index = p_index->p_entry[k];
+                avi_index_Append( &p_indexer->p_idx[j], &p_indexer->i_last_pos, &index );
+            }
+        }
+        i_next = p_range->i_next;
+    }
+
+    p_indexer->b_complete = b_valid && !vlc_killed();
+
+    if( p_indexer->b_complete )
+    {
+        msg_Dbg( p_demux, "index created in %"PRId64" ms using %u ranges",
+                 MS_FROM_VLC_TICK( vlc_tick_now() - i_start_time ), i_ranges );
+
+        /* do not keep the index of a file being written */
+        uint64_t i_size, i_mtime;
+        if( p_indexer->psz_cache &&
+            !index_cache_GetStamp( s, &i_size, &i_mtime ) &&
+            i_size == p_indexer->i_size && i_mtime == p_indexer->i_mtime )
+            AVI_IndexCacheSave( VLC_OBJECT(p_demux), p_indexer->psz_cache,
+                                p_indexer->i_size, p_indexer->i_mtime,
+                                p_indexer->track, p_indexer->i_track,
+                                p_indexer->p_idx );
+    }
+    else
+        msg_Warn( p_demux, "cannot create index" );
+
+    for( unsigned i = 0; i < i_ranges; i++ )
+    {
+        if( ranges[i].s )
+            vlc_stream_Delete( ranges[i].s );
+        if( ranges[i].p_idx )
+        {
+            for( unsigned j = 0; j < p_indexer->i_track; j++ )
+                avi_index_Clean( &ranges[i].p_idx[j] );
+            free( ranges[i].p_idx );
+        }
+    }
+
+    atomic_store_explicit( &p_indexer->b_done, true, memory_order_release );
+    return NULL;
+}
+
+static int AVI_IndexerStart( demux_t *p_demux, const avi_chunk_list_t *p_movi,
+                             char *psz_cache, uint64_t i_size, uint64_t i_mtime )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_demux->psz_url == NULL )
+        return VLC_EGENERIC;
+
+    avi_indexer_t *p_indexer = malloc( sizeof(*p_indexer) );
+    if( unlikely(p_indexer == NULL) )
+        return VLC_ENOMEM;
+
+    p_indexer->p_idx = calloc( p_sys->i_track, sizeof(*p_indexer->p_idx) );
+    if( unlikely(p_indexer->p_idx == NULL) )
+    {
+        free( p_indexer );
+        return VLC_ENOMEM;
+    }
+
+    p_indexer->p_demux = p_demux;
+    p_indexer->track = p_sys->track;
+    p_indexer->i_track = p_sys->i_track;
+    p_indexer->b_odml = p_sys->b_odml;
+    p_indexer->i_movi_begin = p_movi->i_chunk_pos;
+    p_indexer->i_movi_end = p_movi->i_chunk_pos + p_movi->i_chunk_size;
+    p_indexer->i_size = i_size;
+    p_indexer->i_mtime = i_mtime;
+    p_indexer->psz_cache = psz_cache;
+    atomic_init( &p_indexer->b_done, false );
+    p_indexer->b_complete = false;
+    p_indexer->i_last_pos = 0;
+
+    bool b_error = false;
+    for( unsigned i = 0; i < INDEXER_MAX_RANGES; i++ )
+    {
+        p_indexer->interrupts[i] = vlc_interrupt_create();
+        b_error |= p_indexer->interrupts[i] == NULL;
+    }
+
+    if( b_error ||
+        vlc_clone( &p_indexer->thread, AVI_IndexerThread, p_indexer ) )
+    {
+        for( unsigned i = 0; i < INDEXER_MAX_RANGES; i++ )
+            if( p_indexer->interrupts[i] )
+                vlc_interrupt_destroy( p_indexer->interrupts[i] );
+        free( p_indexer->p_idx );
+        free( p_indexer );
+        return VLC_EGENERIC;
+    }
+
+    p_sys->p_indexer = p_indexer;
+    msg_Dbg( p_demux, "creating index in the background" );
+    return VLC_SUCCESS;
+}
+
+static void AVI_IndexerDelete( avi_indexer_t *p_indexer )
+{
+    /* also stops the reads waiting for the access */
+    for( unsigned i = 0; i < INDEXER_MAX_RANGES; i++ )
+        vlc_interrupt_kill( p_indexer->interrupts[i] );
+    vlc_join( p_indexer->thread, NULL );
+
+    for( unsigned i = 0; i < INDEXER_MAX_RANGES; i++ )
+        vlc_interrupt_destroy( p_indexer->interrupts[i] );
+    for( unsigned i = 0; i < p_indexer->i_track; i++ )
+        avi_index_Clean( &p_indexer->p_idx[i] );
+    free( p_indexer->p_idx );
+    free( p_indexer->psz_cache );
+    free( p_indexer );
+}
+
+/* first entry at or after i_pos */
+static uint32_t avi_index_Find( const avi_index_t *p_index, uint64_t i_pos )
+{
+    uint32_t i_low = 0, i_high = p_index->i_size;
+    while( i_low < i_high )
+    {
+        uint32_t i_mid = i_low + (i_high - i_low) / 2;
+        if( p_index->p_entry[i_mid].i_pos < i_pos )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+static void AVI_IndexerPoll( demux_t *p_demux, bool b_wait )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_indexer_t *p_indexer = p_sys->p_indexer;
+
+    if( p_indexer == NULL )
+        return;
+
+    while( !atomic_load_explicit( &p_indexer->b_done, memory_order_acquire ) )
+    {
+        if( !b_wait || vlc_msleep_i11e( VLC_TICK_FROM_MS(10) ) )
+            return;
+    }
+
+    p_sys->p_indexer = NULL;
+
+    if( p_indexer->b_complete )
+    {
+        for( unsigned i = 0; i < p_sys->i_track; i++ )
+        {
+            avi_track_t *tk = p_sys->track[i];
+            avi_index_t *p_index = &p_indexer->p_idx[i];
+
+            /* what was indexed while playing can be as complete */
+            if( p_index->i_size <= tk->idx.i_size )
+                continue;
+
+            /* keep reading from the same chunk */
+            uint32_t i_idxposc = 0;
+            if( tk->i_idxposc < tk->idx.i_size )
+                i_idxposc = avi_index_Find( p_index, tk->idx.p_entry[tk->i_idxposc].i_pos );
+            else if( tk->idx.i_size > 0 )
+                i_idxposc = avi_index_Find( p_index, tk->idx.p_entry[tk->idx.i_size - 1].i_pos + 1 );
+
+            avi_index_Clean( &tk->idx );
+            tk->idx = *p_index;
+            tk->i_idxposc = i_idxposc;
+            avi_index_Init( p_index );
+
+            msg_Dbg( p_demux, "stream[%u] created %"PRIu32" index entries",
+                     i, tk->idx.i_size );
+        }
+        p_sys->i_movi_lastchunk_pos = __MAX( p_sys->i_movi_lastchunk_pos,
+                                             p_indexer->i_last_pos );
+        p_sys->i_length = AVI_MovieGetLength( p_demux );
+    }
+
+    AVI_IndexerDelete( p_indexer );
+}
+
+/* Loads the cached index, or starts creating it in the background.
+ * Returns false if it has to be created now. */
+static bool AVI_IndexCreateAsync( demux_t *p_demux, const avi_chunk_list_t *p_movi )
+{
+    uint64_t i_size, i_mtime;
+    if( p_demux->psz_url == NULL ||
+        index_cache_GetStamp( p_demux->s, &i_size, &i_mtime ) )
+        return false;
+
+    char *psz_cache = var_InheritBool( p_demux, "avi-index-cache" )
+                    ? index_cache_GetPath( VLC_OBJECT(p_demux), INDEX_CACHE_DIR,
+                                           p_demux->psz_url ) : NULL;
+    if( psz_cache && AVI_IndexCacheLoad( p_demux, psz_cache, i_size, i_mtime ) )
+    {
+        free( psz_cache );
+        return true;
+    }
+
+    if( AVI_IndexerStart( p_demux, p_movi, psz_cache, i_size, i_mtime ) )
+    {
+        free( psz_cache );
+        return false;
+    }
+    return true;
+}
+
 static void AVI_IndexCreate( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -2775,6 +3424,9 @@ static void AVI_IndexCreate( demux_t *p_demux )
     for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
         avi_index_Init( &p_sys->track[i_stream]->idx );
 
+    if( p_sys->b_fastseekable && AVI_IndexCreateAsync( p_demux, p_movi ) )
+        return;
+
     i_movi_end = __MIN( (uint32_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
                         stream_Size( p_demux->s ) );
 
@@ -2810,7 +3462,7 @@ static void AVI_IndexCreate( demux_t *p_demux )
             i_dialog_update = vlc_tick_now();
         }
 
-        if( AVI_PacketGetHeader( p_demux, &pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &pk ) )
             break;
 
         if( pk.i_stream < p_sys->i_track &&
@@ -2863,7 +3515,7 @@ static void AVI_IndexCreate( demux_t *p_demux )
         }
 
         if( ( !p_sys->b_odml && pk.i_pos + pk.i_size >= i_movi_end ) ||
-            AVI_PacketNext( p_demux ) )
+            AVI_PacketNext( p_demux->s ) )
         {
             break;
         }
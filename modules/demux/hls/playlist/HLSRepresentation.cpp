@@ -28,13 +28,20 @@
 #include "Parser.hpp"
 #include "HLSSegment.hpp"
 #include "../../adaptive/playlist/BaseAdaptationSet.h"
+#include "../../adaptive/http/Chunk.h"
+#include "../../adaptive/http/HTTPConnectionManager.h"
+#include "../../adaptive/SharedResources.hpp"
 #include "../../adaptive/playlist/SegmentList.h"
 
+#include <vlc_block.h>
+
 #include <ctime>
 #include <limits>
+#include <sstream>
 
 using namespace hls;
 using namespace hls::playlist;
+using namespace adaptive::http;
 
 HLSRepresentation::HLSRepresentation  ( BaseAdaptationSet *set ) :
                 BaseRepresentation( set )
@@ -44,12 +51,20 @@ HLSRepresentation::HLSRepresentation  ( BaseAdaptationSet *set ) :
     updateFailureCount = 0;
     lastUpdateTime = 0;
     targetDuration = 0;
+    partTargetDuration = 0;
+    partHoldBack = 0;
+    b_blockingReload = false;
+    nextMediaSequence = 0;
+    nextPartIndex = 0;
     streamFormat = StreamFormat::Type::Unknown;
     channels = 0;
+    pendingReload = nullptr;
 }
 
 HLSRepresentation::~HLSRepresentation ()
 {
+    if(pendingReload)
+        pendingReload->recycle();
 }
 
 StreamFormat HLSRepresentation::getStreamFormat() const
@@ -62,6 +77,11 @@ bool HLSRepresentation::isLive() const
     return b_live;
 }
 
+bool HLSRepresentation::isLowLatency() const
+{
+    return partTargetDuration > 0;
+}
+
 bool HLSRepresentation::initialized() const
 {
     return b_loaded;
@@ -87,6 +107,22 @@ Url HLSRepresentation::getPlaylistUrl() const
     }
 }
 
+std::string HLSRepresentation::getUpdateUrl() const
+{
+    std::string url = getPlaylistUrl().toString();
+    if(!b_blockingReload || !b_loaded || !isLive())
+        return url;
+
+    /* Have the server hold the reply until the next part is published */
+    std::stringstream ss;
+    ss.imbue(std::locale("C"));
+    ss << url << (url.find('?') == std::string::npos ? '?' : '&')
+       << "_HLS_msn=" << nextMediaSequence;
+    if(isLowLatency())
+        ss << "&_HLS_part=" << nextPartIndex;
+    return ss.str();
+}
+
 void HLSRepresentation::debug(vlc_object_t *obj, int indent) const
 {
     BaseRepresentation::debug(obj, indent);
@@ -129,6 +165,9 @@ bool HLSRepresentation::needsUpdate(uint64_t number) const
         return false;
     if(!b_loaded)
         return true;
+    /* applied as soon as the server replied */
+    if(pendingReload)
+        return pendingReload->isDone();
     if(isLive())
     {
         const vlc_tick_t now = vlc_tick_now();
@@ -136,9 +175,14 @@ bool HLSRepresentation::needsUpdate(uint64_t number) const
         vlc_tick_t duration = targetDuration
                             ? vlc_tick_from_sec(targetDuration)
                             : VLC_TICK_FROM_SEC(2);
+        /* low latency playlists change with every part */
+        if(isLowLatency())
+            duration = partTargetDuration;
         if(updateFailureCount)
             duration /= 2;
-        if(elapsed < duration)
+        /* blocking reloads are held by the server, only
+         * rate limit the ones which would not */
+        if(elapsed < (b_blockingReload ? duration / 4 : duration))
             return false;
 
         if(number == std::numeric_limits<uint64_t>::max())
@@ -150,11 +194,65 @@ bool HLSRepresentation::needsUpdate(uint64_t number) const
     return false;
 }
 
+/* The server holds blocking reloads until the next part is published:
+ * they are downloaded by the connection manager, so that the demux does
+ * not wait for them */
+void HLSRepresentation::startReload(SharedResources *res)
+{
+    if(!b_blockingReload || !isLive())
+        return;
+
+    AbstractConnectionManager *connManager = res->getConnManager();
+    AbstractChunkSource *source = connManager->makeSource(getUpdateUrl(), ID(),
+                                                          ChunkType::Playlist,
+                                                          BytesRange());
+    if(!source)
+        return;
+    pendingReload = dynamic_cast<HTTPChunkBufferedSource *>(source);
+    if(!pendingReload)
+    {
+        source->recycle();
+        return;
+    }
+    connManager->start(pendingReload);
+}
+
+block_t * HLSRepresentation::takeReload()
+{
+    block_t *p_head = nullptr;
+    block_t **pp_tail = &p_head;
+    for(;;)
+    {
+        block_t *p_block = pendingReload->readBlock();
+        if(!p_block)
+            break;
+        block_ChainLastAppend(&pp_tail, p_block);
+    }
+    pendingReload->recycle();
+    pendingReload = nullptr;
+
+    return p_head ? block_ChainGather(p_head) : nullptr;
+}
+
 bool HLSRepresentation::runLocalUpdates(SharedResources *res)
 {
     BasePlaylist *playlist = getPlaylist();
     M3U8Parser parser(res);
-    if(!parser.appendSegmentsFromPlaylistURI(playlist->getVLCObject(), this))
+    bool b_updated;
+    if(pendingReload)
+    {
+        if(!pendingReload->isDone())
+            return false;
+        block_t *p_block = takeReload();
+        b_updated = p_block && p_block->i_buffer;
+        if(b_updated)
+            parser.appendSegmentsFromPlaylistData(playlist->getVLCObject(), this, p_block);
+        else if(p_block)
+            block_Release(p_block);
+    }
+    else b_updated = parser.appendSegmentsFromPlaylistURI(playlist->getVLCObject(), this);
+
+    if(!b_updated)
     {
         msg_Warn(playlist->getVLCObject(), "Failed to update %u/%u playlist ID %s",
                  updateFailureCount, MAX_UPDATE_FAILED_UPDATE_COUNT,
@@ -167,6 +265,7 @@ bool HLSRepresentation::runLocalUpdates(SharedResources *res)
     {
         updateFailureCount = 0;
         b_loaded = true;
+        startReload(res);
         return true;
     }
 }
@@ -25,6 +25,14 @@
 #include "../../adaptive/tools/Properties.hpp"
 #include "../../adaptive/StreamFormat.hpp"
 
+namespace adaptive
+{
+    namespace http
+    {
+        class HTTPChunkBufferedSource;
+    }
+}
+
 namespace hls
 {
     namespace playlist
@@ -45,7 +53,9 @@ namespace hls
 
                 void setPlaylistUrl(const std::string &);
                 Url getPlaylistUrl() const;
+                std::string getUpdateUrl() const;
                 bool isLive() const;
+                bool isLowLatency() const;
                 bool initialized() const;
                 void scheduleNextUpdate(uint64_t, bool) override;
                 bool needsUpdate(uint64_t) const override;
@@ -60,6 +70,11 @@ namespace hls
 
             protected:
                 time_t targetDuration;
+                vlc_tick_t partTargetDuration;
+                vlc_tick_t partHoldBack;
+                bool b_blockingReload;
+                uint64_t nextMediaSequence; /* first missing part, for blocking reloads */
+                uint64_t nextPartIndex;
                 Url playlistUrl;
 
             private:
@@ -70,6 +85,10 @@ namespace hls
                 unsigned updateFailureCount;
                 vlc_tick_t lastUpdateTime;
                 unsigned channels;
+                /* blocking reload held by the server, in background */
+                adaptive::http::HTTPChunkBufferedSource *pendingReload;
+                void startReload(SharedResources *);
+                block_t * takeReload();
         };
     }
 }
@@ -36,6 +36,7 @@ namespace hls
                 virtual ~M3U8();
 
                 bool isLive() const override;
+                bool isLowLatency() const override;
         };
     }
 }
@@ -225,25 +225,32 @@ void M3U8Parser::fillAdaptsetFromMediainfo(const AttributesTag *mediatag,
 
 bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, HLSRepresentation *rep)
 {
-    block_t *p_block = Retrieve::HTTP(resources, ChunkType::Playlist, rep->getPlaylistUrl().toString());
+    block_t *p_block = Retrieve::HTTP(resources, ChunkType::Playlist,
+                                      rep->getPlaylistUrl().toString());
     if(p_block)
     {
-        stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
-        if(substream)
-        {
-            std::list<Tag *> tagslist = parseEntries(substream);
-            vlc_stream_Delete(substream);
-
-            parseSegments(p_obj, rep, tagslist);
-
-            releaseTagsList(tagslist);
-        }
-        block_Release(p_block);
+        appendSegmentsFromPlaylistData(p_obj, rep, p_block);
         return true;
     }
     return false;
 }
 
+void M3U8Parser::appendSegmentsFromPlaylistData(vlc_object_t *p_obj, HLSRepresentation *rep,
+                                                block_t *p_block)
+{
+    stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
+    if(substream)
+    {
+        std::list<Tag *> tagslist = parseEntries(substream);
+        vlc_stream_Delete(substream);
+
+        parseSegments(p_obj, rep, tagslist);
+
+        releaseTagsList(tagslist);
+    }
+    block_Release(p_block);
+}
+
 static bool parseEncryption(const AttributesTag *keytag, const Url &playlistUrl,
                             CommonEncryption &encryption)
 {
@@ -301,6 +308,10 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
     const SingleValueTag *ctx_byterange = nullptr;
     CommonEncryption encryption;
     const ValuesListTag *ctx_extinf = nullptr;
+    const AttributesTag *ctx_preloadhint = nullptr;
+    std::vector<HLSSegment *> parts; /* of the segment being listed */
+    vlc_tick_t nzPartsDuration = 0;
+    std::size_t prevpartrangeoffset = 0;
 
     std::list<HLSSegment *> segmentstoappend;
 
@@ -375,6 +386,83 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
 
                 if(encryption.method != CommonEncryption::Method::None)
                     segment->setEncryption(encryption);
+
+                for(HLSSegment *part : parts)
+                    segment->addPart(part);
+                parts.clear();
+                nzPartsDuration = 0;
+                ctx_preloadhint = nullptr;
+            }
+            break;
+
+            case AttributesTag::EXTXPART:
+            {
+                const AttributesTag *parttag = static_cast<const AttributesTag *>(tag);
+                const Attribute *uriAttr = parttag->getAttributeByName("URI");
+                const Attribute *durAttr = parttag->getAttributeByName("DURATION");
+                if(!uriAttr || !durAttr)
+                    break;
+
+                HLSSegment *part = new (std::nothrow) HLSSegment(rep, sequenceNumber);
+                if(!part)
+                    break;
+
+                part->debugName = "Part";
+                part->setSourceUrl(uriAttr->quotedString());
+                const vlc_tick_t nzDuration = vlc_tick_from_sec(durAttr->floatingPoint());
+                part->duration.Set(timescale.ToScaled(nzDuration));
+                part->startTime.Set(timescale.ToScaled(nzPartsDuration));
+                nzPartsDuration += nzDuration;
+
+                const Attribute *independentAttr = parttag->getAttributeByName("INDEPENDENT");
+                part->independent = parts.empty() ||
+                                    (independentAttr && independentAttr->value == "YES");
+
+                const Attribute *byterangeAttr = parttag->getAttributeByName("BYTERANGE");
+                if(byterangeAttr)
+                {
+                    std::pair<std::size_t,std::size_t> range = byterangeAttr->unescapeQuotes().getByteRange();
+                    if(range.first == 0)
+                        range.first = prevpartrangeoffset;
+                    prevpartrangeoffset = range.first + range.second;
+                    part->setByteRange(range.first, prevpartrangeoffset - 1);
+                }
+
+                part->setDiscontinuitySequenceNumber(discontinuitySequence);
+                part->discontinuity = parts.empty() && discontinuity;
+                if(encryption.method != CommonEncryption::Method::None)
+                    part->setEncryption(encryption);
+
+                parts.push_back(part);
+            }
+            break;
+
+            case AttributesTag::EXTXPRELOADHINT:
+            {
+                const AttributesTag *hinttag = static_cast<const AttributesTag *>(tag);
+                const Attribute *typeAttr = hinttag->getAttributeByName("TYPE");
+                if(typeAttr && typeAttr->value == "PART" && hinttag->getAttributeByName("URI"))
+                    ctx_preloadhint = hinttag;
+            }
+            break;
+
+            case AttributesTag::EXTXPARTINF:
+            {
+                const Attribute *targetAttr = static_cast<const AttributesTag *>(tag)->
+                                              getAttributeByName("PART-TARGET");
+                if(targetAttr)
+                    rep->partTargetDuration = vlc_tick_from_sec(targetAttr->floatingPoint());
+            }
+            break;
+
+            case AttributesTag::EXTXSERVERCONTROL:
+            {
+                const AttributesTag *controltag = static_cast<const AttributesTag *>(tag);
+                const Attribute *attr = controltag->getAttributeByName("CAN-BLOCK-RELOAD");
+                rep->b_blockingReload = attr && attr->value == "YES";
+                attr = controltag->getAttributeByName("PART-HOLD-BACK");
+                if(attr)
+                    rep->partHoldBack = vlc_tick_from_sec(attr->floatingPoint());
             }
             break;
 
@@ -451,10 +539,78 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
         }
     }
 
+    /* Parts of the segment being published, followed by the
+     * one which will be requested next */
+    rep->nextMediaSequence = sequenceNumber;
+    rep->nextPartIndex = parts.size();
+    if(ctx_preloadhint && rep->partTargetDuration)
+    {
+        const Attribute *startAttr = ctx_preloadhint->getAttributeByName("BYTERANGE-START");
+        const Attribute *lengthAttr = ctx_preloadhint->getAttributeByName("BYTERANGE-LENGTH");
+        HLSSegment *part = nullptr;
+        /* open ended ranges can't be requested */
+        if(!startAttr || lengthAttr)
+            part = new (std::nothrow) HLSSegment(rep, sequenceNumber);
+        if(part)
+        {
+            part->debugName = "PreloadPart";
+            part->setSourceUrl(ctx_preloadhint->getAttributeByName("URI")->quotedString());
+            part->duration.Set(timescale.ToScaled(rep->partTargetDuration));
+            part->startTime.Set(timescale.ToScaled(nzPartsDuration));
+            nzPartsDuration += rep->partTargetDuration;
+            part->independent = parts.empty();
+            if(lengthAttr)
+            {
+                const std::size_t start = startAttr ? startAttr->decimal() : 0;
+                part->setByteRange(start, start + lengthAttr->decimal() - 1);
+            }
+            part->setDiscontinuitySequenceNumber(discontinuitySequence);
+            part->discontinuity = parts.empty() && discontinuity;
+            if(encryption.method != CommonEncryption::Method::None)
+                part->setEncryption(encryption);
+            parts.push_back(part);
+        }
+    }
+
+    if(!parts.empty())
+    {
+        HLSSegment *segment = new (std::nothrow) HLSSegment(rep, sequenceNumber);
+        if(segment)
+        {
+            segment->setPartial(true);
+            segment->duration.Set(timescale.ToScaled(nzPartsDuration));
+            segment->startTime.Set(timescale.ToScaled(nzStartTime));
+            if(absReferenceTime != VLC_TICK_INVALID)
+                segment->setDisplayTime(absReferenceTime);
+            segment->setDiscontinuitySequenceNumber(discontinuitySequence);
+            segment->discontinuity = discontinuity;
+            if(encryption.method != CommonEncryption::Method::None)
+                segment->setEncryption(encryption);
+            for(HLSSegment *part : parts)
+                segment->addPart(part);
+            segmentstoappend.push_back(segment);
+        }
+        else
+        {
+            for(HLSSegment *part : parts)
+                delete part;
+        }
+        parts.clear();
+    }
+
     for(HLSSegment *seg : segmentstoappend)
         segmentList->addSegment(seg);
     segmentstoappend.clear();
 
+    if(rep->isLowLatency())
+    {
+        /* Use the server recommended distance to the live edge */
+        vlc_tick_t holdback = rep->partHoldBack ? rep->partHoldBack
+                                                : rep->partTargetDuration * 3;
+        if(holdback > rep->getPlaylist()->suggestedPresentationDelay.Get())
+            rep->getPlaylist()->suggestedPresentationDelay.Set(holdback);
+    }
+
     if(rep->isLive())
     {
         rep->getPlaylist()->duration.Set(0);
@@ -0,0 +1,138 @@
+/*****************************************************************************
+ * index_cache.c: Cached seek index files helpers
+ *****************************************************************************
+ * Copyright (C) 2025 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_stream.h>
+#include <vlc_configuration.h>
+#include <vlc_fs.h>
+#include <vlc_hash.h>
+#include <vlc_strings.h>
+
+#include "index_cache.h"
+
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int index_cache_GetStamp( stream_t *s, uint64_t *pi_size, uint64_t *pi_mtime )
+{
+    if( vlc_stream_GetSize( s, pi_size ) || *pi_size == 0 )
+        return VLC_EGENERIC;
+    if( vlc_stream_GetMTime( s, pi_mtime ) )
+        *pi_mtime = 0;
+    return VLC_SUCCESS;
+}
+
+char * index_cache_GetPath( vlc_object_t *p_obj, const char *psz_subdir,
+                            const char *psz_key )
+{
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_cachedir == NULL )
+        return NULL;
+
+    char *psz_dir;
+    if( asprintf( &psz_dir, "%s"DIR_SEP"%s", psz_cachedir, psz_subdir ) == -1 )
+        psz_dir = NULL;
+    free( psz_cachedir );
+    if( psz_dir == NULL )
+        return NULL;
+
+    if( vlc_mkdir_parent( psz_dir, 0700 ) && errno != EEXIST )
+    {
+        msg_Warn( p_obj, "cannot create %s: %s", psz_dir, vlc_strerror_c(errno) );
+        free( psz_dir );
+        return NULL;
+    }
+
+    vlc_hash_md5_t md5;
+    char psz_hash[VLC_HASH_MD5_DIGEST_HEX_SIZE];
+    vlc_hash_md5_Init( &md5 );
+    vlc_hash_md5_Update( &md5, psz_key, strlen( psz_key ) );
+    vlc_hash_FinishHex( &md5, psz_hash );
+
+    char *psz_file;
+    if( asprintf( &psz_file, "%s"DIR_SEP"%s.idx", psz_dir, psz_hash ) == -1 )
+        psz_file = NULL;
+    free( psz_dir );
+    return psz_file;
+}
+
+uint8_t * index_cache_Read( const char *psz_file, size_t i_max, size_t *pi_size )
+{
+    struct stat st;
+    if( vlc_stat( psz_file, &st ) || st.st_size <= 0 ||
+        (uint64_t) st.st_size > i_max )
+        return NULL;
+
+    FILE *file = vlc_fopen( psz_file, "rb" );
+    if( file == NULL )
+        return NULL;
+
+    const size_t i_size = st.st_size;
+    uint8_t *p_data = malloc( i_size );
+    if( p_data != NULL && fread( p_data, 1, i_size, file ) != i_size )
+    {
+        free( p_data );
+        p_data = NULL;
+    }
+    fclose( file );
+
+    *pi_size = i_size;
+    return p_data;
+}
+
+int index_cache_Write( vlc_object_t *p_obj, const char *psz_file,
+                       const uint8_t *p_data, size_t i_size )
+{
+    char *psz_tmp;
+    if( asprintf( &psz_tmp, "%s.%"PRIu32, psz_file, (uint32_t)getpid() ) == -1 )
+        return VLC_ENOMEM;
+
+    int i_ret = VLC_EGENERIC;
+    FILE *file = vlc_fopen( psz_tmp, "wb" );
+    if( file == NULL )
+    {
+        msg_Warn( p_obj, "cannot create %s: %s", psz_tmp, vlc_strerror_c(errno) );
+    }
+    else if( fwrite( p_data, 1, i_size, file ) != i_size )
+    {
+        msg_Warn( p_obj, "cannot write %s: %s", psz_tmp, vlc_strerror_c(errno) );
+        fclose( file );
+        vlc_unlink( psz_tmp );
+    }
+    else
+    {
+#if !defined( _WIN32 ) && !defined( __OS2__ )
+        vlc_rename( psz_tmp, psz_file ); /* atomically replace old cache */
+        fclose( file );
+#else
+        vlc_unlink( psz_file );
+        fclose( file );
+        vlc_rename( psz_tmp, psz_file );
+#endif
+        i_ret = VLC_SUCCESS;
+    }
+
+    free( psz_tmp );
+    return i_ret;
+}
@@ -0,0 +1,55 @@
+/*****************************************************************************
+ * index_cache.h: Cached seek index files helpers
+ *****************************************************************************
+ * Copyright (C) 2025 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_DEMUX_INDEX_CACHE_H
+#define VLC_DEMUX_INDEX_CACHE_H
+
+/* Demuxers can remember what they learnt about a file, such as the
+ * positions of its times, in one file per location of the user cache
+ * directory. A cache is only valid for the file content it was built
+ * from, identified by its stamp. */
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+/* Gets the stamp of the stream content: its size and, since not all
+ * accesses report it, its modification time or 0.
+ * Returns VLC_EGENERIC when the size is not known. */
+int index_cache_GetStamp( stream_t *, uint64_t *pi_size, uint64_t *pi_mtime );
+
+/* Returns the heap allocated path of the cache file for psz_key, in the
+ * psz_subdir directory of the user cache, that is created if needed,
+ * or NULL on error. */
+char * index_cache_GetPath( vlc_object_t *, const char *psz_subdir,
+                            const char *psz_key );
+
+/* Reads a whole cache file of at most i_max bytes.
+ * Returns the heap allocated content, or NULL if there is none. */
+uint8_t * index_cache_Read( const char *psz_file, size_t i_max, size_t *pi_size );
+
+/* Replaces the cache file, so that readers never see a partial one. */
+int index_cache_Write( vlc_object_t *, const char *psz_file,
+                       const uint8_t *p_data, size_t i_size );
+
+# ifdef __cplusplus
+}
+# endif
+
+#endif
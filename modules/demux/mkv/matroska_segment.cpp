@@ -640,6 +640,9 @@ bool matroska_segment_c::Preload( )
 
             cluster = cluster_;
 
+            // the other clusters are located from the first one
+            _seeker._cluster_hop_pos = cluster->GetElementPosition();
+
             // add first cluster as trusted seekpoint for all tracks
             for( tracks_map_t::const_iterator it = tracks.begin();
                  it != tracks.end(); ++it )
@@ -688,6 +691,9 @@ bool matroska_segment_c::Preload( )
 
     b_preloaded = true;
 
+    if( cluster && !b_cues )
+        _seeker.load_clusters( *this );
+
     if( cluster )
         EnsureDuration();
 
@@ -1159,6 +1165,11 @@ bool matroska_segment_c::ESCreate()
     return true;
 }
 
+void matroska_segment_c::SaveClusters()
+{
+    _seeker.save_clusters( *this );
+}
+
 void matroska_segment_c::ESDestroy( )
 {
     sys.ev.AbortThread();
@@ -156,6 +156,9 @@ public:
     bool ESCreate( );
     void ESDestroy( );
 
+    /* remembers the clusters found for the next openings */
+    void SaveClusters();
+
     static bool CompareSegmentUIDs( const matroska_segment_c * item_a, const matroska_segment_c * item_b );
 
     bool SameFamily( const matroska_segment_c & of_segment ) const;
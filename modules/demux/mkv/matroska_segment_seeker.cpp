@@ -28,8 +28,18 @@
 #include "util.hpp"
 #include "stream_io_callback.hpp"
 
+#include "../index_cache.h"
+
 #include <sstream>
 #include <limits>
+#include <memory>
+#include <vector>
+
+#define CLUSTER_CACHE_DIR     "mkvindex"
+#define CLUSTER_CACHE_MAGIC   "VLCMKVCL"
+#define CLUSTER_CACHE_VERSION 1
+#define CLUSTER_CACHE_HEADER  (8 + 4 + 8 + 8 + 8 + 8 + 4)
+#define CLUSTER_CACHE_ENTRY   (8 + 8 + 8)
 
 namespace {
     template<class It, class T>
@@ -74,8 +84,12 @@ SegmentSeeker::add_cluster( KaxCluster * const p_cluster )
             : UINT64_MAX
     };
 
-    add_cluster_position( cinfo.fpos );
+    return add_cluster( cinfo );
+}
 
+SegmentSeeker::cluster_map_t::iterator
+SegmentSeeker::add_cluster( Cluster const& cinfo )
+{
     cluster_map_t::iterator it = _clusters.lower_bound( cinfo.pts );
 
     if( it != _clusters.end() && it->second.pts == cinfo.pts )
@@ -84,7 +98,10 @@ SegmentSeeker::add_cluster( KaxCluster * const p_cluster )
     }
     else
     {
+        add_cluster_position( cinfo.fpos );
+
         it = _clusters.insert( cluster_map_t::value_type( cinfo.pts, cinfo ) ).first;
+        _cache_dirty = true;
     }
 
     // ------------------------------------------------------------------
@@ -308,6 +325,10 @@ SegmentSeeker::get_seekpoints( matroska_segment_c& ms, vlc_tick_t target_pts,
         }
     };
 
+    if( !ms.b_cues )
+        // locate the clusters around the target instead of reading all blocks up to it
+        index_clusters( ms, target_pts );
+
     for( vlc_tick_t needle_pts = target_pts; ; )
     {
         seekpoint_pair_t seekpoints = get_seekpoints_around( needle_pts, priority_tracks );
@@ -340,6 +361,75 @@ SegmentSeeker::get_seekpoints( matroska_segment_c& ms, vlc_tick_t target_pts,
     vlc_assert_unreachable();
 }
 
+void
+SegmentSeeker::index_clusters( matroska_segment_c& ms, vlc_tick_t max_pts )
+{
+    if( !ms.sys.b_seekable || _cluster_hop_pos == 0 || _cluster_hop_pts > max_pts )
+        return;
+
+    fptr_t const i_saved_pos = ms.es.I_O().getFilePointer();
+    size_t const i_known = _clusters.size();
+
+    // only read the head of each cluster, and jump to the next one from its size
+
+    try
+    {
+        while( _cluster_hop_pts <= max_pts )
+        {
+            ms.es.I_O().setFilePointer( _cluster_hop_pos );
+
+            EbmlParser parser( &ms.es, ms.segment, &ms.sys.demuxer );
+            EbmlElement *el = parser.Get();
+
+            if( el == NULL || ms.es.I_O().IsEOF() )
+                break;
+
+            if( MKV_CHECKED_PTR_DECL( p_cluster, KaxCluster, el ) )
+            {
+                bool b_timestamp = false;
+
+                parser.Down();
+                while( EbmlElement *cl = parser.Get() )
+                {
+                    if( MKV_CHECKED_PTR_DECL( p_tc, KaxClusterTimestamp, cl ) )
+                    {
+                        p_tc->ReadData( ms.es.I_O(), SCOPE_ALL_DATA );
+                        p_cluster->InitTimestamp( static_cast<uint64_t>( *p_tc ), ms.i_timescale );
+                        add_cluster( p_cluster );
+                        _cluster_hop_pts = VLC_TICK_FROM_NS( p_cluster->GlobalTimestamp() );
+                        b_timestamp = true;
+                        break;
+                    }
+                    else if( MKV_CHECKED_PTR_DECL( crc, EbmlCrc32, cl ) )
+                    {
+                        crc->ReadData( ms.es.I_O(), SCOPE_ALL_DATA );
+                    }
+                }
+
+                if( !b_timestamp )
+                    break;
+            }
+
+            // the end of a live recording cluster is only known by reading it
+            if( !el->IsFiniteSize() )
+                break;
+
+            _cluster_hop_pos = el->GetEndPosition();
+            _cache_dirty = true;
+        }
+    }
+    catch( ... )
+    {
+        msg_Warn( &ms.sys.demuxer, "error while locating the clusters at %" PRIu64, _cluster_hop_pos );
+    }
+
+    if( _clusters.size() > i_known )
+        msg_Dbg( &ms.sys.demuxer, "located %zu more clusters, up to %" PRIu64,
+                 _clusters.size() - i_known, _cluster_hop_pos );
+
+    ms.es.I_O().setFilePointer( i_saved_pos );
+}
+
 void
 SegmentSeeker::index_range( matroska_segment_c& ms, Range search_area, vlc_tick_t max_pts )
 {
@@ -539,4 +629,129 @@ SegmentSeeker::mkv_jump_to( matroska_segment_c& ms, fptr_t fpos )
         ms.es.I_O().setFilePointer( fpos );
 }
 
+namespace {
+    /* The positions depend on the file content, which is identified by its
+     * stamp. The stream is not read, so the read-ahead can keep going. */
+    bool cluster_cache_stamp( vlc_stream_io_callback& io, uint64_t *pi_size,
+                              uint64_t *pi_mtime )
+    {
+        io.SuspendPrefetch();
+        bool const b_stamped = !index_cache_GetStamp( io.GetStream(), pi_size, pi_mtime );
+        io.ResumePrefetch();
+        return b_stamped;
+    }
+}
+
+void
+SegmentSeeker::load_clusters( matroska_segment_c& ms )
+{
+    vlc_object_t * const p_obj = VLC_OBJECT( &ms.sys.demuxer );
+    vlc_stream_io_callback& io = ms.es.I_O();
+    stream_t * const s = io.GetStream();
+
+    if( !ms.sys.b_seekable || s->psz_url == NULL ||
+        !var_InheritBool( p_obj, "mkv-cluster-cache" ) )
+        return;
+
+    if( !cluster_cache_stamp( io, &_cache_size, &_cache_mtime ) )
+        return;
+
+    // a file can hold several segments
+    std::ostringstream key;
+    key << s->psz_url << '#' << ms.segment->GetElementPosition();
+
+    char *psz_file = index_cache_GetPath( p_obj, CLUSTER_CACHE_DIR, key.str().c_str() );
+    if( psz_file == NULL )
+        return;
+    _cache_file = psz_file;
+    free( psz_file );
+
+    size_t i_left;
+    std::unique_ptr<uint8_t, decltype(&free)> data(
+        index_cache_Read( _cache_file.c_str(), SIZE_MAX, &i_left ), free );
+    if( !data )
+        return;
+
+    uint8_t const *p = data.get();
+
+    if( i_left < CLUSTER_CACHE_HEADER ||
+        memcmp( p, CLUSTER_CACHE_MAGIC, 8 ) ||
+        GetDWLE( &p[8] ) != CLUSTER_CACHE_VERSION ||
+        GetQWLE( &p[12] ) != _cache_size || GetQWLE( &p[20] ) != _cache_mtime ||
+        GetQWLE( &p[28] ) > _cache_size ||
+        GetDWLE( &p[44] ) != ( i_left - CLUSTER_CACHE_HEADER ) / CLUSTER_CACHE_ENTRY )
+    {
+        msg_Dbg( p_obj, "clusters cache is outdated" );
+        return;
+    }
+
+    fptr_t const hop_pos = GetQWLE( &p[28] );
+    vlc_tick_t const hop_pts = static_cast<int64_t>( GetQWLE( &p[36] ) );
+    uint32_t const i_clusters = GetDWLE( &p[44] );
+
+    p += CLUSTER_CACHE_HEADER;
+    for( uint32_t i = 0; i < i_clusters; i++, p += CLUSTER_CACHE_ENTRY )
+    {
+        Cluster cinfo = {
+            /* fpos     */ GetQWLE( p ),
+            /* pts      */ static_cast<int64_t>( GetQWLE( &p[8] ) ),
+            /* duration */ vlc_tick_t( -1 ),
+            /* size     */ GetQWLE( &p[16] )
+        };
+
+        if( cinfo.fpos < _cache_size )
+            add_cluster( cinfo );
+    }
+
+    if( hop_pos > _cluster_hop_pos )
+    {
+        _cluster_hop_pos = hop_pos;
+        _cluster_hop_pts = hop_pts;
+    }
+    _cache_dirty = false;
+
+    msg_Dbg( p_obj, "loaded %" PRIu32 " clusters from %s", i_clusters, _cache_file.c_str() );
+}
+
+void
+SegmentSeeker::save_clusters( matroska_segment_c& ms )
+{
+    vlc_object_t * const p_obj = VLC_OBJECT( &ms.sys.demuxer );
+
+    if( _cache_file.empty() || !_cache_dirty )
+        return;
+
+    /* the positions found in a file being written are already outdated */
+    uint64_t i_size, i_mtime;
+    if( !cluster_cache_stamp( ms.es.I_O(), &i_size, &i_mtime ) ||
+        i_size != _cache_size || i_mtime != _cache_mtime )
+        return;
+
+    std::vector<uint8_t> data( CLUSTER_CACHE_HEADER + _clusters.size() * CLUSTER_CACHE_ENTRY );
+    uint8_t *p = data.data();
+
+    memcpy( p, CLUSTER_CACHE_MAGIC, 8 );
+    SetDWLE( &p[8], CLUSTER_CACHE_VERSION );
+    SetQWLE( &p[12], _cache_size );
+    SetQWLE( &p[20], _cache_mtime );
+    SetQWLE( &p[28], _cluster_hop_pos );
+    SetQWLE( &p[36], _cluster_hop_pts );
+    SetDWLE( &p[44], _clusters.size() );
+    p += CLUSTER_CACHE_HEADER;
+
+    for( cluster_map_t::const_iterator it = _clusters.begin(); it != _clusters.end(); ++it )
+    {
+        SetQWLE( p, it->second.fpos );
+        SetQWLE( &p[8], it->second.pts );
+        SetQWLE( &p[16], it->second.size );
+        p += CLUSTER_CACHE_ENTRY;
+    }
+
+    if( index_cache_Write( p_obj, _cache_file.c_str(), data.data(), data.size() ) )
+        return;
+    _cache_dirty = false;
+
+    msg_Dbg( p_obj, "saved %zu clusters to %s", _clusters.size(), _cache_file.c_str() );
+}
+
 } // namespace
@@ -29,6 +29,7 @@
 #include <vector>
 #include <map>
 #include <limits>
+#include <string>
 
 namespace mkv {
 
@@ -110,6 +111,11 @@ class SegmentSeeker
 
         cluster_positions_t::iterator add_cluster_position( fptr_t pos );
         cluster_map_t      ::iterator add_cluster( KaxCluster * const );
+        cluster_map_t      ::iterator add_cluster( Cluster const& );
+
+        void index_clusters( matroska_segment_c&, vlc_tick_t max_pts );
+        void load_clusters( matroska_segment_c& );
+        void save_clusters( matroska_segment_c& );
 
         void mkv_jump_to( matroska_segment_c&, fptr_t );
 
@@ -124,6 +130,16 @@ class SegmentSeeker
         tracks_seekpoints_t _tracks_seekpoints;
         cluster_positions_t _cluster_positions;
         cluster_map_t       _clusters;
+
+        /* clusters are hopped, from the first one, up to this position */
+        fptr_t              _cluster_hop_pos = 0;
+        vlc_tick_t          _cluster_hop_pts = -1;
+
+        /* clusters cache, for the segments without Cues */
+        std::string         _cache_file;
+        uint64_t            _cache_size = 0;
+        uint64_t            _cache_mtime = 0;
+        bool                _cache_dirty = false;
 };
 
 } // namespace
@@ -82,6 +82,14 @@ vlc_module_begin ()
             N_("Preload clusters"),
             N_("Find all cluster positions by jumping cluster-to-cluster before playback") )
 
+    add_bool( "mkv-cluster-cache", true,
+            N_("Cache cluster positions"),
+            N_("Keep the cluster positions of the files without cues, so that seeking them again does not read them.") )
+
+    add_integer( "mkv-prefetch-size", 4096,
+            N_("Read-ahead buffer size (KiB)"),
+            N_("Clusters are read ahead in the background into a buffer of this size, from the inputs that are slow to seek (0 to disable).") )
+
     add_shortcut( "mka", "mkv" )
     add_file_extension("mka")
     add_file_extension("mks")
@@ -270,6 +278,14 @@ static int OpenInternal( demux_t *p_demux, bool trust_cues )
         goto error;
     }
 
+    /* read the next clusters while playing the current one */
+    if( !p_sys->b_fastseekable )
+    {
+        int64_t i_prefetch = var_InheritInteger( p_demux, "mkv-prefetch-size" );
+        if( i_prefetch > 0 )
+            p_stream->io_callback.StartPrefetch( VLC_OBJECT(p_demux), i_prefetch * 1024 );
+    }
+
     return VLC_SUCCESS;
 
 error:
@@ -304,6 +320,9 @@ static void Close( vlc_object_t *p_this )
             p_segment->ESDestroy();
     }
 
+    for( size_t i = 0; i < p_sys->opened_segments.size(); i++ )
+        p_sys->opened_segments[i]->SaveClusters();
+
     delete p_sys;
 }
 
@@ -326,7 +345,9 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     switch( i_query )
     {
         case DEMUX_CAN_SEEK:
-            return vlc_stream_vaControl( p_demux->s, i_query, args );
+            /* probed on opening, the read-ahead may be using the stream */
+            *va_arg( args, bool * ) = p_sys->b_seekable;
+            return VLC_SUCCESS;
 
         case DEMUX_GET_ATTACHMENTS:
             ppp_attach = va_arg( args, input_attachment_t*** );
@@ -485,11 +506,18 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
         case DEMUX_NAV_MENU:
             return p_sys->ev.SendEventNav( static_cast<demux_query_e>(i_query) );
 
-        case DEMUX_CAN_PAUSE:
         case DEMUX_SET_PAUSE_STATE:
+        case DEMUX_CAN_PAUSE:
         case DEMUX_CAN_CONTROL_PACE:
         case DEMUX_GET_PTS_DELAY:
-            return demux_vaControlHelper( p_demux->s, 0, -1, 0, 1, i_query, args );
+        {
+            /* not while the read-ahead is using the stream */
+            vlc_stream_io_callback & io = p_sys->streams[0]->io_callback;
+            io.SuspendPrefetch();
+            int i_ret = demux_vaControlHelper( p_demux->s, 0, -1, 0, 1, i_query, args );
+            io.ResumePrefetch();
+            return i_ret;
+        }
 
         default:
             return VLC_EGENERIC;
@@ -23,13 +23,264 @@
 
 #include "stream_io_callback.hpp"
 
+#include <vlc_threads.h>
+#include <vlc_interrupt.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <new>
+
 namespace mkv {
 
+/*****************************************************************************
+ * Read-ahead
+ *****************************************************************************
+ * The buffer is a ring holding the data that follows the current position.
+ * The thread fills it while there is room, and waits for the reader to
+ * consume data, or to suspend it in order to use the stream.
+ *****************************************************************************/
+#define PREFETCH_READ_SIZE (1 << 16)
+#define PREFETCH_RETRY_DELAY VLC_TICK_FROM_MS(100)
+
+struct stream_prefetch_t
+{
+    stream_t        *s;
+    vlc_thread_t    thread;
+    vlc_interrupt_t *interrupt;
+    vlc_mutex_t     lock;
+    vlc_cond_t      wait_space; /* room made, suspended, resumed or stopped */
+    vlc_cond_t      wait_data;  /* data read or read ended */
+
+    uint8_t         *p_buffer;
+    size_t          i_size;
+    size_t          i_head;     /* offset of the next byte to read */
+    size_t          i_fill;     /* bytes available after i_head */
+    uint64_t        i_pos;      /* stream position of i_head */
+
+    unsigned        i_suspended;
+    bool            b_reading;  /* the stream is read without the lock */
+    bool            b_eof;
+    bool            b_interrupted; /* the reader was interrupted */
+    bool            b_quit;
+};
+
+static void *PrefetchThread( void *data )
+{
+    auto *p = static_cast<stream_prefetch_t *>( data );
+
+    vlc_thread_set_name( "vlc-mkv-prefetch" );
+    vlc_interrupt_set( p->interrupt );
+
+    vlc_mutex_lock( &p->lock );
+    for( ;; )
+    {
+        while( !p->b_quit &&
+               ( p->i_suspended || p->b_eof || p->i_fill == p->i_size ) )
+            vlc_cond_wait( &p->wait_space, &p->lock );
+        if( p->b_quit )
+            break;
+
+        /* only this thread writes past the buffered data */
+        size_t i_tail = ( p->i_head + p->i_fill ) % p->i_size;
+        size_t i_len = std::min( p->i_size - p->i_fill, p->i_size - i_tail );
+        i_len = std::min<size_t>( i_len, PREFETCH_READ_SIZE );
+
+        p->b_reading = true;
+        vlc_mutex_unlock( &p->lock );
+
+        ssize_t i_read = vlc_stream_ReadPartial( p->s, &p->p_buffer[i_tail], i_len );
+
+        vlc_mutex_lock( &p->lock );
+        p->b_reading = false;
+        if( i_read > 0 )
+            p->i_fill += i_read;
+        else if( i_read == 0 && !p->b_quit )
+            p->b_eof = true;
+        else
+        {
+            /* not the end of the stream, try again later */
+            vlc_tick_t i_deadline = vlc_tick_now() + PREFETCH_RETRY_DELAY;
+            while( !p->b_quit &&
+                   !vlc_cond_timedwait( &p->wait_space, &p->lock, i_deadline ) );
+        }
+        vlc_cond_broadcast( &p->wait_data );
+    }
+    vlc_mutex_unlock( &p->lock );
+    return NULL;
+}
+
+/* returns with the lock held and the thread away from the stream */
+static void PrefetchSuspend( stream_prefetch_t *p )
+{
+    vlc_mutex_lock( &p->lock );
+    p->i_suspended++;
+    while( p->b_reading )
+        vlc_cond_wait( &p->wait_data, &p->lock );
+}
+
+static void PrefetchResume( stream_prefetch_t *p )
+{
+    assert( p->i_suspended > 0 );
+    if( --p->i_suspended == 0 )
+        vlc_cond_signal( &p->wait_space );
+    vlc_mutex_unlock( &p->lock );
+}
+
+/* drops the buffered data, the stream being at the new position */
+static void PrefetchFlush( stream_prefetch_t *p, uint64_t i_pos, bool b_eof )
+{
+    p->i_head = p->i_fill = 0;
+    p->i_pos = i_pos;
+    p->b_eof = b_eof;
+}
+
+static void PrefetchConsume( stream_prefetch_t *p, size_t i_len )
+{
+    p->i_head = ( p->i_head + i_len ) % p->i_size;
+    p->i_fill -= i_len;
+    p->i_pos += i_len;
+    vlc_cond_signal( &p->wait_space );
+}
+
+static void PrefetchWakeUp( void *data )
+{
+    auto *p = static_cast<stream_prefetch_t *>( data );
+
+    vlc_mutex_lock( &p->lock );
+    p->b_interrupted = true;
+    vlc_cond_broadcast( &p->wait_data );
+    vlc_mutex_unlock( &p->lock );
+}
+
+static size_t PrefetchRead( stream_prefetch_t *p, uint8_t *p_buffer, size_t i_size )
+{
+    size_t i_done = 0;
+
+    /* the read-ahead keeps going, only the reader stops waiting */
+    p->b_interrupted = false;
+    vlc_interrupt_register( PrefetchWakeUp, p );
+    vlc_mutex_lock( &p->lock );
+    while( i_done < i_size )
+    {
+        if( p->i_fill == 0 )
+        {
+            if( p->b_eof || p->b_interrupted )
+                break;
+            vlc_cond_wait( &p->wait_data, &p->lock );
+            continue;
+        }
+
+        size_t i_len = std::min( { i_size - i_done, p->i_fill, p->i_size - p->i_head } );
+        memcpy( &p_buffer[i_done], &p->p_buffer[p->i_head], i_len );
+        PrefetchConsume( p, i_len );
+        i_done += i_len;
+    }
+    vlc_mutex_unlock( &p->lock );
+    vlc_interrupt_unregister();
+
+    return i_done;
+}
+
+/* seeks forward within the buffered data */
+static bool PrefetchSkip( stream_prefetch_t *p, uint64_t i_pos )
+{
+    vlc_mutex_lock( &p->lock );
+    bool b_buffered = i_pos >= p->i_pos && i_pos - p->i_pos <= p->i_fill;
+    if( b_buffered )
+        PrefetchConsume( p, i_pos - p->i_pos );
+    vlc_mutex_unlock( &p->lock );
+    return b_buffered;
+}
+
+bool vlc_stream_io_callback::StartPrefetch( vlc_object_t *p_obj, size_t i_size )
+{
+    assert( p_prefetch == NULL );
+
+    stream_prefetch_t *p = new (std::nothrow) stream_prefetch_t;
+    if( unlikely(p == NULL) )
+        return false;
+
+    p->p_buffer = static_cast<uint8_t *>( malloc( i_size ) );
+    p->interrupt = vlc_interrupt_create();
+    if( unlikely(p->p_buffer == NULL || p->interrupt == NULL) )
+        goto error;
+
+    p->s = s;
+    vlc_mutex_init( &p->lock );
+    vlc_cond_init( &p->wait_space );
+    vlc_cond_init( &p->wait_data );
+    p->i_size = i_size;
+    PrefetchFlush( p, vlc_stream_Tell( s ), mb_eof );
+    p->i_suspended = 0;
+    p->b_reading = false;
+    p->b_interrupted = false;
+    p->b_quit = false;
+
+    if( vlc_clone( &p->thread, PrefetchThread, p ) )
+    {
+        msg_Err( p_obj, "cannot create the read-ahead thread" );
+        goto error;
+    }
+
+    msg_Dbg( p_obj, "reading ahead up to %zu bytes", i_size );
+    p_prefetch = p;
+    return true;
+
+error:
+    if( p->interrupt )
+        vlc_interrupt_destroy( p->interrupt );
+    free( p->p_buffer );
+    delete p;
+    return false;
+}
+
+void vlc_stream_io_callback::StopPrefetch()
+{
+    stream_prefetch_t *p = p_prefetch;
+    if( p == NULL )
+        return;
+
+    vlc_mutex_lock( &p->lock );
+    p->b_quit = true;
+    vlc_cond_signal( &p->wait_space );
+    vlc_mutex_unlock( &p->lock );
+    vlc_interrupt_kill( p->interrupt );
+    vlc_join( p->thread, NULL );
+
+    /* the stream is ahead of the data read so far */
+    if( vlc_stream_Tell( s ) != p->i_pos )
+        mb_eof |= vlc_stream_Seek( s, p->i_pos ) != VLC_SUCCESS;
+
+    p_prefetch = NULL;
+    vlc_interrupt_destroy( p->interrupt );
+    free( p->p_buffer );
+    delete p;
+}
+
+void vlc_stream_io_callback::SuspendPrefetch()
+{
+    if( p_prefetch == NULL )
+        return;
+
+    PrefetchSuspend( p_prefetch );
+    vlc_mutex_unlock( &p_prefetch->lock );
+}
+
+void vlc_stream_io_callback::ResumePrefetch()
+{
+    if( p_prefetch == NULL )
+        return;
+
+    vlc_mutex_lock( &p_prefetch->lock );
+    PrefetchResume( p_prefetch );
+}
+
 /*****************************************************************************
  * Stream management
  *****************************************************************************/
 vlc_stream_io_callback::vlc_stream_io_callback( stream_t *s_, bool b_owner_ )
-                       : s( s_), b_owner( b_owner_ )
+                       : s( s_), b_owner( b_owner_ ), p_prefetch( NULL )
 {
     mb_eof = false;
 }
@@ -39,11 +290,42 @@ uint32 vlc_stream_io_callback::read( void *p_buffer, size_t i_size )
     if( i_size <= 0 || mb_eof )
         return 0;
 
+    if( p_prefetch != NULL )
+    {
+        size_t i_ret = PrefetchRead( p_prefetch, static_cast<uint8_t *>( p_buffer ), i_size );
+        return i_ret < i_size ? 0 : i_ret;
+    }
+
     int i_ret = vlc_stream_Read( s, p_buffer, i_size );
     return i_ret < 0 || i_ret < i_size ? 0 : i_ret;
 }
 
 void vlc_stream_io_callback::setFilePointer(int64_t i_offset, seek_mode mode )
+{
+    if( p_prefetch == NULL )
+    {
+        seekStream( i_offset, mode );
+        return;
+    }
+
+    if( mode == seek_current )
+    {
+        i_offset += getFilePointer();
+        mode = seek_beginning;
+    }
+
+    if( mode == seek_beginning && !mb_eof && i_offset >= 0 &&
+        PrefetchSkip( p_prefetch, i_offset ) )
+        return;
+
+    /* the stream is at the end of the buffered data, which is dropped */
+    PrefetchSuspend( p_prefetch );
+    seekStream( i_offset, mode );
+    PrefetchFlush( p_prefetch, vlc_stream_Tell( s ), mb_eof );
+    PrefetchResume( p_prefetch );
+}
+
+void vlc_stream_io_callback::seekStream( int64_t i_offset, seek_mode mode )
 {
     int64_t i_pos, i_size;
     int64_t i_current = vlc_stream_Tell( s );
@@ -91,6 +373,13 @@ uint64_t vlc_stream_io_callback::getFilePointer( void )
 {
     if ( s == NULL )
         return 0;
+    if( p_prefetch != NULL )
+    {
+        vlc_mutex_lock( &p_prefetch->lock );
+        uint64_t i_pos = p_prefetch->i_pos;
+        vlc_mutex_unlock( &p_prefetch->lock );
+        return i_pos;
+    }
     return vlc_stream_Tell( s );
 }
 
@@ -37,6 +37,8 @@ using namespace libebml;
 
 namespace mkv {
 
+struct stream_prefetch_t;
+
 /*****************************************************************************
  * Stream management
  *****************************************************************************/
@@ -46,17 +48,31 @@ class vlc_stream_io_callback: public IOCallback
     stream_t       *s;
     bool           mb_eof;
     bool           b_owner;
+    stream_prefetch_t *p_prefetch;
+
+    void seekStream( int64_t i_offset, seek_mode mode );
 
   public:
     vlc_stream_io_callback( stream_t *, bool owner );
 
     virtual ~vlc_stream_io_callback()
     {
+        StopPrefetch();
         if( b_owner )
             vlc_stream_Delete( s );
     }
 
     bool IsEOF() const { return mb_eof; }
+    stream_t *GetStream() const { return s; }
+
+    /* Reads ahead of the current position into a buffer of i_size bytes,
+     * from a background thread, for the inputs slow to read or seek.
+     * Seeking within the buffered data does not touch the stream. */
+    bool StartPrefetch( vlc_object_t *, size_t i_size );
+    void StopPrefetch();
+    /* the stream can be queried, but not read nor seeked, between those */
+    void SuspendPrefetch();
+    void ResumePrefetch();
 
     uint32_t read            ( void *p_buffer, size_t i_size) override;
     void     setFilePointer  ( int64_t i_offset, seek_mode mode = seek_beginning ) override;
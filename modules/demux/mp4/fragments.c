@@ -23,6 +23,7 @@
 
 #include "fragments.h"
 #include <limits.h>
+#include <string.h>
 
 void MP4_Fragments_Index_Delete( mp4_fragments_index_t *p_index )
 {
@@ -34,27 +35,53 @@ void MP4_Fragments_Index_Delete( mp4_fragments_index_t *p_index )
     }
 }
 
-mp4_fragments_index_t * MP4_Fragments_Index_New( unsigned i_tracks, unsigned i_num )
+mp4_fragments_index_t * MP4_Fragments_Index_New( unsigned i_tracks )
 {
-    if( !i_tracks || !i_num || SIZE_MAX / i_num < i_tracks )
+    if( !i_tracks )
         return NULL;
     mp4_fragments_index_t *p_index = malloc( sizeof(*p_index) );
     if( p_index )
     {
-        p_index->p_times = calloc( (size_t)i_num * i_tracks, sizeof(*p_index->p_times) );
-        p_index->pi_pos = calloc( i_num, sizeof(*p_index->pi_pos) );
-        if( !p_index->p_times || !p_index->pi_pos )
-        {
-            MP4_Fragments_Index_Delete( p_index );
-            return NULL;
-        }
-        p_index->i_entries = i_num;
+        p_index->p_times = NULL;
+        p_index->pi_pos = NULL;
+        p_index->i_entries = 0;
+        p_index->i_alloc = 0;
         p_index->i_last_time = 0;
         p_index->i_tracks = i_tracks;
     }
     return p_index;
 }
 
+int MP4_Fragments_Index_Append( mp4_fragments_index_t *p_index,
+                                uint64_t i_pos, const stime_t *p_times )
+{
+    if( p_index->i_entries == p_index->i_alloc )
+    {
+        unsigned i_alloc = p_index->i_alloc ? p_index->i_alloc * 2 : 64;
+        if( i_alloc < p_index->i_alloc ||
+            SIZE_MAX / i_alloc / sizeof(*p_index->p_times) < p_index->i_tracks )
+            return VLC_ENOMEM;
+
+        uint64_t *pi_pos = realloc( p_index->pi_pos, sizeof(*pi_pos) * i_alloc );
+        if( !pi_pos )
+            return VLC_ENOMEM;
+        p_index->pi_pos = pi_pos;
+
+        stime_t *p_times_new = realloc( p_index->p_times, sizeof(*p_times_new) *
+                                        i_alloc * p_index->i_tracks );
+        if( !p_times_new )
+            return VLC_ENOMEM;
+        p_index->p_times = p_times_new;
+        p_index->i_alloc = i_alloc;
+    }
+
+    p_index->pi_pos[p_index->i_entries] = i_pos;
+    memcpy( &p_index->p_times[(size_t)p_index->i_entries * p_index->i_tracks],
+            p_times, sizeof(*p_times) * p_index->i_tracks );
+    p_index->i_entries++;
+    return VLC_SUCCESS;
+}
+
 stime_t MP4_Fragment_Index_GetTrackStartTime( mp4_fragments_index_t *p_index,
                                               unsigned i_track_index, uint64_t i_moof_pos )
 {
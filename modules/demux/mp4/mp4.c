@@ -207,6 +207,7 @@ static stime_t GetMoovTrackDuration( demux_sys_t *p_sys, unsigned i_track_ID );
 static int  ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented );
 static int  ProbeFragmentsChecked( demux_t *p_demux );
 static int  ProbeIndex( demux_t *p_demux );
+static stime_t GetMfraDuration( demux_t *p_demux );
 
 static int FragCreateTrunIndex( demux_t *, MP4_Box_t *, MP4_Box_t *, stime_t );
 
@@ -471,33 +472,6 @@ static es_out_id_t * MP4_CreateES( es_out_t *out, const es_format_t *p_fmt,
     return p_es;
 }
 
-static int MP4_ChunkAllocEntries( size_t entries, uint32_t *smallbuf,
-                                  uint32_t **dst0, uint32_t **dst1 )
-{
-    uint32_t *buf;
-
-    if( entries > MP4_CHUNK_SMALLBUF_ENTRIES )
-    {
-        buf = calloc( entries, sizeof( buf[0] ) * 2 );
-        if( unlikely(buf == NULL) )
-            return VLC_ENOMEM;
-    }
-    else buf = smallbuf;
-
-    *dst0 = buf;
-    *dst1 = &buf[entries];
-
-    return VLC_SUCCESS;
-}
-
-static void MP4_ChunkDestroy( mp4_chunk_t *ck )
-{
-    if( ck->p_sample_count_dts != ck->small_dts_buf )
-        free( ck->p_sample_count_dts );
-    if( ck->p_sample_count_pts != ck->small_pts_buf )
-        free( ck->p_sample_count_pts );
-}
-
 static stime_t MP4_MapTrackTimeIntoTimeline( const mp4_track_t *p_track,
                                              uint32_t i_movie_timescale,
                                              stime_t i_time )
@@ -544,42 +518,52 @@ static stime_t MP4_MapMediaTimelineToTrackTime( const mp4_track_t *p_track,
     return i_time;
 }
 
-static stime_t MP4_ChunkGetSampleDTS( const mp4_chunk_t *p_chunk,
+static stime_t MP4_ChunkGetSampleDTS( const mp4_track_t *p_track,
+                                      const mp4_chunk_t *p_chunk,
                                       uint32_t i_sample )
 {
-    uint32_t i_index = 0;
+    const MP4_Box_data_stts_t *stts = p_track->p_stts;
+    uint32_t i_index = p_chunk->i_stts_entry;
+    uint32_t i_skip = p_chunk->i_stts_skip;
     stime_t sdts = p_chunk->i_first_dts;
-    while( i_sample > 0 && i_index < p_chunk->i_entries_dts )
+    while( i_sample > 0 && i_index < stts->i_entry_count )
     {
-        if( i_sample > p_chunk->p_sample_count_dts[i_index] )
+        uint32_t i_left = stts->pi_sample_count[i_index] - i_skip;
+        if( i_sample > i_left )
         {
-            sdts += (stime_t)p_chunk->p_sample_count_dts[i_index] *
-                p_chunk->p_sample_delta_dts[i_index];
-            i_sample -= p_chunk->p_sample_count_dts[i_index++];
+            sdts += (stime_t)i_left * stts->pi_sample_delta[i_index++];
+            i_sample -= i_left;
+            i_skip = 0;
         }
         else
         {
-            sdts += (stime_t)i_sample * p_chunk->p_sample_delta_dts[i_index];
+            sdts += (stime_t)i_sample * stts->pi_sample_delta[i_index];
             break;
         }
     }
     return sdts;
 }
 
-static bool MP4_ChunkGetSampleCTSDelta( const mp4_chunk_t *p_chunk,
+static bool MP4_ChunkGetSampleCTSDelta( const mp4_track_t *p_track,
+                                        const mp4_chunk_t *p_chunk,
                                         uint32_t i_sample, stime_t *pi_delta )
 {
-    if( p_chunk->p_sample_count_pts && p_chunk->p_sample_offset_pts )
+    const MP4_Box_data_ctts_t *ctts = p_track->p_ctts;
+    if( !ctts )
+        return false;
+
+    uint32_t i_skip = p_chunk->i_ctts_skip;
+    for( uint32_t i_index = p_chunk->i_ctts_entry; i_index < ctts->i_entry_count; i_index++ )
     {
-        for( uint32_t i_index = 0; i_index < p_chunk->i_entries_pts ; i_index++ )
+        uint32_t i_left = ctts->pi_sample_count[i_index] - i_skip;
+        if( i_sample < i_left )
         {
-            if( i_sample < p_chunk->p_sample_count_pts[i_index] )
-            {
-                *pi_delta = p_chunk->p_sample_offset_pts[i_index];
-                return true;
-            }
-            i_sample -= p_chunk->p_sample_count_pts[i_index];
+            stime_t i_ctsdelta = ctts->pi_sample_offset[i_index] + p_track->i_cts_shift;
+            *pi_delta = i_ctsdelta < 0 ? 0 : i_ctsdelta; /* should not */
+            return true;
         }
+        i_sample -= i_left;
+        i_skip = 0;
     }
     return false;
 }
@@ -620,55 +604,25 @@ static vlc_tick_t MP4_TrackGetDTSPTS( demux_t *p_demux, const mp4_track_t *p_tra
     return i_dts;
 }
 
-static stime_t MP4_GetChunkSamplesDuration( const mp4_chunk_t *p_chunk,
+static stime_t MP4_GetChunkSamplesDuration( const mp4_track_t *p_track,
+                                            const mp4_chunk_t *p_chunk,
                                             uint32_t i_start_sample,
                                             uint32_t i_nb_samples )
 {
-    stime_t i_duration = 0;
-
-    /* Forward to right index, and set remaining count in that index */
-    uint32_t i_index = 0;
-    uint32_t i_remain = 0;
-    for( uint32_t i = p_chunk->i_sample_first;
-         i<i_start_sample && i_index < p_chunk->i_entries_dts; )
-    {
-        if( i_start_sample - i >= p_chunk->p_sample_count_dts[i_index] )
-        {
-            i += p_chunk->p_sample_count_dts[i_index];
-            i_index++;
-        }
-        else
-        {
-            i_remain = i_start_sample - i;
-            break;
-        }
-    }
-
-    /* Compute total duration from all samples from index */
-    while( i_nb_samples > 0 && i_index < p_chunk->i_entries_dts )
-    {
-        if( i_nb_samples >= p_chunk->p_sample_count_dts[i_index] - i_remain )
-        {
-            i_duration += (p_chunk->p_sample_count_dts[i_index] - i_remain) *
-                          (int64_t) p_chunk->p_sample_delta_dts[i_index];
-            i_nb_samples -= (p_chunk->p_sample_count_dts[i_index] - i_remain);
-            i_index++;
-            i_remain = 0;
-        }
-        else
-        {
-            i_duration += (stime_t)i_nb_samples * p_chunk->p_sample_delta_dts[i_index];
-            break;
-        }
-    }
+    uint32_t i_start = i_start_sample - p_chunk->i_sample_first;
+    if( i_start >= p_chunk->i_sample_count )
+        return 0;
+    i_nb_samples = __MIN( i_nb_samples, p_chunk->i_sample_count - i_start );
 
-    return i_duration;
+    return MP4_ChunkGetSampleDTS( p_track, p_chunk, i_start + i_nb_samples ) -
+           MP4_ChunkGetSampleDTS( p_track, p_chunk, i_start );
 }
 
 static inline vlc_tick_t MP4_GetSamplesDuration( const mp4_track_t *p_track,
                                                  uint32_t i_nb_samples )
 {
-    stime_t i_duration = MP4_GetChunkSamplesDuration( &p_track->chunk[p_track->i_chunk],
+    stime_t i_duration = MP4_GetChunkSamplesDuration( p_track,
+                                                      &p_track->chunk[p_track->i_chunk],
                                                       p_track->i_sample,
                                                       i_nb_samples );
     return MP4_rescale_mtime( i_duration, p_track->i_timescale );
@@ -1391,9 +1345,27 @@ static int Open( vlc_object_t * p_this )
         {
             if( !p_sys->b_fragmented /* as unknown */ )
             {
-                /* Probe remaining to check if there's really fragments
-                   or if that file is just ready to append fragments */
-                ProbeFragments( p_demux, (p_sys->i_duration == 0), &p_sys->b_fragmented );
+                /* A random access index at the end avoids reading all
+                   the fragments for the duration, if seeking is cheap */
+                const uint64_t i_pos = vlc_stream_Tell( p_demux->s );
+                if( p_sys->b_fastseekable )
+                {
+                    ProbeIndex( p_demux );
+                    p_sys->b_index_probed = true;
+                }
+                if( MP4_BoxGet( p_sys->p_root, "mfra/tfra" ) )
+                {
+                    p_sys->b_fragmented = true;
+                    stime_t i_duration = GetMfraDuration( p_demux );
+                    if( (uint64_t) i_duration > p_sys->i_cumulated_duration )
+                        p_sys->i_cumulated_duration = i_duration;
+                }
+                else if( vlc_stream_Seek( p_demux->s, i_pos ) == VLC_SUCCESS )
+                {
+                    /* Probe remaining to check if there's really fragments
+                       or if that file is just ready to append fragments */
+                    ProbeFragments( p_demux, (p_sys->i_duration == 0), &p_sys->b_fragmented );
+                }
             }
 
             if( vlc_stream_Seek( p_demux->s, p_sys->p_moov->i_pos ) != VLC_SUCCESS )
@@ -2676,12 +2648,6 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
         ck->i_offset = BOXDATA(p_co64)->i_chunk_offset[i_chunk];
 
         ck->i_first_dts = 0;
-        ck->i_entries_dts = 0;
-        ck->p_sample_count_dts = NULL;
-        ck->p_sample_delta_dts = NULL;
-        ck->i_entries_pts = 0;
-        ck->p_sample_count_pts = NULL;
-        ck->p_sample_offset_pts = NULL;
     }
 
     /* now we read index for SampleEntry( soun vide mp4a mp4v ...)
@@ -2743,54 +2709,6 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
     return VLC_SUCCESS;
 }
 
-static int xTTS_CountEntries( demux_t *p_demux, uint32_t *pi_entry /* out */,
-                              const uint32_t i_index,
-                              uint32_t i_index_samples_left,
-                              uint32_t i_sample_count,
-                              const uint32_t *pi_index_sample_count,
-                              const uint32_t i_table_count )
-{
-    uint32_t i_array_offset;
-    while( i_sample_count > 0 )
-    {
-        if ( likely((UINT32_MAX - i_index) >= *pi_entry) )
-            i_array_offset = i_index + *pi_entry;
-        else
-            return VLC_EGENERIC;
-
-        if ( i_array_offset >= i_table_count )
-        {
-            msg_Err( p_demux, "invalid index counting total samples %u %u", i_array_offset,  i_table_count );
-            return VLC_EINVAL;
-        }
-
-        if ( i_index_samples_left )
-        {
-            if ( i_index_samples_left > i_sample_count )
-            {
-                i_index_samples_left -= i_sample_count;
-                i_sample_count = 0;
-                *pi_entry +=1; /* No samples left, go copy */
-                break;
-            }
-            else
-            {
-                i_sample_count -= i_index_samples_left;
-                i_index_samples_left = 0;
-                *pi_entry += 1;
-                continue;
-            }
-        }
-        else
-        {
-            i_sample_count -= __MIN( i_sample_count, pi_index_sample_count[i_array_offset] );
-            *pi_entry += 1;
-        }
-    }
-
-    return VLC_SUCCESS;
-}
-
 static int TrackCreateSamplesIndex( demux_t *p_demux,
                                     mp4_track_t *p_demux_track )
 {
@@ -2828,18 +2746,10 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     }
     else
     {
-        /* 2: each sample can have a different size */
+        /* 2: each sample can have a different size, use the stsz table
+         * that is kept for the life of the track */
         p_demux_track->i_sample_size = 0;
-        p_demux_track->p_sample_size =
-            calloc( p_demux_track->i_sample_count, sizeof( uint32_t ) );
-        if( p_demux_track->p_sample_size == NULL )
-            return VLC_ENOMEM;
-
-        for( uint32_t i_sample = 0; i_sample < p_demux_track->i_sample_count; i_sample++ )
-        {
-            p_demux_track->p_sample_size[i_sample] =
-                    stsz->i_entry_size[i_sample];
-        }
+        p_demux_track->p_sample_size = stsz->i_entry_size;
     }
 
     if ( p_demux_track->i_chunk_count && p_demux_track->i_sample_size == 0 )
@@ -2852,122 +2762,62 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
         }
     }
 
-    /* Use stts table to create a sample number -> dts table.
-     * XXX: if we don't want to waste too much memory, we can't expand
-     *  the box! so each chunk will contain an "extract" of this table
-     *  for fast research (problem with raw stream where a sample is sometime
-     *  just channels*bits_per_sample/8 */
-
-     /* FIXME: refactor STTS & CTTS, STTS having now only few extra lines and
-      *        differing in 2/2 fields and 1 signedness */
+    /* Use stts table as sample number -> dts table.
+     * We don't expand the box, which can have one entry for hours of
+     * samples, but each chunk records where its first sample is in the
+     * table runs, so that any sample is found from its chunk */
 
     int64_t i_next_dts = 0;
     /* Find stts
      *  Gives mapping between sample and decoding time
      */
     p_box = MP4_BoxGet( p_demux_track->p_stbl, "stts" );
-    if( !p_box )
+    if( !p_box || !p_box->data.p_stts )
     {
         msg_Warn( p_demux, "cannot find STTS box" );
         return VLC_EGENERIC;
     }
     else
     {
-        MP4_Box_data_stts_t *stts = p_box->data.p_stts;
+        const MP4_Box_data_stts_t *stts = p_box->data.p_stts;
 
         msg_Warn( p_demux, "STTS table of %"PRIu32" entries", stts->i_entry_count );
 
-        /* Create sample -> dts table per chunk */
+        p_demux_track->p_stts = stts;
+
         uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
+        uint32_t i_skip = 0;
+        bool b_truncated = false;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
 
-            /* save first dts */
+            /* save first dts and position in the table */
             ck->i_first_dts = i_next_dts;
+            ck->i_stts_entry = i_index;
+            ck->i_stts_skip = i_skip;
 
-            /* count how many entries are needed for this chunk
-             * for p_sample_delta_dts and p_sample_count_dts */
-            ck->i_entries_dts = 0;
-
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_dts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           stts->pi_sample_count,
-                                           stts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            i_ret = MP4_ChunkAllocEntries( ck->i_entries_dts,
-                                           ck->small_dts_buf,
-                                           &ck->p_sample_count_dts,
-                                           &ck->p_sample_delta_dts );
-            if( i_ret )
+            uint32_t i_sample_count = ck->i_sample_count;
+            while( i_sample_count > 0 && i_index < stts->i_entry_count )
             {
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_dts );
-                ck->i_entries_dts = 0;
-                return i_ret;
-            }
-
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
-
-            for( uint32_t i = 0; i < ck->i_entries_dts; i++ )
-            {
-                if ( i_current_index_samples_left )
+                uint32_t i_count = __MIN( i_sample_count,
+                                          stts->pi_sample_count[i_index] - i_skip );
+                i_next_dts += (int64_t)i_count * stts->pi_sample_delta[i_index];
+                i_sample_count -= i_count;
+                i_skip += i_count;
+                if( i_skip == stts->pi_sample_count[i_index] )
                 {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += (int64_t)ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = i_current_index_samples_left;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += (int64_t)ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_current_index_samples_left ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
+                    i_index++;
+                    i_skip = 0;
                 }
-                else
-                {
-                    if ( stts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += (int64_t)ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left = stts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = stts->pi_sample_count[i_index];
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += (int64_t)ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( stts->pi_sample_count[i_index] ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= stts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
-
             }
+            ck->i_duration = i_next_dts - ck->i_first_dts;
+            b_truncated |= i_sample_count > 0;
         }
+
+        if( b_truncated )
+            msg_Err( p_demux, "invalid STTS table: missing samples" );
     }
 
 
@@ -2977,7 +2827,7 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     p_box = MP4_BoxGet( p_demux_track->p_stbl, "ctts" );
     if( p_box && p_box->data.p_ctts )
     {
-        MP4_Box_data_ctts_t *ctts = p_box->data.p_ctts;
+        const MP4_Box_data_ctts_t *ctts = p_box->data.p_ctts;
 
         msg_Warn( p_demux, "CTTS table of %"PRIu32" entries", ctts->i_entry_count );
 
@@ -2997,81 +2847,30 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
         }
         p_demux_track->i_cts_shift = i_cts_shift;
 
-        /* Create pts-dts table per chunk */
+        p_demux_track->p_ctts = ctts;
+
+        /* Save position of each chunk in the pts-dts table */
         uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
+        uint32_t i_skip = 0;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
-
-            /* count how many entries are needed for this chunk
-             * for p_sample_offset_pts and p_sample_count_pts */
-            ck->i_entries_pts = 0;
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_pts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           ctts->pi_sample_count,
-                                           ctts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            i_ret = MP4_ChunkAllocEntries( ck->i_entries_pts,
-                                           ck->small_pts_buf,
-                                           &ck->p_sample_count_pts,
-                                           &ck->p_sample_offset_pts );
-            if( i_ret )
-            {
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_pts );
-                ck->i_entries_pts = 0;
-                return i_ret;
-            }
 
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
+            ck->i_ctts_entry = i_index;
+            ck->i_ctts_skip = i_skip;
 
-            for( uint32_t i = 0; i < ck->i_entries_pts; i++ )
+            uint32_t i_sample_count = ck->i_sample_count;
+            while( i_sample_count > 0 && i_index < ctts->i_entry_count )
             {
-                int64_t i_ctsdelta = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                if( i_ctsdelta < 0 ) /* should not */
-                    i_ctsdelta = 0;
-                ck->p_sample_offset_pts[i] = i_ctsdelta;
-                if ( i_current_index_samples_left )
+                uint32_t i_count = __MIN( i_sample_count,
+                                          ctts->pi_sample_count[i_index] - i_skip );
+                i_sample_count -= i_count;
+                i_skip += i_count;
+                if( i_skip == ctts->pi_sample_count[i_index] )
                 {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = i_current_index_samples_left;
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
-                {
-                    if ( ctts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        i_current_index_samples_left = ctts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = ctts->pi_sample_count[i_index];
-                        i_sample_count -= ctts->pi_sample_count[i_index];
-                        i_index++;
-                    }
+                    i_index++;
+                    i_skip = 0;
                 }
             }
         }
@@ -3467,24 +3266,27 @@ static int STTSToSampleChunk(const mp4_track_t *p_track, uint64_t i_dts,
     }
 
     /* *** find sample in the chunk *** */
+    const MP4_Box_data_stts_t *stts = p_track->p_stts;
     uint32_t i_sample = ck->i_sample_first;
+    uint32_t i_left = ck->i_sample_count; /* samples of the chunk */
+    uint32_t i_skip = ck->i_stts_skip;
     uint64_t i_entrydts = ck->i_first_dts;
 
-    for( uint_fast32_t i = 0;
-         i < ck->i_entries_dts && i_sample < ck->i_sample_count;
-         i++ )
+    for( uint32_t i = ck->i_stts_entry; i < stts->i_entry_count && i_left > 0; i++ )
     {
-        uint64_t i_entry_duration = ck->p_sample_count_dts[i] * (uint64_t)
-                                    ck->p_sample_delta_dts[i];
+        const uint32_t i_count = __MIN( i_left, stts->pi_sample_count[i] - i_skip );
+        const uint64_t i_entry_duration = i_count * (uint64_t) stts->pi_sample_delta[i];
+        i_skip = 0;
         if( i_entrydts + i_entry_duration < i_dts )
         {
             i_entrydts += i_entry_duration;
-            i_sample += ck->p_sample_count_dts[i];
+            i_sample += i_count;
+            i_left -= i_count;
         }
         else
         {
-            if( ck->p_sample_delta_dts[i] > 0 )
-                i_sample += ( i_dts - i_entrydts ) / ck->p_sample_delta_dts[i];
+            if( stts->pi_sample_delta[i] > 0 )
+                i_sample += ( i_dts - i_entrydts ) / stts->pi_sample_delta[i];
             break;
         }
     }
@@ -3728,7 +3530,8 @@ static void TrackUpdateStarttimes( mp4_track_t *p_track )
 
     /* Probe the 16 first B frames */
     uint32_t i_chunk = p_track->i_chunk;
-    if( !p_track->chunk[i_chunk].i_entries_pts )
+    if( !p_track->p_ctts ||
+        p_track->chunk[i_chunk].i_ctts_entry >= p_track->p_ctts->i_entry_count )
         return;
 
     stime_t lowest = p_track->i_start_dts;
@@ -3751,9 +3554,9 @@ static void TrackUpdateStarttimes( mp4_track_t *p_track )
             break;
         assert(i_nextsample >= ck->i_sample_first);
         stime_t pts;
-        stime_t dts = pts = MP4_ChunkGetSampleDTS( ck, i_nextsample - ck->i_sample_first );
+        stime_t dts = pts = MP4_ChunkGetSampleDTS( p_track, ck, i_nextsample - ck->i_sample_first );
         stime_t delta = UNKNOWN_DELTA;
-        if( MP4_ChunkGetSampleCTSDelta( ck, i_nextsample - ck->i_sample_first, &delta ) )
+        if( MP4_ChunkGetSampleCTSDelta( p_track, ck, i_nextsample - ck->i_sample_first, &delta ) )
             pts += delta;
         if( pts < lowest )
         {
@@ -3769,9 +3572,9 @@ static void TrackUpdateSampleAndTimes( mp4_track_t *p_track )
     uint32_t i_chunk_sample = p_track->i_sample - p_chunk->i_sample_first;
     if( i_chunk_sample > p_chunk->i_sample_count && p_chunk->i_sample_count )
         i_chunk_sample = p_chunk->i_sample_count - 1;
-    p_track->i_next_dts = MP4_ChunkGetSampleDTS( p_chunk, i_chunk_sample );
+    p_track->i_next_dts = MP4_ChunkGetSampleDTS( p_track, p_chunk, i_chunk_sample );
     stime_t i_next_delta;
-    if( !MP4_ChunkGetSampleCTSDelta( p_chunk, i_chunk_sample, &i_next_delta ) )
+    if( !MP4_ChunkGetSampleCTSDelta( p_track, p_chunk, i_chunk_sample, &i_next_delta ) )
         p_track->i_next_delta = UNKNOWN_DELTA;
     else
         p_track->i_next_delta = i_next_delta;
@@ -4068,16 +3871,8 @@ static void MP4_TrackClean( es_out_t *out, mp4_track_t *p_track )
     if( p_track->p_es )
         es_out_Del( out, p_track->p_es );
 
-    if( p_track->chunk )
-    {
-        for( unsigned int i_chunk = 0; i_chunk < p_track->i_chunk_count; i_chunk++ )
-            MP4_ChunkDestroy( &p_track->chunk[i_chunk] );
-    }
     free( p_track->chunk );
 
-    if( !p_track->i_sample_size )
-        free( p_track->p_sample_size );
-
     ASFPacketTrackReset( &p_track->asfinfo );
 
     free( p_track->context.runs.p_array );
@@ -4776,6 +4571,103 @@ static bool GetMoofTrackDuration( MP4_Box_t *p_moov, MP4_Box_t *p_moof,
     return false;
 }
 
+/* Duration up to the end of the last fragment, read from the last one the
+ * mfra index refers to, as the next ones have no sync sample to index */
+static stime_t GetMfraDuration( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    MP4_Box_t *p_first_tfra = MP4_BoxGet( p_sys->p_root, "mfra/tfra" );
+    uint64_t i_last_moof = 0;
+    unsigned i_tfra = 0;
+
+    for( MP4_Box_t *p_tfra = p_first_tfra; p_tfra; p_tfra = p_tfra->p_next )
+    {
+        const MP4_Box_data_tfra_t *p_data = BOXDATA(p_tfra);
+        if( p_tfra->i_type != ATOM_tfra || !p_data || !p_data->i_number_of_entries )
+            continue;
+        i_last_moof = __MAX( i_last_moof,
+                             p_data->p_moof_offset[p_data->i_number_of_entries - 1] );
+        i_tfra++;
+    }
+
+    if( i_tfra == 0 )
+        return 0;
+
+    /* last sync sample times, until fragments tell their ends */
+    stime_t *pi_ends = vlc_alloc( i_tfra, sizeof(*pi_ends) );
+    if( unlikely(!pi_ends) )
+        return 0;
+    i_tfra = 0;
+    for( MP4_Box_t *p_tfra = p_first_tfra; p_tfra; p_tfra = p_tfra->p_next )
+    {
+        const MP4_Box_data_tfra_t *p_data = BOXDATA(p_tfra);
+        if( p_tfra->i_type == ATOM_tfra && p_data && p_data->i_number_of_entries )
+            pi_ends[i_tfra++] = p_data->p_time[p_data->i_number_of_entries - 1];
+    }
+
+    const uint8_t *p_peek;
+    if( vlc_stream_Seek( p_demux->s, i_last_moof ) == VLC_SUCCESS &&
+        vlc_stream_Peek( p_demux->s, &p_peek, 8 ) == 8 &&
+        VLC_FOURCC( p_peek[4], p_peek[5], p_peek[6], p_peek[7] ) == ATOM_moof )
+    {
+        /* Load the remaining fragments one at a time */
+        for( bool b_first = true;; b_first = false )
+        {
+            MP4_Box_t *p_chunk = MP4_BoxGetNextChunk( p_demux->s );
+            if( !p_chunk )
+                break;
+
+            MP4_Box_t *p_moof = p_chunk->p_last;
+            if( p_moof->i_type != ATOM_moof )
+            {
+                MP4_BoxFree( p_chunk );
+                break;
+            }
+
+            i_tfra = 0;
+            for( MP4_Box_t *p_tfra = p_first_tfra; p_tfra; p_tfra = p_tfra->p_next )
+            {
+                const MP4_Box_data_tfra_t *p_data = BOXDATA(p_tfra);
+                if( p_tfra->i_type != ATOM_tfra || !p_data || !p_data->i_number_of_entries )
+                    continue;
+
+                MP4_Box_t *p_traf = MP4_GetTrafByTrackID( p_moof, p_data->i_track_ID );
+                const MP4_Box_t *p_tfdt = p_traf ? MP4_BoxGet( p_traf, "tfdt" ) : NULL;
+                stime_t i_duration;
+                if( GetMoofTrackDuration( p_sys->p_moov, p_moof, p_data->i_track_ID, &i_duration ) )
+                {
+                    if( p_tfdt && BOXDATA(p_tfdt) )
+                        pi_ends[i_tfra] = BOXDATA(p_tfdt)->i_base_media_decode_time + i_duration;
+                    else if( !b_first ) /* follows the previous fragment */
+                        pi_ends[i_tfra] += i_duration;
+                }
+                i_tfra++;
+            }
+
+            MP4_BoxFree( p_chunk );
+        }
+    }
+
+    stime_t i_max_duration = 0;
+    i_tfra = 0;
+    for( MP4_Box_t *p_tfra = p_first_tfra; p_tfra; p_tfra = p_tfra->p_next )
+    {
+        const MP4_Box_data_tfra_t *p_data = BOXDATA(p_tfra);
+        if( p_tfra->i_type != ATOM_tfra || !p_data || !p_data->i_number_of_entries )
+            continue;
+
+        const mp4_track_t *p_track = MP4_GetTrackByTrackID( p_demux, p_data->i_track_ID );
+        if( p_track && p_track->i_timescale )
+            i_max_duration = __MAX( i_max_duration,
+                                    MP4_rescale( pi_ends[i_tfra], p_track->i_timescale,
+                                                 p_sys->i_timescale ) );
+        i_tfra++;
+    }
+
+    free( pi_ends );
+    return i_max_duration;
+}
+
 static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -4784,69 +4676,75 @@ static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
 
     assert( p_sys->p_root );
 
-    MP4_Box_t *p_vroot = MP4_BoxNew(ATOM_root);
-    if( !p_vroot )
-        return VLC_EGENERIC;
-
     if( p_sys->b_seekable && (p_sys->b_fastseekable || b_force) )
     {
-        MP4_ReadBoxContainerChildren( p_demux->s, p_vroot, NULL ); /* Get the rest of the file */
         p_sys->b_fragments_probed = true;
 
-        const unsigned i_moof = MP4_BoxCount( p_vroot, "/moof" );
-        if( i_moof )
+        p_sys->p_fragsindex = MP4_Fragments_Index_New( p_sys->i_tracks );
+        stime_t *pi_track_times = calloc( p_sys->i_tracks, sizeof(*pi_track_times) );
+        stime_t *pi_movie_times = calloc( p_sys->i_tracks, sizeof(*pi_movie_times) );
+        if( !p_sys->p_fragsindex || !pi_track_times || !pi_movie_times )
         {
-            *pb_fragmented = true;
-            p_sys->p_fragsindex = MP4_Fragments_Index_New( p_sys->i_tracks, i_moof );
-            if( !p_sys->p_fragsindex )
-            {
-                MP4_BoxFree( p_vroot );
-                return VLC_EGENERIC;
-            }
+            MP4_Fragments_Index_Delete( p_sys->p_fragsindex );
+            p_sys->p_fragsindex = NULL;
+            free( pi_track_times );
+            free( pi_movie_times );
+            return VLC_EGENERIC;
+        }
 
-            stime_t *pi_track_times = calloc( p_sys->i_tracks, sizeof(*pi_track_times) );
-            if( !pi_track_times )
+        /* Load fragments one at a time, as long recordings can have
+         * thousands of them, and keep only their start times */
+        for( ;; )
+        {
+            MP4_Box_t *p_chunk = MP4_BoxGetNextChunk( p_demux->s );
+            if( !p_chunk )
+                break;
+
+            MP4_Box_t *p_moof = p_chunk->p_last;
+            if( p_moof->i_type != ATOM_moof )
             {
-                MP4_Fragments_Index_Delete( p_sys->p_fragsindex );
-                p_sys->p_fragsindex = NULL;
-                MP4_BoxFree( p_vroot );
-                return VLC_EGENERIC;
+                /* stopped on moov, or end of file */
+                bool b_eof = p_moof->i_type != ATOM_moov;
+                MP4_BoxFree( p_chunk );
+                if( b_eof )
+                    break;
+                continue;
             }
 
-            unsigned index = 0;
-
-            for( MP4_Box_t *p_moof = p_vroot->p_first; p_moof; p_moof = p_moof->p_next )
+            for( unsigned i=0; i<p_sys->i_tracks; i++ )
             {
-                if( p_moof->i_type != ATOM_moof )
-                    continue;
+                MP4_Box_t *p_tfdt = NULL;
+                MP4_Box_t *p_traf = MP4_GetTrafByTrackID( p_moof, p_sys->track[i].i_track_ID );
+                if( p_traf )
+                    p_tfdt = MP4_BoxGet( p_traf, "tfdt" );
 
-                for( unsigned i=0; i<p_sys->i_tracks; i++ )
+                if( p_tfdt && BOXDATA(p_tfdt) )
+                {
+                    pi_track_times[i] = p_tfdt->data.p_tfdt->i_base_media_decode_time;
+                }
+                else if( p_sys->p_fragsindex->i_entries == 0 ) /* Set first fragment time offset from moov */
                 {
-                    MP4_Box_t *p_tfdt = NULL;
-                    MP4_Box_t *p_traf = MP4_GetTrafByTrackID( p_moof, p_sys->track[i].i_track_ID );
-                    if( p_traf )
-                        p_tfdt = MP4_BoxGet( p_traf, "tfdt" );
+                    stime_t i_duration = GetMoovTrackDuration( p_sys, p_sys->track[i].i_track_ID );
+                    pi_track_times[i] = MP4_rescale( i_duration, p_sys->i_timescale, p_sys->track[i].i_timescale );
+                }
 
-                    if( p_tfdt && BOXDATA(p_tfdt) )
-                    {
-                        pi_track_times[i] = p_tfdt->data.p_tfdt->i_base_media_decode_time;
-                    }
-                    else if( index == 0 ) /* Set first fragment time offset from moov */
-                    {
-                        stime_t i_duration = GetMoovTrackDuration( p_sys, p_sys->track[i].i_track_ID );
-                        pi_track_times[i] = MP4_rescale( i_duration, p_sys->i_timescale, p_sys->track[i].i_timescale );
-                    }
+                pi_movie_times[i] = MP4_rescale( pi_track_times[i], p_sys->track[i].i_timescale, p_sys->i_timescale );
 
-                    stime_t i_movietime = MP4_rescale( pi_track_times[i], p_sys->track[i].i_timescale, p_sys->i_timescale );
-                    p_sys->p_fragsindex->p_times[index * p_sys->i_tracks + i] = i_movietime;
+                stime_t i_duration = 0;
+                if( GetMoofTrackDuration( p_sys->p_moov, p_moof, p_sys->track[i].i_track_ID, &i_duration ) )
+                    pi_track_times[i] += i_duration;
+            }
 
-                    stime_t i_duration = 0;
-                    if( GetMoofTrackDuration( p_sys->p_moov, p_moof, p_sys->track[i].i_track_ID, &i_duration ) )
-                        pi_track_times[i] += i_duration;
-                }
+            int i_ret = MP4_Fragments_Index_Append( p_sys->p_fragsindex, p_moof->i_pos,
+                                                    pi_movie_times );
+            MP4_BoxFree( p_chunk );
+            if( i_ret != VLC_SUCCESS )
+                break;
+        }
 
-                p_sys->p_fragsindex->pi_pos[index++] = p_moof->i_pos;
-            }
+        if( p_sys->p_fragsindex->i_entries )
+        {
+            *pb_fragmented = true;
 
             for( unsigned i=0; i<p_sys->i_tracks; i++ )
             {
@@ -4854,15 +4752,25 @@ static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
                 if( p_sys->p_fragsindex->i_last_time < i_movietime )
                     p_sys->p_fragsindex->i_last_time = i_movietime;
             }
-
-            free( pi_track_times );
 #ifdef MP4_VERBOSE
             MP4_Fragments_Index_Dump( VLC_OBJECT(p_demux), p_sys->p_fragsindex, p_sys->i_timescale );
 #endif
         }
+        else
+        {
+            MP4_Fragments_Index_Delete( p_sys->p_fragsindex );
+            p_sys->p_fragsindex = NULL;
+        }
+
+        free( pi_track_times );
+        free( pi_movie_times );
     }
     else
     {
+        MP4_Box_t *p_vroot = MP4_BoxNew(ATOM_root);
+        if( !p_vroot )
+            return VLC_EGENERIC;
+
         /* We stop at first moof, which validates our fragmentation condition
          * and we'll find others while reading. */
         const uint32_t excllist[] = { ATOM_moof, 0 };
@@ -4873,9 +4781,9 @@ static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
             *pb_fragmented = (VLC_FOURCC( p_peek[4], p_peek[5], p_peek[6], p_peek[7] ) == ATOM_moof);
         else
             *pb_fragmented = false;
-    }
 
-    MP4_BoxFree( p_vroot );
+        MP4_BoxFree( p_vroot );
+    }
 
     MP4_Box_t *p_mehd = MP4_BoxGet( p_sys->p_moov, "mvex/mehd");
     if ( !p_mehd )
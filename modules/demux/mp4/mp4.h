@@ -30,8 +30,6 @@
 #include "fragments.h"
 #include "../asf/asfpacket.h"
 
-#define MP4_CHUNK_SMALLBUF_ENTRIES 2
-
 /* Contain all information about a chunk */
 typedef struct
 {
@@ -48,18 +46,12 @@ typedef struct
     uint64_t     i_first_dts;   /* DTS of the first sample */
     uint64_t     i_duration;    /* total duration of all samples */
 
-    uint32_t     i_entries_dts;
-    uint32_t     *p_sample_count_dts;
-    uint32_t     *p_sample_delta_dts;   /* dts delta */
-    uint32_t     small_dts_buf[MP4_CHUNK_SMALLBUF_ENTRIES * 2];
-
-    uint32_t     i_entries_pts;
-    uint32_t     *p_sample_count_pts;
-    uint32_t     *p_sample_offset_pts;  /* pts-dts */
-    uint32_t     small_pts_buf[MP4_CHUNK_SMALLBUF_ENTRIES * 2];
-
-    /* TODO if needed add pts
-        but quickly *add* support for edts and seeking */
+    /* where the first sample is in the stts/ctts run-length tables:
+     * entry, and count of the samples of that entry before it */
+    uint32_t     i_stts_entry;
+    uint32_t     i_stts_skip;
+    uint32_t     i_ctts_entry;
+    uint32_t     i_ctts_skip;
 
 } mp4_chunk_t;
 
@@ -153,8 +145,11 @@ typedef struct
     /* sample size, p_sample_size defined only if i_sample_size == 0
         else i_sample_size is size for all sample */
     uint32_t         i_sample_size;
-    uint32_t         *p_sample_size; /* XXX perhaps add file offset if take
-//                                    too much time to do sumations each time*/
+    const uint32_t   *p_sample_size; /* stsz table */
+
+    /* sample -> dts and pts-dts run-length tables, chunks point into them */
+    const MP4_Box_data_stts_t *p_stts;
+    const MP4_Box_data_ctts_t *p_ctts; /* could be NULL */
 
     const MP4_Box_t *p_track;
     const MP4_Box_t *p_stbl;  /* will contain all timing information */
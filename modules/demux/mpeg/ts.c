@@ -123,6 +123,16 @@ static void Close ( vlc_object_t * );
 #define TS_OFFSETFIX_TEXT   "Try to fix too early PCR (or late DTS)"
 #define TS_GENERATED_PCR_OFFSET_TEXT "Offset in ms for generated PCR"
 
+#define SEEK_INDEX_TEXT N_("Cache a seek index")
+#define SEEK_INDEX_LONGTEXT N_("Remember the time positions of the files " \
+    "played, to seek them directly and get their duration without probing " \
+    "the next times.")
+
+#define WORKERS_TEXT N_("PES threads")
+#define WORKERS_LONGTEXT N_("Number of threads reassembling and sending " \
+    "the PES of the programs, between PCRs. This helps when demuxing " \
+    "many programs at once. 0 disables.")
+
 #define PCR_TEXT N_("Trust in-stream PCR")
 #define PCR_LONGTEXT N_("Use the stream PCR as a reference.")
 
@@ -163,6 +173,9 @@ vlc_module_begin ()
     add_bool( "ts-pcr-offsetfix", true, TS_OFFSETFIX_TEXT, NULL )
     add_integer_with_range( "ts-generated-pcr-offset", 120, 0, 500,
                             TS_GENERATED_PCR_OFFSET_TEXT, NULL )
+    add_bool( "ts-seek-index", true, SEEK_INDEX_TEXT, SEEK_INDEX_LONGTEXT )
+    add_integer_with_range( "ts-workers", 0, 0, TS_WORKERS_MAX,
+                            WORKERS_TEXT, WORKERS_LONGTEXT )
 
     set_capability( "demux", 10 )
     set_callbacks( Open, Close )
@@ -191,12 +204,18 @@ static ts_90khz_t GetPCR( const block_t * );
 static block_t * ProcessTSPacket( demux_t *p_demux, ts_pid_t *pid, block_t *p_pkt, int * );
 static bool GatherSectionsData( demux_t *p_demux, ts_pid_t *, block_t *, size_t );
 static bool GatherPESData( demux_t *p_demux, ts_pid_t *, block_t *, size_t );
-static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, vlc_tick_t i_pcr );
+static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, vlc_tick_t i_pcr,
+                           uint64_t i_offset );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, vlc_tick_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, ts_90khz_t );
+static bool ProgramBatched( const demux_sys_t *, const ts_pmt_t * );
+static void BatchPacket( demux_t *, ts_pmt_t *, block_t * );
+static void FlushProgramBatch( demux_t *, ts_pmt_t * );
+static void CollectProgramBatches( demux_t * );
+static void IndexRAP( demux_t *p_demux, ts_pid_t *, const block_t * );
 static void PCRFixHandle( demux_t *, ts_pmt_t *, block_t * );
 
 #define TS_PACKET_SIZE_188 188
@@ -405,6 +424,10 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_packet_size = i_packet_size;
     p_sys->i_packet_header_size = i_packet_header_size;
     p_sys->i_ts_read = 50;
+    ts_reader_Init( &p_sys->reader, VLC_OBJECT(p_demux),
+                    i_packet_size, i_packet_header_size );
+    p_sys->index = NULL;
+    p_sys->workers = NULL;
     p_sys->csa = NULL;
     p_sys->b_start_record = false;
     p_sys->record_dir_path = NULL;
@@ -542,6 +565,20 @@ static int Open( vlc_object_t *p_this )
     else
         p_sys->es_creation = CREATE_ES;
 
+    if( p_sys->b_canseek && !p_sys->b_access_control &&
+        var_InheritBool( p_demux, "ts-seek-index" ) )
+        p_sys->index = ts_index_Open( VLC_OBJECT(p_demux), p_demux->s,
+                                      i_packet_size );
+
+    int64_t i_workers = var_InheritInteger( p_demux, "ts-workers" );
+    if( i_workers > 0 && !p_demux->b_preparsing )
+    {
+        i_workers = __MIN(i_workers, TS_WORKERS_MAX);
+        p_sys->workers = ts_workers_New( VLC_OBJECT(p_demux), i_workers );
+        if( p_sys->workers )
+            msg_Dbg( p_demux, "handling PES on %"PRId64" threads", i_workers );
+    }
+
     /* Preparse time */
     if( p_demux->b_preparsing && p_sys->b_canseek )
     {
@@ -567,6 +604,12 @@ static void Close( vlc_object_t *p_this )
     demux_t     *p_demux = (demux_t*)p_this;
     demux_sys_t *p_sys = p_demux->p_sys;
 
+    if( p_sys->workers )
+    {
+        DrainPESWorkers( p_demux );
+        ts_workers_Delete( p_sys->workers );
+    }
+
     PIDRelease( p_demux, GetPID(p_sys, 0) );
 
     vlc_mutex_lock( &p_sys->csa_lock );
@@ -591,6 +634,11 @@ static void Close( vlc_object_t *p_this )
         p_sys->stream = p_demux->s;
     }
 
+    ts_reader_Clean( &p_sys->reader );
+
+    if( p_sys->index )
+        ts_index_Close( p_sys->index );
+
     /* Release all non default pids */
     ts_pid_list_Release( p_demux, &p_sys->pids );
 
@@ -635,6 +683,7 @@ static int Demux( demux_t *p_demux )
     if( p_sys->i_pmt_es == 0 && !SEEN(GetPID(p_sys, 0)) && p_sys->patfix.status == PAT_MISSING )
     {
         msg_Warn( p_demux, "Generating PAT as we still have not received one" );
+        DrainPESWorkers( p_demux );
         MissingPATPMTFixup( p_demux );
         GetPID(p_sys, 0)->u.p_pat->b_generated = true;
         p_sys->patfix.status = PAT_FIXTRIED;
@@ -648,6 +697,7 @@ static int Demux( demux_t *p_demux )
         block_t     *p_pkt;
         if( !(p_pkt = ReadTSPacket( p_demux )) )
         {
+            DrainPESWorkers( p_demux );
             return VLC_DEMUXER_EOF;
         }
 
@@ -679,6 +729,8 @@ static int Demux( demux_t *p_demux )
         ts_pid_t *p_pid = GetPID( p_sys, PIDGet( p_pkt ) );
         if( !SEEN(p_pid) )
         {
+            /* The flags are read when handling the PES */
+            DrainPESWorkers( p_demux );
             if( p_pid->type == TYPE_FREE )
                 msg_Dbg( p_demux, "pid[%d] unknown", p_pid->i_pid );
             p_pid->i_flags |= FLAG_SEEN;
@@ -738,6 +790,29 @@ static int Demux( demux_t *p_demux )
                 continue;
             }
 
+            if( p_sys->index &&
+                (p_pkt->p_buffer[1] & 0x40) && /* payload start */
+                (p_pkt->p_buffer[3] & 0xF0) == 0x30 && /* has adaptation and unencrypted payload */
+                p_pkt->p_buffer[4] > 0 && (p_pkt->p_buffer[5] & 0x40) ) /* random access */
+            {
+                IndexRAP( p_demux, p_pid, p_pkt );
+            }
+
+            ts_pmt_t *p_pmt = p_pid->u.p_stream->p_es->p_program;
+            if( p_pmt && p_pid->u.p_stream->transport != TS_TRANSPORT_IGNORE )
+            {
+                /* SL sections update the program descriptors */
+                if( ProgramBatched( p_sys, p_pmt ) &&
+                   !( p_pid->u.p_stream->transport == TS_TRANSPORT_SECTIONS &&
+                      p_pid->u.p_stream->p_es->i_sl_es_id ) )
+                {
+                    BatchPacket( p_demux, p_pmt, p_pkt );
+                    break;
+                }
+                /* Keep the program order */
+                FlushProgramBatch( p_demux, p_pmt );
+            }
+
             if( p_pid->u.p_stream->transport == TS_TRANSPORT_PES )
             {
                 b_frame = GatherPESData( p_demux, p_pid, p_pkt, i_header );
@@ -776,6 +851,8 @@ static int Demux( demux_t *p_demux )
             break;
     }
 
+    CollectProgramBatches( p_demux );
+
     demux_UpdateTitleFromStream( p_demux );
     return VLC_DEMUXER_SUCCESS;
 }
@@ -822,6 +899,8 @@ void UpdatePESFilters( demux_t *p_demux, bool b_all )
     demux_sys_t *p_sys = p_demux->p_sys;
     ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
 
+    DrainPESWorkers( p_demux );
+
     /* We need 3 pass to avoid loss on deselect/relesect with hw filters and
        because pid could be shared and its state altered by another unselected pmt
        First clear flag on every referenced pid
@@ -965,7 +1044,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         if( (i64 = stream_Size( p_sys->stream) ) > 0 )
         {
-            uint64_t offset = vlc_stream_Tell( p_sys->stream );
+            uint64_t offset = ts_reader_Tell( &p_sys->reader, p_sys->stream );
             *pf = (double)offset / (double)i64;
             return VLC_SUCCESS;
         }
@@ -978,6 +1057,9 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
         if(!p_sys->b_canseek)
             break;
 
+        /* Output the data read before the seek */
+        DrainPESWorkers( p_demux );
+
         if( p_sys->b_access_control &&
            !p_sys->b_ignore_time_for_positions && b_bool && p_pmt )
         {
@@ -1012,7 +1094,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         i64 = stream_Size( p_sys->stream );
         if( i64 > 0 &&
-            vlc_stream_Seek( p_sys->stream, (int64_t)(i64 * f) ) == VLC_SUCCESS )
+            ts_reader_Seek( &p_sys->reader, p_sys->stream, (int64_t)(i64 * f) ) == VLC_SUCCESS )
         {
             ReadyQueuesPostSeek( p_demux );
             return VLC_SUCCESS;
@@ -1023,6 +1105,9 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     {
         vlc_tick_t i_time = va_arg( args, vlc_tick_t );
 
+        /* Output the data read before the seek */
+        DrainPESWorkers( p_demux );
+
         if( p_sys->b_canseek && p_pmt && p_pmt->pcr.i_first != VLC_TICK_INVALID &&
            !SeekToTime( p_demux, p_pmt, p_pmt->pcr.i_first + i_time ) )
         {
@@ -1716,7 +1801,8 @@ static void ParsePESDataChain( demux_t *p_demux, ts_pid_t *pid, block_t *p_pes,
                     vlc_tick_t i_pcr = p_block->i_dts;
                     if( i_pcr > VLC_TICK_0 + p_sys->i_generated_pcr_dpb_offset )
                         i_pcr -= p_sys->i_generated_pcr_dpb_offset;
-                    ProgramSetPCR( p_demux, p_pmt, i_pcr );
+                    ProgramSetPCR( p_demux, p_pmt, i_pcr,
+                                   ts_reader_Tell( &p_sys->reader, p_sys->stream ) );
                 }
 
                 /* Compute PCR/DTS offset if any */
@@ -1802,8 +1888,12 @@ static block_t* ReadTSPacket( demux_t *p_demux )
 
     block_t     *p_pkt;
 
-    /* Get a new TS packet */
-    if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
+    /* Get a new TS packet. The header of BluRay streams is skipped, as the
+     * re-sync logic would do (by adjusting packet start), but this would
+     * result in losing first and last ts packets. First packet is usually
+     * PAT, and losing it means losing whole first GOP. This is fatal with
+     * still-image based menus. */
+    if( !( p_pkt = ts_reader_Read( &p_sys->reader, p_sys->stream ) ) )
     {
         int64_t size = stream_Size( p_sys->stream );
         if( size >= 0 && (uint64_t)size == vlc_stream_Tell( p_sys->stream ) )
@@ -1813,64 +1903,6 @@ static block_t* ReadTSPacket( demux_t *p_demux )
         return NULL;
     }
 
-    if( p_pkt->i_buffer < TS_HEADER_SIZE + p_sys->i_packet_header_size )
-    {
-        block_Release( p_pkt );
-        return NULL;
-    }
-
-    /* Skip header (BluRay streams).
-     * re-sync logic would do this (by adjusting packet start), but this would result in losing first and last ts packets.
-     * First packet is usually PAT, and losing it means losing whole first GOP. This is fatal with still-image based menus.
-     */
-    p_pkt->p_buffer += p_sys->i_packet_header_size;
-    p_pkt->i_buffer -= p_sys->i_packet_header_size;
-
-    /* Check sync byte and re-sync if needed */
-    if( p_pkt->p_buffer[0] != 0x47 )
-    {
-        msg_Warn( p_demux, "lost synchro" );
-        block_Release( p_pkt );
-        for( ;; )
-        {
-            const uint8_t *p_peek;
-            int i_peek = 0;
-            unsigned i_skip = 0;
-
-            i_peek = vlc_stream_Peek( p_sys->stream, &p_peek,
-                    p_sys->i_packet_size * 10 );
-            if( i_peek < 0 || (unsigned)i_peek < p_sys->i_packet_size + 1 )
-            {
-                msg_Dbg( p_demux, "eof ?" );
-                return NULL;
-            }
-
-            while( i_skip < i_peek - p_sys->i_packet_size )
-            {
-                if( p_peek[i_skip + p_sys->i_packet_header_size] == 0x47 &&
-                        p_peek[i_skip + p_sys->i_packet_header_size + p_sys->i_packet_size] == 0x47 )
-                {
-                    break;
-                }
-                i_skip++;
-            }
-            msg_Dbg( p_demux, "skipping %d bytes of garbage at %"PRIu64,
-                     i_skip, vlc_stream_Tell( p_sys->stream ) );
-            if (vlc_stream_Read( p_sys->stream, NULL, i_skip ) != i_skip)
-                return NULL;
-
-            if( i_skip < i_peek - p_sys->i_packet_size )
-            {
-                break;
-            }
-        }
-        msg_Dbg( p_demux, "resynced at %" PRIu64, vlc_stream_Tell( p_sys->stream ) );
-        if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
-        {
-            msg_Dbg( p_demux, "eof ?" );
-            return NULL;
-        }
-    }
     return p_pkt;
 }
 
@@ -1927,6 +1959,8 @@ static void UpdatePIDScrambledState( demux_t *p_demux, ts_pid_t *p_pid, bool b_s
         return;
     }
 
+    DrainPESWorkers( p_demux );
+
     msg_Warn( p_demux, "scrambled state changed on pid %d (%d->%d)",
               p_pid->i_pid, !!SCRAMBLED(*p_pid), b_scrambled );
 
@@ -1958,6 +1992,11 @@ static void ReadyQueuesPostSeek( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
+    DrainPESWorkers( p_demux );
+
+    if( p_sys->index )
+        ts_index_Discontinuity( p_sys->index );
+
     ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
     for( int i=0; i< p_pat->programs.i_size; i++ )
     {
@@ -2002,17 +2041,30 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, vlc_tick_t i_see
 
     /* Deal with common but worst binary search case */
     if( p_pmt->pcr.i_first == i_seektime && p_sys->b_canseek )
-        return vlc_stream_Seek( p_sys->stream, 0 );
+        return ts_reader_Seek( &p_sys->reader, p_sys->stream, 0 );
 
     const int64_t i_stream_size = stream_Size( p_sys->stream );
-    if( !p_sys->b_canfastseek || i_stream_size < p_sys->i_packet_size )
+    if( i_stream_size < p_sys->i_packet_size )
         return VLC_EGENERIC;
 
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
-
-    /* Find the time position by using binary search algorithm. */
     uint64_t i_head_pos = 0;
     uint64_t i_tail_pos = (uint64_t) i_stream_size - p_sys->i_packet_size;
+
+    /* Time already played, or narrower range to search */
+    if( p_sys->index )
+    {
+        uint64_t i_pos;
+        if( ts_index_Lookup( p_sys->index, p_pmt->i_number, i_seektime,
+                             &i_pos, &i_head_pos, &i_tail_pos ) )
+            return ts_reader_Seek( &p_sys->reader, p_sys->stream, i_pos );
+    }
+
+    if( !p_sys->b_canfastseek )
+        return VLC_EGENERIC;
+
+    const uint64_t i_initial_pos = ts_reader_Tell( &p_sys->reader, p_sys->stream );
+
+    /* Find the time position by using binary search algorithm. */
     if( i_head_pos >= i_tail_pos )
         return VLC_EGENERIC;
 
@@ -2024,7 +2076,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, vlc_tick_t i_see
         uint64_t i_div = i_splitpos % p_sys->i_packet_size;
         i_splitpos -= i_div;
 
-        if ( vlc_stream_Seek( p_sys->stream, i_splitpos ) != VLC_SUCCESS )
+        if ( ts_reader_Seek( &p_sys->reader, p_sys->stream, i_splitpos ) != VLC_SUCCESS )
             break;
 
         uint64_t i_pos = i_splitpos;
@@ -2038,7 +2090,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, vlc_tick_t i_see
                 break;
             }
             else
-                i_pos = vlc_stream_Tell( p_sys->stream );
+                i_pos = ts_reader_Tell( &p_sys->reader, p_sys->stream );
 
             int i_pid = PIDGet( p_pkt );
             ts_pid_t *p_pid = GetPID(p_sys, i_pid);
@@ -2095,7 +2147,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, vlc_tick_t i_see
     if( !b_found )
     {
         msg_Dbg( p_demux, "Seek():cannot find a time position." );
-        if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) != VLC_SUCCESS )
+        if( ts_reader_Seek( &p_sys->reader, p_sys->stream, i_initial_pos ) != VLC_SUCCESS )
             msg_Err( p_demux, "Can't seek back to %" PRIu64, i_initial_pos );
         return VLC_EGENERIC;
     }
@@ -2181,7 +2233,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, bool *pb_fou
                         if( b_end )
                         {
                             p_pmt->i_last_dts = FROM_SCALE(i_pcr);
-                            p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                            p_pmt->i_last_dts_byte = ts_reader_Tell( &p_sys->reader, p_sys->stream );
                         }
                         /* Start, only keep first */
                         else if( b_pcrresult && p_pmt->pcr.i_first == VLC_TICK_INVALID )
@@ -2209,7 +2261,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, bool *pb_fou
 int ProbeStart( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = ts_reader_Tell( &p_sys->reader, p_sys->stream );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = 0;
@@ -2221,7 +2273,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
         i_pos = (int64_t)p_sys->i_packet_size * i_probe_count;
         i_pos = __MIN( i_pos, i_stream_size );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( ts_reader_Seek( &p_sys->reader, p_sys->stream, i_pos ) )
             return VLC_EGENERIC;
 
         int i_count =  ProbeChunk( p_demux, i_program, false, &b_found );
@@ -2233,7 +2285,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
     } while( i_pos < i_stream_size && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( ts_reader_Seek( &p_sys->reader, p_sys->stream, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2242,7 +2294,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
 int ProbeEnd( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = ts_reader_Tell( &p_sys->reader, p_sys->stream );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = PROBE_CHUNK_COUNT;
@@ -2254,7 +2306,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
         i_pos = i_stream_size - (p_sys->i_packet_size * i_probe_count);
         i_pos = __MAX( i_pos, 0 );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( ts_reader_Seek( &p_sys->reader, p_sys->stream, i_pos ) )
             return VLC_EGENERIC;
 
         int i_count = ProbeChunk( p_demux, i_program, true, &b_found );
@@ -2266,13 +2318,15 @@ int ProbeEnd( demux_t *p_demux, int i_program )
     } while( i_pos > 0 && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( ts_reader_Seek( &p_sys->reader, p_sys->stream, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
 }
 
-static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, vlc_tick_t i_pcr )
+/* i_offset is the stream offset following the PCR packet */
+static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, vlc_tick_t i_pcr,
+                           uint64_t i_offset )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
@@ -2282,6 +2336,9 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, vlc_tick_t i_pcr )
     {
         vlc_tick_t i_mindts = VLC_TICK_INVALID;
 
+        /* The queues of all the programs are read */
+        DrainPESWorkers( p_demux );
+
         ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
         for( int i=0; i< p_pat->programs.i_size; i++ )
         {
@@ -2322,14 +2379,14 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, vlc_tick_t i_pcr )
         es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, i_pcr );
         /* growing files/named fifo handling */
         if( p_sys->b_access_control == false &&
-            vlc_stream_Tell( p_sys->stream ) > p_pmt->i_last_dts_byte )
+            i_offset > p_pmt->i_last_dts_byte )
         {
             if( p_pmt->i_last_dts_byte == 0 ) /* first run */
                 p_pmt->i_last_dts_byte = stream_Size( p_sys->stream );
             else
             {
                 p_pmt->i_last_dts = i_pcr;
-                p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                p_pmt->i_last_dts_byte = i_offset;
             }
         }
     }
@@ -2337,24 +2394,15 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, vlc_tick_t i_pcr )
 
 static int IsVideoEnd( ts_pid_t *p_pid )
 {
-    /* jump to near end of PES packet */
+    /* the PES is gathered in a single block: past its first packet,
+     * check for start code at end */
     block_t *p = p_pid->u.p_stream->gather.p_data;
-    if( !p || !p->p_next )
-        return 0;
-    while( p->p_next->p_next )
-        p = p->p_next;
-    if( p->p_next->i_buffer > 4)
-        p = p->p_next;
-
-    /* extract last bytes */
-    uint8_t tail[ 188 ];
-    const int i_tail = block_ChainExtract( p, tail, sizeof( tail ) );
-    if( i_tail < 4 )
+    if( !p || p->i_buffer <= 188 )
         return 0;
 
-    /* check for start code at end */
-    return ( tail[ i_tail - 4 ] == 0 && tail[ i_tail - 3 ] == 0 && tail[ i_tail - 2 ] == 1 &&
-             ( tail[ i_tail - 1 ] == 0xb7 ||  tail[ i_tail - 1 ] == 0x0a ) );
+    const uint8_t *tail = &p->p_buffer[p->i_buffer - 4];
+    return ( tail[0] == 0 && tail[1] == 0 && tail[2] == 1 &&
+             ( tail[3] == 0xb7 || tail[3] == 0x0a ) );
 }
 
 static void PCRCheckDTS( demux_t *p_demux, ts_pmt_t *p_pmt, vlc_tick_t i_pcr)
@@ -2425,6 +2473,218 @@ static void PCRCheckDTS( demux_t *p_demux, ts_pmt_t *p_pmt, vlc_tick_t i_pcr)
     }
 }
 
+/* Position of the packet just read */
+static uint64_t PacketPosition( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    return ts_reader_Tell( &p_sys->reader, p_sys->stream ) - p_sys->i_packet_size;
+}
+
+/* i_offset is the stream offset following the PCR packet */
+static void IndexPCR( demux_t *p_demux, const ts_pmt_t *p_pmt, uint64_t i_offset )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->index == NULL || p_pmt->pcr.i_first == VLC_TICK_INVALID ||
+        p_pmt->pcr.i_current == VLC_TICK_INVALID )
+        return;
+
+    ts_index_AddPCR( p_sys->index, p_pmt->i_number, p_pmt->pcr.i_current,
+                     i_offset - p_sys->i_packet_size );
+}
+
+static void IndexRAP( demux_t *p_demux, ts_pid_t *p_pid, const block_t *p_pkt )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const ts_es_t *p_es = p_pid->u.p_stream->p_es;
+
+    if( p_es->fmt.i_cat != VIDEO_ES || p_es->p_program == NULL ||
+        p_es->p_program->pcr.i_first == VLC_TICK_INVALID )
+        return;
+
+    unsigned i_skip = 4 + 1 + p_pkt->p_buffer[4];
+    if( i_skip >= p_pkt->i_buffer )
+        return;
+
+    ts_90khz_t i_dts = TS_90KHZ_INVALID;
+    ts_90khz_t i_pts = TS_90KHZ_INVALID;
+    uint8_t i_stream_id;
+    unsigned i_pes_header;
+    if( ParsePESHeader( VLC_OBJECT(p_demux), &p_pkt->p_buffer[i_skip],
+                        p_pkt->i_buffer - i_skip, &i_pes_header,
+                        &i_dts, &i_pts, &i_stream_id, NULL ) != VLC_SUCCESS ||
+        i_pts == TS_90KHZ_INVALID )
+        return;
+
+    /* Indexed by presentation time, so that starting from there
+     * gets the decoders ready to present that time */
+    const ts_pmt_t *p_pmt = p_es->p_program;
+    ts_index_AddRAP( p_sys->index, p_pmt->i_number,
+                     TimeStampWrapAround( p_pmt->pcr.i_first, FROM_SCALE(i_pts) ),
+                     PacketPosition( p_demux ) );
+}
+
+/****************************************************************************
+ * PES handling on the worker threads
+ ****************************************************************************/
+/* Once the PCR and timestamps fixups of a program are settled, the packets
+ * of its streams are routed into a batch, ended by the next PCR of the
+ * program. Each batch runs on any of the workers: PES reassembly, sections
+ * decoding and es_out. A program runs one batch at a time, in routing
+ * order, so the order within each PID is kept.
+ * The demux thread keeps the program PCR state: the PCR ending a batch is
+ * set once that batch is run, at the latest when the next batch of the
+ * program is started. */
+#define TS_BATCH_MAX_PACKETS 4096
+
+static bool ProgramBatched( const demux_sys_t *p_sys, const ts_pmt_t *p_pmt )
+{
+    /* Before that, the PES handling updates the program */
+    return p_sys->workers && p_pmt->pcr.i_current != VLC_TICK_INVALID &&
+           p_pmt->pcr.b_fix_done && !p_pmt->pcr.b_disable &&
+           p_pmt->pcr.i_pcroffset != -1;
+}
+
+static void RunBatch( demux_t *p_demux, block_t *p_pkt )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    while( p_pkt )
+    {
+        block_t *p_next = p_pkt->p_next;
+        p_pkt->p_next = NULL;
+
+        /* Routed packets: the pid exists, and the adaptation field is valid */
+        ts_pid_t *p_pid = GetPID( p_sys, PIDGet( p_pkt ) );
+        size_t i_skip = 4;
+        if( p_pkt->p_buffer[3] & 0x20 )
+            i_skip += 1 + p_pkt->p_buffer[4];
+
+        if( p_pid->u.p_stream->transport == TS_TRANSPORT_PES )
+            GatherPESData( p_demux, p_pid, p_pkt, i_skip );
+        else
+            GatherSectionsData( p_demux, p_pid, p_pkt, i_skip );
+
+        p_pkt = p_next;
+    }
+}
+
+static void ProgramBatchRun( ts_worker_job_t *p_job )
+{
+    ts_pmt_t *p_pmt = container_of( p_job, ts_pmt_t, batch.job );
+    demux_t *p_demux = p_pmt->batch.p_demux;
+
+    RunBatch( p_demux, p_pmt->batch.p_run );
+    p_pmt->batch.p_run = NULL;
+
+    if( p_pmt->batch.i_check_pcr != VLC_TICK_INVALID )
+        PCRCheckDTS( p_demux, p_pmt, p_pmt->batch.i_check_pcr );
+}
+
+/* Sets the PCR following the running batch, once run */
+static void EndProgramBatch( demux_t *p_demux, ts_pmt_t *p_pmt, bool b_wait )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_pmt->batch.b_running ||
+        ( !b_wait && !ts_workers_IsDone( &p_pmt->batch.job ) ) )
+        return;
+
+    ts_workers_Wait( p_sys->workers, &p_pmt->batch.job );
+    p_pmt->batch.b_running = false;
+
+    if( p_pmt->batch.i_pcr != VLC_TICK_INVALID )
+    {
+        ProgramSetPCR( p_demux, p_pmt, p_pmt->batch.i_pcr, p_pmt->batch.i_pcr_offset );
+        IndexPCR( p_demux, p_pmt, p_pmt->batch.i_pcr_offset );
+        p_pmt->batch.i_pcr = VLC_TICK_INVALID;
+    }
+}
+
+/* Runs the routed packets, then the PCR check and the PCR if valid */
+static void StartProgramBatch( demux_t *p_demux, ts_pmt_t *p_pmt,
+                               vlc_tick_t i_check_pcr, vlc_tick_t i_pcr )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const uint64_t i_offset = ts_reader_Tell( &p_sys->reader, p_sys->stream );
+
+    assert( !p_pmt->batch.b_running );
+
+    if( p_pmt->batch.p_pkts == NULL )
+    {
+        if( i_check_pcr != VLC_TICK_INVALID )
+            PCRCheckDTS( p_demux, p_pmt, i_check_pcr );
+        if( i_pcr != VLC_TICK_INVALID )
+        {
+            ProgramSetPCR( p_demux, p_pmt, i_pcr, i_offset );
+            IndexPCR( p_demux, p_pmt, i_offset );
+        }
+        return;
+    }
+
+    p_pmt->batch.p_run = p_pmt->batch.p_pkts;
+    p_pmt->batch.p_pkts = NULL;
+    p_pmt->batch.pp_last = &p_pmt->batch.p_pkts;
+    p_pmt->batch.i_pkts = 0;
+    p_pmt->batch.i_check_pcr = i_check_pcr;
+    p_pmt->batch.i_pcr = i_pcr;
+    p_pmt->batch.i_pcr_offset = i_offset;
+
+    p_pmt->batch.job.pf_run = ProgramBatchRun;
+    p_pmt->batch.b_running = true;
+    ts_workers_Push( p_sys->workers, &p_pmt->batch.job );
+}
+
+static void BatchPacket( demux_t *p_demux, ts_pmt_t *p_pmt, block_t *p_pkt )
+{
+    block_ChainLastAppend( &p_pmt->batch.pp_last, p_pkt );
+
+    /* PCR missing or too far apart */
+    if( ++p_pmt->batch.i_pkts >= TS_BATCH_MAX_PACKETS )
+    {
+        EndProgramBatch( p_demux, p_pmt, true );
+        StartProgramBatch( p_demux, p_pmt, VLC_TICK_INVALID, VLC_TICK_INVALID );
+    }
+}
+
+/* Handles all the data routed to the program, on the calling thread */
+static void FlushProgramBatch( demux_t *p_demux, ts_pmt_t *p_pmt )
+{
+    EndProgramBatch( p_demux, p_pmt, true );
+
+    block_t *p_pkts = p_pmt->batch.p_pkts;
+    p_pmt->batch.p_pkts = NULL;
+    p_pmt->batch.pp_last = &p_pmt->batch.p_pkts;
+    p_pmt->batch.i_pkts = 0;
+    RunBatch( p_demux, p_pkts );
+}
+
+static void CollectProgramBatches( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    ts_pid_t *patpid = GetPID(p_sys, 0);
+
+    if( p_sys->workers == NULL || patpid->type != TYPE_PAT )
+        return;
+
+    ts_pat_t *p_pat = patpid->u.p_pat;
+    for( int i = 0; i < p_pat->programs.i_size; i++ )
+        EndProgramBatch( p_demux, p_pat->programs.p_elems[i]->u.p_pmt, false );
+}
+
+void DrainPESWorkers( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    ts_pid_t *patpid = GetPID(p_sys, 0);
+
+    if( p_sys->workers == NULL || patpid->type != TYPE_PAT )
+        return;
+
+    ts_pat_t *p_pat = patpid->u.p_pat;
+    for( int i = 0; i < p_pat->programs.i_size; i++ )
+        FlushProgramBatch( p_demux, p_pat->programs.p_elems[i]->u.p_pmt );
+}
+
 static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, ts_90khz_t i_pcr )
 {
     demux_sys_t   *p_sys = p_demux->p_sys;
@@ -2445,31 +2705,46 @@ static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, ts_90khz_t i_pcr )
         if( p_pmt->pcr.b_disable )
             continue;
 
+        bool b_check_dts;
+        if( p_pmt->i_pid_pcr == 0x1FFF ) /* That program has no dedicated PCR pid ISO/IEC 13818-1 2.4.4.9 */
+        {
+            if( !PIDReferencedByProgram( p_pmt, pid->i_pid ) ) /* PCR shall be on pid itself */
+                continue;
+            /* ? update PCR for the whole group program ? */
+            b_check_dts = false;
+        }
+        /* else set PCR provided by current pid to program(s) referencing it.
+         * Can be dedicated PCR pid (no owned then) or another pid (owner == pmt) */
+        else if( p_pmt->i_pid_pcr == pid->i_pid ) /* If that program references current pid as PCR */
+        {
+            /* We've found a target group for update */
+            b_check_dts = true;
+        }
+        else continue;
+
+        const bool b_batched = ProgramBatched( p_sys, p_pmt );
+        if( b_batched ) /* previous PCR first */
+            EndProgramBatch( p_demux, p_pmt, true );
+
         vlc_tick_t i_past_pcr = p_pmt->pcr.i_current;
         if( i_past_pcr == VLC_TICK_INVALID )
             i_past_pcr = p_pmt->pcr.i_first;
 
         vlc_tick_t i_program_pcr = TimeStampWrapAround( i_past_pcr, FROM_SCALE(i_pcr) );
 
-        if( p_pmt->i_pid_pcr == 0x1FFF ) /* That program has no dedicated PCR pid ISO/IEC 13818-1 2.4.4.9 */
+        if( b_batched )
         {
-            if( PIDReferencedByProgram( p_pmt, pid->i_pid ) ) /* PCR shall be on pid itself */
-            {
-                /* ? update PCR for the whole group program ? */
-                ProgramSetPCR( p_demux, p_pmt, i_program_pcr );
-            }
-        }
-        else /* set PCR provided by current pid to program(s) referencing it */
-        {
-            /* Can be dedicated PCR pid (no owned then) or another pid (owner == pmt) */
-            if( p_pmt->i_pid_pcr == pid->i_pid ) /* If that program references current pid as PCR */
-            {
-                /* We've found a target group for update */
-                PCRCheckDTS( p_demux, p_pmt, FROM_SCALE(i_pcr) );
-                ProgramSetPCR( p_demux, p_pmt, i_program_pcr );
-            }
+            StartProgramBatch( p_demux, p_pmt,
+                               b_check_dts ? FROM_SCALE(i_pcr) : VLC_TICK_INVALID,
+                               i_program_pcr );
+            continue;
         }
 
+        if( b_check_dts )
+            PCRCheckDTS( p_demux, p_pmt, FROM_SCALE(i_pcr) );
+        ProgramSetPCR( p_demux, p_pmt, i_program_pcr,
+                       ts_reader_Tell( &p_sys->reader, p_sys->stream ) );
+        IndexPCR( p_demux, p_pmt, ts_reader_Tell( &p_sys->reader, p_sys->stream ) );
     }
 }
 
@@ -2789,6 +3064,8 @@ void AddAndCreateES( demux_t *p_demux, ts_pid_t *pid, bool b_create_delayed )
 {
     demux_sys_t  *p_sys = p_demux->p_sys;
 
+    DrainPESWorkers( p_demux );
+
     if( b_create_delayed )
         p_sys->es_creation = CREATE_ES;
 
@@ -22,6 +22,10 @@
 
 #include <vlc_arrays.h>
 
+#include "ts_reader.h"
+#include "ts_index.h"
+#include "ts_workers.h"
+
 #ifdef HAVE_ARIBB24
     typedef struct arib_instance_t arib_instance_t;
 #endif
@@ -66,6 +70,15 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    /* batched packets reads */
+    ts_reader_t reader;
+
+    /* cached seek index, or NULL */
+    ts_index_t *index;
+
+    /* threads handling the PES of the programs, or NULL */
+    ts_workers_t *workers;
+
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
 
@@ -150,6 +163,9 @@ int ProbeStart( demux_t *p_demux, int i_program );
 int ProbeEnd( demux_t *p_demux, int i_program );
 
 void AddAndCreateES( demux_t *p_demux, ts_pid_t *pid, bool b_create_delayed );
+
+/* Handles the data routed to every program, before changing the streams setup */
+void DrainPESWorkers( demux_t *p_demux );
 int FindPCRCandidate( ts_pmt_t *p_pmt );
 
 #endif
@@ -0,0 +1,603 @@
+/*****************************************************************************
+ * ts_index.c: Transport Stream input module for VLC.
+ *****************************************************************************
+ * Copyright (C) 2025 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_stream.h>
+#include <vlc_arrays.h>
+
+#include "ts_index.h"
+#include "../index_cache.h"
+
+#include <assert.h>
+
+/*
+ * Cache file layout, all little endian:
+ *  "VLCTSIDX", u32 version, u32 packet size, u64 file size, u64 file mtime,
+ *  u32 programs count, then for each program:
+ *   u32 number, u8 has bounds, u64 first, first dts, last dts, last dts byte,
+ *   u32 spans count, u32 entries count,
+ *   spans: u64 start, u64 end
+ *   entries: u64 time, u64 position, u8 flags
+ */
+#define INDEX_MAGIC    "VLCTSIDX"
+#define INDEX_VERSION  1
+#define INDEX_DIR      "tsindex"
+#define INDEX_MAX_FILE (64 << 20)
+
+/* Bounds the memory and the file of each program. Positions are indexed
+ * every TS_INDEX_INTERVAL at most, but random access points come on top,
+ * so that the played duration it covers depends on the stream. Later
+ * entries are dropped, and the played spans are no longer extended. */
+#define INDEX_MAX_ENTRIES (1 << 18)
+/* how far before the time to present a random access point is looked for */
+#define INDEX_MAX_RAP_DISTANCE VLC_TICK_FROM_SEC(10)
+
+#define ENTRY_RAP 0x01
+
+typedef struct
+{
+    vlc_tick_t i_time;
+    uint64_t i_pos;
+    uint8_t i_flags;
+} ts_index_entry_t;
+
+/* time range played without discontinuity, where entries are dense */
+typedef struct
+{
+    vlc_tick_t i_start;
+    vlc_tick_t i_end;
+} ts_index_span_t;
+
+typedef struct
+{
+    int i_number;
+    bool b_bounds;
+    ts_index_bounds_t bounds;
+    DECL_ARRAY(ts_index_entry_t) entries; /* sorted by time */
+    DECL_ARRAY(ts_index_span_t) spans; /* sorted by start, not overlapping */
+    int i_span; /* span being played, or -1 */
+    vlc_tick_t i_last_pcr;
+} ts_index_program_t;
+
+struct ts_index_t
+{
+    vlc_object_t *p_obj;
+    stream_t *s;
+    char *psz_file;
+    unsigned i_packet_size;
+    uint64_t i_size;
+    uint64_t i_mtime;
+    bool b_modified;
+    DECL_ARRAY(ts_index_program_t *) programs;
+};
+
+static ts_index_program_t * GetProgram( const ts_index_t *p_index, int i_number )
+{
+    for( int i = 0; i < p_index->programs.i_size; i++ )
+    {
+        if( p_index->programs.p_elems[i]->i_number == i_number )
+            return p_index->programs.p_elems[i];
+    }
+    return NULL;
+}
+
+static ts_index_program_t * NewProgram( ts_index_t *p_index, int i_number )
+{
+    ts_index_program_t *p_prg = calloc( 1, sizeof(*p_prg) );
+    if( unlikely(p_prg == NULL) )
+        return NULL;
+    p_prg->i_number = i_number;
+    ARRAY_INIT( p_prg->entries );
+    ARRAY_INIT( p_prg->spans );
+    p_prg->i_span = -1;
+    p_prg->i_last_pcr = VLC_TICK_INVALID;
+    ARRAY_APPEND( p_index->programs, p_prg );
+    return p_prg;
+}
+
+static ts_index_program_t * GetOrNewProgram( ts_index_t *p_index, int i_number )
+{
+    ts_index_program_t *p_prg = GetProgram( p_index, i_number );
+    return p_prg ? p_prg : NewProgram( p_index, i_number );
+}
+
+static void DeleteProgram( ts_index_program_t *p_prg )
+{
+    ARRAY_RESET( p_prg->entries );
+    ARRAY_RESET( p_prg->spans );
+    free( p_prg );
+}
+
+/* first entry after i_time */
+static int UpperEntry( const ts_index_program_t *p_prg, vlc_tick_t i_time )
+{
+    int i_low = 0, i_high = p_prg->entries.i_size;
+    while( i_low < i_high )
+    {
+        int i_mid = i_low + (i_high - i_low) / 2;
+        if( p_prg->entries.p_elems[i_mid].i_time <= i_time )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+static const ts_index_span_t * FindSpan( const ts_index_program_t *p_prg,
+                                         vlc_tick_t i_time )
+{
+    for( int i = 0; i < p_prg->spans.i_size; i++ )
+    {
+        const ts_index_span_t *p_span = &p_prg->spans.p_elems[i];
+        if( p_span->i_start > i_time )
+            break;
+        if( p_span->i_end >= i_time )
+            return p_span;
+    }
+    return NULL;
+}
+
+static void InsertEntry( ts_index_t *p_index, ts_index_program_t *p_prg, int i,
+                         vlc_tick_t i_time, uint64_t i_pos, uint8_t i_flags )
+{
+    if( p_prg->entries.i_size >= INDEX_MAX_ENTRIES )
+        return;
+    ts_index_entry_t entry = { i_time, i_pos, i_flags };
+    ARRAY_INSERT( p_prg->entries, entry, i );
+    p_index->b_modified = true;
+}
+
+/* Starts a span at i_pcr, or continues the one already covering it */
+static bool SpanStart( ts_index_program_t *p_prg, vlc_tick_t i_pcr )
+{
+    int i = 0;
+    for( ; i < p_prg->spans.i_size; i++ )
+    {
+        const ts_index_span_t *p_span = &p_prg->spans.p_elems[i];
+        if( p_span->i_start > i_pcr )
+            break;
+        if( p_span->i_end >= i_pcr )
+        {
+            p_prg->i_span = i;
+            return false;
+        }
+    }
+    ts_index_span_t span = { i_pcr, i_pcr };
+    ARRAY_INSERT( p_prg->spans, span, i );
+    p_prg->i_span = i;
+    return true;
+}
+
+/* Extends the played span up to i_pcr, merging the spans it reaches */
+static bool SpanExtend( ts_index_program_t *p_prg, vlc_tick_t i_pcr )
+{
+    ts_index_span_t *p_span = &p_prg->spans.p_elems[p_prg->i_span];
+    if( i_pcr <= p_span->i_end )
+        return false;
+    p_span->i_end = i_pcr;
+
+    const int i_next = p_prg->i_span + 1;
+    while( i_next < p_prg->spans.i_size &&
+           p_prg->spans.p_elems[i_next].i_start <= p_span->i_end )
+    {
+        p_span->i_end = __MAX( p_span->i_end, p_prg->spans.p_elems[i_next].i_end );
+        ARRAY_REMOVE( p_prg->spans, i_next );
+        p_span = &p_prg->spans.p_elems[p_prg->i_span];
+    }
+    return true;
+}
+
+void ts_index_Discontinuity( ts_index_t *p_index )
+{
+    for( int i = 0; i < p_index->programs.i_size; i++ )
+        p_index->programs.p_elems[i]->i_span = -1;
+}
+
+void ts_index_AddPCR( ts_index_t *p_index, int i_program,
+                      vlc_tick_t i_pcr, uint64_t i_pos )
+{
+    ts_index_program_t *p_prg = GetOrNewProgram( p_index, i_program );
+    if( unlikely(p_prg == NULL) )
+        return;
+
+    /* clock going back is no continuation of the played span */
+    if( p_prg->i_span >= 0 && i_pcr < p_prg->i_last_pcr )
+        p_prg->i_span = -1;
+    p_prg->i_last_pcr = i_pcr;
+
+    /* spans promise dense entries: none are played past the limit */
+    if( p_prg->entries.i_size >= INDEX_MAX_ENTRIES )
+    {
+        p_prg->i_span = -1;
+        return;
+    }
+
+    if( p_prg->i_span < 0 ? SpanStart( p_prg, i_pcr )
+                          : SpanExtend( p_prg, i_pcr ) )
+        p_index->b_modified = true;
+
+    int i = UpperEntry( p_prg, i_pcr );
+    if( i > 0 && p_prg->entries.p_elems[i - 1].i_time > i_pcr - TS_INDEX_INTERVAL )
+        return; /* close enough to an indexed position */
+    InsertEntry( p_index, p_prg, i, i_pcr, i_pos, 0 );
+}
+
+void ts_index_AddRAP( ts_index_t *p_index, int i_program,
+                      vlc_tick_t i_pts, uint64_t i_pos )
+{
+    ts_index_program_t *p_prg = GetOrNewProgram( p_index, i_program );
+    if( unlikely(p_prg == NULL) )
+        return;
+
+    int i = UpperEntry( p_prg, i_pts );
+    for( int j = i - 1; j >= 0 && p_prg->entries.p_elems[j].i_time == i_pts; j-- )
+    {
+        if( p_prg->entries.p_elems[j].i_pos == i_pos )
+            return; /* already played */
+    }
+    InsertEntry( p_index, p_prg, i, i_pts, i_pos, ENTRY_RAP );
+}
+
+bool ts_index_Lookup( const ts_index_t *p_index, int i_program, vlc_tick_t i_time,
+                      uint64_t *pi_pos, uint64_t *pi_head, uint64_t *pi_tail )
+{
+    const ts_index_program_t *p_prg = GetProgram( p_index, i_program );
+    if( p_prg == NULL )
+        return false;
+
+    const int i = UpperEntry( p_prg, i_time );
+    const ts_index_entry_t *p_entries = p_prg->entries.p_elems;
+
+    const ts_index_span_t *p_span = FindSpan( p_prg, i_time );
+    if( p_span && i > 0 && p_entries[i - 1].i_time >= p_span->i_start )
+    {
+        /* Start from the closest picture the decoders can start with */
+        for( int j = i - 1; j >= 0; j-- )
+        {
+            if( p_entries[j].i_time < i_time - INDEX_MAX_RAP_DISTANCE )
+                break;
+            if( p_entries[j].i_flags & ENTRY_RAP )
+            {
+                *pi_pos = p_entries[j].i_pos;
+                return true;
+            }
+        }
+        *pi_pos = p_entries[i - 1].i_pos;
+        return true;
+    }
+
+    /* Any position indexed before that time precedes its clock, but only
+     * PCR positions are for sure after it: random access points are
+     * indexed by presentation time, that is later than their clock. */
+    if( i > 0 && p_entries[i - 1].i_pos > *pi_head &&
+        p_entries[i - 1].i_pos < *pi_tail )
+        *pi_head = p_entries[i - 1].i_pos;
+    for( int j = i; j < p_prg->entries.i_size; j++ )
+    {
+        if( p_entries[j].i_flags & ENTRY_RAP )
+            continue;
+        if( p_entries[j].i_pos < *pi_tail && p_entries[j].i_pos > *pi_head )
+            *pi_tail = p_entries[j].i_pos;
+        break;
+    }
+    return false;
+}
+
+bool ts_index_GetBounds( const ts_index_t *p_index, int i_program,
+                         ts_index_bounds_t *p_bounds )
+{
+    const ts_index_program_t *p_prg = GetProgram( p_index, i_program );
+    if( p_prg == NULL || !p_prg->b_bounds )
+        return false;
+    *p_bounds = p_prg->bounds;
+    return true;
+}
+
+void ts_index_SetBounds( ts_index_t *p_index, int i_program,
+                         const ts_index_bounds_t *p_bounds )
+{
+    ts_index_program_t *p_prg = GetOrNewProgram( p_index, i_program );
+    if( unlikely(p_prg == NULL) )
+        return;
+    p_prg->bounds = *p_bounds;
+    p_prg->b_bounds = true;
+    p_index->b_modified = true;
+}
+
+/*****************************************************************************
+ * Cache file
+ *****************************************************************************/
+typedef struct
+{
+    const uint8_t *p;
+    size_t i_left;
+} reader_t;
+
+static bool Read( reader_t *r, void *p_dst, size_t i_size )
+{
+    if( r->i_left < i_size )
+        return false;
+    memcpy( p_dst, r->p, i_size );
+    r->p += i_size;
+    r->i_left -= i_size;
+    return true;
+}
+
+static bool Read8( reader_t *r, uint8_t *pi )
+{
+    return Read( r, pi, 1 );
+}
+
+static bool Read32( reader_t *r, uint32_t *pi )
+{
+    uint8_t buf[4];
+    if( !Read( r, buf, 4 ) )
+        return false;
+    *pi = GetDWLE( buf );
+    return true;
+}
+
+static bool Read64( reader_t *r, uint64_t *pi )
+{
+    uint8_t buf[8];
+    if( !Read( r, buf, 8 ) )
+        return false;
+    *pi = GetQWLE( buf );
+    return true;
+}
+
+static bool ReadTick( reader_t *r, vlc_tick_t *pi )
+{
+    uint64_t i;
+    if( !Read64( r, &i ) )
+        return false;
+    *pi = (vlc_tick_t) i;
+    return true;
+}
+
+static bool LoadProgram( ts_index_t *p_index, reader_t *r )
+{
+    uint32_t i_number, i_spans, i_entries;
+    uint8_t i_bounds;
+    ts_index_bounds_t bounds;
+
+    if( !Read32( r, &i_number ) || !Read8( r, &i_bounds ) ||
+        !ReadTick( r, &bounds.i_first ) || !ReadTick( r, &bounds.i_first_dts ) ||
+        !ReadTick( r, &bounds.i_last_dts ) || !Read64( r, &bounds.i_last_dts_byte ) ||
+        !Read32( r, &i_spans ) || !Read32( r, &i_entries ) )
+        return false;
+
+    if( i_number > UINT16_MAX || GetProgram( p_index, i_number ) ||
+        i_spans > r->i_left / 16 || i_entries > INDEX_MAX_ENTRIES ||
+        i_entries > (r->i_left - i_spans * 16) / 17 )
+        return false;
+
+    ts_index_program_t *p_prg = NewProgram( p_index, i_number );
+    if( unlikely(p_prg == NULL) )
+        return false;
+    p_prg->b_bounds = i_bounds != 0;
+    p_prg->bounds = bounds;
+
+    for( uint32_t i = 0; i < i_spans; i++ )
+    {
+        ts_index_span_t span;
+        if( !ReadTick( r, &span.i_start ) || !ReadTick( r, &span.i_end ) ||
+            span.i_start > span.i_end ||
+            (i > 0 && span.i_start <= p_prg->spans.p_elems[i - 1].i_end) )
+            return false;
+        ARRAY_APPEND( p_prg->spans, span );
+    }
+
+    for( uint32_t i = 0; i < i_entries; i++ )
+    {
+        ts_index_entry_t entry;
+        if( !ReadTick( r, &entry.i_time ) || !Read64( r, &entry.i_pos ) ||
+            !Read8( r, &entry.i_flags ) ||
+            entry.i_pos >= p_index->i_size ||
+            (i > 0 && entry.i_time < p_prg->entries.p_elems[i - 1].i_time) )
+            return false;
+        ARRAY_APPEND( p_prg->entries, entry );
+    }
+    return true;
+}
+
+static void Reset( ts_index_t *p_index )
+{
+    for( int i = 0; i < p_index->programs.i_size; i++ )
+        DeleteProgram( p_index->programs.p_elems[i] );
+    ARRAY_RESET( p_index->programs );
+}
+
+bool ts_index_Parse( ts_index_t *p_index, const uint8_t *p_data, size_t i_data )
+{
+    reader_t r = { .p = p_data, .i_left = i_data };
+    char magic[8];
+    uint32_t i_version, i_packet_size, i_programs;
+    uint64_t i_size, i_mtime;
+    bool b_valid = Read( &r, magic, 8 ) && !memcmp( magic, INDEX_MAGIC, 8 ) &&
+                   Read32( &r, &i_version ) && i_version == INDEX_VERSION &&
+                   Read32( &r, &i_packet_size ) &&
+                   Read64( &r, &i_size ) && Read64( &r, &i_mtime ) &&
+                   Read32( &r, &i_programs );
+
+    if( b_valid && ( i_packet_size != p_index->i_packet_size ||
+                     i_size != p_index->i_size || i_mtime != p_index->i_mtime ) )
+    {
+        msg_Dbg( p_index->p_obj, "seek index is outdated" );
+        b_valid = false;
+    }
+
+    Reset( p_index );
+    for( uint32_t i = 0; b_valid && i < i_programs; i++ )
+        b_valid = LoadProgram( p_index, &r );
+    b_valid = b_valid && r.i_left == 0;
+
+    if( !b_valid )
+        Reset( p_index );
+    return b_valid;
+}
+
+static uint8_t * Write( uint8_t *p, const void *p_src, size_t i_size )
+{
+    memcpy( p, p_src, i_size );
+    return p + i_size;
+}
+
+static uint8_t * Write32( uint8_t *p, uint32_t i )
+{
+    SetDWLE( p, i );
+    return p + 4;
+}
+
+static uint8_t * Write64( uint8_t *p, uint64_t i )
+{
+    SetQWLE( p, i );
+    return p + 8;
+}
+
+uint8_t * ts_index_Serialize( const ts_index_t *p_index, size_t *pi_size )
+{
+    size_t i_size = 8 + 4 + 4 + 8 + 8 + 4;
+    for( int i = 0; i < p_index->programs.i_size; i++ )
+    {
+        const ts_index_program_t *p_prg = p_index->programs.p_elems[i];
+        i_size += 4 + 1 + 4 * 8 + 4 + 4 +
+                  p_prg->spans.i_size * 16 + p_prg->entries.i_size * 17;
+    }
+
+    uint8_t *p_data = malloc( i_size );
+    if( unlikely(p_data == NULL) )
+        return NULL;
+
+    uint8_t *p = Write( p_data, INDEX_MAGIC, 8 );
+    p = Write32( p, INDEX_VERSION );
+    p = Write32( p, p_index->i_packet_size );
+    p = Write64( p, p_index->i_size );
+    p = Write64( p, p_index->i_mtime );
+    p = Write32( p, p_index->programs.i_size );
+    for( int i = 0; i < p_index->programs.i_size; i++ )
+    {
+        const ts_index_program_t *p_prg = p_index->programs.p_elems[i];
+        p = Write32( p, p_prg->i_number );
+        *p++ = p_prg->b_bounds;
+        p = Write64( p, p_prg->bounds.i_first );
+        p = Write64( p, p_prg->bounds.i_first_dts );
+        p = Write64( p, p_prg->bounds.i_last_dts );
+        p = Write64( p, p_prg->bounds.i_last_dts_byte );
+        p = Write32( p, p_prg->spans.i_size );
+        p = Write32( p, p_prg->entries.i_size );
+        for( int j = 0; j < p_prg->spans.i_size; j++ )
+        {
+            p = Write64( p, p_prg->spans.p_elems[j].i_start );
+            p = Write64( p, p_prg->spans.p_elems[j].i_end );
+        }
+        for( int j = 0; j < p_prg->entries.i_size; j++ )
+        {
+            p = Write64( p, p_prg->entries.p_elems[j].i_time );
+            p = Write64( p, p_prg->entries.p_elems[j].i_pos );
+            *p++ = p_prg->entries.p_elems[j].i_flags;
+        }
+    }
+    assert( (size_t)(p - p_data) == i_size );
+
+    *pi_size = i_size;
+    return p_data;
+}
+
+ts_index_t * ts_index_New( vlc_object_t *p_obj, unsigned i_packet_size,
+                           uint64_t i_size, uint64_t i_mtime )
+{
+    ts_index_t *p_index = malloc( sizeof(*p_index) );
+    if( unlikely(p_index == NULL) )
+        return NULL;
+
+    p_index->p_obj = p_obj;
+    p_index->s = NULL;
+    p_index->psz_file = NULL;
+    p_index->i_packet_size = i_packet_size;
+    p_index->i_size = i_size;
+    p_index->i_mtime = i_mtime;
+    p_index->b_modified = false;
+    ARRAY_INIT( p_index->programs );
+    return p_index;
+}
+
+ts_index_t * ts_index_Open( vlc_object_t *p_obj, stream_t *s, unsigned i_packet_size )
+{
+    uint64_t i_size, i_mtime;
+    if( s->psz_url == NULL || index_cache_GetStamp( s, &i_size, &i_mtime ) )
+        return NULL;
+
+    /* one index per location, replaced when the file changes */
+    char *psz_file = index_cache_GetPath( p_obj, INDEX_DIR, s->psz_url );
+    if( psz_file == NULL )
+        return NULL;
+
+    ts_index_t *p_index = ts_index_New( p_obj, i_packet_size, i_size, i_mtime );
+    if( unlikely(p_index == NULL) )
+    {
+        free( psz_file );
+        return NULL;
+    }
+    p_index->s = s;
+    p_index->psz_file = psz_file;
+
+    size_t i_data;
+    uint8_t *p_data = index_cache_Read( psz_file, INDEX_MAX_FILE, &i_data );
+    if( p_data )
+    {
+        if( ts_index_Parse( p_index, p_data, i_data ) )
+            msg_Dbg( p_obj, "loaded seek index of %d programs from %s",
+                     p_index->programs.i_size, psz_file );
+        free( p_data );
+    }
+
+    return p_index;
+}
+
+static void Save( ts_index_t *p_index )
+{
+    size_t i_size;
+    uint8_t *p_data = ts_index_Serialize( p_index, &i_size );
+    if( unlikely(p_data == NULL) )
+        return;
+
+    if( index_cache_Write( p_index->p_obj, p_index->psz_file,
+                           p_data, i_size ) == VLC_SUCCESS )
+        msg_Dbg( p_index->p_obj, "saved seek index to %s", p_index->psz_file );
+    free( p_data );
+}
+
+void ts_index_Close( ts_index_t *p_index )
+{
+    /* growing files index would be outdated at once */
+    uint64_t i_size, i_mtime;
+    if( p_index->b_modified && p_index->psz_file != NULL &&
+        !index_cache_GetStamp( p_index->s, &i_size, &i_mtime ) &&
+        i_size == p_index->i_size && i_mtime == p_index->i_mtime )
+        Save( p_index );
+
+    Reset( p_index );
+    free( p_index->psz_file );
+    free( p_index );
+}
@@ -0,0 +1,72 @@
+/*****************************************************************************
+ * ts_index.h: Transport Stream input module for VLC.
+ *****************************************************************************
+ * Copyright (C) 2025 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_TS_INDEX_H
+#define VLC_TS_INDEX_H
+
+/* minimum time between two indexed PCR */
+#define TS_INDEX_INTERVAL VLC_TICK_FROM_MS(250)
+
+typedef struct ts_index_t ts_index_t;
+
+/* program boundaries, as probed on opening */
+typedef struct
+{
+    vlc_tick_t i_first;
+    vlc_tick_t i_first_dts;
+    vlc_tick_t i_last_dts;
+    uint64_t   i_last_dts_byte;
+} ts_index_bounds_t;
+
+/* Times -> positions of the programs of a file, built while playing and
+ * kept in the user cache directory for the next sessions. Times are in
+ * the program clock domain, unwrapped from the first PCR. */
+
+/* loads the cached index of that stream, or starts an empty one,
+ * returns NULL if the stream cannot be indexed */
+ts_index_t * ts_index_Open( vlc_object_t *, stream_t *, unsigned i_packet_size );
+/* saves the index if it was updated */
+void ts_index_Close( ts_index_t * );
+
+/* starts an empty index of that file content, that is never saved */
+ts_index_t * ts_index_New( vlc_object_t *, unsigned i_packet_size,
+                           uint64_t i_size, uint64_t i_mtime );
+/* replaces the index by a cached one, returns false and leaves it empty
+ * if the data is invalid or for another file content */
+bool ts_index_Parse( ts_index_t *, const uint8_t *p_data, size_t i_data );
+/* returns the heap allocated cache data of the index, or NULL */
+uint8_t * ts_index_Serialize( const ts_index_t *, size_t *pi_size );
+
+/* the next positions do not follow the previous ones (seek) */
+void ts_index_Discontinuity( ts_index_t * );
+
+void ts_index_AddPCR( ts_index_t *, int i_program, vlc_tick_t i_pcr, uint64_t i_pos );
+/* random access point, by the presentation time of its picture */
+void ts_index_AddRAP( ts_index_t *, int i_program, vlc_tick_t i_pts, uint64_t i_pos );
+
+/* Returns true with the position to start from to present i_time, if that
+ * time was played before. Otherwise narrows the [*pi_head, *pi_tail]
+ * range the position has to be searched in. */
+bool ts_index_Lookup( const ts_index_t *, int i_program, vlc_tick_t i_time,
+                      uint64_t *pi_pos, uint64_t *pi_head, uint64_t *pi_tail );
+
+bool ts_index_GetBounds( const ts_index_t *, int i_program, ts_index_bounds_t * );
+void ts_index_SetBounds( ts_index_t *, int i_program, const ts_index_bounds_t * );
+
+#endif
@@ -96,6 +96,40 @@ static uint8_t *FindNextPESHeader( uint8_t *p_buf, size_t i_buffer )
     return NULL;
 }
 
+/* Appends the packet payload to the gathered data. The PES is gathered in
+ * a single block rather than as a chain of packets, which would keep their
+ * whole read chunks alive until the PES is output, then decoded. */
+static block_t * ts_pes_Append( block_t *p_data, block_t *p_pkt,
+                                size_t i_expected )
+{
+    if( p_data == NULL )
+    {
+        p_data = block_Alloc( __MAX(i_expected, p_pkt->i_buffer) );
+        if( unlikely(p_data == NULL) )
+            goto end;
+        p_data->i_buffer = 0;
+        p_data->i_flags = p_pkt->i_flags;
+    }
+    else if( (size_t)(p_data->p_start + p_data->i_size -
+                      &p_data->p_buffer[p_data->i_buffer]) < p_pkt->i_buffer )
+    {
+        /* Grow geometrically when the PES size is unknown */
+        const size_t i_used = p_data->i_buffer;
+        p_data = block_Realloc( p_data, 0, __MAX(i_used * 2,
+                                                 i_used + p_pkt->i_buffer) );
+        if( unlikely(p_data == NULL) )
+            goto end;
+        p_data->i_buffer = i_used;
+    }
+
+    memcpy( &p_data->p_buffer[p_data->i_buffer], p_pkt->p_buffer, p_pkt->i_buffer );
+    p_data->i_buffer += p_pkt->i_buffer;
+
+end:
+    block_Release( p_pkt );
+    return p_data;
+}
+
 static bool ts_pes_Push( ts_pes_parse_callback *cb,
                   ts_stream_t *p_pes, block_t *p_pkt,
                   bool b_unit_start, ts_90khz_t i_append_pcr )
@@ -145,8 +179,19 @@ static bool ts_pes_Push( ts_pes_parse_callback *cb,
         return b_ret;
     }
 
-    block_ChainLastAppend( &p_pes->gather.pp_last, p_pkt );
-    p_pes->gather.i_gathered += p_pkt->i_buffer;
+    const size_t i_payload = p_pkt->i_buffer;
+    p_pes->gather.p_data = ts_pes_Append( p_pes->gather.p_data, p_pkt,
+                                          p_pes->gather.i_data_size );
+    if( unlikely(p_pes->gather.p_data == NULL) )
+    {
+        p_pes->gather.i_data_size = 0;
+        p_pes->gather.i_gathered = 0;
+        p_pes->gather.i_block_flags = 0;
+        p_pes->gather.pp_last = &p_pes->gather.p_data;
+        return b_ret;
+    }
+    p_pes->gather.pp_last = &p_pes->gather.p_data->p_next;
+    p_pes->gather.i_gathered += i_payload;
 
     if( p_pes->gather.i_data_size > 0 &&
         p_pes->gather.i_gathered >= p_pes->gather.i_data_size )
@@ -100,6 +100,8 @@ static void PATCallBack( void *data, dvbpsi_pat_t *p_dvbpsipat )
     ts_pid_t             *patpid = GetPID(p_sys, 0);
     ts_pat_t             *p_pat = GetPID(p_sys, 0)->u.p_pat;
 
+    DrainPESWorkers( p_demux );
+
     patpid->i_flags |= FLAG_SEEN;
 
     msg_Dbg( p_demux, "PATCallBack called" );
@@ -1862,6 +1864,8 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_dvbpsipmt )
     ts_pmt_t     *p_pmt = NULL;
     bool          b_encryption = false;
 
+    DrainPESWorkers( p_demux );
+
     msg_Dbg( p_demux, "PMTCallBack called for program %d", p_dvbpsipmt->i_program_number );
 
     if (unlikely(GetPID(p_sys, 0)->type != TYPE_PAT))
@@ -2118,6 +2122,11 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_dvbpsipmt )
     /* Install CAM descrambling */
     if ( p_sys->standard == TS_STANDARD_ARIB && p_sys->stream == p_demux->s && b_encryption )
     {
+        /* Packets already buffered by the reader must be descrambled too */
+        const uint64_t i_pos = ts_reader_Tell( &p_sys->reader, p_sys->stream );
+        if( ts_reader_Seek( &p_sys->reader, p_sys->stream, i_pos ) != VLC_SUCCESS )
+            msg_Warn( p_demux, "cannot rewind to descramble buffered packets" );
+
         stream_t *wrapper = ts_stream_wrapper_New( p_demux->s );
         if( wrapper )
         {
@@ -2227,7 +2236,19 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_dvbpsipmt )
     UpdatePESFilters( p_demux, p_sys->seltype == PROGRAM_ALL );
 
     /* Probe Boundaries */
-    if( p_sys->b_canfastseek && !p_pmt->b_last_dts_probed )
+    ts_index_bounds_t bounds;
+    if( !p_pmt->b_last_dts_probed && p_sys->index &&
+        ts_index_GetBounds( p_sys->index, p_pmt->i_number, &bounds ) )
+    {
+        if( p_pmt->pcr.i_first == VLC_TICK_INVALID )
+            p_pmt->pcr.i_first = bounds.i_first;
+        if( p_pmt->pcr.i_first_dts == VLC_TICK_INVALID )
+            p_pmt->pcr.i_first_dts = bounds.i_first_dts;
+        p_pmt->i_last_dts = bounds.i_last_dts;
+        p_pmt->i_last_dts_byte = bounds.i_last_dts_byte;
+        p_pmt->b_last_dts_probed = true;
+    }
+    else if( p_sys->b_canfastseek && !p_pmt->b_last_dts_probed )
     {
         ProbeStart( p_demux, p_pmt->i_number );
         ProbeEnd( p_demux, p_pmt->i_number );
@@ -2235,6 +2256,17 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_dvbpsipmt )
         if( p_pmt->i_last_dts != VLC_TICK_INVALID &&
             p_pmt->i_last_dts < p_pmt->pcr.i_first_dts )
             p_pmt->i_last_dts = TimeStampWrapAround( p_pmt->pcr.i_first_dts, p_pmt->i_last_dts );
+
+        if( p_sys->index && p_pmt->i_last_dts != VLC_TICK_INVALID &&
+            ( p_pmt->pcr.i_first != VLC_TICK_INVALID ||
+              p_pmt->pcr.i_first_dts != VLC_TICK_INVALID ) )
+        {
+            bounds.i_first = p_pmt->pcr.i_first;
+            bounds.i_first_dts = p_pmt->pcr.i_first_dts;
+            bounds.i_last_dts = p_pmt->i_last_dts;
+            bounds.i_last_dts_byte = p_pmt->i_last_dts_byte;
+            ts_index_SetBounds( p_sys->index, p_pmt->i_number, &bounds );
+        }
     }
 
     dvbpsi_pmt_delete( p_dvbpsipmt );
@@ -0,0 +1,236 @@
+/*****************************************************************************
+ * ts_reader.c: Transport Stream input module for VLC.
+ *****************************************************************************
+ * Copyright (C) 2025 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_stream.h>
+#include <vlc_atomic.h>
+
+#include "ts_reader.h"
+
+#include <assert.h>
+#include <string.h>
+
+#define TS_SYNC_BYTE 0x47
+
+typedef struct
+{
+    block_t b;
+    ts_reader_chunk_t *p_chunk;
+} ts_reader_view_t;
+
+struct ts_reader_chunk_t
+{
+    vlc_atomic_rc_t rc;
+    size_t i_size;
+    unsigned i_views;
+    uint8_t *p_data;
+    /* one block per packet, so that reading does not allocate */
+    ts_reader_view_t views[];
+};
+
+static ts_reader_chunk_t * ChunkNew( unsigned i_packet_size )
+{
+    const size_t i_size = (size_t) i_packet_size * TS_READER_CHUNK_PACKETS;
+    ts_reader_chunk_t *p_chunk =
+        malloc( sizeof(*p_chunk) +
+                sizeof(ts_reader_view_t) * TS_READER_CHUNK_PACKETS + i_size );
+    if( unlikely(p_chunk == NULL) )
+        return NULL;
+    vlc_atomic_rc_init( &p_chunk->rc );
+    p_chunk->i_size = i_size;
+    p_chunk->i_views = 0;
+    p_chunk->p_data = (uint8_t *) &p_chunk->views[TS_READER_CHUNK_PACKETS];
+    return p_chunk;
+}
+
+static void ChunkRelease( ts_reader_chunk_t *p_chunk )
+{
+    if( vlc_atomic_rc_dec( &p_chunk->rc ) )
+        free( p_chunk );
+}
+
+static void ViewRelease( block_t *p_block )
+{
+    ts_reader_view_t *p_view = container_of( p_block, ts_reader_view_t, b );
+    ChunkRelease( p_view->p_chunk );
+}
+
+static const struct vlc_block_callbacks view_cbs =
+{
+    ViewRelease,
+};
+
+void ts_reader_Init( ts_reader_t *r, vlc_object_t *p_obj,
+                     unsigned i_packet_size, unsigned i_header_size )
+{
+    r->p_obj = p_obj;
+    r->i_packet_size = i_packet_size;
+    r->i_header_size = i_header_size;
+    r->p_chunk = NULL;
+    r->i_pos = r->i_end = 0;
+    r->b_resync = false;
+    r->i_skipped = 0;
+}
+
+void ts_reader_Flush( ts_reader_t *r )
+{
+    if( r->p_chunk )
+        ChunkRelease( r->p_chunk );
+    r->p_chunk = NULL;
+    r->i_pos = r->i_end = 0;
+    r->b_resync = false;
+}
+
+void ts_reader_Clean( ts_reader_t *r )
+{
+    ts_reader_Flush( r );
+}
+
+/* Reads more data after the unconsumed one. Data is appended to the current
+ * chunk while a packet fits, otherwise the remains go to a new chunk. */
+static bool Refill( ts_reader_t *r, stream_t *s )
+{
+    ts_reader_chunk_t *p_chunk = r->p_chunk;
+
+    if( p_chunk == NULL || p_chunk->i_size - r->i_end < r->i_packet_size )
+    {
+        ts_reader_chunk_t *p_new = ChunkNew( r->i_packet_size );
+        if( unlikely(p_new == NULL) )
+            return false;
+        if( p_chunk )
+        {
+            r->i_end -= r->i_pos;
+            assert( r->i_end < p_new->i_size );
+            memcpy( p_new->p_data, &p_chunk->p_data[r->i_pos], r->i_end );
+            ChunkRelease( p_chunk );
+        }
+        r->i_pos = 0;
+        r->p_chunk = p_chunk = p_new;
+    }
+
+    ssize_t i_read = vlc_stream_ReadPartial( s, &p_chunk->p_data[r->i_end],
+                                             p_chunk->i_size - r->i_end );
+    if( i_read <= 0 )
+        return false;
+    r->i_end += i_read;
+    return true;
+}
+
+/* Finds the next sync byte followed by another one a packet later, or
+ * skips what cannot be verified with the data read so far. */
+static bool Resync( ts_reader_t *r )
+{
+    const uint8_t *p_data = r->p_chunk->p_data;
+    const size_t i_sync = r->i_header_size;
+    size_t i_pos = r->i_pos;
+    bool b_found = false;
+
+    while( i_pos + i_sync + r->i_packet_size < r->i_end )
+    {
+        /* memchr() is the vectorized scan of the C library */
+        const uint8_t *p = memchr( &p_data[i_pos + i_sync], TS_SYNC_BYTE,
+                                   r->i_end - r->i_packet_size - (i_pos + i_sync) );
+        if( p == NULL )
+        {
+            i_pos = r->i_end - r->i_packet_size - i_sync;
+            break;
+        }
+        i_pos = p - p_data - i_sync;
+        if( p[r->i_packet_size] == TS_SYNC_BYTE )
+        {
+            b_found = true;
+            break;
+        }
+        i_pos++;
+    }
+
+    r->i_skipped += i_pos - r->i_pos;
+    r->i_pos = i_pos;
+
+    if( b_found )
+    {
+        msg_Dbg( r->p_obj, "resynced after skipping %"PRIu64" bytes of garbage",
+                 r->i_skipped );
+        r->b_resync = false;
+    }
+    return b_found;
+}
+
+block_t * ts_reader_Read( ts_reader_t *r, stream_t *s )
+{
+    for( ;; )
+    {
+        if( r->b_resync && !Resync( r ) )
+        {
+            if( !Refill( r, s ) )
+                return NULL;
+            continue;
+        }
+
+        if( r->i_end - r->i_pos < r->i_packet_size )
+        {
+            if( !Refill( r, s ) )
+                return NULL;
+            continue;
+        }
+
+        ts_reader_chunk_t *p_chunk = r->p_chunk;
+        uint8_t *p_packet = &p_chunk->p_data[r->i_pos];
+
+        /* Check sync byte and re-sync if needed */
+        if( p_packet[r->i_header_size] != TS_SYNC_BYTE )
+        {
+            msg_Warn( r->p_obj, "lost synchro" );
+            r->b_resync = true;
+            r->i_skipped = 0;
+            continue;
+        }
+
+        assert( p_chunk->i_views < TS_READER_CHUNK_PACKETS );
+        ts_reader_view_t *p_view = &p_chunk->views[p_chunk->i_views++];
+        block_Init( &p_view->b, &view_cbs, p_packet, r->i_packet_size );
+        p_view->p_chunk = p_chunk;
+        vlc_atomic_rc_inc( &p_chunk->rc );
+        r->i_pos += r->i_packet_size;
+
+        /* Skip header (BluRay streams) */
+        p_view->b.p_buffer += r->i_header_size;
+        p_view->b.i_buffer -= r->i_header_size;
+        return &p_view->b;
+    }
+}
+
+uint64_t ts_reader_Tell( const ts_reader_t *r, stream_t *s )
+{
+    return vlc_stream_Tell( s ) - (r->i_end - r->i_pos);
+}
+
+int ts_reader_Seek( ts_reader_t *r, stream_t *s, uint64_t i_pos )
+{
+    /* keep the buffered packets if the stream cannot seek */
+    if( vlc_stream_Seek( s, i_pos ) != VLC_SUCCESS )
+        return VLC_EGENERIC;
+    ts_reader_Flush( r );
+    return VLC_SUCCESS;
+}
@@ -0,0 +1,61 @@
+/*****************************************************************************
+ * ts_reader.h: Transport Stream input module for VLC.
+ *****************************************************************************
+ * Copyright (C) 2025 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_TS_READER_H
+#define VLC_TS_READER_H
+
+/* how many TS packets are read from the stream at once */
+#define TS_READER_CHUNK_PACKETS 64
+
+typedef struct ts_reader_chunk_t ts_reader_chunk_t;
+
+/* Reads the stream by chunks of packets, and returns the packets as blocks
+ * pointing into the chunk, which lives until all its packets are released.
+ * The stream position is ahead of the last returned packet, use
+ * ts_reader_Tell() and ts_reader_Seek(). As any packet pins its whole chunk,
+ * packets are not meant to be kept: the PES gathering copies their payload. */
+typedef struct
+{
+    vlc_object_t *p_obj;
+    unsigned i_packet_size;
+    unsigned i_header_size;
+
+    ts_reader_chunk_t *p_chunk;
+    size_t i_pos; /* next packet offset in chunk */
+    size_t i_end; /* end of data read in chunk */
+
+    bool b_resync;
+    uint64_t i_skipped;
+} ts_reader_t;
+
+void ts_reader_Init( ts_reader_t *, vlc_object_t *,
+                     unsigned i_packet_size, unsigned i_header_size );
+void ts_reader_Clean( ts_reader_t * );
+
+/* drops the buffered packets */
+void ts_reader_Flush( ts_reader_t * );
+
+/* returns a packet, header skipped and starting with the sync byte,
+ * or NULL on EOF/error */
+block_t * ts_reader_Read( ts_reader_t *, stream_t * );
+
+uint64_t ts_reader_Tell( const ts_reader_t *, stream_t * );
+int ts_reader_Seek( ts_reader_t *, stream_t *, uint64_t i_pos );
+
+#endif
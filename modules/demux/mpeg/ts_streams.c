@@ -38,6 +38,8 @@
 #include "ts_si.h"
 #include "ts_psip.h"
 
+#include <assert.h>
+
 ts_pat_t *ts_pat_New( demux_t *p_demux )
 {
     ts_pat_t *pat = malloc( sizeof( ts_pat_t ) );
@@ -119,6 +121,14 @@ ts_pmt_t *ts_pmt_New( demux_t *p_demux )
 
     pmt->pcr.b_fix_done = false;
 
+    pmt->batch.p_demux = p_demux;
+    pmt->batch.p_pkts = NULL;
+    pmt->batch.pp_last = &pmt->batch.p_pkts;
+    pmt->batch.i_pkts = 0;
+    pmt->batch.p_run = NULL;
+    pmt->batch.b_running = false;
+    pmt->batch.i_pcr = VLC_TICK_INVALID;
+
     pmt->eit.i_event_length = 0;
     pmt->eit.i_event_start = 0;
 
@@ -143,6 +153,8 @@ void ts_pmt_Del( demux_t *p_demux, ts_pmt_t *pmt )
     for( int i=0; i<pmt->od.objects.i_size; i++ )
         ODFree( pmt->od.objects.p_elems[i] );
     ARRAY_RESET( pmt->od.objects );
+    assert( !pmt->batch.b_running );
+    block_ChainRelease( pmt->batch.p_pkts );
     if( pmt->i_number > -1 )
         es_out_Control( p_demux->out, ES_OUT_DEL_GROUP, pmt->i_number );
 
@@ -24,6 +24,7 @@ typedef struct ts_sections_processor_t ts_sections_processor_t;
 
 #include "mpeg4_iod.h"
 #include "timestamps.h"
+#include "ts_workers.h"
 
 #include <vlc_common.h>
 #include <vlc_arrays.h>
@@ -78,6 +79,23 @@ struct ts_pmt_t
     uint64_t i_last_dts_byte;
     bool b_last_dts_probed;
 
+    /* PES handled on the worker threads, one batch per PCR interval */
+    struct
+    {
+        ts_worker_job_t job;
+        demux_t *p_demux;
+        /* packets routed since the last batch */
+        block_t *p_pkts;
+        block_t **pp_last;
+        unsigned i_pkts;
+        /* batch being run, and the PCR that follows it */
+        block_t *p_run;
+        bool b_running;
+        vlc_tick_t i_check_pcr;
+        vlc_tick_t i_pcr;
+        uint64_t i_pcr_offset;
+    } batch;
+
     /* CA */
     //en50221_capmt_info_t *capmt;
 
@@ -0,0 +1,140 @@
+/*****************************************************************************
+ * ts_workers.c: Transport Stream input module for VLC.
+ *****************************************************************************
+ * Copyright (C) 2025 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_threads.h>
+
+#include "ts_workers.h"
+
+#include <assert.h>
+
+struct ts_workers_t
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait; /* job pushed or quit */
+    vlc_cond_t done; /* job run */
+
+    ts_worker_job_t *p_first; /* jobs not started yet */
+    ts_worker_job_t **pp_last;
+    bool b_quit;
+
+    unsigned i_threads;
+    vlc_thread_t threads[];
+};
+
+static void *Run( void *data )
+{
+    ts_workers_t *p_workers = data;
+
+    vlc_thread_set_name( "vlc-ts-worker" );
+
+    vlc_mutex_lock( &p_workers->lock );
+    for( ;; )
+    {
+        while( p_workers->p_first == NULL && !p_workers->b_quit )
+            vlc_cond_wait( &p_workers->wait, &p_workers->lock );
+        if( p_workers->p_first == NULL )
+            break;
+
+        ts_worker_job_t *p_job = p_workers->p_first;
+        p_workers->p_first = p_job->p_next;
+        if( p_workers->p_first == NULL )
+            p_workers->pp_last = &p_workers->p_first;
+        vlc_mutex_unlock( &p_workers->lock );
+
+        p_job->pf_run( p_job );
+
+        vlc_mutex_lock( &p_workers->lock );
+        atomic_store_explicit( &p_job->b_done, true, memory_order_release );
+        vlc_cond_broadcast( &p_workers->done );
+    }
+    vlc_mutex_unlock( &p_workers->lock );
+    return NULL;
+}
+
+ts_workers_t * ts_workers_New( vlc_object_t *p_obj, unsigned i_threads )
+{
+    assert( i_threads > 0 && i_threads <= TS_WORKERS_MAX );
+
+    ts_workers_t *p_workers = malloc( sizeof(*p_workers) +
+                                      sizeof(vlc_thread_t) * i_threads );
+    if( unlikely(p_workers == NULL) )
+        return NULL;
+
+    vlc_mutex_init( &p_workers->lock );
+    vlc_cond_init( &p_workers->wait );
+    vlc_cond_init( &p_workers->done );
+    p_workers->p_first = NULL;
+    p_workers->pp_last = &p_workers->p_first;
+    p_workers->b_quit = false;
+
+    p_workers->i_threads = 0;
+    for( unsigned i = 0; i < i_threads; i++ )
+    {
+        if( vlc_clone( &p_workers->threads[i], Run, p_workers ) )
+        {
+            msg_Err( p_obj, "cannot create worker thread" );
+            ts_workers_Delete( p_workers );
+            return NULL;
+        }
+        p_workers->i_threads++;
+    }
+
+    return p_workers;
+}
+
+void ts_workers_Delete( ts_workers_t *p_workers )
+{
+    vlc_mutex_lock( &p_workers->lock );
+    assert( p_workers->p_first == NULL );
+    p_workers->b_quit = true;
+    vlc_cond_broadcast( &p_workers->wait );
+    vlc_mutex_unlock( &p_workers->lock );
+
+    for( unsigned i = 0; i < p_workers->i_threads; i++ )
+        vlc_join( p_workers->threads[i], NULL );
+    free( p_workers );
+}
+
+void ts_workers_Push( ts_workers_t *p_workers, ts_worker_job_t *p_job )
+{
+    p_job->p_next = NULL;
+    atomic_store_explicit( &p_job->b_done, false, memory_order_relaxed );
+
+    vlc_mutex_lock( &p_workers->lock );
+    *p_workers->pp_last = p_job;
+    p_workers->pp_last = &p_job->p_next;
+    vlc_cond_signal( &p_workers->wait );
+    vlc_mutex_unlock( &p_workers->lock );
+}
+
+void ts_workers_Wait( ts_workers_t *p_workers, ts_worker_job_t *p_job )
+{
+    if( ts_workers_IsDone( p_job ) )
+        return;
+
+    vlc_mutex_lock( &p_workers->lock );
+    while( !ts_workers_IsDone( p_job ) )
+        vlc_cond_wait( &p_workers->done, &p_workers->lock );
+    vlc_mutex_unlock( &p_workers->lock );
+}
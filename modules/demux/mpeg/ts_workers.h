@@ -0,0 +1,51 @@
+/*****************************************************************************
+ * ts_workers.h: Transport Stream input module for VLC.
+ *****************************************************************************
+ * Copyright (C) 2025 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_TS_WORKERS_H
+#define VLC_TS_WORKERS_H
+
+#include <vlc_atomic.h>
+
+#define TS_WORKERS_MAX 16
+
+typedef struct ts_workers_t ts_workers_t;
+typedef struct ts_worker_job_t ts_worker_job_t;
+
+/* Jobs are owned by the caller, and run once by any of the threads:
+ * the caller waits for a job before pushing it again. */
+struct ts_worker_job_t
+{
+    ts_worker_job_t *p_next;
+    void (*pf_run)( ts_worker_job_t * );
+    atomic_bool b_done;
+};
+
+ts_workers_t * ts_workers_New( vlc_object_t *, unsigned i_threads );
+/* all pushed jobs must have been waited for */
+void ts_workers_Delete( ts_workers_t * );
+
+void ts_workers_Push( ts_workers_t *, ts_worker_job_t * );
+void ts_workers_Wait( ts_workers_t *, ts_worker_job_t * );
+
+static inline bool ts_workers_IsDone( ts_worker_job_t *p_job )
+{
+    return atomic_load_explicit( &p_job->b_done, memory_order_acquire );
+}
+
+#endif
@@ -0,0 +1,557 @@
+/*****************************************************************************
+ * binary.c: binary tracer plugin
+ *****************************************************************************
+ * Copyright (C) 2025 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Traces are appended by each thread to its own chunk, with varint encoding
+ * and interned strings, and a background thread writes the chunks to the
+ * file. Tracing threads never format text nor wait for the file. Use
+ * extras/misc/vlc-trace-convert.py to convert the output to the layout of
+ * the JSON tracer or to a Chrome trace.
+ *
+ * File layout:
+ *
+ *   file    := "VLCBTRC" version:u8 block*
+ *   block   := chunk:varint thread:varint size:varint record{size bytes}
+ *   record  := 0x01 delta:svarint count:varint entry{count}  (trace)
+ *            | 0x02 count:varint                    (lost traces)
+ *   entry   := type:u8 key:string value
+ *   value   := svarint | varint | f64 little endian | string
+ *              (according to enum vlc_tracer_value)
+ *   string  := 0x00 len:varint bytes                (not interned)
+ *            | (id << 1 | 1):varint len:varint bytes (interned, id > 0)
+ *            | (id << 1):varint                     (reference, id > 0)
+ *
+ * Records of a block come from a single chunk, and the blocks of a chunk
+ * appear in order. String ids and timestamp deltas (in nanoseconds) are
+ * relative to the previous records of the same chunk. An id can be
+ * interned again with another string, later references then use it.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_configuration.h>
+#include <vlc_plugin.h>
+#include <vlc_fs.h>
+#include <vlc_threads.h>
+#include <vlc_tracer.h>
+
+#include <stdatomic.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#define BINARY_FILENAME "vlc-trace.bin"
+#define BINARY_MAGIC "VLCBTRC"
+#define BINARY_VERSION 1
+
+enum
+{
+    RECORD_TRACE = 0x01,
+    RECORD_LOST = 0x02,
+};
+
+#define CHUNK_SIZE (64 * 1024)
+#define CHUNK_MAX 256               /* number of concurrently tracing threads */
+#define CHUNK_IDLE_FLUSHES 50       /* before an unused chunk can be reused */
+
+#define INTERN_SIZE 256
+#define INTERN_PROBES 4
+#define INTERN_MAX_LEN 64
+
+#define FLUSH_INTERVAL VLC_TICK_FROM_MS(100)
+
+#define VARINT_MAX 10
+/* upper bound of a lost record */
+#define LOST_RECORD_MAX (1 + VARINT_MAX)
+
+struct intern_slot
+{
+    const char *ptr;
+    uint8_t len;
+    char str[INTERN_MAX_LEN];
+};
+
+struct trace_chunk
+{
+    vlc_mutex_t lock;
+    const void *owner;      /* token of the owning thread, NULL if unused */
+    unsigned long thread;
+    unsigned idle;          /* flushes without data, only used by the flusher */
+    uint64_t last_ts;
+    uint64_t lost;
+    size_t len;
+    uint8_t *data;          /* filled by the owner */
+    uint8_t *spare;         /* written by the flusher, swapped with data */
+
+    struct intern_slot strings[INTERN_SIZE];
+
+    unsigned id;
+    struct trace_chunk *next; /* immutable once published */
+};
+
+typedef struct
+{
+    FILE *stream;
+    uint64_t instance;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    struct trace_chunk *chunks;
+    unsigned chunk_count;
+    bool closing;
+    atomic_bool wake;
+    atomic_uint_fast64_t lost;  /* traces without chunk */
+
+    vlc_thread_t thread;
+} vlc_tracer_sys_t;
+
+static atomic_uint_fast64_t instances = 1;
+
+static thread_local struct
+{
+    uint64_t instance;
+    struct trace_chunk *chunk;
+} current;
+
+static size_t PutVarint(uint8_t *p, uint64_t value)
+{
+    size_t len = 0;
+    while (value >= 0x80)
+    {
+        p[len++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    p[len++] = value;
+    return len;
+}
+
+static size_t PutSVarint(uint8_t *p, int64_t value)
+{
+    return PutVarint(p, ((uint64_t) value << 1) ^ (uint64_t) (value >> 63));
+}
+
+static size_t PutDouble(uint8_t *p, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof (bits));
+    SetQWLE(p, bits);
+    return sizeof (bits);
+}
+
+/* Upper bound of the size of an encoded string */
+static size_t StringBound(size_t len)
+{
+    return 2 * VARINT_MAX + len;
+}
+
+static size_t PutString(struct trace_chunk *chunk, uint8_t *p,
+                        const char *str, size_t len)
+{
+    size_t pos = 0;
+
+    if (len > INTERN_MAX_LEN)
+    {
+        p[pos++] = 0;
+        pos += PutVarint(&p[pos], len);
+        memcpy(&p[pos], str, len);
+        return pos + len;
+    }
+
+    /* Most strings are literals, look them up by address first */
+    uint64_t hash = ((uintptr_t) str >> 3) * UINT64_C(0x9E3779B97F4A7C15);
+    unsigned first = (hash >> 32) % INTERN_SIZE;
+    unsigned slot = first;
+
+    for (unsigned i = 0; i < INTERN_PROBES; i++)
+    {
+        unsigned probe = (first + i) % INTERN_SIZE;
+        const struct intern_slot *s = &chunk->strings[probe];
+
+        if (s->ptr == str)
+        {
+            if (s->len == len && memcmp(s->str, str, len) == 0)
+                return PutVarint(p, (probe + 1) << 1);
+            slot = probe; /* same address, new content */
+            break;
+        }
+        if (s->ptr == NULL)
+        {
+            slot = probe;
+            break;
+        }
+    }
+
+    /* (Re)define the string, evicting the previous one if needed */
+    struct intern_slot *s = &chunk->strings[slot];
+    s->ptr = str;
+    s->len = len;
+    memcpy(s->str, str, len);
+
+    pos += PutVarint(&p[pos], (slot + 1) << 1 | 1);
+    pos += PutVarint(&p[pos], len);
+    memcpy(&p[pos], str, len);
+    pos += len;
+    return pos;
+}
+
+static struct trace_chunk *AcquireChunk(vlc_tracer_sys_t *sys)
+{
+    struct trace_chunk *chunk, *unused = NULL;
+
+    /* The thread may already own a chunk of this tracer, if it traced to
+     * another one in between: take it back rather than using another one */
+    vlc_mutex_lock(&sys->lock);
+    for (chunk = sys->chunks; chunk != NULL; chunk = chunk->next)
+    {
+        vlc_mutex_lock(&chunk->lock);
+        if (chunk->owner == &current)
+            break;
+        if (chunk->owner == NULL && unused == NULL)
+            unused = chunk;
+        vlc_mutex_unlock(&chunk->lock);
+    }
+
+    if (chunk == NULL && unused != NULL)
+    {
+        /* owners are only set with the tracer lock held */
+        chunk = unused;
+        vlc_mutex_lock(&chunk->lock);
+    }
+
+    if (chunk == NULL && sys->chunk_count < CHUNK_MAX)
+    {
+        chunk = malloc(sizeof (*chunk));
+        if (chunk != NULL)
+        {
+            chunk->data = malloc(2 * (CHUNK_SIZE + LOST_RECORD_MAX));
+            if (unlikely(chunk->data == NULL))
+            {
+                free(chunk);
+                chunk = NULL;
+            }
+        }
+        if (chunk != NULL)
+        {
+            chunk->spare = chunk->data + CHUNK_SIZE + LOST_RECORD_MAX;
+            vlc_mutex_init(&chunk->lock);
+            chunk->last_ts = 0;
+            chunk->lost = 0;
+            chunk->len = 0;
+            memset(chunk->strings, 0, sizeof (chunk->strings));
+            chunk->id = ++sys->chunk_count;
+            chunk->next = sys->chunks;
+            vlc_mutex_lock(&chunk->lock);
+            sys->chunks = chunk;
+        }
+    }
+
+    if (chunk != NULL)
+    {
+        chunk->owner = &current;
+        chunk->thread = vlc_thread_id();
+        chunk->idle = 0;
+        vlc_mutex_unlock(&chunk->lock);
+    }
+    vlc_mutex_unlock(&sys->lock);
+    return chunk;
+}
+
+static void TraceBinary(void *opaque, vlc_tick_t ts,
+                        const struct vlc_tracer_trace *trace)
+{
+    vlc_tracer_sys_t *sys = opaque;
+    struct trace_chunk *chunk = NULL;
+
+    if (current.instance == sys->instance)
+    {
+        chunk = current.chunk;
+        vlc_mutex_lock(&chunk->lock);
+        if (chunk->owner != &current)
+        {
+            /* Taken back by the flusher after a long idle period */
+            vlc_mutex_unlock(&chunk->lock);
+            chunk = NULL;
+        }
+    }
+
+    if (chunk == NULL)
+    {
+        chunk = AcquireChunk(sys);
+        if (unlikely(chunk == NULL))
+        {
+            atomic_fetch_add_explicit(&sys->lost, 1, memory_order_relaxed);
+            return;
+        }
+        current.instance = sys->instance;
+        current.chunk = chunk;
+        vlc_mutex_lock(&chunk->lock);
+    }
+
+    /* Make sure the whole record fits before writing anything */
+    size_t bound = 1 + 2 * VARINT_MAX;
+    size_t count = 0;
+    for (const struct vlc_tracer_entry *entry = trace->entries;
+         entry->key != NULL; entry++, count++)
+    {
+        bound += 1 + StringBound(strlen(entry->key));
+        if (entry->type == VLC_TRACER_STRING)
+            bound += StringBound(strlen(entry->value.string));
+        else
+            bound += VARINT_MAX;
+    }
+
+    if (bound > CHUNK_SIZE - chunk->len)
+    {
+        chunk->lost++;
+        vlc_mutex_unlock(&chunk->lock);
+        if (!atomic_exchange_explicit(&sys->wake, true, memory_order_relaxed))
+            vlc_cond_signal(&sys->wait);
+        return;
+    }
+
+    uint8_t *p = &chunk->data[chunk->len];
+    size_t pos = 0;
+    uint64_t ns = NS_FROM_VLC_TICK(ts);
+
+    p[pos++] = RECORD_TRACE;
+    pos += PutSVarint(&p[pos], (int64_t) (ns - chunk->last_ts));
+    pos += PutVarint(&p[pos], count);
+
+    for (const struct vlc_tracer_entry *entry = trace->entries;
+         entry->key != NULL; entry++)
+    {
+        p[pos++] = entry->type;
+        pos += PutString(chunk, &p[pos], entry->key, strlen(entry->key));
+        switch (entry->type)
+        {
+            case VLC_TRACER_INT:
+                pos += PutSVarint(&p[pos], entry->value.integer);
+                break;
+            case VLC_TRACER_UINT:
+                pos += PutVarint(&p[pos], entry->value.uinteger);
+                break;
+            case VLC_TRACER_DOUBLE:
+                pos += PutDouble(&p[pos], entry->value.double_);
+                break;
+            case VLC_TRACER_STRING:
+                pos += PutString(chunk, &p[pos], entry->value.string,
+                                 strlen(entry->value.string));
+                break;
+            default:
+                vlc_assert_unreachable();
+        }
+    }
+    assert(pos <= bound);
+
+    chunk->last_ts = ns;
+    chunk->len += pos;
+
+    bool wake = chunk->len > CHUNK_SIZE / 2;
+    vlc_mutex_unlock(&chunk->lock);
+
+    if (wake && !atomic_exchange_explicit(&sys->wake, true, memory_order_relaxed))
+        vlc_cond_signal(&sys->wait);
+}
+
+static void WriteBlock(vlc_tracer_sys_t *sys, unsigned id, unsigned long thread,
+                       const uint8_t *block, size_t size)
+{
+    uint8_t header[3 * VARINT_MAX];
+    size_t len = PutVarint(header, id);
+    len += PutVarint(&header[len], thread);
+    len += PutVarint(&header[len], size);
+
+    fwrite(header, 1, len, sys->stream);
+    fwrite(block, 1, size, sys->stream);
+}
+
+static void FlushChunk(vlc_tracer_sys_t *sys, struct trace_chunk *chunk)
+{
+    vlc_mutex_lock(&chunk->lock);
+    size_t size = chunk->len;
+    uint64_t lost = chunk->lost;
+    unsigned long thread = chunk->thread;
+
+    if (size == 0 && lost == 0)
+    {
+        /* The thread may be gone, let another one use the chunk */
+        if (chunk->owner != NULL && ++chunk->idle >= CHUNK_IDLE_FLUSHES)
+            chunk->owner = NULL;
+        vlc_mutex_unlock(&chunk->lock);
+        return;
+    }
+
+    /* Let the owner go on in the other buffer while we write this one */
+    uint8_t *block = chunk->data;
+    chunk->data = chunk->spare;
+    chunk->spare = block;
+    chunk->len = 0;
+    chunk->lost = 0;
+    chunk->idle = 0;
+    vlc_mutex_unlock(&chunk->lock);
+
+    if (lost > 0)
+    {
+        block[size++] = RECORD_LOST;
+        size += PutVarint(&block[size], lost);
+    }
+    WriteBlock(sys, chunk->id, thread, block, size);
+}
+
+static void FlushLost(vlc_tracer_sys_t *sys)
+{
+    uint64_t lost = atomic_exchange_explicit(&sys->lost, 0,
+                                             memory_order_relaxed);
+    if (lost == 0)
+        return;
+
+    uint8_t block[LOST_RECORD_MAX];
+    size_t size = 0;
+    block[size++] = RECORD_LOST;
+    size += PutVarint(&block[size], lost);
+    WriteBlock(sys, 0, 0, block, size);
+}
+
+static void *FlushThread(void *data)
+{
+    vlc_tracer_sys_t *sys = data;
+
+    vlc_thread_set_name("vlc-tracer");
+
+    vlc_mutex_lock(&sys->lock);
+    for (;;)
+    {
+        vlc_tick_t deadline = vlc_tick_now() + FLUSH_INTERVAL;
+        while (!sys->closing
+            && !atomic_load_explicit(&sys->wake, memory_order_relaxed))
+            if (vlc_cond_timedwait(&sys->wait, &sys->lock, deadline))
+                break;
+
+        bool closing = sys->closing;
+        struct trace_chunk *chunks = sys->chunks;
+        atomic_store_explicit(&sys->wake, false, memory_order_relaxed);
+        vlc_mutex_unlock(&sys->lock);
+
+        /* Chunks are only added at the head, the rest of the list does not
+         * change */
+        for (struct trace_chunk *chunk = chunks; chunk != NULL;
+             chunk = chunk->next)
+            FlushChunk(sys, chunk);
+        FlushLost(sys);
+        fflush(sys->stream);
+
+        if (closing)
+            break;
+        vlc_mutex_lock(&sys->lock);
+    }
+    return NULL;
+}
+
+static void Close(void *opaque)
+{
+    vlc_tracer_sys_t *sys = opaque;
+
+    vlc_mutex_lock(&sys->lock);
+    sys->closing = true;
+    vlc_cond_signal(&sys->wait);
+    vlc_mutex_unlock(&sys->lock);
+    vlc_join(sys->thread, NULL);
+
+    fclose(sys->stream);
+
+    struct trace_chunk *chunk = sys->chunks;
+    while (chunk != NULL)
+    {
+        struct trace_chunk *next = chunk->next;
+        free(chunk->data < chunk->spare ? chunk->data : chunk->spare);
+        free(chunk);
+        chunk = next;
+    }
+    free(sys);
+}
+
+static const struct vlc_tracer_operations binary_ops =
+{
+    TraceBinary,
+    Close
+};
+
+static const struct vlc_tracer_operations *Open(vlc_object_t *obj,
+                                               void **restrict sysp)
+{
+    vlc_tracer_sys_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return NULL;
+
+    char *path = var_InheritString(obj, "binary-tracer-file");
+    const char *filename = path != NULL ? path : BINARY_FILENAME;
+
+    msg_Dbg(obj, "opening trace file `%s'", filename);
+    sys->stream = vlc_fopen(filename, "wb");
+    if (sys->stream == NULL)
+    {
+        msg_Err(obj, "error opening trace file `%s': %s", filename,
+                vlc_strerror_c(errno));
+        free(path);
+        free(sys);
+        return NULL;
+    }
+    free(path);
+
+    fputs(BINARY_MAGIC, sys->stream);
+    fputc(BINARY_VERSION, sys->stream);
+
+    sys->instance = atomic_fetch_add_explicit(&instances, 1,
+                                              memory_order_relaxed);
+    vlc_mutex_init(&sys->lock);
+    vlc_cond_init(&sys->wait);
+    sys->chunks = NULL;
+    sys->chunk_count = 0;
+    sys->closing = false;
+    atomic_init(&sys->wake, false);
+    atomic_init(&sys->lost, 0);
+
+    if (vlc_clone(&sys->thread, FlushThread, sys))
+    {
+        fclose(sys->stream);
+        free(sys);
+        return NULL;
+    }
+
+    *sysp = sys;
+    return &binary_ops;
+}
+
+#define TRACEFILE_NAME_TEXT N_("Trace filename")
+#define TRACEFILE_NAME_LONGTEXT N_("Specify the binary trace filename.")
+
+vlc_module_begin()
+    set_shortname(N_("Binary tracer"))
+    set_description(N_("Binary tracer"))
+    set_subcategory(SUBCAT_ADVANCED_MISC)
+    set_capability("tracer", 0)
+    set_callback(Open)
+
+    add_savefile("binary-tracer-file", NULL, TRACEFILE_NAME_TEXT,
+                 TRACEFILE_NAME_LONGTEXT)
+vlc_module_end()
@@ -0,0 +1,249 @@
+/*****************************************************************************
+ * chrome.c: Chrome trace event format tracer plugin
+ *****************************************************************************
+ * Copyright (C) 2025 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Writes the traces in the Chrome trace event format, which can be opened
+ * in Perfetto (ui.perfetto.dev) or chrome://tracing:
+ *  - spans (vlc_tracer_TraceBegin/End) become duration events,
+ *  - traces with an "event" become instant events,
+ *  - other traces become counters of their numeric values, one series per
+ *    "type" and "id".
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_configuration.h>
+#include <vlc_plugin.h>
+#include <vlc_fs.h>
+#include <vlc_charset.h>
+#include <vlc_tracer.h>
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+#define CHROME_FILENAME "vlc-trace.json"
+
+/* All the traces come from the same process */
+#define CHROME_PID 1
+
+typedef struct
+{
+    FILE *stream;
+} vlc_tracer_sys_t;
+
+static void PrintString(FILE *stream, const char *str)
+{
+    if (!IsUTF8(str))
+    {
+        fputs("\"invalid string\"", stream);
+        return;
+    }
+
+    fputc('"', stream);
+    for (; *str != '\0'; str++)
+    {
+        unsigned char c = *str;
+        if (c == '"' || c == '\\')
+            fprintf(stream, "\\%c", c);
+        else if (c < 0x20 || c == 0x7F)
+            fprintf(stream, "\\u%04x", c);
+        else
+            fputc(c, stream);
+    }
+    fputc('"', stream);
+}
+
+static void PrintValue(FILE *stream, const struct vlc_tracer_entry *entry)
+{
+    switch (entry->type)
+    {
+        case VLC_TRACER_INT:
+            fprintf(stream, "%"PRId64, entry->value.integer);
+            break;
+        case VLC_TRACER_UINT:
+            fprintf(stream, "%"PRIu64, entry->value.uinteger);
+            break;
+        case VLC_TRACER_DOUBLE:
+            if (isfinite(entry->value.double_))
+                vlc_fprintf_c(stream, "%.17g", entry->value.double_);
+            else
+                fputs("null", stream);
+            break;
+        case VLC_TRACER_STRING:
+            PrintString(stream, entry->value.string);
+            break;
+        default:
+            vlc_assert_unreachable();
+    }
+}
+
+static bool IsSpanKey(const char *key)
+{
+    return !strcmp(key, "type") || !strcmp(key, "span")
+        || !strcmp(key, "phase") || !strcmp(key, "event");
+}
+
+static void TraceChrome(void *opaque, vlc_tick_t ts,
+                        const struct vlc_tracer_trace *trace)
+{
+    vlc_tracer_sys_t *sys = opaque;
+    FILE *stream = sys->stream;
+    const char *type = NULL, *id = NULL, *span = NULL, *phase = NULL;
+    const char *event = NULL;
+
+    for (const struct vlc_tracer_entry *entry = trace->entries;
+         entry->key != NULL; entry++)
+    {
+        if (entry->type != VLC_TRACER_STRING)
+            continue;
+        if (!strcmp(entry->key, "type"))
+            type = entry->value.string;
+        else if (!strcmp(entry->key, "id"))
+            id = entry->value.string;
+        else if (!strcmp(entry->key, "span"))
+            span = entry->value.string;
+        else if (!strcmp(entry->key, "phase"))
+            phase = entry->value.string;
+        else if (!strcmp(entry->key, "event"))
+            event = entry->value.string;
+    }
+
+    const char *name;
+    char ph;
+    if (span != NULL && phase != NULL)
+    {
+        name = span;
+        ph = strcmp(phase, VLC_TRACE_SPAN_BEGIN) ? 'E' : 'B';
+    }
+    else if (event != NULL)
+    {
+        name = event;
+        ph = 'i';
+    }
+    else
+    {
+        name = type != NULL ? type : "trace";
+        ph = 'C';
+    }
+
+    int64_t ns = NS_FROM_VLC_TICK(ts);
+
+    flockfile(stream);
+    fputs(",\n{\"name\":", stream);
+    PrintString(stream, name);
+    if (type != NULL)
+    {
+        fputs(",\"cat\":", stream);
+        PrintString(stream, type);
+    }
+    fprintf(stream, ",\"ph\":\"%c\",\"ts\":%"PRId64".%03u,\"pid\":%d,"
+            "\"tid\":%lu", ph, ns / 1000, (unsigned) (ns % 1000), CHROME_PID,
+            vlc_thread_id());
+    if (ph == 'i')
+        fputs(",\"s\":\"t\"", stream);
+    else if (ph == 'C' && id != NULL)
+    {
+        /* One counter series per traced object */
+        fputs(",\"id\":", stream);
+        PrintString(stream, id);
+    }
+
+    fputs(",\"args\":{", stream);
+    bool first = true;
+    for (const struct vlc_tracer_entry *entry = trace->entries;
+         entry->key != NULL; entry++)
+    {
+        /* Counters only take numbers */
+        if (ph == 'C' ? entry->type == VLC_TRACER_STRING
+                      : IsSpanKey(entry->key))
+            continue;
+        if (!first)
+            fputc(',', stream);
+        first = false;
+        PrintString(stream, entry->key);
+        fputc(':', stream);
+        PrintValue(stream, entry);
+    }
+    fputs("}}", stream);
+    funlockfile(stream);
+}
+
+static void Close(void *opaque)
+{
+    vlc_tracer_sys_t *sys = opaque;
+    fputs("\n]\n", sys->stream);
+    fclose(sys->stream);
+    free(sys);
+}
+
+static const struct vlc_tracer_operations chrome_ops =
+{
+    TraceChrome,
+    Close
+};
+
+static const struct vlc_tracer_operations *Open(vlc_object_t *obj,
+                                               void **restrict sysp)
+{
+    vlc_tracer_sys_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return NULL;
+
+    char *path = var_InheritString(obj, "chrome-tracer-file");
+    const char *filename = path != NULL ? path : CHROME_FILENAME;
+
+    msg_Dbg(obj, "opening trace file `%s'", filename);
+    sys->stream = vlc_fopen(filename, "wt");
+    if (sys->stream == NULL)
+    {
+        msg_Err(obj, "error opening trace file `%s': %s", filename,
+                vlc_strerror_c(errno));
+        free(path);
+        free(sys);
+        return NULL;
+    }
+    free(path);
+
+    /* The closing bracket is optional in this format, so that a trace file
+     * is usable even if VLC does not exit cleanly. */
+    fprintf(sys->stream, "[\n{\"name\":\"process_name\",\"ph\":\"M\","
+            "\"pid\":%d,\"args\":{\"name\":\"VLC\"}}", CHROME_PID);
+
+    *sysp = sys;
+    return &chrome_ops;
+}
+
+#define TRACEFILE_NAME_TEXT N_("Trace filename")
+#define TRACEFILE_NAME_LONGTEXT N_("Specify the Chrome trace filename.")
+
+vlc_module_begin()
+    set_shortname(N_("Chrome tracer"))
+    set_description(N_("Chrome trace event format tracer"))
+    set_subcategory(SUBCAT_ADVANCED_MISC)
+    set_capability("tracer", 0)
+    set_callback(Open)
+
+    add_savefile("chrome-tracer-file", NULL, TRACEFILE_NAME_TEXT,
+                 TRACEFILE_NAME_LONGTEXT)
+vlc_module_end()
@@ -0,0 +1,329 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+
+//! Asynchronous batching of encoded points.
+//!
+//! Tracing threads only push lines to a bounded lock-free queue. A flusher
+//! thread drains it periodically, or earlier when it fills up, and sends the
+//! lines to the sink in batches. Points that do not fit in the queue and
+//! batches the sink fails to send are counted and dropped: tracing never
+//! waits for the collector.
+
+use std::{
+    fmt::Write,
+    io,
+    sync::{
+        atomic::{AtomicBool, AtomicU64, Ordering},
+        Arc,
+    },
+    thread::{self, JoinHandle, Thread},
+    time::{Duration, Instant},
+};
+
+use crate::{queue::Queue, sink::Sink};
+
+/// Measurement used to report the tracer's own counters.
+const STATS_MEASUREMENT: &str = "telegraf_tracer";
+const STATS_INTERVAL: Duration = Duration::from_secs(10);
+
+#[derive(Clone, Debug)]
+pub struct Config {
+    /// Maximum number of points waiting to be sent.
+    pub queue_size: usize,
+    /// Maximum size of a batch, in bytes.
+    pub batch_size: usize,
+    /// Maximum delay before a point is sent.
+    pub interval: Duration,
+}
+
+impl Default for Config {
+    fn default() -> Self {
+        Self {
+            queue_size: 8192,
+            batch_size: 64 * 1024,
+            interval: Duration::from_millis(200),
+        }
+    }
+}
+
+#[derive(Default, Debug)]
+pub struct Stats {
+    /// Points accepted in the queue.
+    pub queued: AtomicU64,
+    /// Points dropped because the queue was full.
+    pub dropped: AtomicU64,
+    /// Points written to the sink.
+    pub sent: AtomicU64,
+    /// Points lost because the sink failed.
+    pub lost: AtomicU64,
+}
+
+struct Shared {
+    queue: Queue<String>,
+    stats: Stats,
+    stopping: AtomicBool,
+    wake_pending: AtomicBool,
+}
+
+pub struct Batcher {
+    shared: Arc<Shared>,
+    flusher: Thread,
+    thread: Option<JoinHandle<()>>,
+}
+
+impl Batcher {
+    pub fn new(sink: Sink, config: Config) -> io::Result<Self> {
+        let shared = Arc::new(Shared {
+            queue: Queue::new(config.queue_size),
+            stats: Stats::default(),
+            stopping: AtomicBool::new(false),
+            wake_pending: AtomicBool::new(false),
+        });
+
+        let thread = {
+            let shared = shared.clone();
+            thread::Builder::new()
+                .name(String::from("vlc-telegraf"))
+                .spawn(move || Flusher::new(sink, &config).run(&shared))?
+        };
+
+        Ok(Self {
+            shared,
+            flusher: thread.thread().clone(),
+            thread: Some(thread),
+        })
+    }
+
+    /// Queues a line for sending, without blocking.
+    pub fn push(&self, line: String) {
+        let shared = &*self.shared;
+        if shared.queue.push(line).is_err() {
+            shared.stats.dropped.fetch_add(1, Ordering::Relaxed);
+            return;
+        }
+        shared.stats.queued.fetch_add(1, Ordering::Relaxed);
+
+        // Flush early rather than drop, but wake the flusher only once
+        if shared.queue.len() >= shared.queue.capacity() / 2
+            && !shared.wake_pending.swap(true, Ordering::Relaxed)
+        {
+            self.flusher.unpark();
+        }
+    }
+
+    #[cfg(test)]
+    pub fn stats(&self) -> &Stats {
+        &self.shared.stats
+    }
+}
+
+impl Drop for Batcher {
+    fn drop(&mut self) {
+        self.shared.stopping.store(true, Ordering::Release);
+        self.flusher.unpark();
+        if let Some(thread) = self.thread.take() {
+            let _ = thread.join();
+        }
+    }
+}
+
+struct Flusher {
+    sink: Sink,
+    interval: Duration,
+    max_batch: usize,
+    batch: Vec<u8>,
+    points: u64,
+    failing: bool,
+    reported: (u64, u64),
+    last_report: Instant,
+}
+
+impl Flusher {
+    fn new(sink: Sink, config: &Config) -> Self {
+        let max_batch = sink
+            .max_batch()
+            .map_or(config.batch_size, |max| max.min(config.batch_size));
+        Self {
+            sink,
+            interval: config.interval,
+            max_batch,
+            batch: Vec::with_capacity(max_batch),
+            points: 0,
+            failing: false,
+            reported: (0, 0),
+            last_report: Instant::now(),
+        }
+    }
+
+    fn append(&mut self, stats: &Stats, line: &str) {
+        if !self.batch.is_empty() && self.batch.len() + line.len() + 1 > self.max_batch {
+            self.flush(stats);
+        }
+        self.batch.extend_from_slice(line.as_bytes());
+        self.batch.push(b'\n');
+        self.points += 1;
+    }
+
+    fn flush(&mut self, stats: &Stats) {
+        if self.batch.is_empty() {
+            return;
+        }
+
+        match self.sink.send(&self.batch) {
+            Ok(()) => {
+                stats.sent.fetch_add(self.points, Ordering::Relaxed);
+                self.failing = false;
+            }
+            Err(err) => {
+                stats.lost.fetch_add(self.points, Ordering::Relaxed);
+                if !self.failing {
+                    eprintln!("telegraf tracer: cannot send points: {}", err);
+                    self.failing = true;
+                }
+            }
+        }
+        self.batch.clear();
+        self.points = 0;
+    }
+
+    /// Adds the tracer counters to the batch when they changed.
+    fn report(&mut self, stats: &Stats) {
+        let counters = (
+            stats.dropped.load(Ordering::Relaxed),
+            stats.lost.load(Ordering::Relaxed),
+        );
+        self.last_report = Instant::now();
+        if counters == self.reported {
+            return;
+        }
+        self.reported = counters;
+
+        let mut line = String::from(STATS_MEASUREMENT);
+        let _ = write!(line, " dropped={}u,lost={}u", counters.0, counters.1);
+        self.append(stats, &line);
+    }
+
+    fn run(mut self, shared: &Shared) {
+        loop {
+            let stopping = shared.stopping.load(Ordering::Acquire);
+            shared.wake_pending.store(false, Ordering::Relaxed);
+
+            while let Some(line) = shared.queue.pop() {
+                self.append(&shared.stats, &line);
+            }
+            if stopping || self.last_report.elapsed() >= STATS_INTERVAL {
+                self.report(&shared.stats);
+            }
+            self.flush(&shared.stats);
+
+            if stopping {
+                break;
+            }
+            thread::park_timeout(self.interval);
+        }
+    }
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+    use crate::sink::Endpoint;
+    use std::{
+        io::{BufRead, BufReader},
+        net::{TcpListener, UdpSocket},
+    };
+
+    #[test]
+    fn test_batcher_udp() {
+        let server = UdpSocket::bind("127.0.0.1:0").unwrap();
+        server
+            .set_read_timeout(Some(Duration::from_secs(5)))
+            .unwrap();
+        let address = server.local_addr().unwrap().to_string();
+
+        let config = Config {
+            batch_size: 64,
+            ..Config::default()
+        };
+        let batcher = Batcher::new(Sink::new(Endpoint::Udp(address)), config).unwrap();
+        for i in 0..10 {
+            batcher.push(format!("m value={i}i"));
+        }
+
+        // Batches are split at line boundaries and stay below the limit
+        let mut lines = Vec::new();
+        let mut buf = [0u8; 1024];
+        while lines.len() < 10 {
+            let len = server.recv(&mut buf).unwrap();
+            assert!(len <= 64);
+            let datagram = std::str::from_utf8(&buf[..len]).unwrap();
+            assert!(datagram.ends_with('\n'));
+            lines.extend(datagram.lines().map(String::from));
+        }
+        let expected: Vec<_> = (0..10).map(|i| format!("m value={i}i")).collect();
+        assert_eq!(lines, expected);
+
+        drop(batcher);
+    }
+
+    #[test]
+    fn test_batcher_tcp() {
+        let server = TcpListener::bind("127.0.0.1:0").unwrap();
+        let address = server.local_addr().unwrap().to_string();
+
+        let batcher = Batcher::new(Sink::new(Endpoint::Tcp(address)), Config::default()).unwrap();
+        for i in 0..100 {
+            batcher.push(format!("m value={i}i"));
+        }
+        let (stream, _) = server.accept().unwrap();
+        drop(batcher);
+
+        let lines: Vec<_> = BufReader::new(stream)
+            .lines()
+            .map(Result::unwrap)
+            .collect();
+        let expected: Vec<_> = (0..100).map(|i| format!("m value={i}i")).collect();
+        assert_eq!(lines, expected);
+    }
+
+    #[test]
+    fn test_batcher_drops_when_full() {
+        // A stalled collector: accepted but never read
+        let server = TcpListener::bind("127.0.0.1:0").unwrap();
+        let address = server.local_addr().unwrap().to_string();
+
+        let config = Config {
+            queue_size: 16,
+            interval: Duration::from_secs(3600),
+            ..Config::default()
+        };
+        let batcher = Batcher::new(Sink::new(Endpoint::Tcp(address)), config).unwrap();
+
+        // Pushing never blocks, whatever the state of the collector
+        let start = Instant::now();
+        for i in 0..100_000 {
+            batcher.push(format!("m value={i}i"));
+        }
+        assert!(start.elapsed() < Duration::from_secs(5));
+
+        let stats = batcher.stats();
+        let queued = stats.queued.load(Ordering::Relaxed);
+        let dropped = stats.dropped.load(Ordering::Relaxed);
+        assert_eq!(queued + dropped, 100_000);
+        assert!(dropped > 0);
+        drop(server);
+    }
+}
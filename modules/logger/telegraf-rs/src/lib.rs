@@ -15,26 +15,44 @@
 // along with this program; if not, write to the Free Software Foundation,
 // Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
 
-use std::{cell::UnsafeCell, sync::Mutex};
-use telegraf::{Client, IntoFieldData};
-use vlcrs_core::tracer::{TraceValue, TracerCapability, TracerModuleLoader};
+//! Tracer sending the traces to a Telegraf socket listener.
+//!
+//! Traces are encoded in the InfluxDB line protocol on the tracing thread
+//! and queued without blocking; a background thread sends them in batches.
+//! The tracer is configured through the environment:
+//!
+//!  - `VLC_TELEGRAF_ENDPOINT`: `tcp://`, `udp://`, `unix://` or `unixgram://`
+//!    address of the listener, `tcp://localhost:8094` by default,
+//!  - `VLC_TELEGRAF_QUEUE_SIZE`: number of points kept while waiting to be
+//!    sent, extra points are dropped,
+//!  - `VLC_TELEGRAF_BATCH_SIZE`: maximum size in bytes of a batch,
+//!  - `VLC_TELEGRAF_FLUSH_INTERVAL`: maximum delay in milliseconds before a
+//!    point is sent.
+
+mod batch;
+mod line_protocol;
+mod queue;
+mod sink;
+
+use std::{
+    str::FromStr,
+    time::{Duration, SystemTime, UNIX_EPOCH},
+};
+use vlcrs_core::tracer::{TracerCapability, TracerModuleLoader};
 use vlcrs_macros::module;
 
-struct TraceValueWrapper<'a>(TraceValue<'a>);
+use batch::{Batcher, Config};
+use sink::{Endpoint, Sink};
 
-impl<'a> IntoFieldData for TraceValueWrapper<'a> {
-    fn field_data(&self) -> telegraf::FieldData {
-        match self.0 {
-            TraceValue::String(value) => telegraf::FieldData::Str(String::from(value)),
-            TraceValue::Integer(value) => telegraf::FieldData::Number(value),
-            TraceValue::Unsigned(value) => telegraf::FieldData::UNumber(value),
-            TraceValue::Double(value) => telegraf::FieldData::Float(value),
-        }
-    }
+fn env_or<T: FromStr>(name: &str, default: T) -> T {
+    std::env::var(name)
+        .ok()
+        .and_then(|value| value.parse().ok())
+        .unwrap_or(default)
 }
 
 struct TelegrafTracer {
-    endpoint: Mutex<UnsafeCell<telegraf::Client>>,
+    batcher: Batcher,
 }
 
 impl TracerCapability for TelegrafTracer {
@@ -44,51 +62,40 @@ impl TracerCapability for TelegrafTracer {
     {
         let endpoint_address =
             std::env::var("VLC_TELEGRAF_ENDPOINT").unwrap_or(String::from("tcp://localhost:8094"));
-        let endpoint = Client::new(&endpoint_address)
-            .map(UnsafeCell::new)
-            .map(Mutex::new)
-            .unwrap();
-        Some(Self { endpoint })
-    }
-
-    fn trace(&self, _tick: vlcrs_core::tracer::Tick, trace: &vlcrs_core::tracer::Trace) {
-        let (tags, records) = trace.entries().fold(
-            (Vec::new(), Vec::new()),
-            |(mut tags, mut records), entry| {
-                let name = String::from(entry.key);
-                if let TraceValue::String(value) = entry.value {
-                    let value = String::from(value);
-                    tags.push(telegraf::protocol::Tag { name, value });
-                } else {
-                    let value = TraceValueWrapper(entry.value).field_data();
-                    records.push(telegraf::protocol::Field { name, value });
-                }
+        let Some(endpoint) = Endpoint::parse(&endpoint_address) else {
+            eprintln!("telegraf tracer: invalid endpoint: {}", endpoint_address);
+            return None;
+        };
 
-                (tags, records)
-            },
-        );
+        let default = Config::default();
+        let config = Config {
+            queue_size: env_or("VLC_TELEGRAF_QUEUE_SIZE", default.queue_size),
+            batch_size: env_or("VLC_TELEGRAF_BATCH_SIZE", default.batch_size),
+            interval: Duration::from_millis(env_or(
+                "VLC_TELEGRAF_FLUSH_INTERVAL",
+                default.interval.as_millis() as u64,
+            )),
+        };
 
-        if records.is_empty() {
-            /* We cannot support events for now. */
-            return;
+        match Batcher::new(Sink::new(endpoint), config) {
+            Ok(batcher) => Some(Self { batcher }),
+            Err(err) => {
+                eprintln!("telegraf tracer: cannot start sender: {}", err);
+                None
+            }
         }
+    }
 
-        let p = telegraf::Point {
-            measurement: String::from("measurement"),
-            tags,
-            fields: records,
-            timestamp: None, //Some(tick.0 as u64),
-        };
+    fn trace(&self, _tick: vlcrs_core::tracer::Tick, trace: &vlcrs_core::tracer::Trace) {
+        // Points are sent later, so timestamp them now rather than letting
+        // Telegraf use the reception time.
+        let timestamp = SystemTime::now()
+            .duration_since(UNIX_EPOCH)
+            .ok()
+            .map(|time| time.as_nanos());
 
-        let mut endpoint = self.endpoint.lock().unwrap();
-        if let Err(err) = endpoint.get_mut().write_point(&p) {
-            match err {
-                telegraf::TelegrafError::IoError(e) => eprintln!("TelegrafTracer: IO Error: {}", e),
-                telegraf::TelegrafError::ConnectionError(s) => {
-                    eprintln!("telegraf tracer: connection error: {}", s)
-                }
-                telegraf::TelegrafError::BadProtocol(_) => todo!(),
-            }
+        if let Some(line) = line_protocol::encode("measurement", trace, timestamp) {
+            self.batcher.push(line);
         }
     }
 }
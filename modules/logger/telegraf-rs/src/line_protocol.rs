@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+
+//! InfluxDB line protocol encoding.
+//!
+//! `measurement,tag=value,... field=value,... timestamp`
+
+use std::fmt::Write;
+use vlcrs_core::tracer::{TraceEntry, TraceValue};
+
+fn escape(out: &mut String, value: &str, special: &[char]) {
+    for c in value.chars() {
+        if special.contains(&c) {
+            out.push('\\');
+        }
+        out.push(c);
+    }
+}
+
+/// Encodes trace entries as a single line, without the line terminator.
+///
+/// String values become tags, the others become fields. Non-finite doubles
+/// cannot be represented and are skipped. Returns `None` if there is no
+/// field, since a point needs at least one.
+pub fn encode<'a, I>(measurement: &str, entries: I, timestamp_ns: Option<u128>) -> Option<String>
+where
+    I: IntoIterator<Item = TraceEntry<'a>> + Clone,
+{
+    let mut line = String::with_capacity(128);
+    escape(&mut line, measurement, &[',', ' ']);
+
+    for entry in entries.clone() {
+        if let TraceValue::String(value) = entry.value {
+            line.push(',');
+            escape(&mut line, entry.key, &[',', '=', ' ']);
+            line.push('=');
+            escape(&mut line, value, &[',', '=', ' ']);
+        }
+    }
+
+    let mut separator = ' ';
+    for entry in entries {
+        match entry.value {
+            TraceValue::String(_) => continue,
+            TraceValue::Double(value) if !value.is_finite() => continue,
+            _ => (),
+        }
+        line.push(separator);
+        separator = ',';
+        escape(&mut line, entry.key, &[',', '=', ' ']);
+        line.push('=');
+        // Writing to a String cannot fail
+        let _ = match entry.value {
+            TraceValue::Integer(value) => write!(line, "{value}i"),
+            TraceValue::Unsigned(value) => write!(line, "{value}u"),
+            TraceValue::Double(value) => write!(line, "{value:?}"),
+            TraceValue::String(_) => unreachable!(),
+        };
+    }
+
+    if separator == ' ' {
+        /* We cannot support events for now. */
+        return None;
+    }
+
+    if let Some(timestamp) = timestamp_ns {
+        let _ = write!(line, " {timestamp}");
+    }
+    Some(line)
+}
+
+#[cfg(test)]
+mod test {
+    use super::encode;
+    use vlcrs_core::tracer::{TraceEntry, TraceValue};
+
+    #[test]
+    fn test_encode() {
+        let entries = [
+            TraceEntry { key: "type", value: TraceValue::String("RENDER") },
+            TraceEntry { key: "drift", value: TraceValue::Integer(-12) },
+            TraceEntry { key: "id", value: TraceValue::String("video output") },
+            TraceEntry { key: "count", value: TraceValue::Unsigned(3) },
+            TraceEntry { key: "rate", value: TraceValue::Double(1.0) },
+        ];
+        assert_eq!(
+            encode("measurement", entries.iter().copied(), Some(42)).as_deref(),
+            Some("measurement,type=RENDER,id=video\\ output drift=-12i,count=3u,rate=1.0 42")
+        );
+    }
+
+    #[test]
+    fn test_encode_escape() {
+        let entries = [
+            TraceEntry { key: "a,b", value: TraceValue::String("x=y") },
+            TraceEntry { key: "c d", value: TraceValue::Integer(1) },
+        ];
+        assert_eq!(
+            encode("m m", entries.iter().copied(), None).as_deref(),
+            Some("m\\ m,a\\,b=x\\=y c\\ d=1i")
+        );
+    }
+
+    #[test]
+    fn test_encode_non_finite() {
+        let entries = [
+            TraceEntry { key: "nan", value: TraceValue::Double(f64::NAN) },
+            TraceEntry { key: "rate", value: TraceValue::Double(0.5) },
+            TraceEntry { key: "inf", value: TraceValue::Double(f64::INFINITY) },
+        ];
+        assert_eq!(
+            encode("measurement", entries.iter().copied(), None).as_deref(),
+            Some("measurement rate=0.5")
+        );
+
+        let entries = [TraceEntry { key: "inf", value: TraceValue::Double(f64::NEG_INFINITY) }];
+        assert_eq!(encode("measurement", entries.iter().copied(), None), None);
+    }
+
+    #[test]
+    fn test_encode_event() {
+        let entries = [TraceEntry { key: "type", value: TraceValue::String("EVENT") }];
+        assert_eq!(encode("measurement", entries.iter().copied(), None), None);
+    }
+}
@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+
+//! Bounded lock-free queue.
+//!
+//! Each slot carries a sequence number telling whether it is ready to be
+//! written or read for a given lap around the buffer, so that producers and
+//! consumers only contend on their own position counter and never wait for
+//! each other: pushing into a full queue fails instead of blocking.
+
+use std::{
+    cell::UnsafeCell,
+    mem::MaybeUninit,
+    sync::atomic::{AtomicUsize, Ordering},
+};
+
+#[repr(align(64))]
+struct CachePadded<T>(T);
+
+struct Slot<T> {
+    seq: AtomicUsize,
+    value: UnsafeCell<MaybeUninit<T>>,
+}
+
+pub struct Queue<T> {
+    slots: Box<[Slot<T>]>,
+    mask: usize,
+    enqueue_pos: CachePadded<AtomicUsize>,
+    dequeue_pos: CachePadded<AtomicUsize>,
+}
+
+// SAFETY: values are moved in and out of the slots by a single thread at a
+//         time, as granted by the sequence numbers.
+unsafe impl<T: Send> Send for Queue<T> {}
+unsafe impl<T: Send> Sync for Queue<T> {}
+
+impl<T> Queue<T> {
+    /// Creates a queue holding at least `capacity` values.
+    pub fn new(capacity: usize) -> Self {
+        let capacity = capacity.max(2).next_power_of_two();
+        let slots = (0..capacity)
+            .map(|i| Slot {
+                seq: AtomicUsize::new(i),
+                value: UnsafeCell::new(MaybeUninit::uninit()),
+            })
+            .collect();
+        Self {
+            slots,
+            mask: capacity - 1,
+            enqueue_pos: CachePadded(AtomicUsize::new(0)),
+            dequeue_pos: CachePadded(AtomicUsize::new(0)),
+        }
+    }
+
+    pub fn capacity(&self) -> usize {
+        self.mask + 1
+    }
+
+    /// Approximate number of queued values.
+    pub fn len(&self) -> usize {
+        let tail = self.dequeue_pos.0.load(Ordering::Relaxed);
+        let head = self.enqueue_pos.0.load(Ordering::Relaxed);
+        head.wrapping_sub(tail).min(self.capacity())
+    }
+
+    /// Appends a value, giving it back if the queue is full.
+    pub fn push(&self, value: T) -> Result<(), T> {
+        let mut pos = self.enqueue_pos.0.load(Ordering::Relaxed);
+        loop {
+            let slot = &self.slots[pos & self.mask];
+            let seq = slot.seq.load(Ordering::Acquire);
+            let diff = seq.wrapping_sub(pos) as isize;
+
+            if diff == 0 {
+                match self.enqueue_pos.0.compare_exchange_weak(
+                    pos,
+                    pos.wrapping_add(1),
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => {
+                        // SAFETY: winning the position gives exclusive
+                        //         access to the slot until seq is bumped.
+                        unsafe { (*slot.value.get()).write(value) };
+                        slot.seq.store(pos.wrapping_add(1), Ordering::Release);
+                        return Ok(());
+                    }
+                    Err(current) => pos = current,
+                }
+            } else if diff < 0 {
+                // The slot still holds the value of the previous lap
+                return Err(value);
+            } else {
+                pos = self.enqueue_pos.0.load(Ordering::Relaxed);
+            }
+        }
+    }
+
+    /// Removes the oldest value.
+    pub fn pop(&self) -> Option<T> {
+        let mut pos = self.dequeue_pos.0.load(Ordering::Relaxed);
+        loop {
+            let slot = &self.slots[pos & self.mask];
+            let seq = slot.seq.load(Ordering::Acquire);
+            let diff = seq.wrapping_sub(pos.wrapping_add(1)) as isize;
+
+            if diff == 0 {
+                match self.dequeue_pos.0.compare_exchange_weak(
+                    pos,
+                    pos.wrapping_add(1),
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => {
+                        // SAFETY: the value was fully written before seq
+                        //         was published, and nobody else reads it.
+                        let value = unsafe { (*slot.value.get()).assume_init_read() };
+                        slot.seq
+                            .store(pos.wrapping_add(self.mask + 1), Ordering::Release);
+                        return Some(value);
+                    }
+                    Err(current) => pos = current,
+                }
+            } else if diff < 0 {
+                return None;
+            } else {
+                pos = self.dequeue_pos.0.load(Ordering::Relaxed);
+            }
+        }
+    }
+}
+
+impl<T> Drop for Queue<T> {
+    fn drop(&mut self) {
+        while self.pop().is_some() {}
+    }
+}
+
+#[cfg(test)]
+mod test {
+    use super::Queue;
+    use std::sync::Arc;
+
+    #[test]
+    fn test_queue_bounded() {
+        let queue = Queue::new(3);
+        assert_eq!(queue.capacity(), 4);
+        for i in 0..4 {
+            assert!(queue.push(i).is_ok());
+        }
+        assert_eq!(queue.push(4), Err(4));
+        assert_eq!(queue.len(), 4);
+
+        assert_eq!(queue.pop(), Some(0));
+        assert!(queue.push(4).is_ok());
+        assert_eq!((1..5).collect::<Vec<_>>(), std::iter::from_fn(|| queue.pop()).collect::<Vec<_>>());
+        assert_eq!(queue.pop(), None);
+    }
+
+    #[test]
+    fn test_queue_drops_values() {
+        let value = Arc::new(());
+        let queue = Queue::new(4);
+        queue.push(value.clone()).unwrap();
+        queue.push(value.clone()).unwrap();
+        drop(queue);
+        assert_eq!(Arc::strong_count(&value), 1);
+    }
+
+    #[test]
+    fn test_queue_concurrent() {
+        const PRODUCERS: usize = 4;
+        const COUNT: usize = 10000;
+
+        let queue = Arc::new(Queue::new(64));
+        let producers: Vec<_> = (0..PRODUCERS)
+            .map(|p| {
+                let queue = queue.clone();
+                std::thread::spawn(move || {
+                    for i in 0..COUNT {
+                        let mut value = p * COUNT + i;
+                        while let Err(v) = queue.push(value) {
+                            value = v;
+                            std::thread::yield_now();
+                        }
+                    }
+                })
+            })
+            .collect();
+
+        // Values of each producer come out in order
+        let mut last = [None; PRODUCERS];
+        let mut received = 0;
+        while received < PRODUCERS * COUNT {
+            match queue.pop() {
+                Some(value) => {
+                    let (p, i) = (value / COUNT, value % COUNT);
+                    assert!(last[p].map_or(true, |last| last < i));
+                    last[p] = Some(i);
+                    received += 1;
+                }
+                None => std::thread::yield_now(),
+            }
+        }
+
+        for producer in producers {
+            producer.join().unwrap();
+        }
+        assert_eq!(queue.pop(), None);
+    }
+}
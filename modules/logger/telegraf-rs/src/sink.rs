@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+
+//! Connections to the Telegraf socket listener.
+
+use std::{
+    io::{self, Write},
+    net::{TcpStream, UdpSocket},
+    time::{Duration, Instant},
+};
+
+#[cfg(unix)]
+use std::os::unix::net::{UnixDatagram, UnixStream};
+
+/// Largest datagram sent to datagram endpoints.
+const MAX_DATAGRAM: usize = 8192;
+
+/// Delay before trying to reconnect to an endpoint that failed.
+const RETRY_DELAY: Duration = Duration::from_secs(1);
+
+/// Time allowed to a stream endpoint to accept a batch.
+const WRITE_TIMEOUT: Duration = Duration::from_secs(2);
+
+#[derive(Clone, Debug, PartialEq)]
+pub enum Endpoint {
+    Tcp(String),
+    Udp(String),
+    #[cfg(unix)]
+    Unix(String),
+    #[cfg(unix)]
+    UnixGram(String),
+}
+
+impl Endpoint {
+    /// Parses `tcp://host:port`, `udp://host:port`, `unix:///path` or
+    /// `unixgram:///path`.
+    pub fn parse(url: &str) -> Option<Self> {
+        let (scheme, address) = url.split_once("://")?;
+        let address = String::from(address);
+        if address.is_empty() {
+            return None;
+        }
+        match scheme {
+            "tcp" => Some(Self::Tcp(address)),
+            "udp" => Some(Self::Udp(address)),
+            #[cfg(unix)]
+            "unix" => Some(Self::Unix(address)),
+            #[cfg(unix)]
+            "unixgram" => Some(Self::UnixGram(address)),
+            _ => None,
+        }
+    }
+
+    fn is_datagram(&self) -> bool {
+        match self {
+            Self::Udp(_) => true,
+            #[cfg(unix)]
+            Self::UnixGram(_) => true,
+            _ => false,
+        }
+    }
+}
+
+enum Connection {
+    Tcp(TcpStream),
+    Udp(UdpSocket),
+    #[cfg(unix)]
+    Unix(UnixStream),
+    #[cfg(unix)]
+    UnixGram(UnixDatagram),
+}
+
+impl Connection {
+    fn open(endpoint: &Endpoint) -> io::Result<Self> {
+        Ok(match endpoint {
+            Endpoint::Tcp(address) => {
+                let stream = TcpStream::connect(address)?;
+                stream.set_write_timeout(Some(WRITE_TIMEOUT))?;
+                Self::Tcp(stream)
+            }
+            Endpoint::Udp(address) => {
+                let socket = UdpSocket::bind(if address.starts_with('[') {
+                    "[::]:0"
+                } else {
+                    "0.0.0.0:0"
+                })?;
+                socket.connect(address)?;
+                Self::Udp(socket)
+            }
+            #[cfg(unix)]
+            Endpoint::Unix(path) => {
+                let stream = UnixStream::connect(path)?;
+                stream.set_write_timeout(Some(WRITE_TIMEOUT))?;
+                Self::Unix(stream)
+            }
+            #[cfg(unix)]
+            Endpoint::UnixGram(path) => {
+                let socket = UnixDatagram::unbound()?;
+                socket.connect(path)?;
+                Self::UnixGram(socket)
+            }
+        })
+    }
+
+    fn send(&mut self, data: &[u8]) -> io::Result<()> {
+        match self {
+            Self::Tcp(stream) => stream.write_all(data),
+            Self::Udp(socket) => socket.send(data).map(|_| ()),
+            #[cfg(unix)]
+            Self::Unix(stream) => stream.write_all(data),
+            #[cfg(unix)]
+            Self::UnixGram(socket) => socket.send(data).map(|_| ()),
+        }
+    }
+}
+
+/// Sends batches of lines, reconnecting lazily after failures.
+pub struct Sink {
+    endpoint: Endpoint,
+    connection: Option<Connection>,
+    retry: Option<Instant>,
+}
+
+impl Sink {
+    pub fn new(endpoint: Endpoint) -> Self {
+        Self {
+            endpoint,
+            connection: None,
+            retry: None,
+        }
+    }
+
+    /// Largest batch that can be sent at once.
+    pub fn max_batch(&self) -> Option<usize> {
+        self.endpoint.is_datagram().then_some(MAX_DATAGRAM)
+    }
+
+    /// Sends newline terminated lines. On failure, the connection is dropped
+    /// and the data is lost.
+    pub fn send(&mut self, data: &[u8]) -> io::Result<()> {
+        if self.connection.is_none() {
+            if self.retry.is_some_and(|retry| Instant::now() < retry) {
+                return Err(io::Error::from(io::ErrorKind::NotConnected));
+            }
+            match Connection::open(&self.endpoint) {
+                Ok(connection) => self.connection = Some(connection),
+                Err(err) => {
+                    self.retry = Some(Instant::now() + RETRY_DELAY);
+                    return Err(err);
+                }
+            }
+        }
+
+        let result = self.connection.as_mut().unwrap().send(data);
+        if result.is_err() {
+            self.connection = None;
+            self.retry = Some(Instant::now() + RETRY_DELAY);
+        }
+        result
+    }
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    #[test]
+    fn test_endpoint_parse() {
+        assert_eq!(
+            Endpoint::parse("tcp://localhost:8094"),
+            Some(Endpoint::Tcp(String::from("localhost:8094")))
+        );
+        assert_eq!(
+            Endpoint::parse("udp://127.0.0.1:8092"),
+            Some(Endpoint::Udp(String::from("127.0.0.1:8092")))
+        );
+        assert_eq!(Endpoint::parse("http://localhost:8086"), None);
+        assert_eq!(Endpoint::parse("localhost:8094"), None);
+        assert_eq!(Endpoint::parse("tcp://"), None);
+    }
+
+    #[test]
+    fn test_sink_reconnect_delay() {
+        // Nothing listens there: the failure is remembered for a while
+        let listener = std::net::TcpListener::bind("127.0.0.1:0").unwrap();
+        let address = listener.local_addr().unwrap().to_string();
+        drop(listener);
+
+        let mut sink = Sink::new(Endpoint::Tcp(address));
+        assert!(sink.send(b"m f=1i\n").is_err());
+        assert_eq!(
+            sink.send(b"m f=1i\n").unwrap_err().kind(),
+            io::ErrorKind::NotConnected
+        );
+    }
+}
@@ -0,0 +1,427 @@
+/*****************************************************************************
+ * whisper_shared_vlc.c : Shared audio ring between Whisper capture and readers
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_variables.h>
+#include <vlc_threads.h>
+
+#include "whisper_shared_vlc.h"
+
+#define WHISPER_RING_MASK (WHISPER_RING_SIZE - 1)
+/* The writer publishes its position after each chunk of at most
+ * WHISPER_RING_GUARD samples, so it may be overwriting up to that many
+ * samples past the published position: readers only trust what lies within
+ * the remaining WHISPER_RING_USABLE samples. */
+#define WHISPER_RING_GUARD (WHISPER_RING_SIZE / 4)
+#define WHISPER_RING_USABLE (WHISPER_RING_SIZE - WHISPER_RING_GUARD)
+#define CACHE_LINE 64
+
+/* Timestamps are kept per written block in a separate ring of marks. The
+ * writer fills one mark at a time, so only the oldest few marks may be
+ * overwritten while a reader searches them. */
+#define WHISPER_RING_MARKS 4096
+#define WHISPER_RING_MARKS_MASK (WHISPER_RING_MARKS - 1)
+#define WHISPER_RING_MARKS_USABLE (WHISPER_RING_MARKS - 64)
+
+struct whisper_ring_mark
+{
+    uint64_t pos;       // ring position of the first sample of the block
+    size_t count;       // number of samples of the block
+    vlc_tick_t pts;     // stream timestamp of the first sample
+    vlc_tick_t length;  // stream duration of the block
+};
+
+static_assert((WHISPER_RING_SIZE & WHISPER_RING_MASK) == 0,
+              "ring size must be a power of two");
+static_assert(WHISPER_RING_USABLE >= WHISPER_BUFFER_SIZE,
+              "ring must hold at least WHISPER_BUFFER_SIZE samples");
+
+struct whisper_ring
+{
+    // Producer side, only written by the attached writer
+    alignas(CACHE_LINE) _Atomic uint64_t write_pos;
+    _Atomic uint64_t mark_count;
+    atomic_uint seq; // bumped to wake up waiting readers
+
+    // Read-mostly state, kept away from the producer cache line
+    alignas(CACHE_LINE) float *samples;
+    struct whisper_ring_mark *marks;
+    atomic_uint waiters;
+    atomic_bool has_writer;
+    vlc_atomic_rc_t rc;
+
+    // Registry linkage, protected by VLC_WHISPER_MUTEX
+    libvlc_int_t *libvlc;
+    struct whisper_ring *next;
+    char *name;
+};
+
+struct whisper_ring_reader
+{
+    // Consumer side, only touched by the reading thread
+    alignas(CACHE_LINE) uint64_t read_pos;
+    whisper_ring_t *ring;
+    atomic_bool interrupted;
+
+    // Statistics, may be read from any thread
+    alignas(CACHE_LINE) _Atomic uint64_t read;
+    _Atomic uint64_t overruns;
+    _Atomic uint64_t dropped;
+};
+
+/*****************************************************************************
+ * Registry
+ *****************************************************************************/
+#define REGISTRY_VAR "whisper-rings"
+
+static whisper_ring_t *RingCreate(libvlc_int_t *libvlc, const char *name)
+{
+    whisper_ring_t *ring = aligned_alloc(CACHE_LINE, sizeof(*ring));
+    if (!ring)
+        return NULL;
+
+    ring->samples = aligned_alloc(CACHE_LINE,
+                                  WHISPER_RING_SIZE * sizeof(float));
+    ring->marks = vlc_alloc(WHISPER_RING_MARKS, sizeof(*ring->marks));
+    ring->name = strdup(name);
+    if (!ring->samples || !ring->marks || !ring->name) {
+        aligned_free(ring->samples);
+        free(ring->marks);
+        free(ring->name);
+        aligned_free(ring);
+        return NULL;
+    }
+
+    memset(ring->samples, 0, WHISPER_RING_SIZE * sizeof(float));
+    atomic_init(&ring->write_pos, 0);
+    atomic_init(&ring->mark_count, 0);
+    atomic_init(&ring->seq, 0);
+    atomic_init(&ring->waiters, 0);
+    atomic_init(&ring->has_writer, false);
+    vlc_atomic_rc_init(&ring->rc);
+    ring->libvlc = libvlc;
+    ring->next = NULL;
+    return ring;
+}
+
+whisper_ring_t *whisper_ring_Acquire(vlc_object_t *obj, const char *name)
+{
+    libvlc_int_t *libvlc = vlc_object_instance(obj);
+    if (!name || !*name)
+        name = WHISPER_RING_DEFAULT_NAME;
+
+    vlc_global_lock(VLC_WHISPER_MUTEX);
+
+    /* created once, it lives as long as the instance */
+    if (var_Type(libvlc, REGISTRY_VAR) == 0)
+        var_Create(libvlc, REGISTRY_VAR, VLC_VAR_ADDRESS);
+    whisper_ring_t *head = var_GetAddress(libvlc, REGISTRY_VAR);
+
+    whisper_ring_t *ring;
+    for (ring = head; ring != NULL; ring = ring->next)
+        if (!strcmp(ring->name, name)) {
+            vlc_atomic_rc_inc(&ring->rc);
+            break;
+        }
+
+    if (!ring) {
+        ring = RingCreate(libvlc, name);
+        if (ring) {
+            ring->next = head;
+            var_SetAddress(libvlc, REGISTRY_VAR, ring);
+        }
+    }
+
+    vlc_global_unlock(VLC_WHISPER_MUTEX);
+    return ring;
+}
+
+void whisper_ring_Release(whisper_ring_t *ring)
+{
+    libvlc_int_t *libvlc = ring->libvlc;
+
+    vlc_global_lock(VLC_WHISPER_MUTEX);
+
+    if (!vlc_atomic_rc_dec(&ring->rc)) {
+        vlc_global_unlock(VLC_WHISPER_MUTEX);
+        return;
+    }
+
+    whisper_ring_t *head = var_GetAddress(libvlc, REGISTRY_VAR);
+    if (head == ring) {
+        var_SetAddress(libvlc, REGISTRY_VAR, ring->next);
+    } else {
+        whisper_ring_t *prev = head;
+        while (prev->next != ring)
+            prev = prev->next;
+        prev->next = ring->next;
+    }
+
+    vlc_global_unlock(VLC_WHISPER_MUTEX);
+
+    assert(!atomic_load(&ring->has_writer));
+    aligned_free(ring->samples);
+    free(ring->marks);
+    free(ring->name);
+    aligned_free(ring);
+}
+
+/*****************************************************************************
+ * Writer
+ *****************************************************************************/
+int whisper_ring_AttachWriter(whisper_ring_t *ring)
+{
+    bool expected = false;
+    if (!atomic_compare_exchange_strong(&ring->has_writer, &expected, true))
+        return VLC_EGENERIC;
+    return VLC_SUCCESS;
+}
+
+void whisper_ring_DetachWriter(whisper_ring_t *ring)
+{
+    atomic_store(&ring->has_writer, false);
+}
+
+static void WriteMark(whisper_ring_t *ring, uint64_t pos, size_t count,
+                      vlc_tick_t pts, vlc_tick_t length)
+{
+    uint64_t index = atomic_load_explicit(&ring->mark_count,
+                                          memory_order_relaxed);
+
+    /* Orders the previous count store before overwriting an old mark, so
+     * that a reader seeing the new mark contents also sees that count. */
+    atomic_thread_fence(memory_order_release);
+    ring->marks[index & WHISPER_RING_MARKS_MASK] = (struct whisper_ring_mark) {
+        .pos = pos, .count = count, .pts = pts, .length = length,
+    };
+    atomic_store_explicit(&ring->mark_count, index + 1, memory_order_release);
+}
+
+void whisper_ring_Write(whisper_ring_t *ring, const float *samples,
+                        size_t count, vlc_tick_t pts, vlc_tick_t length)
+{
+    uint64_t pos = atomic_load_explicit(&ring->write_pos,
+                                        memory_order_relaxed);
+
+    // Published before the samples, so that readable samples are timestamped
+    if (pts != VLC_TICK_INVALID && count > 0)
+        WriteMark(ring, pos, count, pts, length);
+
+    // Only the most recent samples can be kept anyway
+    if (count > WHISPER_RING_USABLE) {
+        pos += count - WHISPER_RING_USABLE;
+        samples += count - WHISPER_RING_USABLE;
+        count = WHISPER_RING_USABLE;
+    }
+
+    while (count > 0) {
+        size_t offset = pos & WHISPER_RING_MASK;
+        size_t chunk = WHISPER_RING_SIZE - offset;
+        if (chunk > WHISPER_RING_GUARD)
+            chunk = WHISPER_RING_GUARD;
+        if (chunk > count)
+            chunk = count;
+
+        /* Orders the previous position store before overwriting old
+         * samples: a reader copying any of the new samples then sees at
+         * least that position when checking for overruns, and the guard
+         * covers the rest. */
+        atomic_thread_fence(memory_order_release);
+        memcpy(ring->samples + offset, samples, chunk * sizeof(float));
+
+        pos += chunk;
+        samples += chunk;
+        count -= chunk;
+        atomic_store_explicit(&ring->write_pos, pos, memory_order_release);
+    }
+
+    // Pairs with the fence in whisper_ring_Wait(): either the reader sees the
+    // new position, or we see it waiting and wake it up.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&ring->waiters, memory_order_relaxed) > 0) {
+        atomic_fetch_add_explicit(&ring->seq, 1, memory_order_relaxed);
+        vlc_atomic_notify_all(&ring->seq);
+    }
+}
+
+/*****************************************************************************
+ * Readers
+ *****************************************************************************/
+whisper_ring_reader_t *whisper_ring_NewReader(whisper_ring_t *ring)
+{
+    whisper_ring_reader_t *reader = aligned_alloc(CACHE_LINE,
+                                                  sizeof(*reader));
+    if (!reader)
+        return NULL;
+
+    vlc_atomic_rc_inc(&ring->rc);
+    reader->ring = ring;
+    atomic_init(&reader->interrupted, false);
+    reader->read_pos = atomic_load_explicit(&ring->write_pos,
+                                            memory_order_acquire);
+    atomic_init(&reader->read, 0);
+    atomic_init(&reader->overruns, 0);
+    atomic_init(&reader->dropped, 0);
+    return reader;
+}
+
+void whisper_ring_DeleteReader(whisper_ring_reader_t *reader)
+{
+    whisper_ring_Release(reader->ring);
+    aligned_free(reader);
+}
+
+/* Moves a lapped reader forward, leaving half the usable ring as headroom so
+ * that the writer does not immediately overwrite the new read position. */
+static void ReaderSkip(whisper_ring_reader_t *reader, uint64_t write_pos)
+{
+    uint64_t resume = write_pos - WHISPER_RING_USABLE / 2;
+
+    atomic_fetch_add_explicit(&reader->overruns, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&reader->dropped, resume - reader->read_pos,
+                              memory_order_relaxed);
+    reader->read_pos = resume;
+}
+
+size_t whisper_ring_Available(whisper_ring_reader_t *reader)
+{
+    uint64_t write_pos = atomic_load_explicit(&reader->ring->write_pos,
+                                              memory_order_acquire);
+
+    if (write_pos - reader->read_pos > WHISPER_RING_USABLE)
+        ReaderSkip(reader, write_pos);
+
+    return write_pos - reader->read_pos;
+}
+
+size_t whisper_ring_Wait(whisper_ring_reader_t *reader, size_t count,
+                         vlc_tick_t deadline)
+{
+    whisper_ring_t *ring = reader->ring;
+    size_t available;
+
+    atomic_fetch_add_explicit(&ring->waiters, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    for (;;) {
+        unsigned seq = atomic_load_explicit(&ring->seq, memory_order_acquire);
+
+        available = whisper_ring_Available(reader);
+        if (available >= count || atomic_load(&reader->interrupted))
+            break;
+
+        if (deadline == VLC_TICK_INVALID)
+            vlc_atomic_wait(&ring->seq, seq);
+        else if (vlc_atomic_timedwait(&ring->seq, seq, deadline))
+            break;
+    }
+
+    atomic_fetch_sub_explicit(&ring->waiters, 1, memory_order_relaxed);
+    return available;
+}
+
+void whisper_ring_Interrupt(whisper_ring_reader_t *reader)
+{
+    whisper_ring_t *ring = reader->ring;
+
+    atomic_store(&reader->interrupted, true);
+    atomic_fetch_add_explicit(&ring->seq, 1, memory_order_release);
+    vlc_atomic_notify_all(&ring->seq);
+}
+
+size_t whisper_ring_Read(whisper_ring_reader_t *reader, float *samples,
+                         size_t count, uint64_t *ppos)
+{
+    whisper_ring_t *ring = reader->ring;
+    size_t available = whisper_ring_Available(reader);
+
+    if (count > available)
+        count = available;
+    if (count == 0)
+        return 0;
+
+    uint64_t pos = reader->read_pos;
+    size_t offset = pos & WHISPER_RING_MASK;
+    size_t first = WHISPER_RING_SIZE - offset;
+    if (first > count)
+        first = count;
+
+    memcpy(samples, ring->samples + offset, first * sizeof(float));
+    memcpy(samples + first, ring->samples, (count - first) * sizeof(float));
+
+    // Check that the writer did not lap us while copying
+    atomic_thread_fence(memory_order_acquire);
+    uint64_t write_pos = atomic_load_explicit(&ring->write_pos,
+                                              memory_order_relaxed);
+    if (write_pos - pos > WHISPER_RING_USABLE) {
+        ReaderSkip(reader, write_pos);
+        return 0;
+    }
+
+    reader->read_pos = pos + count;
+    atomic_fetch_add_explicit(&reader->read, count, memory_order_relaxed);
+    if (ppos)
+        *ppos = pos;
+    return count;
+}
+
+vlc_tick_t whisper_ring_GetTimestamp(whisper_ring_reader_t *reader,
+                                     uint64_t pos)
+{
+    whisper_ring_t *ring = reader->ring;
+    uint64_t count = atomic_load_explicit(&ring->mark_count,
+                                          memory_order_acquire);
+    uint64_t first = count > WHISPER_RING_MARKS_USABLE
+                   ? count - WHISPER_RING_MARKS_USABLE : 0;
+    uint64_t low = first;
+    uint64_t high = count;
+
+    // Find the last mark at or before pos
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+        if (ring->marks[mid & WHISPER_RING_MARKS_MASK].pos <= pos)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    if (low == first)
+        return VLC_TICK_INVALID; // older than the oldest mark
+
+    uint64_t index = low - 1;
+    struct whisper_ring_mark mark = ring->marks[index & WHISPER_RING_MARKS_MASK];
+
+    // Check that the writer did not overwrite the marks we looked at
+    atomic_thread_fence(memory_order_acquire);
+    uint64_t now = atomic_load_explicit(&ring->mark_count,
+                                        memory_order_relaxed);
+    if (now - first >= WHISPER_RING_MARKS)
+        return VLC_TICK_INVALID;
+
+    // Interpolate within the block, extrapolate past its end
+    return mark.pts + (vlc_tick_t)(pos - mark.pos) * mark.length
+                      / (vlc_tick_t)mark.count;
+}
+
+void whisper_ring_GetStats(const whisper_ring_reader_t *reader,
+                           whisper_ring_stats_t *stats)
+{
+    stats->written = atomic_load_explicit(&reader->ring->write_pos,
+                                          memory_order_relaxed);
+    stats->read = atomic_load_explicit(&reader->read, memory_order_relaxed);
+    stats->overruns = atomic_load_explicit(&reader->overruns,
+                                           memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&reader->dropped,
+                                          memory_order_relaxed);
+}
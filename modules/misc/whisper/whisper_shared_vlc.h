@@ -0,0 +1,124 @@
+/*****************************************************************************
+ * whisper_shared_vlc.h : Shared audio ring between Whisper capture and readers
+ *****************************************************************************
+ * The capture audio filter owns the write side of a named ring. Any number of
+ * readers (the transcription sub source, level meters, ...) can attach to the
+ * same ring, each with its own read position. Writing and reading are
+ * lock-free: the writer never waits for readers and a reader that falls too
+ * far behind detects the overrun and skips ahead instead of reading torn data.
+ *
+ * Rings are looked up by name in a registry held by the libvlc instance, so
+ * that the writer and its readers find each other regardless of which one is
+ * created first.
+ *****************************************************************************/
+
+#ifndef WHISPER_SHARED_VLC_H
+#define WHISPER_SHARED_VLC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vlc_common.h>
+
+#define WHISPER_SAMPLE_RATE 16000
+#define WHISPER_BUFFER_SIZE (WHISPER_SAMPLE_RATE * 10) // 10 seconds
+
+// Ring capacity, rounded up from WHISPER_BUFFER_SIZE to a power of two
+#define WHISPER_RING_SIZE (1 << 18)
+
+#define WHISPER_RING_DEFAULT_NAME "default"
+
+typedef struct whisper_ring whisper_ring_t;
+typedef struct whisper_ring_reader whisper_ring_reader_t;
+
+typedef struct
+{
+    uint64_t written;   // samples written to the ring since its creation
+    uint64_t read;      // samples consumed by this reader
+    uint64_t overruns;  // number of times this reader was lapped by the writer
+    uint64_t dropped;   // samples skipped because of overruns
+} whisper_ring_stats_t;
+
+/**
+ * Gets the ring registered under the given name, creating it if needed.
+ *
+ * The returned ring must be released with whisper_ring_Release().
+ */
+whisper_ring_t *whisper_ring_Acquire(vlc_object_t *obj, const char *name);
+void whisper_ring_Release(whisper_ring_t *ring);
+
+/**
+ * Takes ownership of the write side of the ring.
+ *
+ * Only one writer can be attached at a time.
+ *
+ * \return VLC_SUCCESS, or VLC_EGENERIC if another writer is attached
+ */
+int whisper_ring_AttachWriter(whisper_ring_t *ring);
+void whisper_ring_DetachWriter(whisper_ring_t *ring);
+
+/**
+ * Appends samples to the ring. Must only be called by the attached writer.
+ *
+ * This never blocks: the oldest samples are overwritten.
+ *
+ * \param pts stream timestamp of the first sample, or VLC_TICK_INVALID
+ * \param length stream duration of the samples
+ */
+void whisper_ring_Write(whisper_ring_t *ring, const float *samples,
+                        size_t count, vlc_tick_t pts, vlc_tick_t length);
+
+/**
+ * Creates a new reader, positioned at the current write position.
+ *
+ * The reader holds a reference to the ring.
+ */
+whisper_ring_reader_t *whisper_ring_NewReader(whisper_ring_t *ring);
+void whisper_ring_DeleteReader(whisper_ring_reader_t *reader);
+
+/**
+ * Returns the number of samples readable without overrun.
+ */
+size_t whisper_ring_Available(whisper_ring_reader_t *reader);
+
+/**
+ * Waits until at least count samples are available.
+ *
+ * The wait ends early when the deadline is reached (VLC_TICK_INVALID waits
+ * forever) or when whisper_ring_Interrupt() is called.
+ *
+ * \return the number of samples available
+ */
+size_t whisper_ring_Wait(whisper_ring_reader_t *reader, size_t count,
+                         vlc_tick_t deadline);
+
+/**
+ * Wakes up whisper_ring_Wait() and makes later waits return immediately.
+ *
+ * This can be called from any thread.
+ */
+void whisper_ring_Interrupt(whisper_ring_reader_t *reader);
+
+/**
+ * Reads up to count samples.
+ *
+ * \param pos if not NULL, receives the ring position of the first sample
+ * read, which jumps forward after an overrun
+ * \return the number of samples read, 0 if none are available or if the
+ * writer overwrote the data while it was being copied
+ */
+size_t whisper_ring_Read(whisper_ring_reader_t *reader, float *samples,
+                         size_t count, uint64_t *pos);
+
+/**
+ * Returns the stream timestamp of the sample at the given ring position,
+ * interpolated from the timestamps given to whisper_ring_Write().
+ *
+ * \return VLC_TICK_INVALID if the position is not timestamped or is too old
+ */
+vlc_tick_t whisper_ring_GetTimestamp(whisper_ring_reader_t *reader,
+                                     uint64_t pos);
+
+void whisper_ring_GetStats(const whisper_ring_reader_t *reader,
+                           whisper_ring_stats_t *stats);
+
+#endif /* WHISPER_SHARED_VLC_H */
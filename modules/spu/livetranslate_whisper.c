@@ -19,6 +19,7 @@
 #include <vlc_aout.h>
 #include <vlc_variables.h>
 #include <vlc_threads.h>
+#include <vlc_vector.h>
 
 /* Note: To use this, you need to:
  * 1. Install whisper.cpp: https://github.com/ggerganov/whisper.cpp
@@ -30,12 +31,9 @@
 
 #include <whisper.h>
 #include "whisper_shared_vlc.h"
-#include "ctranslate2_wrapper.h"
-
-// CLI translation functions
-char *translate_cli(const char *text, const char *source_lang, 
-                    const char *target_lang, vlc_object_t *obj);
-bool translate_cli_is_available(void);
+#include "livetranslate_whisper_model.h"
+#include "livetranslate_whisper_stream.h"
+#include "translate_worker.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -59,6 +57,43 @@ static subpicture_t *Filter( filter_t *, vlc_tick_t );
 #define TRANSLATION_MODEL_TEXT N_("Translation model path")
 #define TRANSLATION_MODEL_LONGTEXT N_("Path to CTranslate2 translation model directory (e.g., /path/to/opus-mt-en-fr)")
 
+#define TRANSLATOR_TEXT N_("Translation backend")
+#define TRANSLATOR_LONGTEXT N_("Backend translating the transcribed text to the target language. \"auto\" uses the CTranslate2 model if one is configured, the translation command otherwise.")
+
+#define TRANSLATOR_COMMAND_TEXT N_("Translation command")
+#define TRANSLATOR_COMMAND_LONGTEXT N_("Command started once to translate captions: it reads one caption per line on its standard input and writes one translation per line on its standard output. The language pair (e.g. en:fr) is appended as last argument.")
+
+#define TRANSLATION_TIMEOUT_TEXT N_("Translation timeout (ms)")
+#define TRANSLATION_TIMEOUT_LONGTEXT N_("Captions not translated within this delay are shown untranslated.")
+
+#define TRANSLATION_QUEUE_TEXT N_("Translation queue size")
+#define TRANSLATION_QUEUE_LONGTEXT N_("Maximum number of captions waiting for translation. Captions that do not fit are shown untranslated.")
+
+static const char *const ppsz_translator_values[] = {
+    "auto", "ctranslate2", "process",
+};
+static const char *const ppsz_translator_descriptions[] = {
+    N_("Automatic"), "CTranslate2", N_("Command"),
+};
+
+#define CHANNEL_TEXT N_("Audio channel")
+#define CHANNEL_LONGTEXT N_("Name of the shared audio ring filled by the Whisper audio capture filter (see --livetranslate-whisper-audio-channel)")
+
+#define STEP_TEXT N_("Decoding step (ms)")
+#define STEP_LONGTEXT N_("Amount of new audio that triggers a new decode of the sliding window. Lower values reduce the caption latency but cost more CPU.")
+
+#define LENGTH_TEXT N_("Window length (ms)")
+#define LENGTH_LONGTEXT N_("Maximum length of the audio window decoded at once. Text that is not stable yet when it leaves the window is committed as is.")
+
+#define KEEP_TEXT N_("Overlap (ms)")
+#define KEEP_LONGTEXT N_("Amount of already transcribed audio kept at the start of the window as acoustic context.")
+
+#define THREADS_TEXT N_("Threads")
+#define THREADS_LONGTEXT N_("Number of threads used by each Whisper decode.")
+
+#define WORKERS_TEXT N_("Decoding workers")
+#define WORKERS_LONGTEXT N_("Number of decodes that can run at once for all the transcribers sharing a model. Each worker needs its own decoding buffers. Only the first transcriber loading a model sets it.")
+
 #define CFG_PREFIX "livetranslate-whisper-"
 
 vlc_module_begin()
@@ -73,6 +108,17 @@ vlc_module_begin()
     add_bool( CFG_PREFIX "translate", true, TRANSLATE_TEXT, TRANSLATE_LONGTEXT )
     add_string( CFG_PREFIX "target-lang", "en", TARGET_LANG_TEXT, TARGET_LANG_LONGTEXT )
     add_string( CFG_PREFIX "translation-model", "", TRANSLATION_MODEL_TEXT, TRANSLATION_MODEL_LONGTEXT )
+    add_string( CFG_PREFIX "translator", "auto", TRANSLATOR_TEXT, TRANSLATOR_LONGTEXT )
+        change_string_list( ppsz_translator_values, ppsz_translator_descriptions )
+    add_string( CFG_PREFIX "translator-command", "trans -brief -no-ansi -shell", TRANSLATOR_COMMAND_TEXT, TRANSLATOR_COMMAND_LONGTEXT )
+    add_integer_with_range( CFG_PREFIX "translation-timeout", 3000, 100, 30000, TRANSLATION_TIMEOUT_TEXT, TRANSLATION_TIMEOUT_LONGTEXT )
+    add_integer_with_range( CFG_PREFIX "translation-queue", 8, 1, 64, TRANSLATION_QUEUE_TEXT, TRANSLATION_QUEUE_LONGTEXT )
+    add_string( CFG_PREFIX "channel", WHISPER_RING_DEFAULT_NAME, CHANNEL_TEXT, CHANNEL_LONGTEXT )
+    add_integer_with_range( CFG_PREFIX "step", 500, 100, 10000, STEP_TEXT, STEP_LONGTEXT )
+    add_integer_with_range( CFG_PREFIX "length", 10000, 1000, 30000, LENGTH_TEXT, LENGTH_LONGTEXT )
+    add_integer_with_range( CFG_PREFIX "keep", 200, 0, 1000, KEEP_TEXT, KEEP_LONGTEXT )
+    add_integer_with_range( CFG_PREFIX "threads", 4, 1, 64, THREADS_TEXT, THREADS_LONGTEXT )
+    add_integer_with_range( CFG_PREFIX "workers", 2, 1, 32, WORKERS_TEXT, WORKERS_LONGTEXT )
     add_integer( CFG_PREFIX "position", 8, "Position", "Subtitle position" )
     add_integer( CFG_PREFIX "size", 0, "Font size", "Font size in pixels" )
     add_rgb( CFG_PREFIX "color", 0xFFFFFF, "Color", "Text color" )
@@ -81,109 +127,6 @@ vlc_module_begin()
     add_shortcut( "livetranscribe", "whisper" )
 vlc_module_end()
 
-/*****************************************************************************
- * Shared buffer management using VLC variables
- *****************************************************************************/
-static whisper_shared_buffer_t *whisper_shared_get_buffer(vlc_object_t *obj)
-{
-    // Get the root libvlc object
-    libvlc_int_t *p_libvlc = vlc_object_instance(obj);
-    if (!p_libvlc)
-        return NULL;
-        
-    // Check if buffer already exists
-    var_Create(p_libvlc, "whisper-shared-buffer", VLC_VAR_ADDRESS);
-    void *ptr = var_GetAddress(p_libvlc, "whisper-shared-buffer");
-    
-    if (ptr) {
-        whisper_shared_buffer_t *buffer = (whisper_shared_buffer_t *)ptr;
-        atomic_fetch_add(&buffer->ref_count, 1);
-        return buffer;
-    }
-    
-    // Create new buffer
-    whisper_shared_buffer_t *buffer = malloc(sizeof(whisper_shared_buffer_t));
-    if (!buffer)
-        return NULL;
-        
-    buffer->samples = malloc(WHISPER_BUFFER_SIZE * sizeof(float));
-    if (!buffer->samples) {
-        free(buffer);
-        return NULL;
-    }
-    
-    memset(buffer->samples, 0, WHISPER_BUFFER_SIZE * sizeof(float));
-    atomic_init(&buffer->write_pos, 0);
-    atomic_init(&buffer->read_pos, 0);
-    atomic_init(&buffer->active, true);
-    atomic_init(&buffer->ref_count, 1);
-    var_SetAddress(p_libvlc, "whisper-shared-buffer", buffer);
-    
-    return buffer;
-}
-
-static void whisper_shared_release_buffer(vlc_object_t *obj, whisper_shared_buffer_t *buffer)
-{
-    if (!buffer)
-        return;
-        
-    int count = atomic_fetch_sub(&buffer->ref_count, 1);
-    if (count == 1) {
-        // Last reference, clean up
-        libvlc_int_t *p_libvlc = vlc_object_instance(obj);
-        if (p_libvlc) {
-            var_SetAddress(p_libvlc, "whisper-shared-buffer", NULL);
-            var_Destroy(p_libvlc, "whisper-shared-buffer");
-        }
-        
-        atomic_store(&buffer->active, false);
-        free(buffer->samples);
-        free(buffer);
-    }
-}
-
-static int whisper_shared_read_buffer(whisper_shared_buffer_t *buffer, float *samples, size_t count)
-{
-    if (!buffer || !atomic_load(&buffer->active))
-        return -1;
-        
-    size_t write_pos = atomic_load(&buffer->write_pos);
-    size_t read_pos = atomic_load(&buffer->read_pos);
-    
-    // Calculate available samples
-    size_t available_samples = 0;
-    if (write_pos >= read_pos) {
-        available_samples = write_pos - read_pos;
-    } else {
-        available_samples = WHISPER_BUFFER_SIZE - read_pos + write_pos;
-    }
-    
-    if (available_samples < count)
-        return -1;
-        
-    for (size_t i = 0; i < count; i++) {
-        samples[i] = buffer->samples[(read_pos + i) % WHISPER_BUFFER_SIZE];
-    }
-    
-    atomic_store(&buffer->read_pos, (read_pos + count) % WHISPER_BUFFER_SIZE);
-    return 0;
-}
-
-static size_t whisper_shared_available_buffer(whisper_shared_buffer_t *buffer)
-{
-    if (!buffer || !atomic_load(&buffer->active))
-        return 0;
-        
-    size_t write_pos = atomic_load(&buffer->write_pos);
-    size_t read_pos = atomic_load(&buffer->read_pos);
-    
-    if (write_pos >= read_pos) {
-        return write_pos - read_pos;
-    } else {
-        return WHISPER_BUFFER_SIZE - read_pos + write_pos;
-    }
-}
-
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
@@ -194,21 +137,46 @@ static const struct vlc_filter_operations filter_ops = {
     .source_sub = Filter, .close = DestroyFilter,
 };
 
-// Use shared definitions from audio filter
+// Captions stay on screen at least this long, if not replaced
+#define CAPTION_MIN_DURATION VLC_TICK_FROM_SEC(2)
+// Captions waiting to be displayed
+#define CAPTION_MAX 64
+// Timestamp jump considered as a discontinuity (seek)
+#define CAPTION_DISCONTINUITY VLC_TICK_FROM_MS(200)
+
+typedef struct
+{
+    char *psz_text;
+    vlc_tick_t i_start; // stream time
+    vlc_tick_t i_stop;  // stream time, VLC_TICK_INVALID while in progress
+    vlc_tick_t i_queued; // system date, used when there is no stream clock
+} caption_t;
+
+struct caption_vec VLC_VECTOR(caption_t);
 
 struct filter_sys_t
 {
-    /* Whisper context */
-    struct whisper_context *whisper_ctx;
+    /* Whisper model, shared with the other transcribers */
+    whisper_model_t *model;
     
-    /* Shared buffer */
-    whisper_shared_buffer_t *shared_buffer;
+    /* Shared audio ring, read through our own cursor */
+    whisper_ring_reader_t *audio_reader;
     
-    /* Transcription */
+    /* Status text, shown until captions are available */
     char current_text[1024];
     vlc_tick_t last_update;
     vlc_mutex_t text_mutex;
     
+    /* Transcription, timed in stream time, protected by text_mutex */
+    struct caption_vec captions;
+    caption_t partial;
+    const caption_t *p_displayed;
+    char *psz_displayed;
+    vlc_tick_t i_displayed_stop;
+    
+    /* Expected timestamp of the next audio sample */
+    vlc_tick_t i_next_pts;
+    
     /* Configuration */
     char *model_path;
     char *language;
@@ -219,12 +187,18 @@ struct filter_sys_t
     int i_size;
     text_style_t *p_style;
     
-    /* Translation context for CTranslate2 */
-    translation_ctx_t *translation_ctx;
+    /* Translation worker, NULL if the text is shown as transcribed */
+    translate_worker_t *translator;
     
+    /* Streaming decoder */
+    whisper_stream_t *stream;
+    size_t i_step;
+    int i_threads;
+
     /* Processing thread */
     vlc_thread_t processing_thread;
     bool b_processing_active;
+    atomic_bool b_stopping;
 };
 
 
@@ -232,6 +206,174 @@ struct filter_sys_t
 /*****************************************************************************
  * Audio processing thread
  *****************************************************************************/
+static void SetText(filter_t *p_filter, const char *text)
+{
+    struct filter_sys_t *p_sys = p_filter->p_sys;
+
+    vlc_mutex_lock(&p_sys->text_mutex);
+    strncpy(p_sys->current_text, text, sizeof(p_sys->current_text) - 1);
+    p_sys->current_text[sizeof(p_sys->current_text) - 1] = '\0';
+    p_sys->last_update = vlc_tick_now();
+    vlc_mutex_unlock(&p_sys->text_mutex);
+}
+
+static void CaptionClean(caption_t *caption)
+{
+    free(caption->psz_text);
+    caption->psz_text = NULL;
+}
+
+/* Queues a final caption, in stream time order */
+static void QueueCaption(filter_t *p_filter, caption_t *caption)
+{
+    struct filter_sys_t *p_sys = p_filter->p_sys;
+
+    msg_Dbg(p_filter, "Final text to display at %"PRId64": %s",
+            caption->i_start, caption->psz_text);
+
+    caption->i_queued = vlc_tick_now();
+
+    vlc_mutex_lock(&p_sys->text_mutex);
+    if (p_sys->captions.size == CAPTION_MAX) {
+        CaptionClean(&p_sys->captions.data[0]);
+        vlc_vector_remove(&p_sys->captions, 0);
+    }
+
+    // Translations may complete after captions that skipped the queue
+    size_t index = p_sys->captions.size;
+    while (index > 0 && caption->i_start != VLC_TICK_INVALID &&
+           p_sys->captions.data[index - 1].i_start > caption->i_start)
+        index--;
+
+    // The vector may move, forget the displayed caption address
+    p_sys->p_displayed = NULL;
+    if (!vlc_vector_insert(&p_sys->captions, index, *caption))
+        CaptionClean(caption);
+    vlc_mutex_unlock(&p_sys->text_mutex);
+}
+
+struct pending_caption
+{
+    filter_t *p_filter;
+    caption_t caption;
+};
+
+static void CaptionTranslated(void *opaque, char *result)
+{
+    struct pending_caption *pending = opaque;
+
+    if (result) {
+        free(pending->caption.psz_text);
+        pending->caption.psz_text = result;
+    } else
+        msg_Warn(pending->p_filter, "Translation failed, using English text");
+
+    QueueCaption(pending->p_filter, &pending->caption);
+    free(pending);
+}
+
+/* Maps ring positions of a segment to stream time */
+static void SegmentToStream(filter_t *p_filter, uint64_t start, uint64_t end,
+                            vlc_tick_t *pi_start, vlc_tick_t *pi_stop)
+{
+    struct filter_sys_t *p_sys = p_filter->p_sys;
+
+    *pi_start = whisper_ring_GetTimestamp(p_sys->audio_reader, start);
+    *pi_stop = end > start
+             ? whisper_ring_GetTimestamp(p_sys->audio_reader, end - 1)
+             : VLC_TICK_INVALID;
+    if (*pi_stop != VLC_TICK_INVALID && *pi_start != VLC_TICK_INVALID &&
+        *pi_stop < *pi_start)
+        *pi_stop = *pi_start; // segment across a discontinuity
+}
+
+static void PublishText(filter_t *p_filter)
+{
+    struct filter_sys_t *p_sys = p_filter->p_sys;
+    whisper_stream_segment_t segment;
+
+    // Completed segments are final, translate and queue them
+    while (whisper_stream_PopSegment(p_sys->stream, &segment)) {
+        caption_t caption = { .psz_text = segment.text };
+        SegmentToStream(p_filter, segment.start, segment.end,
+                        &caption.i_start, &caption.i_stop);
+
+        if (p_sys->translator) {
+            // The result is queued by the translation worker
+            struct pending_caption *pending = malloc(sizeof(*pending));
+            if (pending) {
+                pending->p_filter = p_filter;
+                pending->caption = caption;
+                if (translate_worker_Submit(p_sys->translator, caption.psz_text,
+                                            CaptionTranslated, pending) == VLC_SUCCESS)
+                    continue;
+                free(pending);
+            }
+            msg_Warn(p_filter, "Translation queue full, using English text");
+        }
+        QueueCaption(p_filter, &caption);
+    }
+
+    // Partial text is only shown as is, translating it would be wasteful
+    uint64_t start = 0;
+    char *partial = p_sys->translator ? NULL
+                  : whisper_stream_GetPartial(p_sys->stream, &start);
+    if (partial && !*partial) {
+        free(partial);
+        partial = NULL;
+    }
+
+    vlc_mutex_lock(&p_sys->text_mutex);
+    CaptionClean(&p_sys->partial);
+    p_sys->partial.psz_text = partial;
+    p_sys->partial.i_start = partial
+        ? whisper_ring_GetTimestamp(p_sys->audio_reader, start)
+        : VLC_TICK_INVALID;
+    p_sys->partial.i_stop = VLC_TICK_INVALID;
+    p_sys->partial.i_queued = vlc_tick_now();
+    vlc_mutex_unlock(&p_sys->text_mutex);
+}
+
+/* Detects seeks from the timestamps of the samples read */
+static bool CheckDiscontinuity(filter_t *p_filter, uint64_t pos, size_t count)
+{
+    struct filter_sys_t *p_sys = p_filter->p_sys;
+    vlc_tick_t pts = whisper_ring_GetTimestamp(p_sys->audio_reader, pos);
+    vlc_tick_t expected = p_sys->i_next_pts;
+
+    vlc_tick_t last = whisper_ring_GetTimestamp(p_sys->audio_reader,
+                                                pos + count - 1);
+    p_sys->i_next_pts = last != VLC_TICK_INVALID
+                      ? last + vlc_tick_from_samples(1, WHISPER_SAMPLE_RATE)
+                      : VLC_TICK_INVALID;
+
+    return pts != VLC_TICK_INVALID && expected != VLC_TICK_INVALID &&
+           (pts < expected - CAPTION_DISCONTINUITY ||
+            pts > expected + CAPTION_DISCONTINUITY);
+}
+
+static int Decode(filter_t *p_filter)
+{
+    struct filter_sys_t *p_sys = p_filter->p_sys;
+    
+    if (!p_sys->model)
+        return VLC_EGENERIC;
+    
+    struct whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.language = p_sys->language;
+    params.translate = p_sys->b_translate;  // Enable translation if requested
+    params.n_threads = p_sys->i_threads;
+    params.print_progress = false;
+    params.print_realtime = false;
+    
+    if (whisper_model_Decode(p_sys->model, p_sys->stream, params) != 0) {
+        msg_Err(p_filter, "Whisper processing failed");
+        SetText(p_filter, "Transcription failed");
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
 static void *ProcessingThread(void *data)
 {
     filter_t *p_filter = (filter_t *)data;
@@ -239,133 +381,65 @@ static void *ProcessingThread(void *data)
     
     msg_Info(p_filter, "Whisper processing thread started");
     
-    // Test counter for demo
-    int test_counter = 0;
-    const char *test_messages[] = {
-        "Whisper transcription initializing...",
-        "Waiting for audio input...",
-        "Audio capture not yet implemented",
-        "This is a test of the subtitle system",
-        "Real transcription will appear here"
-    };
-    
-    // Allocate processing buffer
-    float *process_buffer = malloc(WHISPER_SAMPLE_RATE * 30 * sizeof(float));
-    if (!process_buffer) {
+    // Allocate read buffer, one window is the most we can use at once
+    const size_t read_size = WHISPER_SAMPLE_RATE * 30;
+    float *read_buffer = malloc(read_size * sizeof(float));
+    if (!read_buffer) {
         msg_Err(p_filter, "Failed to allocate processing buffer");
         return NULL;
     }
     
-    while (p_sys->b_processing_active) {
-        vlc_tick_sleep(VLC_TICK_FROM_SEC(2)); // Process every 2 seconds
-        
-        // Check available audio samples
-        size_t available_samples = whisper_shared_available_buffer(p_sys->shared_buffer);
-        
-        // Log available samples periodically
-        static int check_counter = 0;
-        if (check_counter++ % 5 == 0) { // Every 10 seconds
-            msg_Info(p_filter, "Available audio samples: %zu (need %d)", available_samples, WHISPER_SAMPLE_RATE * 2);
-        }
-        
-        // Need at least 2 seconds of audio
-        if (available_samples < WHISPER_SAMPLE_RATE * 2) {
-            // Show waiting message
-            if (test_counter < 5) {
-                vlc_mutex_lock(&p_sys->text_mutex);
-                strncpy(p_sys->current_text, test_messages[test_counter % 5], sizeof(p_sys->current_text) - 1);
-                p_sys->current_text[sizeof(p_sys->current_text) - 1] = '\0';
-                p_sys->last_update = vlc_tick_now();
-                vlc_mutex_unlock(&p_sys->text_mutex);
-                test_counter++;
-            }
-            continue;
-        }
+    const vlc_tick_t step_duration = vlc_tick_from_samples(p_sys->i_step,
+                                                           WHISPER_SAMPLE_RATE);
+    bool b_idle = true;
+    
+    for (;;) {
+        // Sleep until a full step of new audio is available. The capture
+        // filter only sends speech, so audio may also stop for a while.
+        size_t available = whisper_ring_Wait(p_sys->audio_reader, p_sys->i_step,
+                                             vlc_tick_now() + 2 * step_duration);
+        if (atomic_load(&p_sys->b_stopping))
+            break;
         
-        // Limit to what we can process
-        size_t samples_to_process = available_samples;
-        if (samples_to_process > WHISPER_SAMPLE_RATE * 5) {
-            samples_to_process = WHISPER_SAMPLE_RATE * 5; // Process max 5 seconds at a time
-        }
-        
-        // Read audio for processing
-        if (whisper_shared_read_buffer(p_sys->shared_buffer, process_buffer, samples_to_process) != 0) {
-            msg_Err(p_filter, "Failed to read audio from shared buffer");
+        if (available == 0) {
+            // End of speech: decode the tail once and show it as final
+            if (b_idle)
+                continue;
+            b_idle = true;
+            Decode(p_filter);
+            whisper_stream_Flush(p_sys->stream);
+            PublishText(p_filter);
             continue;
         }
+        b_idle = false;
         
-        msg_Info(p_filter, "Processing %zu audio samples with Whisper", samples_to_process);
-        
-        // Process with Whisper
-        if (p_sys->whisper_ctx) {
-            struct whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-            params.language = p_sys->language;
-            params.translate = p_sys->b_translate;  // Enable translation if requested
-            params.n_threads = 4;
-            params.print_progress = false;
-            params.print_realtime = false;
-            
-            if (whisper_full(p_sys->whisper_ctx, params, process_buffer, (int)samples_to_process) == 0) {
-                const int n_segments = whisper_full_n_segments(p_sys->whisper_ctx);
-                if (n_segments > 0) {
-                    // Get the last segment's text
-                    const char *text = whisper_full_get_segment_text(p_sys->whisper_ctx, n_segments - 1);
-                    
-                    // Check if we need to translate to another language
-                    char *final_text = NULL;
-                    if (p_sys->b_translate && p_sys->target_language && 
-                        strcmp(p_sys->target_language, "en") != 0) {
-                        
-                        // Try CTranslate2 first
-                        if (p_sys->translation_ctx) {
-                            final_text = ctranslate2_translate(p_sys->translation_ctx, text, 
-                                                              "en", p_sys->target_language,
-                                                              VLC_OBJECT(p_filter));
-                            if (final_text) {
-                                msg_Info(p_filter, "Translated from English to %s using CTranslate2: %s", 
-                                        p_sys->target_language, final_text);
-                            }
-                        }
-                        
-                        // If CTranslate2 failed or not available, try CLI translation
-                        if (!final_text && translate_cli_is_available()) {
-                            final_text = translate_cli(text, "en", p_sys->target_language,
-                                                      VLC_OBJECT(p_filter));
-                            if (final_text) {
-                                msg_Info(p_filter, "Translated from English to %s using CLI: %s", 
-                                        p_sys->target_language, final_text);
-                            }
-                        }
-                        
-                        // If all translation failed, use original text
-                        if (!final_text) {
-                            final_text = strdup(text);
-                            msg_Warn(p_filter, "Translation to %s failed, using English text", 
-                                    p_sys->target_language);
-                        }
-                    } else {
-                        // Use the text as-is (either original language or English)
-                        final_text = strdup(text);
-                    }
-                    
-                    if (final_text) {
-                        vlc_mutex_lock(&p_sys->text_mutex);
-                        strncpy(p_sys->current_text, final_text, sizeof(p_sys->current_text) - 1);
-                        p_sys->current_text[sizeof(p_sys->current_text) - 1] = '\0';
-                        p_sys->last_update = vlc_tick_now();
-                        vlc_mutex_unlock(&p_sys->text_mutex);
-                        
-                        msg_Info(p_filter, "Final text to display: %s", final_text);
-                        free(final_text);
-                    }
-                }
-            } else {
-                msg_Err(p_filter, "Whisper processing failed");
+        // Drain everything that arrived while we were decoding
+        uint64_t pos;
+        size_t count;
+        while ((count = whisper_ring_Read(p_sys->audio_reader, read_buffer,
+                                          read_size, &pos)) > 0) {
+            if (CheckDiscontinuity(p_filter, pos, count)) {
+                msg_Dbg(p_filter, "Audio discontinuity, restarting decoding");
+                whisper_stream_Reset(p_sys->stream);
+                PublishText(p_filter);
             }
+            whisper_stream_Push(p_sys->stream, pos, read_buffer, count);
         }
+        
+        if (Decode(p_filter) == VLC_SUCCESS)
+            PublishText(p_filter);
     }
     
-    free(process_buffer);
+    // Show what was still pending
+    whisper_stream_Flush(p_sys->stream);
+    PublishText(p_filter);
+    
+    whisper_ring_stats_t stats;
+    whisper_ring_GetStats(p_sys->audio_reader, &stats);
+    msg_Dbg(p_filter, "Read %"PRIu64" audio samples, %"PRIu64" overruns, "
+            "%"PRIu64" samples dropped", stats.read, stats.overruns, stats.dropped);
+    
+    free(read_buffer);
     msg_Info(p_filter, "Whisper processing thread ended");
     return NULL;
 }
@@ -388,6 +462,11 @@ static int CreateFilter( filter_t *p_filter )
     // Initialize timing
     p_sys->last_update = 0;
     p_sys->current_text[0] = '\0';
+    vlc_vector_init(&p_sys->captions);
+    p_sys->partial.psz_text = NULL;
+    p_sys->p_displayed = NULL;
+    p_sys->psz_displayed = NULL;
+    p_sys->i_next_pts = VLC_TICK_INVALID;
     
     // Get configuration
     p_sys->model_path = var_InheritString(p_filter, CFG_PREFIX "model");
@@ -414,9 +493,15 @@ static int CreateFilter( filter_t *p_filter )
         p_sys->p_style->i_font_size = p_sys->i_size;
     }
     
-    // Get shared buffer
-    p_sys->shared_buffer = whisper_shared_get_buffer(VLC_OBJECT(p_filter));
-    if (!p_sys->shared_buffer) {
+    // Attach a reader to the shared audio ring
+    char *channel = var_InheritString(p_filter, CFG_PREFIX "channel");
+    whisper_ring_t *ring = whisper_ring_Acquire(VLC_OBJECT(p_filter), channel);
+    free(channel);
+    if (ring) {
+        p_sys->audio_reader = whisper_ring_NewReader(ring);
+        whisper_ring_Release(ring);
+    }
+    if (!p_sys->audio_reader) {
         msg_Err(p_filter, "Failed to get shared audio buffer");
         text_style_Delete(p_sys->p_style);
         free(p_sys->language);
@@ -430,14 +515,9 @@ static int CreateFilter( filter_t *p_filter )
     
     // Initialize Whisper
     if (p_sys->model_path && *p_sys->model_path) {
-        msg_Info(p_filter, "Loading Whisper model from: %s", p_sys->model_path);
-        
-        // Initialize Whisper with default parameters
-        struct whisper_context_params cparams = whisper_context_default_params();
-        p_sys->whisper_ctx = whisper_init_from_file_with_params(p_sys->model_path, cparams);
-        if (!p_sys->whisper_ctx) {
-            msg_Err(p_filter, "Failed to load Whisper model from %s", p_sys->model_path);
-        } else {
+        p_sys->model = whisper_model_Acquire(VLC_OBJECT(p_filter), p_sys->model_path,
+                                             var_InheritInteger(p_filter, CFG_PREFIX "workers"));
+        if (p_sys->model) {
             msg_Info(p_filter, "Whisper model loaded successfully");
             if (p_sys->b_translate) {
                 msg_Info(p_filter, "Translation mode: enabled (target language: %s)", 
@@ -445,46 +525,62 @@ static int CreateFilter( filter_t *p_filter )
             } else {
                 msg_Info(p_filter, "Translation mode: disabled (transcribe only)");
             }
-        }
-        
-        strcpy(p_sys->current_text, p_sys->b_translate ? "Whisper translator ready - waiting for audio..." : "Whisper transcriber ready - waiting for audio...");
+            SetText(p_filter, p_sys->b_translate ? "Whisper translator ready - waiting for audio..." : "Whisper transcriber ready - waiting for audio...");
+        } else
+            SetText(p_filter, "Failed to load the Whisper model");
     } else {
         msg_Warn(p_filter, "No Whisper model path specified");
-        strcpy(p_sys->current_text, "Please configure Whisper model path");
+        SetText(p_filter, "Please configure Whisper model path");
     }
     
-    // Initialize CTranslate2 if translation model is specified
-    p_sys->translation_ctx = NULL;
-    if (p_sys->b_translate && p_sys->target_language && 
-        strcmp(p_sys->target_language, "en") != 0 &&
-        p_sys->translation_model_path && *p_sys->translation_model_path) {
-        
-        if (ctranslate2_is_available()) {
-            msg_Info(p_filter, "Initializing CTranslate2 with model: %s", 
-                    p_sys->translation_model_path);
-            p_sys->translation_ctx = ctranslate2_init(p_sys->translation_model_path, 
-                                                      VLC_OBJECT(p_filter));
-            if (!p_sys->translation_ctx) {
-                msg_Warn(p_filter, "Failed to initialize CTranslate2, will use English output only");
-            }
-        } else {
-            msg_Warn(p_filter, "CTranslate2 support not compiled in");
-            // Check if CLI translation is available as fallback
-            if (translate_cli_is_available()) {
-                msg_Info(p_filter, "translate-shell (CLI) is available as fallback");
-            } else {
-                msg_Warn(p_filter, "No translation backend available, will use English output only");
-                msg_Info(p_filter, "Install translate-shell for CLI translation: sudo apt-get install translate-shell");
-            }
-        }
+    // Start the translation worker if the text is not wanted in English
+    if (p_sys->b_translate && p_sys->target_language &&
+        strcmp(p_sys->target_language, "en") != 0) {
+        char *backend = var_InheritString(p_filter, CFG_PREFIX "translator");
+        char *command = var_InheritString(p_filter, CFG_PREFIX "translator-command");
+        translate_worker_cfg_t translate_cfg = {
+            .backend = backend,
+            .model_path = p_sys->translation_model_path,
+            .command = command,
+            .source_lang = "en", // Whisper translates to English
+            .target_lang = p_sys->target_language,
+            .queue_size = var_InheritInteger(p_filter, CFG_PREFIX "translation-queue"),
+            .timeout = VLC_TICK_FROM_MS(var_InheritInteger(p_filter, CFG_PREFIX "translation-timeout")),
+        };
+        p_sys->translator = translate_worker_New(VLC_OBJECT(p_filter), &translate_cfg);
+        if (!p_sys->translator)
+            msg_Warn(p_filter, "No translation backend available, will use English output only");
+        free(backend);
+        free(command);
+    }
+    
+    // Set up the streaming decoder
+    whisper_stream_cfg_t stream_cfg = {
+        .step = var_InheritInteger(p_filter, CFG_PREFIX "step") * WHISPER_SAMPLE_RATE / 1000,
+        .length = var_InheritInteger(p_filter, CFG_PREFIX "length") * WHISPER_SAMPLE_RATE / 1000,
+        .keep = var_InheritInteger(p_filter, CFG_PREFIX "keep") * WHISPER_SAMPLE_RATE / 1000,
+    };
+    if (stream_cfg.step > stream_cfg.length)
+        stream_cfg.step = stream_cfg.length;
+    if (stream_cfg.keep >= stream_cfg.length)
+        stream_cfg.keep = stream_cfg.length / 2;
+    p_sys->i_step = stream_cfg.step;
+    p_sys->i_threads = var_InheritInteger(p_filter, CFG_PREFIX "threads");
+    p_sys->stream = whisper_stream_New(&stream_cfg);
+    if (!p_sys->stream) {
+        msg_Err(p_filter, "Failed to create the streaming decoder");
+        DestroyFilter(p_filter);
+        return VLC_ENOMEM;
     }
     
     // Start processing thread
-    p_sys->b_processing_active = true;
+    atomic_init(&p_sys->b_stopping, false);
     if (vlc_clone(&p_sys->processing_thread, ProcessingThread, p_filter) != 0) {
         msg_Err(p_filter, "Failed to create processing thread");
-        p_sys->b_processing_active = false;
+        DestroyFilter(p_filter);
+        return VLC_ENOMEM;
     }
+    p_sys->b_processing_active = true;
     
     msg_Info(p_filter, "Whisper live transcription filter created");
     
@@ -505,22 +601,30 @@ static void DestroyFilter( filter_t *p_filter )
     
     // Stop processing thread
     if (p_sys->b_processing_active) {
-        p_sys->b_processing_active = false;
+        atomic_store(&p_sys->b_stopping, true);
+        whisper_ring_Interrupt(p_sys->audio_reader);
         vlc_join(p_sys->processing_thread, NULL);
     }
     
-    // Clean up Whisper
-    if (p_sys->whisper_ctx) {
-        whisper_free(p_sys->whisper_ctx);
-    }
+    // Pending translations complete before the captions are freed
+    if (p_sys->translator)
+        translate_worker_Delete(p_sys->translator);
     
-    // Clean up CTranslate2
-    if (p_sys->translation_ctx) {
-        ctranslate2_cleanup(p_sys->translation_ctx);
-    }
+    if (p_sys->stream)
+        whisper_stream_Delete(p_sys->stream);
+    
+    // Release Whisper model
+    if (p_sys->model)
+        whisper_model_Release(p_sys->model);
+    
+    // Release shared audio ring
+    whisper_ring_DeleteReader(p_sys->audio_reader);
     
-    // Release shared buffer
-    whisper_shared_release_buffer(VLC_OBJECT(p_filter), p_sys->shared_buffer);
+    caption_t *caption;
+    vlc_vector_foreach_ref(caption, &p_sys->captions)
+        CaptionClean(caption);
+    vlc_vector_destroy(&p_sys->captions);
+    CaptionClean(&p_sys->partial);
     
     // Free resources
     free(p_sys->model_path);
@@ -537,21 +641,113 @@ static void DestroyFilter( filter_t *p_filter )
 /*****************************************************************************
  * Filter: output transcription subtitles
  *****************************************************************************/
+
+/* Gets the system dates of a caption. Captions are timed against the stream,
+ * so that they follow pause, seek and rate changes. Without stream clock,
+ * they are shown as soon as they are available. */
+static void CaptionDates(filter_t *p_filter, const caption_t *caption,
+                         vlc_tick_t date, vlc_tick_t *pi_start,
+                         vlc_tick_t *pi_stop)
+{
+    vlc_tick_t start = caption->i_start != VLC_TICK_INVALID
+        ? filter_ConvertSubpictureTs(p_filter, date, caption->i_start)
+        : VLC_TICK_INVALID;
+    vlc_tick_t stop;
+
+    if (start == VLC_TICK_INVALID) {
+        start = caption->i_queued;
+        stop = caption->i_stop != VLC_TICK_INVALID &&
+               caption->i_start != VLC_TICK_INVALID
+             ? start + caption->i_stop - caption->i_start
+             : start;
+    } else
+        stop = caption->i_stop != VLC_TICK_INVALID
+             ? filter_ConvertSubpictureTs(p_filter, date, caption->i_stop)
+             : start;
+
+    if (stop < start + CAPTION_MIN_DURATION)
+        stop = start + CAPTION_MIN_DURATION;
+    *pi_start = start;
+    *pi_stop = stop;
+}
+
+/* Picks the caption to show at the given system date */
+static const caption_t *SelectCaption(filter_t *p_filter, vlc_tick_t date,
+                                      vlc_tick_t *pi_stop)
+{
+    struct filter_sys_t *p_sys = p_filter->p_sys;
+    const caption_t *p_selected = NULL;
+    size_t i_kept = 0;
+
+    for (size_t i = 0; i < p_sys->captions.size; i++) {
+        caption_t *caption = &p_sys->captions.data[i];
+        vlc_tick_t start, stop;
+
+        CaptionDates(p_filter, caption, date, &start, &stop);
+        if (stop <= date) {
+            // Already shown, or too late to be
+            CaptionClean(caption);
+            continue;
+        }
+
+        p_sys->captions.data[i_kept] = *caption;
+        if (start <= date) {
+            // The most recent caption replaces the older ones
+            p_selected = &p_sys->captions.data[i_kept];
+            *pi_stop = stop;
+        }
+        i_kept++;
+    }
+
+    if (i_kept < p_sys->captions.size) {
+        vlc_vector_remove_slice(&p_sys->captions, i_kept,
+                                p_sys->captions.size - i_kept);
+        p_sys->p_displayed = NULL;
+    }
+
+    // Show the text in progress when no final caption is due
+    if (!p_selected && p_sys->partial.psz_text) {
+        vlc_tick_t start, stop;
+
+        CaptionDates(p_filter, &p_sys->partial, date, &start, &stop);
+        if (start <= date) {
+            p_selected = &p_sys->partial;
+            *pi_stop = date + CAPTION_MIN_DURATION;
+        }
+    }
+    return p_selected;
+}
+
 static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
 {
     struct filter_sys_t *p_sys = p_filter->p_sys;
     subpicture_t *p_spu = NULL;
+    const char *psz_text;
+    vlc_tick_t i_stop;
     
     vlc_mutex_lock(&p_sys->text_mutex);
     
-    // Check if we have text to display
-    if (p_sys->current_text[0] == '\0') {
-        vlc_mutex_unlock(&p_sys->text_mutex);
-        return NULL;
-    }
-    
-    // Don't update too frequently
-    if (date - p_sys->last_update < VLC_TICK_FROM_MS(100)) {
+    const caption_t *caption = SelectCaption(p_filter, date, &i_stop);
+    if (caption) {
+        // Don't emit the same caption again, unless its timing moved
+        if (caption == p_sys->p_displayed &&
+            p_sys->psz_displayed == caption->psz_text &&
+            i_stop > p_sys->i_displayed_stop - VLC_TICK_FROM_MS(100) &&
+            i_stop < p_sys->i_displayed_stop + VLC_TICK_FROM_MS(100)) {
+            vlc_mutex_unlock(&p_sys->text_mutex);
+            return NULL;
+        }
+        p_sys->p_displayed = caption;
+        p_sys->psz_displayed = caption->psz_text;
+        p_sys->i_displayed_stop = i_stop;
+        psz_text = caption->psz_text;
+    } else if (p_sys->captions.size == 0 && !p_sys->partial.psz_text &&
+               p_sys->current_text[0] != '\0' &&
+               date - p_sys->last_update < VLC_TICK_FROM_SEC(5)) {
+        // Status messages are shown for a while, until captions come
+        psz_text = p_sys->current_text;
+        i_stop = date + VLC_TICK_FROM_MS(100);
+    } else {
         vlc_mutex_unlock(&p_sys->text_mutex);
         return NULL;
     }
@@ -570,7 +766,7 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
     }
     
     // Set text
-    p_region->p_text = text_segment_New(p_sys->current_text);
+    p_region->p_text = text_segment_New(psz_text);
     p_region->p_text->style = text_style_Duplicate(p_sys->p_style);
     
     vlc_mutex_unlock(&p_sys->text_mutex);
@@ -583,10 +779,10 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
     
     // Timing
     p_spu->i_start = date;
-    p_spu->i_stop = date + VLC_TICK_FROM_SEC(5);
+    p_spu->i_stop = i_stop;
     p_spu->b_ephemer = true;
     
     vlc_spu_regions_push(&p_spu->regions, p_region);
     
     return p_spu;
-}
\ No newline at end of file
+}
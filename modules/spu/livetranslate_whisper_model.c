@@ -0,0 +1,284 @@
+/*****************************************************************************
+ * livetranslate_whisper_model.c : Shared Whisper models and decoding workers
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_variables.h>
+#include <vlc_threads.h>
+
+#include "livetranslate_whisper_model.h"
+
+struct whisper_job
+{
+    whisper_stream_t *stream;
+    struct whisper_full_params params;
+    int i_ret;
+    bool b_done;
+    struct whisper_job *next;
+};
+
+struct whisper_worker
+{
+    whisper_model_t *model;
+    struct whisper_state *state;
+    vlc_thread_t thread;
+};
+
+struct whisper_model
+{
+    // Registry linkage and reference count, protected by VLC_WHISPER_MUTEX
+    libvlc_int_t *libvlc;
+    struct whisper_model *next;
+    char *path;
+    unsigned refs;
+
+    vlc_object_t *obj;              // for logging
+    vlc_mutex_t lock;
+    vlc_cond_t wait;                // workers wait for jobs
+    vlc_cond_t done;                // clients wait for their job
+    bool b_loaded;
+    struct whisper_context *ctx;    // read-only once loaded
+
+    // Pending jobs, protected by lock
+    struct whisper_job *first;
+    struct whisper_job **last;
+    bool b_closing;
+
+    struct whisper_worker *workers;
+    unsigned i_workers;
+
+    // Statistics, protected by lock
+    uint64_t i_jobs;
+    vlc_tick_t i_busy;
+};
+
+/*****************************************************************************
+ * Workers
+ *****************************************************************************/
+static void *WorkerThread(void *data)
+{
+    struct whisper_worker *worker = data;
+    whisper_model_t *model = worker->model;
+
+    vlc_thread_set_name("vlc-whisper");
+
+    vlc_mutex_lock(&model->lock);
+    for (;;) {
+        while (model->first == NULL && !model->b_closing)
+            vlc_cond_wait(&model->wait, &model->lock);
+        if (model->b_closing)
+            break;
+
+        struct whisper_job *job = model->first;
+        model->first = job->next;
+        if (model->first == NULL)
+            model->last = &model->first;
+        vlc_mutex_unlock(&model->lock);
+
+        // The stream is only touched by us until the job is marked done
+        vlc_tick_t start = vlc_tick_now();
+        job->i_ret = whisper_stream_Decode(job->stream, model->ctx,
+                                           worker->state, job->params);
+
+        vlc_mutex_lock(&model->lock);
+        model->i_jobs++;
+        model->i_busy += vlc_tick_now() - start;
+        job->b_done = true;
+        vlc_cond_broadcast(&model->done);
+    }
+    vlc_mutex_unlock(&model->lock);
+    return NULL;
+}
+
+static void StopWorkers(whisper_model_t *model)
+{
+    vlc_mutex_lock(&model->lock);
+    assert(model->first == NULL);
+    model->b_closing = true;
+    vlc_cond_broadcast(&model->wait);
+    vlc_mutex_unlock(&model->lock);
+
+    for (unsigned i = 0; i < model->i_workers; i++) {
+        vlc_join(model->workers[i].thread, NULL);
+        whisper_free_state(model->workers[i].state);
+    }
+    free(model->workers);
+    model->workers = NULL;
+    model->i_workers = 0;
+}
+
+static void StartWorkers(whisper_model_t *model, unsigned count)
+{
+    model->workers = vlc_alloc(count, sizeof(*model->workers));
+    if (!model->workers)
+        return;
+
+    for (unsigned i = 0; i < count; i++) {
+        struct whisper_worker *worker = &model->workers[model->i_workers];
+
+        // Each worker has its own decoding buffers, the weights are shared
+        worker->model = model;
+        worker->state = whisper_init_state(model->ctx);
+        if (!worker->state) {
+            msg_Warn(model->obj, "cannot allocate Whisper state for worker %u", i);
+            break;
+        }
+        if (vlc_clone(&worker->thread, WorkerThread, worker)) {
+            whisper_free_state(worker->state);
+            break;
+        }
+        model->i_workers++;
+    }
+}
+
+/*****************************************************************************
+ * Registry
+ *****************************************************************************/
+#define REGISTRY_VAR "whisper-models"
+
+static void ModelDelete(whisper_model_t *model)
+{
+    if (model->i_workers > 0)
+        StopWorkers(model);
+    if (model->ctx) {
+        msg_Dbg(model->obj, "unloading Whisper model %s after %"PRIu64
+                " decodes (%"PRId64" ms of work)", model->path, model->i_jobs,
+                MS_FROM_VLC_TICK(model->i_busy));
+        whisper_free(model->ctx);
+    }
+    free(model->path);
+    free(model);
+}
+
+static void ModelUnref(whisper_model_t *model)
+{
+    libvlc_int_t *libvlc = model->libvlc;
+
+    vlc_global_lock(VLC_WHISPER_MUTEX);
+
+    if (--model->refs > 0) {
+        vlc_global_unlock(VLC_WHISPER_MUTEX);
+        return;
+    }
+
+    whisper_model_t *head = var_GetAddress(libvlc, REGISTRY_VAR);
+    if (head == model) {
+        var_SetAddress(libvlc, REGISTRY_VAR, model->next);
+    } else {
+        whisper_model_t *prev = head;
+        while (prev->next != model)
+            prev = prev->next;
+        prev->next = model->next;
+    }
+
+    vlc_global_unlock(VLC_WHISPER_MUTEX);
+
+    ModelDelete(model);
+}
+
+whisper_model_t *whisper_model_Acquire(vlc_object_t *obj, const char *path,
+                                       unsigned workers)
+{
+    libvlc_int_t *libvlc = vlc_object_instance(obj);
+
+    assert(workers > 0);
+
+    vlc_global_lock(VLC_WHISPER_MUTEX);
+
+    /* created once, it lives as long as the instance */
+    if (var_Type(libvlc, REGISTRY_VAR) == 0)
+        var_Create(libvlc, REGISTRY_VAR, VLC_VAR_ADDRESS);
+    whisper_model_t *head = var_GetAddress(libvlc, REGISTRY_VAR);
+
+    whisper_model_t *model;
+    for (model = head; model != NULL; model = model->next)
+        if (!strcmp(model->path, path)) {
+            model->refs++;
+            break;
+        }
+
+    if (!model) {
+        model = calloc(1, sizeof(*model));
+        if (model)
+            model->path = strdup(path);
+        if (model && model->path) {
+            model->libvlc = libvlc;
+            model->refs = 1;
+            model->obj = VLC_OBJECT(libvlc);
+            vlc_mutex_init(&model->lock);
+            vlc_cond_init(&model->wait);
+            vlc_cond_init(&model->done);
+            model->last = &model->first;
+            model->next = head;
+            var_SetAddress(libvlc, REGISTRY_VAR, model);
+        } else {
+            free(model);
+            model = NULL;
+        }
+    }
+
+    vlc_global_unlock(VLC_WHISPER_MUTEX);
+
+    if (!model)
+        return NULL;
+
+    // Loading takes seconds: do not hold the global lock meanwhile, other
+    // users of the same model wait for the first one to load it
+    vlc_mutex_lock(&model->lock);
+    if (!model->b_loaded) {
+        msg_Info(obj, "Loading Whisper model from: %s", path);
+        struct whisper_context_params cparams = whisper_context_default_params();
+        model->ctx = whisper_init_from_file_with_params_no_state(path, cparams);
+        if (model->ctx)
+            StartWorkers(model, workers);
+        model->b_loaded = true;
+    } else
+        msg_Dbg(obj, "Sharing loaded Whisper model %s", path);
+    bool b_usable = model->i_workers > 0;
+    vlc_mutex_unlock(&model->lock);
+
+    if (!b_usable) {
+        msg_Err(obj, "Failed to load Whisper model from %s", path);
+        ModelUnref(model);
+        return NULL;
+    }
+    return model;
+}
+
+void whisper_model_Release(whisper_model_t *model)
+{
+    ModelUnref(model);
+}
+
+/*****************************************************************************
+ * Decoding
+ *****************************************************************************/
+int whisper_model_Decode(whisper_model_t *model, whisper_stream_t *stream,
+                         struct whisper_full_params params)
+{
+    struct whisper_job job = {
+        .stream = stream,
+        .params = params,
+        .b_done = false,
+        .next = NULL,
+    };
+
+    vlc_mutex_lock(&model->lock);
+    *model->last = &job;
+    model->last = &job.next;
+    vlc_cond_signal(&model->wait);
+
+    while (!job.b_done)
+        vlc_cond_wait(&model->done, &model->lock);
+    vlc_mutex_unlock(&model->lock);
+
+    return job.i_ret;
+}
@@ -0,0 +1,47 @@
+/*****************************************************************************
+ * livetranslate_whisper_model.h : Shared Whisper models and decoding workers
+ *****************************************************************************
+ * Whisper models are loaded once per process and shared by all the
+ * transcribers using the same model file. Decoding state is not tied to the
+ * transcribers either: each model owns a bounded pool of worker threads, each
+ * with its own decoding state, that serve the decode requests of all the
+ * transcribers in turn. Memory thus depends on the number of models and
+ * workers, not on the number of transcribed streams.
+ *****************************************************************************/
+
+#ifndef LIVETRANSLATE_WHISPER_MODEL_H
+#define LIVETRANSLATE_WHISPER_MODEL_H
+
+#include <vlc_common.h>
+
+#include <whisper.h>
+
+#include "livetranslate_whisper_stream.h"
+
+typedef struct whisper_model whisper_model_t;
+
+/**
+ * Gets the model loaded from the given file, loading it if needed.
+ *
+ * \param workers number of decoding workers, only used by the first user of
+ * the model
+ * \return the model, to be released with whisper_model_Release(), or NULL if
+ * it cannot be loaded
+ */
+whisper_model_t *whisper_model_Acquire(vlc_object_t *obj, const char *path,
+                                       unsigned workers);
+void whisper_model_Release(whisper_model_t *model);
+
+/**
+ * Runs whisper_stream_Decode() on one of the model workers and waits for it.
+ *
+ * Requests are served in arrival order. As each transcriber waits for its
+ * decode before submitting the next one, busy transcribers are served in
+ * turn and none can starve the others.
+ *
+ * \return 0 on success, -1 on error
+ */
+int whisper_model_Decode(whisper_model_t *model, whisper_stream_t *stream,
+                         struct whisper_full_params params);
+
+#endif /* LIVETRANSLATE_WHISPER_MODEL_H */
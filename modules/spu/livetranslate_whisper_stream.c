@@ -0,0 +1,380 @@
+/*****************************************************************************
+ * livetranslate_whisper_stream.c : Incremental Whisper decoding
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_vector.h>
+
+#include "livetranslate_whisper_stream.h"
+
+// Whisper timestamps are in centiseconds
+#define SAMPLES_PER_CS (WHISPER_SAMPLE_RATE / 100)
+
+// Whisper uses at most n_text_ctx / 2 prompt tokens
+#define PROMPT_MAX 224
+
+struct stream_token
+{
+    whisper_token id;
+    char *text;
+    uint64_t start;
+    uint64_t end;
+    bool eos;       // ends a sentence or a Whisper segment
+};
+
+struct token_vec VLC_VECTOR(struct stream_token);
+struct segment_vec VLC_VECTOR(whisper_stream_segment_t);
+
+struct whisper_stream
+{
+    whisper_stream_cfg_t cfg;
+
+    // Audio window
+    float *window;
+    size_t window_len;
+    uint64_t window_start;
+    bool b_started;
+
+    // Everything before this position has been committed
+    uint64_t committed_end;
+
+    // Last committed tokens, passed as prompt to the next decodes
+    whisper_token prompt[PROMPT_MAX];
+    size_t prompt_len;
+
+    // Tentative tokens from the last decode
+    struct token_vec hyp;
+
+    // Committed text of the segment in progress
+    char *line;
+    size_t line_len;
+    uint64_t line_start;
+
+    // Completed segments, waiting to be popped
+    struct segment_vec segments;
+};
+
+static void TokensClear(struct token_vec *tokens)
+{
+    struct stream_token *token;
+    vlc_vector_foreach_ref(token, tokens)
+        free(token->text);
+    vlc_vector_clear(tokens);
+}
+
+whisper_stream_t *whisper_stream_New(const whisper_stream_cfg_t *cfg)
+{
+    assert(cfg->length > 0 && cfg->keep < cfg->length);
+
+    whisper_stream_t *stream = calloc(1, sizeof(*stream));
+    if (!stream)
+        return NULL;
+
+    stream->cfg = *cfg;
+    stream->window = vlc_alloc(cfg->length, sizeof(float));
+    if (!stream->window) {
+        free(stream);
+        return NULL;
+    }
+
+    vlc_vector_init(&stream->hyp);
+    vlc_vector_init(&stream->segments);
+    return stream;
+}
+
+void whisper_stream_Delete(whisper_stream_t *stream)
+{
+    whisper_stream_segment_t *segment;
+    vlc_vector_foreach_ref(segment, &stream->segments)
+        free(segment->text);
+    vlc_vector_destroy(&stream->segments);
+
+    TokensClear(&stream->hyp);
+    vlc_vector_destroy(&stream->hyp);
+
+    free(stream->line);
+    free(stream->window);
+    free(stream);
+}
+
+/*****************************************************************************
+ * Committed text
+ *****************************************************************************/
+static void EndLine(whisper_stream_t *stream)
+{
+    if (stream->line_len == 0)
+        return;
+
+    const char *text = stream->line;
+    while (*text == ' ')
+        text++;
+
+    if (*text != '\0') {
+        whisper_stream_segment_t segment = {
+            .text = strdup(text),
+            .start = stream->line_start,
+            .end = stream->committed_end,
+        };
+        if (segment.text && !vlc_vector_push(&stream->segments, segment))
+            free(segment.text);
+    }
+
+    stream->line_len = 0;
+}
+
+static void AppendLine(whisper_stream_t *stream, const struct stream_token *token)
+{
+    size_t len = strlen(token->text);
+    char *line = realloc(stream->line, stream->line_len + len + 1);
+    if (!line)
+        return;
+
+    if (stream->line_len == 0)
+        stream->line_start = token->start;
+
+    memcpy(line + stream->line_len, token->text, len + 1);
+    stream->line = line;
+    stream->line_len += len;
+}
+
+static void PromptAppend(whisper_stream_t *stream, whisper_token id)
+{
+    if (stream->prompt_len == PROMPT_MAX) {
+        memmove(stream->prompt, stream->prompt + 1,
+                (PROMPT_MAX - 1) * sizeof(*stream->prompt));
+        stream->prompt_len--;
+    }
+    stream->prompt[stream->prompt_len++] = id;
+}
+
+/* Commits the first count tentative tokens */
+static void Commit(whisper_stream_t *stream, size_t count)
+{
+    assert(count <= stream->hyp.size);
+
+    for (size_t i = 0; i < count; i++) {
+        struct stream_token *token = &stream->hyp.data[i];
+
+        AppendLine(stream, token);
+        PromptAppend(stream, token->id);
+        if (token->end > stream->committed_end)
+            stream->committed_end = token->end;
+        if (token->eos)
+            EndLine(stream);
+        free(token->text);
+    }
+
+    if (count > 0)
+        vlc_vector_remove_slice(&stream->hyp, 0, count);
+}
+
+void whisper_stream_Flush(whisper_stream_t *stream)
+{
+    Commit(stream, stream->hyp.size);
+    EndLine(stream);
+}
+
+void whisper_stream_Reset(whisper_stream_t *stream)
+{
+    whisper_stream_Flush(stream);
+    stream->prompt_len = 0;
+    stream->window_len = 0;
+    stream->b_started = false;
+}
+
+/*****************************************************************************
+ * Audio window
+ *****************************************************************************/
+
+/* Drops the audio before the given position. Tentative tokens lying in the
+ * dropped audio are committed, since they will never be decoded again. */
+static void Trim(whisper_stream_t *stream, uint64_t pos)
+{
+    if (pos <= stream->window_start)
+        return;
+    if (pos > stream->window_start + stream->window_len)
+        pos = stream->window_start + stream->window_len;
+
+    if (pos > stream->committed_end) {
+        size_t count = 0;
+        while (count < stream->hyp.size
+            && (stream->hyp.data[count].start
+                + stream->hyp.data[count].end) / 2 < pos)
+            count++;
+        Commit(stream, count);
+        if (stream->committed_end < pos)
+            stream->committed_end = pos;
+    }
+
+    size_t drop = pos - stream->window_start;
+    memmove(stream->window, stream->window + drop,
+            (stream->window_len - drop) * sizeof(float));
+    stream->window_len -= drop;
+    stream->window_start = pos;
+}
+
+void whisper_stream_Push(whisper_stream_t *stream, uint64_t pos,
+                         const float *samples, size_t count)
+{
+    if (stream->b_started
+     && pos != stream->window_start + stream->window_len)
+        // Discontinuity: what was pending will never be confirmed
+        whisper_stream_Reset(stream);
+
+    if (!stream->b_started) {
+        stream->window_start = stream->committed_end = pos;
+        stream->b_started = true;
+    }
+
+    while (count > 0) {
+        size_t chunk = __MIN(count, stream->cfg.length);
+        if (stream->window_len + chunk > stream->cfg.length)
+            Trim(stream, stream->window_start + stream->window_len + chunk
+                         - stream->cfg.length);
+
+        memcpy(stream->window + stream->window_len, samples,
+               chunk * sizeof(float));
+        stream->window_len += chunk;
+        samples += chunk;
+        count -= chunk;
+    }
+}
+
+/*****************************************************************************
+ * Decoding
+ *****************************************************************************/
+static bool IsSentenceEnd(const char *text)
+{
+    size_t len = strlen(text);
+    return len > 0 && strchr(".?!", text[len - 1]) != NULL;
+}
+
+int whisper_stream_Decode(whisper_stream_t *stream, struct whisper_context *ctx,
+                          struct whisper_state *state,
+                          struct whisper_full_params params)
+{
+    uint64_t window_end = stream->window_start + stream->window_len;
+    if (stream->committed_end >= window_end)
+        return 0; // nothing new to decode
+
+    params.prompt_tokens = stream->prompt_len > 0 ? stream->prompt : NULL;
+    params.prompt_n_tokens = stream->prompt_len;
+    params.no_context = true;
+    params.token_timestamps = true;
+
+    if (whisper_full_with_state(ctx, state, params, stream->window,
+                                (int)stream->window_len) != 0)
+        return -1;
+
+    const whisper_token eot = whisper_token_eot(ctx);
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    struct token_vec hyp;
+    vlc_vector_init(&hyp);
+
+    for (int i = 0; i < n_segments; i++) {
+        const int n_tokens = whisper_full_n_tokens_from_state(state, i);
+        for (int j = 0; j < n_tokens; j++) {
+            whisper_token_data data = whisper_full_get_token_data_from_state(state, i, j);
+            if (data.id >= eot)
+                continue; // special or timestamp token
+
+            struct stream_token token = {
+                .id = data.id,
+                .start = stream->window_start + data.t0 * SAMPLES_PER_CS,
+                .end = stream->window_start + data.t1 * SAMPLES_PER_CS,
+            };
+            if (token.end > window_end)
+                token.end = window_end;
+            if (token.start > token.end)
+                token.start = token.end;
+
+            // Overlap with already committed audio
+            if ((token.start + token.end) / 2 < stream->committed_end)
+                continue;
+
+            token.text = strdup(whisper_full_get_token_text_from_state(ctx, state, i, j));
+            if (!token.text)
+                continue;
+            token.eos = IsSentenceEnd(token.text);
+            if (!vlc_vector_push(&hyp, token))
+                free(token.text);
+        }
+
+        // Whisper segment boundaries are only trusted before the last one
+        if (i + 1 < n_segments && hyp.size > 0)
+            vlc_vector_last_ref(&hyp)->eos = true;
+    }
+
+    // Local agreement: commit the prefix common to the last two decodes
+    size_t agreed = 0;
+    while (agreed < hyp.size && agreed < stream->hyp.size
+        && hyp.data[agreed].id == stream->hyp.data[agreed].id)
+        agreed++;
+
+    TokensClear(&stream->hyp);
+    vlc_vector_destroy(&stream->hyp);
+    stream->hyp = hyp;
+    Commit(stream, agreed);
+
+    // Keep only a short overlap of committed audio as context
+    if (stream->committed_end > stream->window_start + stream->cfg.keep)
+        Trim(stream, stream->committed_end - stream->cfg.keep);
+
+    return 0;
+}
+
+/*****************************************************************************
+ * Output
+ *****************************************************************************/
+bool whisper_stream_PopSegment(whisper_stream_t *stream,
+                               whisper_stream_segment_t *segment)
+{
+    if (stream->segments.size == 0)
+        return false;
+
+    *segment = stream->segments.data[0];
+    vlc_vector_remove(&stream->segments, 0);
+    return true;
+}
+
+char *whisper_stream_GetPartial(const whisper_stream_t *stream,
+                                uint64_t *start)
+{
+    size_t len = stream->line_len;
+    for (size_t i = 0; i < stream->hyp.size; i++)
+        len += strlen(stream->hyp.data[i].text);
+    if (len == 0)
+        return NULL;
+
+    char *text = malloc(len + 1);
+    if (!text)
+        return NULL;
+
+    char *p = text;
+    if (stream->line_len > 0) {
+        memcpy(p, stream->line, stream->line_len);
+        p += stream->line_len;
+        *start = stream->line_start;
+    } else
+        *start = stream->hyp.data[0].start;
+
+    for (size_t i = 0; i < stream->hyp.size; i++) {
+        size_t tlen = strlen(stream->hyp.data[i].text);
+        memcpy(p, stream->hyp.data[i].text, tlen);
+        p += tlen;
+    }
+    *p = '\0';
+
+    // Whisper tokens carry their leading space
+    size_t skip = strspn(text, " ");
+    memmove(text, text + skip, len + 1 - skip);
+    return text;
+}
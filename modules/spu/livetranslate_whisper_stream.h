@@ -0,0 +1,91 @@
+/*****************************************************************************
+ * livetranslate_whisper_stream.h : Incremental Whisper decoding
+ *****************************************************************************
+ * Audio is accumulated in a sliding window that is decoded again every time
+ * a new hop of samples arrives. Tokens on which two consecutive decodes agree
+ * are committed, are passed as prompt to the following decodes and are never
+ * decoded again: committed audio is dropped from the window, except for a
+ * short overlap kept as acoustic context.
+ *
+ * All positions are expressed in samples, in the time base of the audio ring
+ * the samples are read from.
+ *****************************************************************************/
+
+#ifndef LIVETRANSLATE_WHISPER_STREAM_H
+#define LIVETRANSLATE_WHISPER_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <whisper.h>
+
+typedef struct whisper_stream whisper_stream_t;
+
+typedef struct
+{
+    size_t step;    // samples between two decodes
+    size_t length;  // maximum window length, in samples
+    size_t keep;    // committed samples kept at the start of the window
+} whisper_stream_cfg_t;
+
+typedef struct
+{
+    char *text;     // heap allocated, owned by the caller once popped
+    uint64_t start; // position of the first sample of the segment
+    uint64_t end;   // position following the last sample of the segment
+} whisper_stream_segment_t;
+
+whisper_stream_t *whisper_stream_New(const whisper_stream_cfg_t *cfg);
+void whisper_stream_Delete(whisper_stream_t *stream);
+
+/**
+ * Appends samples read at the given position.
+ *
+ * If the position does not follow the previous samples (after an overrun),
+ * the pending text is flushed and decoding starts over from there.
+ */
+void whisper_stream_Push(whisper_stream_t *stream, uint64_t pos,
+                         const float *samples, size_t count);
+
+/**
+ * Decodes the current window and commits the stable tokens.
+ *
+ * The prompt related fields of params are overridden.
+ *
+ * \param state decoding state of ctx, see whisper_init_state()
+ * \return 0 on success, -1 if whisper failed
+ */
+int whisper_stream_Decode(whisper_stream_t *stream, struct whisper_context *ctx,
+                          struct whisper_state *state,
+                          struct whisper_full_params params);
+
+/**
+ * Commits all pending tokens, as if they were stable.
+ */
+void whisper_stream_Flush(whisper_stream_t *stream);
+
+/**
+ * Flushes the pending text and drops the audio window, for instance after a
+ * seek. Decoding restarts from the next pushed samples.
+ */
+void whisper_stream_Reset(whisper_stream_t *stream);
+
+/**
+ * Pops the oldest completed segment.
+ *
+ * \return true if a segment was returned
+ */
+bool whisper_stream_PopSegment(whisper_stream_t *stream,
+                               whisper_stream_segment_t *segment);
+
+/**
+ * Returns the text of the segment in progress: the committed part followed
+ * by the tentative part of the last decode.
+ *
+ * \return a heap allocated string, or NULL if there is no text in progress
+ */
+char *whisper_stream_GetPartial(const whisper_stream_t *stream,
+                                uint64_t *start);
+
+#endif /* LIVETRANSLATE_WHISPER_STREAM_H */
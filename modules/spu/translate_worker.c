@@ -0,0 +1,514 @@
+/*****************************************************************************
+ * translate_worker.c : Persistent caption translation worker
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+#include <vlc_spawn.h>
+#include <vlc_threads.h>
+#include <vlc_vector.h>
+
+#include "translate_worker.h"
+#include "ctranslate2_wrapper.h"
+
+// Requests handed to the backend at once
+#define TRANSLATE_BATCH_MAX 8
+// Longest line exchanged with the helper process
+#define TRANSLATE_LINE_MAX 4096
+
+struct translate_request
+{
+    char *text;
+    char *result;
+    vlc_tick_t deadline;
+    translate_worker_cb cb;
+    void *opaque;
+};
+
+struct request_vec VLC_VECTOR(struct translate_request);
+
+struct translate_backend
+{
+    const char *name;
+    int  (*open)(translate_worker_t *);
+    void (*close)(translate_worker_t *);
+    /* Fills the result of the given requests, leaving NULL on failure */
+    void (*translate)(translate_worker_t *, struct translate_request *, size_t);
+};
+
+struct translate_worker
+{
+    vlc_object_t *obj;
+    translate_worker_cfg_t cfg;
+    char *source_lang;
+    char *target_lang;
+
+    const struct translate_backend *backend;
+    void *backend_sys;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    struct request_vec queue;
+    bool b_closing;
+
+    // Statistics, protected by lock
+    uint64_t i_submitted;
+    uint64_t i_rejected;
+    uint64_t i_expired;
+
+    vlc_thread_t thread;
+};
+
+static void RequestComplete(struct translate_request *req)
+{
+    req->cb(req->opaque, req->result);
+    free(req->text);
+}
+
+/*****************************************************************************
+ * Stub backend: tags the text with the target language, for tests
+ *****************************************************************************/
+static int StubOpen(translate_worker_t *worker)
+{
+    VLC_UNUSED(worker);
+    return VLC_SUCCESS;
+}
+
+static void StubClose(translate_worker_t *worker)
+{
+    VLC_UNUSED(worker);
+}
+
+static void StubTranslate(translate_worker_t *worker,
+                          struct translate_request *reqs, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        if (asprintf(&reqs[i].result, "[%s] %s", worker->target_lang,
+                     reqs[i].text) < 0)
+            reqs[i].result = NULL;
+}
+
+/*****************************************************************************
+ * CTranslate2 backend: the model stays loaded for the worker lifetime
+ *****************************************************************************/
+static int Ct2Open(translate_worker_t *worker)
+{
+    if (!ctranslate2_is_available()) {
+        msg_Warn(worker->obj, "CTranslate2 support not compiled in");
+        return VLC_EGENERIC;
+    }
+    if (!worker->cfg.model_path || !*worker->cfg.model_path)
+        return VLC_EGENERIC;
+
+    msg_Info(worker->obj, "Initializing CTranslate2 with model: %s",
+             worker->cfg.model_path);
+    worker->backend_sys = ctranslate2_init(worker->cfg.model_path, worker->obj);
+    return worker->backend_sys ? VLC_SUCCESS : VLC_EGENERIC;
+}
+
+static void Ct2Close(translate_worker_t *worker)
+{
+    ctranslate2_cleanup(worker->backend_sys);
+}
+
+static void Ct2Translate(translate_worker_t *worker,
+                         struct translate_request *reqs, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        // The model cannot be interrupted, only skip what is already late
+        if (vlc_tick_now() >= reqs[i].deadline)
+            break;
+        reqs[i].result = ctranslate2_translate(worker->backend_sys,
+                                               reqs[i].text,
+                                               worker->source_lang,
+                                               worker->target_lang,
+                                               worker->obj);
+    }
+}
+
+/*****************************************************************************
+ * Process backend: one request line in, one result line out
+ *****************************************************************************/
+struct process_sys
+{
+    char *cmdline;
+    char *langs;
+    char **argv;
+    pid_t pid;
+    int fd_in;   // helper standard input
+    int fd_out;  // helper standard output
+    char buf[TRANSLATE_LINE_MAX];
+    size_t buf_len;
+    vlc_tick_t i_retry; // do not respawn a failing helper before this date
+};
+
+static void ProcessStop(translate_worker_t *worker)
+{
+    struct process_sys *sys = worker->backend_sys;
+
+    if (sys->pid == 0)
+        return;
+
+    kill(sys->pid, SIGTERM);
+    vlc_close(sys->fd_in);
+    vlc_close(sys->fd_out);
+    vlc_waitpid(sys->pid);
+    sys->pid = 0;
+    sys->buf_len = 0;
+}
+
+static int ProcessStart(translate_worker_t *worker)
+{
+    struct process_sys *sys = worker->backend_sys;
+    int in[2], out[2];
+
+    if (vlc_tick_now() < sys->i_retry)
+        return VLC_EGENERIC;
+    sys->i_retry = vlc_tick_now() + VLC_TICK_FROM_SEC(5);
+
+    if (vlc_pipe(in))
+        return VLC_EGENERIC;
+    if (vlc_pipe(out)) {
+        vlc_close(in[0]);
+        vlc_close(in[1]);
+        return VLC_EGENERIC;
+    }
+
+    int fdv[] = { in[0], out[1], -1, -1 };
+    int val = vlc_spawnp(&sys->pid, sys->argv[0], fdv,
+                         (const char *const *)sys->argv);
+    vlc_close(in[0]);
+    vlc_close(out[1]);
+
+    if (val) {
+        msg_Warn(worker->obj, "cannot start %s: %s", sys->argv[0],
+                 vlc_strerror_c(val));
+        vlc_close(in[1]);
+        vlc_close(out[0]);
+        sys->pid = 0;
+        return VLC_EGENERIC;
+    }
+
+    msg_Dbg(worker->obj, "started translation helper %s (pid %d)",
+            sys->argv[0], (int)sys->pid);
+    sys->fd_in = in[1];
+    sys->fd_out = out[0];
+    sys->buf_len = 0;
+    return VLC_SUCCESS;
+}
+
+static int ProcessOpen(translate_worker_t *worker)
+{
+    if (!worker->cfg.command || !*worker->cfg.command)
+        return VLC_EGENERIC;
+
+    struct process_sys *sys = calloc(1, sizeof(*sys));
+    if (!sys)
+        return VLC_ENOMEM;
+
+    // Split the command line on blanks, then append the language pair
+    sys->cmdline = strdup(worker->cfg.command);
+    if (!sys->cmdline ||
+        asprintf(&sys->langs, "%s:%s", worker->source_lang,
+                 worker->target_lang) < 0)
+        sys->langs = NULL;
+    sys->argv = vlc_alloc(strlen(worker->cfg.command) / 2 + 3, sizeof(char *));
+    if (!sys->cmdline || !sys->langs || !sys->argv)
+        goto error;
+
+    size_t argc = 0;
+    char *saveptr;
+    for (char *arg = strtok_r(sys->cmdline, " \t", &saveptr); arg != NULL;
+         arg = strtok_r(NULL, " \t", &saveptr))
+        sys->argv[argc++] = arg;
+    if (argc == 0)
+        goto error;
+    sys->argv[argc++] = sys->langs;
+    sys->argv[argc] = NULL;
+
+    worker->backend_sys = sys;
+    // Start now rather than on the first caption
+    ProcessStart(worker);
+    return VLC_SUCCESS;
+
+error:
+    free(sys->argv);
+    free(sys->langs);
+    free(sys->cmdline);
+    free(sys);
+    return VLC_EGENERIC;
+}
+
+static void ProcessClose(translate_worker_t *worker)
+{
+    struct process_sys *sys = worker->backend_sys;
+
+    ProcessStop(worker);
+    free(sys->argv);
+    free(sys->langs);
+    free(sys->cmdline);
+    free(sys);
+}
+
+static int ProcessWriteLine(struct process_sys *sys, const char *text)
+{
+    size_t len = strlen(text);
+    char *line = malloc(len + 1);
+    if (!line)
+        return VLC_ENOMEM;
+
+    // The protocol is line based: captions are sent on a single line
+    for (size_t i = 0; i < len; i++)
+        line[i] = (text[i] == '\n' || text[i] == '\r') ? ' ' : text[i];
+    line[len] = '\n';
+
+    size_t done = 0;
+    while (done <= len) {
+        ssize_t val = vlc_write(sys->fd_in, line + done, len + 1 - done);
+        if (val < 0) {
+            if (errno == EINTR)
+                continue;
+            free(line);
+            return VLC_EGENERIC;
+        }
+        done += val;
+    }
+    free(line);
+    return VLC_SUCCESS;
+}
+
+static char *ProcessReadLine(struct process_sys *sys, vlc_tick_t deadline)
+{
+    for (;;) {
+        char *eol = memchr(sys->buf, '\n', sys->buf_len);
+        if (eol) {
+            size_t len = eol - sys->buf;
+            while (len > 0 && sys->buf[len - 1] == '\r')
+                len--;
+            char *line = strndup(sys->buf, len);
+            sys->buf_len -= eol + 1 - sys->buf;
+            memmove(sys->buf, eol + 1, sys->buf_len);
+            return line;
+        }
+        if (sys->buf_len == sizeof(sys->buf))
+            return NULL; // line too long, out of sync
+
+        vlc_tick_t delay = deadline - vlc_tick_now();
+        if (delay <= 0)
+            return NULL;
+
+        struct pollfd ufd = { .fd = sys->fd_out, .events = POLLIN };
+        int val = poll(&ufd, 1, MS_FROM_VLC_TICK(delay) + 1);
+        if (val < 0 && errno == EINTR)
+            continue;
+        if (val <= 0)
+            return NULL;
+
+        ssize_t len = read(sys->fd_out, sys->buf + sys->buf_len,
+                           sizeof(sys->buf) - sys->buf_len);
+        if (len < 0 && errno == EINTR)
+            continue;
+        if (len <= 0)
+            return NULL; // helper exited
+        sys->buf_len += len;
+    }
+}
+
+static void ProcessTranslate(translate_worker_t *worker,
+                             struct translate_request *reqs, size_t count)
+{
+    struct process_sys *sys = worker->backend_sys;
+
+    if (sys->pid == 0 && ProcessStart(worker) != VLC_SUCCESS)
+        return;
+
+    // Send the whole batch, then collect the results in order
+    for (size_t i = 0; i < count; i++)
+        if (ProcessWriteLine(sys, reqs[i].text) != VLC_SUCCESS) {
+            msg_Warn(worker->obj, "translation helper stopped reading");
+            ProcessStop(worker);
+            return;
+        }
+
+    for (size_t i = 0; i < count; i++) {
+        reqs[i].result = ProcessReadLine(sys, reqs[i].deadline);
+        if (!reqs[i].result) {
+            // Late results would be matched with the wrong requests
+            msg_Warn(worker->obj, "translation helper timed out, restarting");
+            ProcessStop(worker);
+            return;
+        }
+    }
+}
+
+static const struct translate_backend backends[] = {
+    { "ctranslate2", Ct2Open, Ct2Close, Ct2Translate },
+    { "process", ProcessOpen, ProcessClose, ProcessTranslate },
+    { "stub", StubOpen, StubClose, StubTranslate },
+};
+
+/*****************************************************************************
+ * Worker
+ *****************************************************************************/
+static void *Thread(void *data)
+{
+    translate_worker_t *worker = data;
+    struct translate_request batch[TRANSLATE_BATCH_MAX];
+
+    vlc_thread_set_name("vlc-translate");
+
+    vlc_mutex_lock(&worker->lock);
+    for (;;) {
+        while (worker->queue.size == 0 && !worker->b_closing)
+            vlc_cond_wait(&worker->wait, &worker->lock);
+        if (worker->b_closing)
+            break;
+
+        size_t count = __MIN(worker->queue.size, TRANSLATE_BATCH_MAX);
+        memcpy(batch, worker->queue.data, count * sizeof(*batch));
+        vlc_vector_remove_slice(&worker->queue, 0, count);
+        vlc_mutex_unlock(&worker->lock);
+
+        // Requests that waited too long in the queue are not worth the work
+        vlc_tick_t now = vlc_tick_now();
+        size_t expired = 0;
+        while (expired < count && batch[expired].deadline <= now)
+            expired++;
+
+        worker->backend->translate(worker, batch + expired, count - expired);
+
+        size_t failed = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (!batch[i].result)
+                failed++;
+            RequestComplete(&batch[i]);
+        }
+
+        vlc_mutex_lock(&worker->lock);
+        worker->i_expired += failed;
+    }
+
+    // Cancel what is left
+    struct translate_request *req;
+    vlc_vector_foreach_ref(req, &worker->queue)
+        RequestComplete(req);
+    vlc_vector_clear(&worker->queue);
+    vlc_mutex_unlock(&worker->lock);
+    return NULL;
+}
+
+translate_worker_t *translate_worker_New(vlc_object_t *obj,
+                                         const translate_worker_cfg_t *cfg)
+{
+    assert(cfg->queue_size > 0 && cfg->target_lang != NULL);
+
+    translate_worker_t *worker = calloc(1, sizeof(*worker));
+    if (!worker)
+        return NULL;
+
+    worker->obj = obj;
+    worker->cfg = *cfg;
+    worker->source_lang = strdup(cfg->source_lang ? cfg->source_lang : "en");
+    worker->target_lang = strdup(cfg->target_lang);
+    if (!worker->source_lang || !worker->target_lang)
+        goto error;
+
+    // "auto" prefers the in-process model, then the helper process, and
+    // never picks the stub
+    bool b_auto = !cfg->backend || !strcmp(cfg->backend, "auto");
+    for (size_t i = 0; i < ARRAY_SIZE(backends); i++) {
+        if (b_auto ? !strcmp(backends[i].name, "stub")
+                   : strcmp(backends[i].name, cfg->backend))
+            continue;
+        if (backends[i].open(worker) == VLC_SUCCESS) {
+            worker->backend = &backends[i];
+            break;
+        }
+    }
+    if (!worker->backend) {
+        msg_Warn(obj, "no translation backend available");
+        goto error;
+    }
+    msg_Info(obj, "Translating to %s using the %s backend",
+             worker->target_lang, worker->backend->name);
+
+    vlc_mutex_init(&worker->lock);
+    vlc_cond_init(&worker->wait);
+    vlc_vector_init(&worker->queue);
+
+    if (vlc_clone(&worker->thread, Thread, worker)) {
+        worker->backend->close(worker);
+        vlc_vector_destroy(&worker->queue);
+        goto error;
+    }
+    return worker;
+
+error:
+    free(worker->source_lang);
+    free(worker->target_lang);
+    free(worker);
+    return NULL;
+}
+
+void translate_worker_Delete(translate_worker_t *worker)
+{
+    vlc_mutex_lock(&worker->lock);
+    worker->b_closing = true;
+    vlc_cond_signal(&worker->wait);
+    vlc_mutex_unlock(&worker->lock);
+
+    vlc_join(worker->thread, NULL);
+
+    msg_Dbg(worker->obj, "%"PRIu64" translations requested, %"PRIu64
+            " rejected, %"PRIu64" failed or late", worker->i_submitted,
+            worker->i_rejected, worker->i_expired);
+
+    worker->backend->close(worker);
+    vlc_vector_destroy(&worker->queue);
+    free(worker->source_lang);
+    free(worker->target_lang);
+    free(worker);
+}
+
+int translate_worker_Submit(translate_worker_t *worker, const char *text,
+                            translate_worker_cb cb, void *opaque)
+{
+    struct translate_request req = {
+        .text = strdup(text),
+        .deadline = vlc_tick_now() + worker->cfg.timeout,
+        .cb = cb,
+        .opaque = opaque,
+    };
+    if (!req.text)
+        return VLC_ENOMEM;
+
+    int ret = VLC_SUCCESS;
+    vlc_mutex_lock(&worker->lock);
+    if (worker->queue.size >= worker->cfg.queue_size) {
+        // Back-pressure: never make the caller wait for the backend
+        worker->i_rejected++;
+        ret = VLC_EGENERIC;
+    } else if (!vlc_vector_push(&worker->queue, req))
+        ret = VLC_ENOMEM;
+    else {
+        worker->i_submitted++;
+        vlc_cond_signal(&worker->wait);
+    }
+    vlc_mutex_unlock(&worker->lock);
+
+    if (ret != VLC_SUCCESS)
+        free(req.text);
+    return ret;
+}
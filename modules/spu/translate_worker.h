@@ -0,0 +1,61 @@
+/*****************************************************************************
+ * translate_worker.h : Persistent caption translation worker
+ *****************************************************************************
+ * Captions are translated by a long-lived backend, fed by a background
+ * thread from a bounded request queue:
+ *  - "ctranslate2" keeps a CTranslate2 model loaded in-process,
+ *  - "process" keeps a helper process running and exchanges one line per
+ *    caption over its standard input and output,
+ *  - "stub" tags the text with the target language, for tests only: it is
+ *    not offered to users.
+ *
+ * Requests are never blocking: when the queue is full, submission fails and
+ * the caller shows the original text instead.
+ *****************************************************************************/
+
+#ifndef TRANSLATE_WORKER_H
+#define TRANSLATE_WORKER_H
+
+#include <vlc_common.h>
+#include <vlc_tick.h>
+
+typedef struct translate_worker translate_worker_t;
+
+typedef struct
+{
+    const char *backend;     // "auto", "ctranslate2", "process" or "stub"
+    const char *model_path;  // CTranslate2 model directory
+    const char *command;     // helper command line, the language pair
+                             // (e.g. "en:fr") is appended as last argument
+    const char *source_lang;
+    const char *target_lang;
+    size_t queue_size;       // maximum number of pending requests
+    vlc_tick_t timeout;      // maximum delay between submission and result
+} translate_worker_cfg_t;
+
+/**
+ * Called from the worker thread once a request is done.
+ *
+ * \param result heap allocated translation, owned by the callee, or NULL if
+ * the translation failed, timed out or was cancelled
+ */
+typedef void (*translate_worker_cb)(void *opaque, char *result);
+
+translate_worker_t *translate_worker_New(vlc_object_t *obj,
+                                         const translate_worker_cfg_t *cfg);
+
+/**
+ * Stops the worker. Pending requests are completed with a NULL result.
+ */
+void translate_worker_Delete(translate_worker_t *worker);
+
+/**
+ * Queues a translation request.
+ *
+ * \return VLC_SUCCESS if cb will be called, VLC_ENOMEM, or VLC_EGENERIC if
+ * the queue is full
+ */
+int translate_worker_Submit(translate_worker_t *worker, const char *text,
+                            translate_worker_cb cb, void *opaque);
+
+#endif /* TRANSLATE_WORKER_H */
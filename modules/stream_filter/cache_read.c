@@ -495,6 +495,11 @@ static int Open(vlc_object_t *obj)
     if (s->s->pf_read == NULL && s->s->pf_block == NULL)
         return VLC_EGENERIC;
 
+    /* Seekable block sources, such as memory mapped files, deliver their
+     * data without copies, which caching would defeat. */
+    if (s->s->pf_block != NULL && vlc_stream_CanFastSeek(s->s))
+        return VLC_EGENERIC;
+
     stream_sys_t *sys = malloc(sizeof (*sys));
     if (unlikely(sys == NULL))
         return VLC_ENOMEM;
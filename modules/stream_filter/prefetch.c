@@ -34,6 +34,14 @@
 #include <vlc_stream.h>
 #include <vlc_fs.h>
 #include <vlc_interrupt.h>
+#include <vlc_url.h>
+
+#include "prefetch_uring.h"
+
+/* period of the consumption rate measurements */
+#define PREFETCH_PERIOD VLC_TICK_FROM_MS(500)
+/* smallest adaptive read-ahead window */
+#define PREFETCH_WINDOW_MIN (256 << 10)
 
 struct stream_ctrl
 {
@@ -76,9 +84,40 @@ typedef struct
     char        *buffer;
     size_t       seek_threshold;
 
+    /* Adaptive read-ahead: the window of unread data follows the
+     * consumption rate times the access latency, and the buffer follows
+     * the window, up to buffer_max. */
+    bool         adaptive;
+    bool         seeking;
+    size_t       buffer_max;
+    size_t       window;
+    size_t       seek_threshold_min;
+    uint64_t     rate;           /* consumption, bytes per second */
+    uint64_t     rate_bytes;
+    vlc_tick_t   rate_date;
+    uint64_t     bandwidth;      /* upstream, bytes per second */
+    uint64_t     read_bytes;
+    vlc_tick_t   read_time;
+    vlc_tick_t   latency;        /* decaying peak of the access delays */
+    uint64_t     stalls;
+    unsigned     period_stalls;
+
+    /* last values reported to the input statistics */
+    bool         report;
+    size_t       report_window;
+    uint64_t     report_stalls;
+
     struct stream_ctrl *controls;
+
+    uring_reader_t *uring; /* local file read through io_uring */
 } stream_sys_t;
 
+static void ThreadDelay(stream_sys_t *sys, vlc_tick_t delay)
+{
+    if (delay > sys->latency)
+        sys->latency = delay;
+}
+
 static ssize_t ThreadRead(stream_t *stream, void *buf, size_t length)
 {
     stream_sys_t *sys = stream->p_sys;
@@ -86,9 +125,17 @@ static ssize_t ThreadRead(stream_t *stream, void *buf, size_t length)
     vlc_mutex_unlock(&sys->lock);
     assert(length > 0);
 
+    vlc_tick_t start = vlc_tick_now();
     ssize_t val = vlc_stream_ReadPartial(stream->s, buf, length);
+    vlc_tick_t delay = vlc_tick_now() - start;
 
     vlc_mutex_lock(&sys->lock);
+    if (val > 0)
+    {
+        ThreadDelay(sys, delay);
+        sys->read_bytes += val;
+        sys->read_time += delay;
+    }
     return val;
 }
 
@@ -98,12 +145,19 @@ static int ThreadSeek(stream_t *stream, uint64_t seek_offset)
 
     vlc_mutex_unlock(&sys->lock);
 
+    vlc_tick_t start = vlc_tick_now();
     int val = vlc_stream_Seek(stream->s, seek_offset);
+    vlc_tick_t delay = vlc_tick_now() - start;
     if (val != VLC_SUCCESS)
         msg_Err(stream, "cannot seek (to offset %"PRIu64")", seek_offset);
 
     vlc_mutex_lock(&sys->lock);
 
+    if (val == VLC_SUCCESS && sys->adaptive)
+    {   /* start over with a small window, it regrows with the rate */
+        ThreadDelay(sys, delay);
+        sys->window = __MIN(PREFETCH_WINDOW_MIN, sys->buffer_max);
+    }
     return (val == VLC_SUCCESS) ? 0 : -1;
 }
 
@@ -124,6 +178,45 @@ static int ThreadControl(stream_t *stream, int query, ...)
     return ret;
 }
 
+/* Moves the buffered data to a buffer of another size, dropping the oldest
+ * history if it does not fit. */
+static void ThreadResize(stream_t *stream, size_t size)
+{
+    stream_sys_t *sys = stream->p_sys;
+    char *buffer = malloc(size);
+    if (unlikely(buffer == NULL))
+    {   /* keep the current buffer, with a fixed window */
+        sys->adaptive = false;
+        sys->buffer_max = sys->window = sys->buffer_size;
+        return;
+    }
+
+    if (sys->buffer_length > size)
+    {
+        sys->buffer_offset += sys->buffer_length - size;
+        sys->buffer_length = size;
+    }
+
+    for (size_t done = 0; done < sys->buffer_length;)
+    {
+        uint64_t pos = sys->buffer_offset + done;
+        size_t from = pos % sys->buffer_size;
+        size_t to = pos % size;
+        size_t len = sys->buffer_length - done;
+
+        if (len > sys->buffer_size - from)
+            len = sys->buffer_size - from;
+        if (len > size - to)
+            len = size - to;
+        memcpy(buffer + to, sys->buffer + from, len);
+        done += len;
+    }
+
+    free(sys->buffer);
+    sys->buffer = buffer;
+    sys->buffer_size = size;
+}
+
 static void *Thread(void *data)
 {
     vlc_thread_set_name("vlc-prefetch");
@@ -148,6 +241,18 @@ static void *Thread(void *data)
             continue;
         }
 
+        if (sys->report && (sys->report_window != sys->window
+                         || sys->report_stalls != sys->stalls))
+        {   /* Tell the input statistics */
+            sys->report_window = sys->window;
+            sys->report_stalls = sys->stalls;
+            if (ThreadControl(stream, STREAM_SET_PREFETCH_STATS,
+                              (uint64_t)sys->report_window,
+                              sys->report_stalls) != VLC_SUCCESS)
+                sys->report = false;
+            continue;
+        }
+
         if (sys->paused != paused)
         {   /* Update pause state */
             msg_Dbg(stream, paused ? "resuming" : "pausing");
@@ -221,6 +326,30 @@ static void *Thread(void *data)
             continue;
         }
 
+        if (sys->adaptive)
+        {
+            size_t unread = history < sys->buffer_length
+                          ? sys->buffer_length - history : 0;
+            /* as much room for history as for the window */
+            size_t size = __MAX(2 * sys->window, PREFETCH_WINDOW_MIN);
+            if (size > sys->buffer_max)
+                size = sys->buffer_max;
+
+            if ((size > sys->buffer_size || size * 4 <= sys->buffer_size)
+             && unread <= size)
+            {
+                msg_Dbg(stream, "resizing buffer to %zu bytes", size);
+                ThreadResize(stream, size);
+                continue;
+            }
+
+            if (unread >= sys->window)
+            {   /* Enough read ahead */
+                vlc_cond_wait(&sys->wait_space, &sys->lock);
+                continue;
+            }
+        }
+
         assert(sys->buffer_size >= sys->buffer_length);
 
         size_t len = sys->buffer_size - sys->buffer_length;
@@ -274,6 +403,9 @@ static int Seek(stream_t *stream, uint64_t offset)
     stream_sys_t *sys = stream->p_sys;
 
     vlc_mutex_lock(&sys->lock);
+    if (offset < sys->buffer_offset
+     || offset > sys->buffer_offset + sys->buffer_length)
+        sys->seeking = true; /* waiting for data is expected */
     sys->stream_offset = offset;
     sys->error = false;
     vlc_cond_signal(&sys->wait_space);
@@ -297,6 +429,57 @@ static size_t BufferLevel(const stream_t *stream, bool *eof)
     return sys->buffer_offset + sys->buffer_length - sys->stream_offset;
 }
 
+/* Sizes the read-ahead window from the bandwidth-delay product, every
+ * period of consumption. */
+static void UpdateWindow(stream_t *stream, size_t consumed)
+{
+    stream_sys_t *sys = stream->p_sys;
+    vlc_tick_t now = vlc_tick_now();
+
+    if (sys->rate_date == VLC_TICK_INVALID)
+    {
+        sys->rate_date = now;
+        sys->rate_bytes = 0;
+        return;
+    }
+
+    sys->rate_bytes += consumed;
+    vlc_tick_t elapsed = now - sys->rate_date;
+    if (elapsed < PREFETCH_PERIOD)
+        return;
+
+    uint64_t rate = sys->rate_bytes * CLOCK_FREQ / elapsed;
+    sys->rate = sys->rate ? (3 * sys->rate + rate) / 4 : rate;
+    sys->rate_date = now;
+    sys->rate_bytes = 0;
+
+    if (sys->read_time > 0)
+    {
+        sys->bandwidth = sys->read_bytes * CLOCK_FREQ / sys->read_time;
+        sys->read_bytes = 0;
+        sys->read_time = 0;
+    }
+
+    /* Room for the latency to double, and for one more period */
+    uint64_t window = sys->rate * (2 * sys->latency + PREFETCH_PERIOD)
+                    / CLOCK_FREQ;
+    if (sys->period_stalls > 0 && window < 2 * (uint64_t)sys->window)
+        window = 2 * (uint64_t)sys->window; /* too late, grow faster */
+    if (window < PREFETCH_WINDOW_MIN)
+        window = PREFETCH_WINDOW_MIN;
+    if (window > sys->buffer_max)
+        window = sys->buffer_max;
+    sys->window = window;
+    sys->period_stalls = 0;
+
+    /* Skipping forward by reading is cheaper than seeking, as long as it
+     * takes less than the access latency */
+    uint64_t threshold = sys->bandwidth * sys->latency / CLOCK_FREQ;
+    sys->seek_threshold = __MAX(threshold, sys->seek_threshold_min);
+
+    sys->latency -= sys->latency / 8;
+}
+
 static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
 {
     stream_sys_t *sys = stream->p_sys;
@@ -324,6 +507,13 @@ static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
             return 0;
         }
 
+        if (!sys->seeking)
+        {   /* The read-ahead did not keep up */
+            sys->seeking = true;
+            sys->stalls++;
+            sys->period_stalls++;
+        }
+
         vlc_interrupt_forward_start(sys->interrupt, data);
         vlc_cond_wait(&sys->wait_data, &sys->lock);
         vlc_interrupt_forward_stop(data);
@@ -338,11 +528,33 @@ static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
 
     memcpy(buf, sys->buffer + offset, copy);
     sys->stream_offset += copy;
+    sys->seeking = false;
+    if (sys->adaptive)
+        UpdateWindow(stream, copy);
     vlc_cond_signal(&sys->wait_space);
     vlc_mutex_unlock(&sys->lock);
     return copy;
 }
 
+static ssize_t UringRead(stream_t *stream, void *buf, size_t buflen)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    ssize_t val = uring_reader_Read(sys->uring, sys->stream_offset,
+                                    buf, buflen);
+    if (val > 0)
+        sys->stream_offset += val;
+    return val;
+}
+
+static int UringSeek(stream_t *stream, uint64_t offset)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    sys->stream_offset = offset;
+    return 0;
+}
+
 static int Control(stream_t *stream, int query, va_list args)
 {
     stream_sys_t *sys = stream->p_sys;
@@ -394,6 +606,7 @@ static int Control(stream_t *stream, int query, va_list args)
 
             vlc_mutex_lock(&sys->lock);
             sys->paused = paused;
+            sys->rate_date = VLC_TICK_INVALID; /* restart measuring */
             vlc_cond_signal(&sys->wait_space);
             vlc_mutex_unlock (&sys->lock);
             break;
@@ -420,6 +633,7 @@ static int Control(stream_t *stream, int query, va_list args)
         }
         case STREAM_SET_PRIVATE_ID_CA:
         case STREAM_GET_PRIVATE_ID_STATE:
+        case STREAM_SET_PREFETCH_STATS:
             return VLC_EGENERIC;
         default:
             msg_Err(stream, "unimplemented query (%d) in control", query);
@@ -432,11 +646,17 @@ static int Open(vlc_object_t *obj)
 {
     stream_t *stream = (stream_t *)obj;
 
+    /* Local files can be read ahead with io_uring, several reads at once,
+     * when asked for. */
+    bool uring = var_InheritBool(obj, "prefetch-uring") &&
+                 stream->psz_url != NULL &&
+                 !strncmp(stream->psz_url, "file:", 5);
+
     /* For local files, the operating system is likely to do a better work at
      * caching/prefetching. Also, prefetching with this module could cause
      * undesirable high load at start-up. Lastly, local files may require
      * support for title/seekpoint and meta control requests. */
-    if (vlc_stream_CanFastSeek(stream->s))
+    if (!uring && vlc_stream_CanFastSeek(stream->s))
         return VLC_EGENERIC;
 
     /* PID-filtered streams are not suitable for prefetching, as they would
@@ -473,6 +693,26 @@ static int Open(vlc_object_t *obj)
     sys->buffer_size = var_InheritInteger(obj, "prefetch-buffer-size") << 10u;
     sys->seek_threshold = var_InheritInteger(obj, "prefetch-seek-threshold");
     sys->controls = NULL;
+    sys->adaptive = var_InheritBool(obj, "prefetch-adaptive");
+    sys->seeking = true;
+    sys->seek_threshold_min = sys->seek_threshold;
+    sys->rate = 0;
+    sys->rate_bytes = 0;
+    sys->rate_date = VLC_TICK_INVALID;
+    sys->bandwidth = 0;
+    sys->read_bytes = 0;
+    sys->read_time = 0;
+    sys->latency = 0;
+    sys->stalls = 0;
+    sys->period_stalls = 0;
+    sys->report = true;
+    sys->report_window = 0;
+    sys->report_stalls = 0;
+    sys->uring = NULL;
+
+    vlc_mutex_init(&sys->lock);
+    vlc_cond_init(&sys->wait_data);
+    vlc_cond_init(&sys->wait_space);
 
     uint64_t size = stream_Size(stream->s);
     if (size > 0)
@@ -481,6 +721,34 @@ static int Open(vlc_object_t *obj)
             sys->buffer_size = size;
     }
 
+    sys->buffer_max = sys->buffer_size;
+    sys->window = sys->buffer_size;
+    if (sys->adaptive)
+    {   /* start small, the window grows with the measured rate */
+        sys->window = __MIN(PREFETCH_WINDOW_MIN, sys->buffer_max);
+        sys->buffer_size = __MIN(2 * sys->window, sys->buffer_max);
+    }
+
+    if (uring)
+    {
+        char *path = vlc_uri2path(stream->psz_url);
+        if (path != NULL)
+        {
+            sys->uring = uring_reader_New(obj, path, sys->buffer_max);
+            free(path);
+        }
+        if (sys->uring != NULL)
+        {
+            sys->buffer = NULL;
+            stream->p_sys = sys;
+            stream->pf_read = UringRead;
+            stream->pf_seek = UringSeek;
+            stream->pf_control = Control;
+            return VLC_SUCCESS;
+        }
+        msg_Dbg(stream, "falling back to the prefetch thread");
+    }
+
     sys->buffer = malloc(sys->buffer_size);
     if (sys->buffer == NULL)
         goto error;
@@ -489,10 +757,6 @@ static int Open(vlc_object_t *obj)
     if (unlikely(sys->interrupt == NULL))
         goto error;
 
-    vlc_mutex_init(&sys->lock);
-    vlc_cond_init(&sys->wait_data);
-    vlc_cond_init(&sys->wait_space);
-
     stream->p_sys = sys;
 
     if (vlc_clone(&sys->thread, Thread, stream))
@@ -501,7 +765,10 @@ static int Open(vlc_object_t *obj)
         goto error;
     }
 
-    msg_Dbg(stream, "using %zu bytes buffer", sys->buffer_size);
+    if (sys->adaptive)
+        msg_Dbg(stream, "using up to %zu bytes buffer", sys->buffer_max);
+    else
+        msg_Dbg(stream, "using %zu bytes buffer", sys->buffer_size);
     stream->pf_read = Read;
     stream->pf_seek = Seek;
     stream->pf_control = Control;
@@ -523,6 +790,12 @@ static void Close (vlc_object_t *obj)
     stream_t *stream = (stream_t *)obj;
     stream_sys_t *sys = stream->p_sys;
 
+    if (sys->uring != NULL)
+    {
+        uring_reader_Delete(sys->uring);
+        goto out;
+    }
+
     vlc_mutex_lock(&sys->lock);
     vlc_interrupt_kill(sys->interrupt);
     vlc_cond_signal(&sys->wait_space);
@@ -531,6 +804,7 @@ static void Close (vlc_object_t *obj)
     vlc_join(sys->thread, NULL);
     vlc_interrupt_destroy(sys->interrupt);
 
+out:
     while(sys->controls)
     {
         struct stream_ctrl *ctrl = sys->controls;
@@ -556,4 +830,12 @@ vlc_module_begin()
     add_integer("prefetch-seek-threshold", 1 << 14, N_("Seek threshold"),
                 N_("Prefetch forward seek threshold (bytes)"))
         change_integer_range(0, UINT64_C(1) << 60)
+    add_bool("prefetch-adaptive", true, N_("Adaptive read-ahead"),
+             N_("Size the read-ahead from the measured bitrate and access "
+                "latency, up to the buffer size."))
+    add_bool("prefetch-uring", false, N_("Read local files with io_uring"),
+             N_("Read local files ahead with several asynchronous reads "
+                "(Linux only). The prefetch thread is used otherwise. "
+                "This filter is not probed for local files, so this only "
+                "applies with --stream-filter=prefetch."))
 vlc_module_end()
@@ -0,0 +1,694 @@
+/*****************************************************************************
+ * prefetch_uring.c: io_uring read-ahead for the prefetch module
+ *****************************************************************************
+ * Copyright (C) 2025 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+#include <vlc_threads.h>
+
+#include "prefetch_uring.h"
+
+#if defined(HAVE_LINUX_IO_URING_H)
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <sys/syscall.h>
+# include <sys/uio.h>
+# include <linux/io_uring.h>
+#endif
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup)
+
+#define URING_ENTRIES      256
+#define URING_BUFFERS      64         /* registered buffers, one per reader */
+#define URING_SLOT_SIZE    (256 * 1024)
+#define URING_MAX_INFLIGHT 4          /* reads in flight per reader */
+#define URING_RETRY_DELAY  VLC_TICK_FROM_MS(20)  /* left over submissions */
+#define URING_MAX_BACKOFF  VLC_TICK_FROM_MS(100) /* failing ring waits */
+
+/* One ring and one completion thread for the whole process */
+typedef struct
+{
+    int fd;
+    unsigned i_refs;
+    vlc_thread_t thread;
+
+    vlc_mutex_t lock; /* submission queue and buffer table */
+    unsigned *p_sq_head;
+    unsigned *p_sq_tail;
+    unsigned *p_sq_array;
+    unsigned i_sq_mask;
+    unsigned i_sq_entries;
+    struct io_uring_sqe *p_sqes;
+    unsigned i_sq_pending;
+
+    unsigned *p_cq_head;
+    unsigned *p_cq_tail;
+    unsigned i_cq_mask;
+    struct io_uring_cqe *p_cqes;
+
+    void *p_sq_ring;
+    size_t i_sq_ring_size;
+    void *p_cq_ring;
+    size_t i_cq_ring_size;
+    size_t i_sqes_size;
+
+    bool b_fixed; /* sparse buffer table registered */
+    bool buffers_used[URING_BUFFERS];
+} uring_engine_t;
+
+static vlc_mutex_t engine_lock = VLC_STATIC_MUTEX;
+static uring_engine_t *engine;
+
+typedef struct
+{
+    uring_reader_t *p_reader;
+    uint8_t *p_data;
+    uint64_t i_offset;
+    size_t i_length; /* bytes read, once ready */
+    unsigned i_generation;
+    bool b_inflight;
+    bool b_ready;
+} uring_slot_t;
+
+struct uring_reader_t
+{
+    vlc_object_t *p_obj;
+    uring_engine_t *p_engine;
+    int fd;
+    int i_buffer; /* registered buffer index, or -1 for plain reads */
+    uint8_t *p_buffer;
+    size_t i_buffer_size;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait; /* slot completed */
+    /* Slots map the file from i_origin onwards, round robin. Repositioning
+     * bumps the generation, completions of older reads are then ignored. */
+    unsigned i_generation;
+    uint64_t i_origin;
+    uint64_t i_consumed; /* stream position */
+    uint64_t i_fill;     /* offset of the next read to submit */
+    uint64_t i_eof;
+    int i_error;
+    unsigned i_inflight;
+    unsigned i_slots;
+    uring_slot_t slots[];
+};
+
+static int Setup( unsigned i_entries, struct io_uring_params *p_params )
+{
+    return syscall( __NR_io_uring_setup, i_entries, p_params );
+}
+
+static int Enter( int fd, unsigned i_submit, unsigned i_wait, unsigned i_flags )
+{
+    return syscall( __NR_io_uring_enter, fd, i_submit, i_wait, i_flags,
+                    NULL, 0 );
+}
+
+static int Register( int fd, unsigned i_opcode, const void *p_arg, unsigned i_args )
+{
+    return syscall( __NR_io_uring_register, fd, i_opcode, p_arg, i_args );
+}
+
+/* The engine lock must be held */
+static struct io_uring_sqe * GetSqe( uring_engine_t *e )
+{
+    unsigned i_tail = *e->p_sq_tail + e->i_sq_pending;
+    unsigned i_head = __atomic_load_n( e->p_sq_head, __ATOMIC_ACQUIRE );
+    if( i_tail - i_head >= e->i_sq_entries )
+        return NULL;
+
+    unsigned i_index = i_tail & e->i_sq_mask;
+    struct io_uring_sqe *p_sqe = &e->p_sqes[i_index];
+    memset( p_sqe, 0, sizeof(*p_sqe) );
+    e->p_sq_array[i_index] = i_index;
+    e->i_sq_pending++;
+    return p_sqe;
+}
+
+/* The engine lock must be held */
+static void Submit( uring_engine_t *e )
+{
+    unsigned i_tail = *e->p_sq_tail + e->i_sq_pending;
+    if( e->i_sq_pending > 0 )
+    {
+        __atomic_store_n( e->p_sq_tail, i_tail, __ATOMIC_RELEASE );
+        e->i_sq_pending = 0;
+    }
+
+    /* also retries the entries a previous call left over, when the kernel
+     * was out of memory (EAGAIN) or of completion room (EBUSY) */
+    unsigned i_head = __atomic_load_n( e->p_sq_head, __ATOMIC_ACQUIRE );
+    if( i_tail == i_head )
+        return;
+    while( Enter( e->fd, i_tail - i_head, 0, 0 ) < 0 && errno == EINTR );
+}
+
+static void Refill( uring_reader_t * );
+
+static void Complete( uring_slot_t *s, int32_t i_res )
+{
+    uring_reader_t *r = s->p_reader;
+
+    vlc_mutex_lock( &r->lock );
+    assert( r->i_inflight > 0 );
+    s->b_inflight = false;
+    r->i_inflight--;
+
+    if( s->i_generation == r->i_generation )
+    {
+        if( i_res == -EAGAIN || i_res == -EINTR )
+        {
+            /* read that slot again */
+            r->i_fill = s->i_offset;
+        }
+        else if( i_res < 0 )
+        {
+            r->i_error = -i_res;
+        }
+        else
+        {
+            s->i_length = i_res;
+            s->b_ready = true;
+            if( (size_t) i_res < URING_SLOT_SIZE && s->i_offset + i_res < r->i_eof )
+                r->i_eof = s->i_offset + i_res;
+        }
+        Refill( r );
+    }
+
+    vlc_cond_broadcast( &r->wait );
+    vlc_mutex_unlock( &r->lock );
+}
+
+static void *Run( void *data )
+{
+    uring_engine_t *e = data;
+    bool b_quit = false;
+    vlc_tick_t i_backoff = 0;
+
+    vlc_thread_set_name( "vlc-prefetch-io" );
+
+    while( !b_quit )
+    {
+        unsigned i_head = *e->p_cq_head;
+        unsigned i_tail = __atomic_load_n( e->p_cq_tail, __ATOMIC_ACQUIRE );
+
+        if( i_head == i_tail )
+        {
+            /* errors are transient (EAGAIN, EBUSY), but do not spin while
+             * they last */
+            if( Enter( e->fd, 0, 1, IORING_ENTER_GETEVENTS ) < 0 &&
+                errno != EINTR )
+            {
+                i_backoff = i_backoff ? __MIN( 2 * i_backoff, URING_MAX_BACKOFF )
+                                      : VLC_TICK_FROM_MS(1);
+                vlc_tick_sleep( i_backoff );
+            }
+            else
+                i_backoff = 0;
+            continue;
+        }
+
+        while( i_head != i_tail )
+        {
+            const struct io_uring_cqe *p_cqe = &e->p_cqes[i_head & e->i_cq_mask];
+            uint64_t i_data = p_cqe->user_data;
+            int32_t i_res = p_cqe->res;
+
+            __atomic_store_n( e->p_cq_head, ++i_head, __ATOMIC_RELEASE );
+
+            if( i_data == 0 )
+                b_quit = true;
+            else
+                Complete( (uring_slot_t *)(uintptr_t) i_data, i_res );
+        }
+    }
+    return NULL;
+}
+
+static bool Probe( vlc_object_t *p_obj, int fd )
+{
+    const unsigned i_ops = 256;
+    struct io_uring_probe *p_probe =
+        calloc( 1, sizeof(*p_probe) + i_ops * sizeof(struct io_uring_probe_op) );
+    if( unlikely(p_probe == NULL) )
+        return false;
+
+    bool b_ok = Register( fd, IORING_REGISTER_PROBE, p_probe, i_ops ) == 0 &&
+                p_probe->last_op >= IORING_OP_READ &&
+                (p_probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+    if( !b_ok )
+        msg_Dbg( p_obj, "io_uring reads are not supported" );
+    free( p_probe );
+    return b_ok;
+}
+
+static void EngineDelete( uring_engine_t *e )
+{
+    if( e->p_sqes != MAP_FAILED )
+        munmap( e->p_sqes, e->i_sqes_size );
+    if( e->p_cq_ring != MAP_FAILED )
+        munmap( e->p_cq_ring, e->i_cq_ring_size );
+    if( e->p_sq_ring != MAP_FAILED )
+        munmap( e->p_sq_ring, e->i_sq_ring_size );
+    vlc_close( e->fd );
+    free( e );
+}
+
+static uring_engine_t * EngineNew( vlc_object_t *p_obj )
+{
+    struct io_uring_params params;
+    memset( &params, 0, sizeof(params) );
+
+    int fd = Setup( URING_ENTRIES, &params );
+    if( fd < 0 )
+    {
+        msg_Dbg( p_obj, "io_uring is not available: %s", vlc_strerror_c(errno) );
+        return NULL;
+    }
+
+    /* completions must not be dropped when many readers are in flight */
+    if( !(params.features & IORING_FEAT_NODROP) || !Probe( p_obj, fd ) )
+    {
+        vlc_close( fd );
+        return NULL;
+    }
+
+    uring_engine_t *e = malloc( sizeof(*e) );
+    if( unlikely(e == NULL) )
+    {
+        vlc_close( fd );
+        return NULL;
+    }
+    e->fd = fd;
+    e->i_refs = 0;
+    e->i_sq_pending = 0;
+
+    e->i_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    e->i_cq_ring_size = params.cq_off.cqes +
+                        params.cq_entries * sizeof(struct io_uring_cqe);
+    e->i_sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    e->p_sq_ring = mmap( NULL, e->i_sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+    e->p_cq_ring = mmap( NULL, e->i_cq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING );
+    e->p_sqes = mmap( NULL, e->i_sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+    if( e->p_sq_ring == MAP_FAILED || e->p_cq_ring == MAP_FAILED ||
+        e->p_sqes == MAP_FAILED )
+    {
+        msg_Err( p_obj, "cannot map io_uring: %s", vlc_strerror_c(errno) );
+        EngineDelete( e );
+        return NULL;
+    }
+
+    uint8_t *p_sq = e->p_sq_ring, *p_cq = e->p_cq_ring;
+    e->p_sq_head = (unsigned *)(p_sq + params.sq_off.head);
+    e->p_sq_tail = (unsigned *)(p_sq + params.sq_off.tail);
+    e->p_sq_array = (unsigned *)(p_sq + params.sq_off.array);
+    e->i_sq_mask = *(unsigned *)(p_sq + params.sq_off.ring_mask);
+    e->i_sq_entries = params.sq_entries;
+    e->p_cq_head = (unsigned *)(p_cq + params.cq_off.head);
+    e->p_cq_tail = (unsigned *)(p_cq + params.cq_off.tail);
+    e->i_cq_mask = *(unsigned *)(p_cq + params.cq_off.ring_mask);
+    e->p_cqes = (struct io_uring_cqe *)(p_cq + params.cq_off.cqes);
+
+    /* Buffers are registered as readers come and go, into a sparse table
+     * (Linux 5.19). Without it, plain reads are used. */
+    struct io_uring_rsrc_register reg = {
+        .nr = URING_BUFFERS,
+        .flags = IORING_RSRC_REGISTER_SPARSE,
+    };
+    e->b_fixed = Register( fd, IORING_REGISTER_BUFFERS2, &reg, sizeof(reg) ) == 0;
+    for( unsigned i = 0; i < URING_BUFFERS; i++ )
+        e->buffers_used[i] = false;
+
+    vlc_mutex_init( &e->lock );
+
+    if( vlc_clone( &e->thread, Run, e ) )
+    {
+        msg_Err( p_obj, "cannot create io_uring thread" );
+        EngineDelete( e );
+        return NULL;
+    }
+
+    msg_Dbg( p_obj, "io_uring started with %u entries%s", params.sq_entries,
+             e->b_fixed ? ", registered buffers" : "" );
+    return e;
+}
+
+static uring_engine_t * EngineHold( vlc_object_t *p_obj )
+{
+    vlc_mutex_lock( &engine_lock );
+    if( engine == NULL )
+        engine = EngineNew( p_obj );
+    uring_engine_t *e = engine;
+    if( e != NULL )
+        e->i_refs++;
+    vlc_mutex_unlock( &engine_lock );
+    return e;
+}
+
+static void EngineRelease( uring_engine_t *e )
+{
+    vlc_mutex_lock( &engine_lock );
+    assert( e == engine );
+    if( --e->i_refs > 0 )
+    {
+        vlc_mutex_unlock( &engine_lock );
+        return;
+    }
+    engine = NULL;
+    vlc_mutex_unlock( &engine_lock );
+
+    /* no reads are left in flight: a no-op completion stops the thread */
+    vlc_mutex_lock( &e->lock );
+    struct io_uring_sqe *p_sqe = GetSqe( e );
+    assert( p_sqe != NULL );
+    p_sqe->opcode = IORING_OP_NOP;
+    p_sqe->user_data = 0;
+    Submit( e );
+    vlc_mutex_unlock( &e->lock );
+
+    vlc_join( e->thread, NULL );
+    EngineDelete( e );
+}
+
+static void RegisterBuffer( uring_reader_t *r )
+{
+    uring_engine_t *e = r->p_engine;
+
+    r->i_buffer = -1;
+    if( !e->b_fixed )
+        return;
+
+    vlc_mutex_lock( &e->lock );
+    for( unsigned i = 0; i < URING_BUFFERS; i++ )
+    {
+        if( e->buffers_used[i] )
+            continue;
+
+        struct iovec iov = { r->p_buffer, r->i_buffer_size };
+        struct io_uring_rsrc_update2 update = {
+            .offset = i,
+            .data = (uintptr_t) &iov,
+            .nr = 1,
+        };
+        /* pinning the pages may exceed the locked memory limit */
+        if( Register( e->fd, IORING_REGISTER_BUFFERS_UPDATE,
+                      &update, sizeof(update) ) == 1 )
+        {
+            e->buffers_used[i] = true;
+            r->i_buffer = i;
+        }
+        else
+            msg_Dbg( r->p_obj, "cannot register buffer: %s",
+                     vlc_strerror_c(errno) );
+        break;
+    }
+    vlc_mutex_unlock( &e->lock );
+}
+
+static void UnregisterBuffer( uring_reader_t *r )
+{
+    uring_engine_t *e = r->p_engine;
+
+    if( r->i_buffer < 0 )
+        return;
+
+    struct iovec iov = { NULL, 0 };
+    struct io_uring_rsrc_update2 update = {
+        .offset = r->i_buffer,
+        .data = (uintptr_t) &iov,
+        .nr = 1,
+    };
+    vlc_mutex_lock( &e->lock );
+    Register( e->fd, IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update) );
+    e->buffers_used[r->i_buffer] = false;
+    vlc_mutex_unlock( &e->lock );
+}
+
+static uint64_t SlotStart( const uring_reader_t *r, uint64_t i_offset )
+{
+    assert( i_offset >= r->i_origin );
+    return i_offset - (i_offset - r->i_origin) % URING_SLOT_SIZE;
+}
+
+static uring_slot_t * GetSlot( uring_reader_t *r, uint64_t i_offset )
+{
+    assert( i_offset >= r->i_origin );
+    return &r->slots[((i_offset - r->i_origin) / URING_SLOT_SIZE) % r->i_slots];
+}
+
+/* Submits the reads of the slots the stream position has left behind.
+ * The reader lock must be held. */
+static void Refill( uring_reader_t *r )
+{
+    uring_engine_t *e = r->p_engine;
+    const uint64_t i_window = (uint64_t) r->i_slots * URING_SLOT_SIZE;
+    const uint64_t i_start = SlotStart( r, r->i_consumed );
+
+    vlc_mutex_lock( &e->lock );
+    while( r->i_inflight < URING_MAX_INFLIGHT && r->i_error == 0 &&
+           r->i_fill < r->i_eof && r->i_fill - i_start < i_window )
+    {
+        uring_slot_t *s = GetSlot( r, r->i_fill );
+        if( s->b_inflight )
+            break; /* still reading for a previous position */
+
+        struct io_uring_sqe *p_sqe = GetSqe( e );
+        if( p_sqe == NULL )
+            break;
+
+        if( r->i_buffer >= 0 )
+        {
+            p_sqe->opcode = IORING_OP_READ_FIXED;
+            p_sqe->buf_index = r->i_buffer;
+        }
+        else
+            p_sqe->opcode = IORING_OP_READ;
+        p_sqe->fd = r->fd;
+        p_sqe->off = r->i_fill;
+        p_sqe->addr = (uintptr_t) s->p_data;
+        p_sqe->len = URING_SLOT_SIZE;
+        p_sqe->user_data = (uintptr_t) s;
+
+        s->i_offset = r->i_fill;
+        s->i_generation = r->i_generation;
+        s->b_inflight = true;
+        s->b_ready = false;
+        r->i_inflight++;
+        r->i_fill += URING_SLOT_SIZE;
+    }
+    Submit( e );
+    vlc_mutex_unlock( &e->lock );
+}
+
+static bool SlotHolds( const uring_reader_t *r, const uring_slot_t *s,
+                       uint64_t i_start )
+{
+    return s->i_generation == r->i_generation && s->i_offset == i_start &&
+           (s->b_inflight || s->b_ready);
+}
+
+ssize_t uring_reader_Read( uring_reader_t *r, uint64_t i_offset,
+                           void *p_buf, size_t i_len )
+{
+    vlc_mutex_lock( &r->lock );
+
+    /* Restart reading from that offset unless it is, or is about to be,
+     * read already */
+    if( i_offset < r->i_origin ||
+        ( !SlotHolds( r, GetSlot( r, i_offset ), SlotStart( r, i_offset ) ) &&
+          SlotStart( r, i_offset ) != r->i_fill ) )
+    {
+        r->i_generation++;
+        r->i_origin = r->i_fill = i_offset;
+        r->i_eof = UINT64_MAX;
+        r->i_error = 0;
+    }
+    r->i_consumed = i_offset;
+
+    const uint64_t i_start = SlotStart( r, i_offset );
+    uring_slot_t *s = GetSlot( r, i_offset );
+    for( ;; )
+    {
+        Refill( r );
+
+        if( r->i_error != 0 )
+        {
+            msg_Err( r->p_obj, "read error: %s", vlc_strerror_c(r->i_error) );
+            /* start over from there on the next call, ignoring the reads
+             * still in flight */
+            r->i_generation++;
+            r->i_origin = r->i_fill = r->i_consumed;
+            r->i_eof = UINT64_MAX;
+            r->i_error = 0;
+            vlc_mutex_unlock( &r->lock );
+            return -1;
+        }
+        if( i_offset >= r->i_eof )
+        {
+            vlc_mutex_unlock( &r->lock );
+            return 0;
+        }
+        if( s->b_ready && s->i_generation == r->i_generation &&
+            s->i_offset == i_start )
+            break;
+        /* wake up to submit again what the ring could not take */
+        vlc_cond_timedwait( &r->wait, &r->lock,
+                            vlc_tick_now() + URING_RETRY_DELAY );
+    }
+
+    size_t i_skip = i_offset - i_start;
+    size_t i_copy = s->i_length > i_skip ? s->i_length - i_skip : 0;
+    if( i_copy > i_len )
+        i_copy = i_len;
+    memcpy( p_buf, &s->p_data[i_skip], i_copy );
+    r->i_consumed = i_offset + i_copy;
+    Refill( r );
+    vlc_mutex_unlock( &r->lock );
+
+    return i_copy;
+}
+
+uring_reader_t * uring_reader_New( vlc_object_t *p_obj, const char *psz_path,
+                                   size_t i_buffer_size )
+{
+    unsigned i_slots = i_buffer_size / URING_SLOT_SIZE;
+    if( i_slots < 2 * URING_MAX_INFLIGHT )
+        i_slots = 2 * URING_MAX_INFLIGHT;
+
+    uring_reader_t *r = malloc( sizeof(*r) + sizeof(uring_slot_t) * i_slots );
+    if( unlikely(r == NULL) )
+        return NULL;
+
+    r->p_obj = p_obj;
+    r->i_slots = i_slots;
+    r->i_buffer_size = (size_t) i_slots * URING_SLOT_SIZE;
+    r->p_buffer = aligned_alloc( 4096, r->i_buffer_size );
+    if( unlikely(r->p_buffer == NULL) )
+    {
+        free( r );
+        return NULL;
+    }
+
+    r->fd = vlc_open( psz_path, O_RDONLY );
+    if( r->fd == -1 )
+    {
+        msg_Err( p_obj, "cannot open file %s: %s", psz_path,
+                 vlc_strerror_c(errno) );
+        goto error;
+    }
+
+    /* offsets are meaningless for anything else */
+    struct stat st;
+    if( fstat( r->fd, &st ) || !S_ISREG(st.st_mode) )
+        goto error;
+
+    r->p_engine = EngineHold( p_obj );
+    if( r->p_engine == NULL )
+        goto error;
+    RegisterBuffer( r );
+
+    vlc_mutex_init( &r->lock );
+    vlc_cond_init( &r->wait );
+    r->i_generation = 0;
+    r->i_origin = r->i_consumed = r->i_fill = 0;
+    r->i_eof = UINT64_MAX;
+    r->i_error = 0;
+    r->i_inflight = 0;
+    for( unsigned i = 0; i < i_slots; i++ )
+    {
+        uring_slot_t *s = &r->slots[i];
+        s->p_reader = r;
+        s->p_data = &r->p_buffer[(size_t) i * URING_SLOT_SIZE];
+        s->i_offset = 0;
+        s->i_length = 0;
+        s->i_generation = UINT_MAX;
+        s->b_inflight = false;
+        s->b_ready = false;
+    }
+
+    msg_Dbg( p_obj, "reading ahead with io_uring, %u slots of %u bytes%s",
+             i_slots, URING_SLOT_SIZE,
+             r->i_buffer >= 0 ? " (registered)" : "" );
+    return r;
+
+error:
+    if( r->fd != -1 )
+        vlc_close( r->fd );
+    free( r->p_buffer );
+    free( r );
+    return NULL;
+}
+
+void uring_reader_Delete( uring_reader_t *r )
+{
+    /* the kernel may still be writing in the buffer */
+    vlc_mutex_lock( &r->lock );
+    r->i_generation++;
+    while( r->i_inflight > 0 )
+        vlc_cond_wait( &r->wait, &r->lock );
+    vlc_mutex_unlock( &r->lock );
+
+    UnregisterBuffer( r );
+    EngineRelease( r->p_engine );
+    vlc_close( r->fd );
+    free( r->p_buffer );
+    free( r );
+}
+
+#else
+
+uring_reader_t * uring_reader_New( vlc_object_t *p_obj, const char *psz_path,
+                                   size_t i_buffer_size )
+{
+    VLC_UNUSED(psz_path); VLC_UNUSED(i_buffer_size);
+    msg_Dbg( p_obj, "io_uring is not supported" );
+    return NULL;
+}
+
+void uring_reader_Delete( uring_reader_t *r )
+{
+    VLC_UNUSED(r);
+    vlc_assert_unreachable();
+}
+
+ssize_t uring_reader_Read( uring_reader_t *r, uint64_t i_offset,
+                           void *p_buf, size_t i_len )
+{
+    VLC_UNUSED(r); VLC_UNUSED(i_offset); VLC_UNUSED(p_buf); VLC_UNUSED(i_len);
+    vlc_assert_unreachable();
+}
+
+#endif
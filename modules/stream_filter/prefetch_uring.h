@@ -0,0 +1,39 @@
+/*****************************************************************************
+ * prefetch_uring.h: io_uring read-ahead for the prefetch module
+ *****************************************************************************
+ * Copyright (C) 2025 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_PREFETCH_URING_H
+#define VLC_PREFETCH_URING_H
+
+typedef struct uring_reader_t uring_reader_t;
+
+/* Reads a local file ahead of the stream position, with several reads in
+ * flight on an io_uring shared by all the readers of the process. */
+
+/* returns NULL if the file cannot be opened or if the kernel does not
+ * support io_uring, in which case the thread mode should be used */
+uring_reader_t * uring_reader_New( vlc_object_t *, const char *psz_path,
+                                   size_t i_buffer_size );
+void uring_reader_Delete( uring_reader_t * );
+
+/* returns the number of bytes read at that offset, 0 at the end of the file
+ * or -1 on error */
+ssize_t uring_reader_Read( uring_reader_t *, uint64_t i_offset,
+                           void *p_buf, size_t i_len );
+
+#endif
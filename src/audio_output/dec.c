@@ -907,7 +907,14 @@ int vlc_aout_stream_Play(vlc_aout_stream *stream, block_t *block)
             vlc_mutex_unlock (&owner->vp.lock);
         }
 
+        struct vlc_tracer *tracer = aout_stream_tracer(stream);
+        if (tracer != NULL)
+            vlc_tracer_TraceBegin(tracer, "RENDER", stream->str_id, "filters");
+
         block = aout_FiltersPlay(stream->filters, block, stream->sync.rate);
+
+        if (tracer != NULL)
+            vlc_tracer_TraceEnd(tracer, "RENDER", stream->str_id, "filters");
         if (block == NULL)
             return ret;
         assert (block->i_pts != VLC_TICK_INVALID);
@@ -270,6 +270,23 @@ static int AStreamControl(stream_t *s, int cmd, va_list args)
 {
     stream_t *access = s->p_sys;
 
+    if (cmd == STREAM_SET_PREFETCH_STATS)
+    {   /* from the prefetch filter above */
+        struct vlc_access_stream_private *priv = vlc_stream_Private(s);
+        struct input_stats *stats =
+            priv->input ? input_priv(priv->input)->stats : NULL;
+        if (stats == NULL)
+            return VLC_EGENERIC;
+
+        uint64_t window = va_arg(args, uint64_t);
+        uint64_t stalls = va_arg(args, uint64_t);
+        atomic_store_explicit(&stats->prefetch_window, window,
+                              memory_order_relaxed);
+        atomic_store_explicit(&stats->prefetch_stalls, stalls,
+                              memory_order_relaxed);
+        return VLC_SUCCESS;
+    }
+
     return vlc_stream_vaControl(access, cmd, args);
 }
 
@@ -1629,8 +1629,14 @@ static void DecoderThread_DecodeBlock( vlc_input_decoder_t *p_owner, vlc_frame_t
                             frame->i_pts, frame->i_dts );
     }
 
+    if ( tracer != NULL )
+        vlc_tracer_TraceBegin( tracer, "DEC", p_owner->psz_id, "decode" );
+
     int ret = p_dec->pf_decode( p_dec, frame );
 
+    if ( tracer != NULL )
+        vlc_tracer_TraceEnd( tracer, "DEC", p_owner->psz_id, "decode" );
+
     vlc_fifo_Lock(p_owner->p_fifo);
     switch( ret )
     {
@@ -218,6 +218,7 @@ typedef struct
     vlc_tick_t  i_pts_jitter;
     int         i_cr_average;
     float       rate;
+    float       catchup_rate; /* requested by the master demux, over rate */
 
     /* */
     bool        b_paused;
@@ -930,6 +931,12 @@ static void EsOutChangePause(es_out_sys_t *p_sys, bool b_paused, vlc_tick_t i_da
     p_sys->i_pause_date = i_date;
 }
 
+/* Playback rate, as set by the user and adjusted by the demux */
+static float EsOutGetRate(es_out_sys_t *p_sys)
+{
+    return p_sys->rate * p_sys->catchup_rate;
+}
+
 static void EsOutChangeRate(es_out_sys_t *p_sys, float rate)
 {
     es_out_id_t *es;
@@ -939,7 +946,7 @@ static void EsOutChangeRate(es_out_sys_t *p_sys, float rate)
 
     foreach_es_then_es_slaves(es)
         if( es->p_dec != NULL )
-            vlc_input_decoder_ChangeRate( es->p_dec, rate );
+            vlc_input_decoder_ChangeRate( es->p_dec, EsOutGetRate(p_sys) );
 }
 
 static void EsOutChangePosition(es_out_sys_t *p_sys, bool b_flush,
@@ -1206,7 +1213,7 @@ static void EsOutProgramsChangeRate(es_out_sys_t *p_sys)
     es_out_pgrm_t *pgrm;
 
     vlc_list_foreach(pgrm, &p_sys->programs, node)
-        input_clock_ChangeRate(pgrm->p_input_clock, p_sys->rate);
+        input_clock_ChangeRate(pgrm->p_input_clock, EsOutGetRate(p_sys));
 }
 
 static void EsOutFrameNext(es_out_sys_t *p_sys)
@@ -1269,7 +1276,7 @@ static vlc_tick_t EsOutGetBuffering(es_out_sys_t *p_sys)
 
         }
 
-        const vlc_tick_t i_consumed = i_system_duration * p_sys->rate - i_stream_duration;
+        const vlc_tick_t i_consumed = i_system_duration * EsOutGetRate(p_sys) - i_stream_duration;
         i_delay = p_sys->i_pts_delay + p_sys->i_pts_jitter
                 + p_sys->i_tracks_pts_delay - i_consumed;
     }
@@ -1566,7 +1573,8 @@ static es_out_pgrm_t *EsOutProgramAdd(es_out_sys_t *p_sys, input_source_t *sourc
         return NULL;
     }
 
-    p_pgrm->p_input_clock = input_clock_New(vlc_object_logger(p_input), p_sys->rate);
+    p_pgrm->p_input_clock = input_clock_New(vlc_object_logger(p_input),
+                                            EsOutGetRate(p_sys));
     if( !p_pgrm->p_input_clock )
     {
         vlc_clock_main_Delete(p_pgrm->clocks.main);
@@ -2379,7 +2387,7 @@ static void EsOutCreateDecoder(es_out_sys_t *p_sys, es_out_id_t *p_es)
     }
     if( dec != NULL )
     {
-        vlc_input_decoder_ChangeRate( dec, p_sys->rate );
+        vlc_input_decoder_ChangeRate( dec, EsOutGetRate(p_sys) );
 
         if( unlikely( p_sys->b_paused ) ) /* Could happen during next-frame */
             vlc_input_decoder_ChangePause( dec, true, p_sys->i_pause_date );
@@ -3659,6 +3667,23 @@ static int EsOutVaControlLocked(es_out_sys_t *p_sys, input_source_t *source,
         return VLC_SUCCESS;
     }
 
+    case ES_OUT_REQUEST_RATE:
+    {
+        /* Only changes the pace of the clocks and decoders: the user rate
+         * is kept, and the adjustment applies on top of it */
+        const float catchup_rate = va_arg( args, double );
+
+        if( source != input_priv(p_sys->p_input)->master ||
+            !(catchup_rate > 0.f) )
+            return VLC_EGENERIC;
+        if( catchup_rate != p_sys->catchup_rate )
+        {
+            p_sys->catchup_rate = catchup_rate;
+            EsOutChangeRate(p_sys, p_sys->rate);
+        }
+        return VLC_SUCCESS;
+    }
+
     case ES_OUT_VOUT_SET_MOUSE_EVENT:
     {
         es_out_id_t *p_es = va_arg( args, es_out_id_t * );
@@ -4139,6 +4164,7 @@ input_EsOutNew(input_thread_t *p_input, input_source_t *main_source, float rate,
     p_sys->i_pause_date = -1;
 
     p_sys->rate = rate;
+    p_sys->catchup_rate = 1.f;
 
     p_sys->b_buffering = true;
     p_sys->b_draining = false;
@@ -721,6 +721,12 @@ static int ControlLocked( es_out_t *p_out, input_source_t *in, int i_query,
     case ES_OUT_POST_SUBNODE:
         return es_out_in_vaControl( p_sys->p_out, in, i_query, args );
 
+    /* The timeshift owns the rate while delayed */
+    case ES_OUT_REQUEST_RATE:
+        if( p_sys->b_delayed )
+            return VLC_EGENERIC;
+        return es_out_in_vaControl( p_sys->p_out, in, i_query, args );
+
     default:
         vlc_assert_unreachable();
         return VLC_EGENERIC;
@@ -981,6 +987,10 @@ static int TsStart(struct es_out_timeshift *p_sys)
     p_ts->p_storage_r = NULL;
     p_ts->p_storage_w = NULL;
 
+    /* The timeshift owns the rate while delayed, stop catching up */
+    es_out_in_Control( p_sys->p_out, input_priv(p_sys->p_input)->master,
+                       ES_OUT_REQUEST_RATE, 1.0 );
+
     p_sys->b_delayed = true;
     if( vlc_clone( &p_ts->thread, TsRun, p_ts ) )
     {
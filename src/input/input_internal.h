@@ -721,6 +721,8 @@ typedef struct input_rate_t
 struct input_stats {
     input_rate_t input_bitrate;
     input_rate_t demux_bitrate;
+    atomic_uintmax_t prefetch_window;
+    atomic_uintmax_t prefetch_stalls;
     atomic_uintmax_t demux_corrupted;
     atomic_uintmax_t demux_discontinuity;
     atomic_uintmax_t decoded_audio;
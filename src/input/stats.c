@@ -59,6 +59,8 @@ struct input_stats *input_stats_Create(void)
 
     input_rate_Init(&stats->input_bitrate);
     input_rate_Init(&stats->demux_bitrate);
+    atomic_init(&stats->prefetch_window, 0);
+    atomic_init(&stats->prefetch_stalls, 0);
     atomic_init(&stats->demux_corrupted, 0);
     atomic_init(&stats->demux_discontinuity, 0);
     atomic_init(&stats->decoded_audio, 0);
@@ -84,6 +86,10 @@ void input_stats_Compute(struct input_stats *stats, input_stats_t *st)
     st->i_read_bytes = stats->input_bitrate.value;
     st->f_input_bitrate = stats_GetRate(&stats->input_bitrate);
     vlc_mutex_unlock(&stats->input_bitrate.lock);
+    st->i_prefetch_window = atomic_load_explicit(&stats->prefetch_window,
+                                                 memory_order_relaxed);
+    st->i_prefetch_stalls = atomic_load_explicit(&stats->prefetch_stalls,
+                                                 memory_order_relaxed);
 
     vlc_mutex_lock(&stats->demux_bitrate.lock);
     st->i_demux_read_bytes = stats->demux_bitrate.value;
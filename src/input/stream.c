@@ -897,6 +897,8 @@ int vlc_stream_vaControl(stream_t *s, int cmd, va_list args)
                 return s->ops->stream.set_record_state(s, record_state, dir_path, ext);
             }
             return VLC_EGENERIC;
+        case STREAM_SET_PREFETCH_STATS:
+            return VLC_EGENERIC;
         case STREAM_SET_PRIVATE_ID_STATE:
             if (s->ops->stream.set_private_id_state != NULL) {
                 int priv_data = va_arg(args, int);
@@ -1122,6 +1122,25 @@ static const char* const ppsz_restore_playback_desc[] = {
 #define TRACER_LONGTEXT N_( \
     "This allow to select which tracer module you want to use." )
 
+#define TRACER_RECORDER_TEXT N_("Flight recorder duration")
+#define TRACER_RECORDER_LONGTEXT N_( \
+    "Keep the traces of the last seconds in memory, to be written to a " \
+    "file on demand or after an error. 0 disables the recorder." )
+
+#define TRACER_RECORDER_SIZE_TEXT N_("Flight recorder size (kiB)")
+#define TRACER_RECORDER_SIZE_LONGTEXT N_( \
+    "Memory used by the flight recorder for each tracing thread. Older " \
+    "traces are overwritten when it is full." )
+
+#define TRACER_RECORDER_FILE_TEXT N_("Flight recorder file")
+#define TRACER_RECORDER_FILE_LONGTEXT N_( \
+    "File the recorded traces are written to. By default, a new file is " \
+    "created in the cache directory for each dump." )
+
+#define TRACER_RECORDER_ERROR_TEXT N_("Dump the flight recorder on errors")
+#define TRACER_RECORDER_ERROR_LONGTEXT N_( \
+    "Write the recorded traces when playback fails." )
+
 #define VLM_CONF_TEXT N_("VLM configuration file")
 #define VLM_CONF_LONGTEXT N_( \
     "Read a VLM configuration file as soon as VLM is started." )
@@ -2112,6 +2131,16 @@ vlc_module_begin ()
     add_obsolete_string("vod-server") /* since 4.0.0 */
     add_module("tracer", "tracer", "none",
                TRACER_TEXT, TRACER_LONGTEXT)
+    add_integer( "tracer-recorder", 0, TRACER_RECORDER_TEXT,
+                 TRACER_RECORDER_LONGTEXT )
+        change_integer_range( 0, 3600 )
+    add_integer( "tracer-recorder-size", 1024, TRACER_RECORDER_SIZE_TEXT,
+                 TRACER_RECORDER_SIZE_LONGTEXT )
+        change_integer_range( 1, 1024 * 1024 )
+    add_savefile( "tracer-recorder-file", NULL, TRACER_RECORDER_FILE_TEXT,
+                  TRACER_RECORDER_FILE_LONGTEXT )
+    add_bool( "tracer-recorder-on-error", true, TRACER_RECORDER_ERROR_TEXT,
+              TRACER_RECORDER_ERROR_LONGTEXT )
 
     set_section( N_("Plugins" ), NULL )
 #ifdef HAVE_DYNAMIC_PLUGINS
@@ -182,9 +182,7 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
 
     vlc_LogInit(p_libvlc);
 
-    char *tracer_name = var_InheritString(p_libvlc, "tracer");
-    priv->tracer = vlc_tracer_Create(VLC_OBJECT(p_libvlc), tracer_name);
-    free(tracer_name);
+    priv->tracer = vlc_TracerInit(p_libvlc);
 
     /*
      * Support for gettext
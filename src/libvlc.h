@@ -62,6 +62,26 @@ typedef struct vlc_tracer vlc_tracer_t;
 int vlc_LogPreinit(libvlc_int_t *) VLC_USED;
 void vlc_LogInit(libvlc_int_t *);
 
+/*
+ * Tracing
+ */
+
+/**
+ * Creates the tracer of the instance, with the configured tracer module
+ * and/or flight recorder.
+ *
+ * \return the tracer, or NULL if tracing is disabled
+ */
+vlc_tracer_t *vlc_TracerInit(libvlc_int_t *);
+
+/**
+ * Dumps the flight recorder after an error, unless disabled or already
+ * dumped recently.
+ *
+ * The dump is written asynchronously, so this can be called with locks held.
+ */
+void vlc_tracer_Incident(vlc_tracer_t *);
+
 /*
  * LibVLC exit event handling
  */
@@ -26,15 +26,466 @@
 
 #include <stdlib.h>
 #include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
 #include <assert.h>
 
 #include <vlc_common.h>
 #include <vlc_modules.h>
 #include <vlc_tracer.h>
+#include <vlc_charset.h>
+#include <vlc_configuration.h>
+#include <vlc_fs.h>
 #include "../libvlc.h"
 
+/*
+ * Flight recorder
+ *
+ * Each tracing thread copies its traces into its own ring of fixed-size
+ * records, overwriting the oldest ones. Nothing is written out until the
+ * recorder is dumped, so it can stay enabled all the time.
+ *
+ * The ring of a thread that is gone is kept until a dump wrote it or its
+ * traces left the window. Past RECORDER_RINGS_MAX rings, a new thread takes
+ * over such a ring, or is not recorded if there is none.
+ */
+#define RECORDER_ENTRIES 8
+#define RECORDER_STRINGS 160
+#define RECORDER_RINGS_MAX 64
+
+struct vlc_trace_record
+{
+    vlc_tick_t ts;
+    uint8_t count;
+    uint8_t types[RECORDER_ENTRIES];
+    uint8_t keys[RECORDER_ENTRIES];         /* offsets in strings */
+    union
+    {
+        int64_t integer;
+        uint64_t uinteger;
+        double double_;
+        uint8_t string;                     /* offset in strings */
+    } values[RECORDER_ENTRIES];
+    char strings[RECORDER_STRINGS];
+};
+
+struct vlc_trace_ring
+{
+    vlc_mutex_t lock;
+    bool live;              /* the owning thread still exists */
+    bool dumped;            /* dumped since its thread is gone */
+    unsigned long thread;
+    uint64_t written;       /* total number of records written */
+    struct vlc_trace_ring *next;
+    struct vlc_trace_record records[];
+};
+
+struct vlc_tracer_recorder
+{
+    vlc_object_t *obj;
+    vlc_tick_t window;
+    size_t size;            /* records per ring */
+    char *path;
+
+    vlc_threadvar_t ring_key; /* ring of the calling thread */
+
+    vlc_mutex_t lock;       /* protects the list and dumps */
+    struct vlc_trace_ring *rings;
+    unsigned ring_count;
+
+    /* Dumps after errors are written by a thread of their own, since errors
+     * are reported with locks held */
+    bool on_error;
+    vlc_thread_t thread;
+    vlc_cond_t wait;
+    bool incident;
+    bool closing;
+    vlc_tick_t last_incident;
+};
+
+/* Called when a tracing thread exits: its ring is kept for the next dump */
+static void RecorderReleaseRing(void *data)
+{
+    struct vlc_trace_ring *ring = data;
+
+    vlc_mutex_lock(&ring->lock);
+    ring->live = false;
+    ring->dumped = false;
+    vlc_mutex_unlock(&ring->lock);
+}
+
+static struct vlc_trace_ring *RecorderAcquireRing(struct vlc_tracer_recorder *rec)
+{
+    struct vlc_trace_ring *ring = NULL;
+
+    vlc_mutex_lock(&rec->lock);
+    if (rec->ring_count < RECORDER_RINGS_MAX)
+    {
+        ring = malloc(sizeof (*ring) + rec->size * sizeof (ring->records[0]));
+        if (ring != NULL)
+        {
+            vlc_mutex_init(&ring->lock);
+            ring->written = 0;
+            ring->next = rec->rings;
+            rec->rings = ring;
+            rec->ring_count++;
+        }
+    }
+    else
+    {
+        /* Take over the ring with the oldest traces among the ones of the
+         * threads that are gone, once a dump wrote them or they left the
+         * window: until then, this thread is not recorded */
+        vlc_tick_t oldest = VLC_TICK_MAX;
+        vlc_tick_t since = vlc_tick_now() - rec->window;
+        for (struct vlc_trace_ring *r = rec->rings; r != NULL; r = r->next)
+        {
+            vlc_mutex_lock(&r->lock);
+            bool reusable = !r->live;
+            vlc_tick_t last = r->written > 0
+                ? r->records[(r->written - 1) % rec->size].ts : VLC_TICK_MIN;
+            if (!r->dumped && last >= since)
+                reusable = false;
+            vlc_mutex_unlock(&r->lock);
+            if (reusable && last < oldest)
+            {
+                oldest = last;
+                ring = r;
+            }
+        }
+    }
+
+    if (ring != NULL)
+    {
+        vlc_mutex_lock(&ring->lock);
+        ring->live = true;
+        ring->thread = vlc_thread_id();
+        ring->written = 0;
+        vlc_mutex_unlock(&ring->lock);
+    }
+    vlc_mutex_unlock(&rec->lock);
+    return ring;
+}
+
+static uint8_t RecordString(struct vlc_trace_record *record, size_t *offset,
+                            const char *str)
+{
+    size_t len = strnlen(str, RECORDER_STRINGS - 1 - *offset);
+    uint8_t pos = *offset;
+
+    memcpy(&record->strings[pos], str, len);
+    record->strings[pos + len] = '\0';
+    *offset += len + 1;
+    return pos;
+}
+
+static void RecorderTrace(struct vlc_tracer_recorder *rec, vlc_tick_t ts,
+                          const struct vlc_tracer_trace *trace)
+{
+    struct vlc_trace_ring *ring = vlc_threadvar_get(rec->ring_key);
+
+    if (ring == NULL)
+    {
+        /* NULL if every ring is in use by a live thread: this one is not
+         * recorded */
+        ring = RecorderAcquireRing(rec);
+        if (ring == NULL)
+            return;
+        if (unlikely(vlc_threadvar_set(rec->ring_key, ring)))
+        {
+            RecorderReleaseRing(ring);
+            return;
+        }
+    }
+    vlc_mutex_lock(&ring->lock);
+
+    struct vlc_trace_record *record =
+        &ring->records[ring->written % rec->size];
+    size_t offset = 0;
+    unsigned count = 0;
+
+    record->ts = ts;
+    for (const struct vlc_tracer_entry *entry = trace->entries;
+         entry->key != NULL && count < RECORDER_ENTRIES
+          && offset < RECORDER_STRINGS; entry++, count++)
+    {
+        record->types[count] = entry->type;
+        record->keys[count] = RecordString(record, &offset, entry->key);
+        if (entry->type == VLC_TRACER_STRING)
+        {
+            if (offset >= RECORDER_STRINGS)
+                break;
+            record->values[count].string =
+                RecordString(record, &offset, entry->value.string);
+        }
+        else
+            record->values[count].uinteger = entry->value.uinteger;
+    }
+    record->count = count;
+    ring->written++;
+    vlc_mutex_unlock(&ring->lock);
+}
+
+struct vlc_trace_dump_record
+{
+    unsigned long thread;
+    struct vlc_trace_record record;
+};
+
+static int CompareRecords(const void *a, const void *b)
+{
+    const struct vlc_trace_dump_record *ra = a, *rb = b;
+    return (ra->record.ts > rb->record.ts) - (ra->record.ts < rb->record.ts);
+}
+
+static void DumpString(FILE *stream, const char *str)
+{
+    fputc('"', stream);
+    for (; *str != '\0'; str++)
+    {
+        unsigned char c = *str;
+        if (c == '"' || c == '\\')
+            fprintf(stream, "\\%c", c);
+        else if (c < 0x20 || c == 0x7F)
+            fprintf(stream, "\\u%04x", c);
+        else
+            fputc(c, stream);
+    }
+    fputc('"', stream);
+}
+
+static void DumpRecord(FILE *stream, const struct vlc_trace_dump_record *dump)
+{
+    const struct vlc_trace_record *record = &dump->record;
+
+    /* Same layout as the JSON tracer, with the thread */
+    fprintf(stream, "{\"Timestamp\": \"%"PRId64"\",\"Thread\": \"%lu\","
+            "\"Body\": {", NS_FROM_VLC_TICK(record->ts), dump->thread);
+    for (unsigned i = 0; i < record->count; i++)
+    {
+        if (i > 0)
+            fputc(',', stream);
+        DumpString(stream, &record->strings[record->keys[i]]);
+        switch (record->types[i])
+        {
+            case VLC_TRACER_INT:
+                fprintf(stream, ": \"%"PRId64"\"", record->values[i].integer);
+                break;
+            case VLC_TRACER_UINT:
+                fprintf(stream, ": \"%"PRIu64"\"", record->values[i].uinteger);
+                break;
+            case VLC_TRACER_DOUBLE:
+                vlc_fprintf_c(stream, ": \"%le\"", record->values[i].double_);
+                break;
+            case VLC_TRACER_STRING:
+                fputs(": ", stream);
+                DumpString(stream,
+                           &record->strings[record->values[i].string]);
+                break;
+            default:
+                vlc_assert_unreachable();
+        }
+    }
+    fputs("}}\n", stream);
+}
+
+static char *RecorderDefaultPath(void)
+{
+    char *dir = config_GetUserDir(VLC_CACHE_DIR);
+    if (dir == NULL)
+        return NULL;
+
+    char *path;
+    time_t now = time(NULL);
+    struct tm tm;
+    char date[32];
+    strftime(date, sizeof (date), "%Y%m%d-%H%M%S", localtime_r(&now, &tm));
+    if (asprintf(&path, "%s"DIR_SEP"vlc-recorder-%s.json", dir, date) < 0)
+        path = NULL;
+    free(dir);
+    return path;
+}
+
+static int RecorderDump(struct vlc_tracer_recorder *rec, const char *path)
+{
+    char *default_path = NULL;
+    if (path == NULL)
+        path = rec->path;
+    if (path == NULL)
+    {
+        default_path = RecorderDefaultPath();
+        if (default_path == NULL)
+            return VLC_ENOMEM;
+        path = default_path;
+    }
+
+    vlc_mutex_lock(&rec->lock);
+
+    size_t total = 0;
+    for (struct vlc_trace_ring *ring = rec->rings; ring != NULL;
+         ring = ring->next)
+    {
+        vlc_mutex_lock(&ring->lock);
+        total += __MIN(ring->written, rec->size);
+        vlc_mutex_unlock(&ring->lock);
+    }
+
+    /* Copy the recent records out of the rings, so that tracing threads
+     * are only held for a memcpy. Rings do not shrink while we hold the
+     * recorder lock. */
+    struct vlc_trace_dump_record *records =
+        vlc_alloc(total > 0 ? total : 1, sizeof (*records));
+    size_t count = 0;
+    vlc_tick_t since = vlc_tick_now() - rec->window;
+
+    for (struct vlc_trace_ring *ring = rec->rings;
+         records != NULL && ring != NULL; ring = ring->next)
+    {
+        vlc_mutex_lock(&ring->lock);
+        uint64_t first = ring->written > rec->size
+                       ? ring->written - rec->size : 0;
+        for (uint64_t i = first; i < ring->written && count < total; i++)
+        {
+            const struct vlc_trace_record *record =
+                &ring->records[i % rec->size];
+            if (record->ts < since)
+                continue;
+            records[count].thread = ring->thread;
+            records[count].record = *record;
+            count++;
+        }
+        if (!ring->live)
+            ring->dumped = true;
+        vlc_mutex_unlock(&ring->lock);
+    }
+    vlc_mutex_unlock(&rec->lock);
+
+    if (records == NULL)
+    {
+        free(default_path);
+        return VLC_ENOMEM;
+    }
+
+    qsort(records, count, sizeof (*records), CompareRecords);
+
+    int ret = VLC_SUCCESS;
+    FILE *stream = vlc_fopen(path, "wt");
+    if (stream != NULL)
+    {
+        for (size_t i = 0; i < count; i++)
+            DumpRecord(stream, &records[i]);
+        if (fclose(stream))
+            ret = VLC_EGENERIC;
+    }
+    else
+        ret = VLC_EGENERIC;
+
+    if (ret == VLC_SUCCESS)
+        msg_Info(rec->obj, "dumped %zu traces to `%s'", count, path);
+    else
+        msg_Err(rec->obj, "cannot dump traces to `%s': %s", path,
+                vlc_strerror_c(errno));
+
+    free(records);
+    free(default_path);
+    return ret;
+}
+
+static void *RecorderThread(void *data)
+{
+    struct vlc_tracer_recorder *rec = data;
+
+    vlc_thread_set_name("vlc-trace-dump");
+
+    vlc_mutex_lock(&rec->lock);
+    for (;;)
+    {
+        while (!rec->incident && !rec->closing)
+            vlc_cond_wait(&rec->wait, &rec->lock);
+        if (rec->closing)
+            break;
+        rec->incident = false;
+        vlc_mutex_unlock(&rec->lock);
+
+        RecorderDump(rec, NULL);
+
+        vlc_mutex_lock(&rec->lock);
+    }
+    vlc_mutex_unlock(&rec->lock);
+    return NULL;
+}
+
+static struct vlc_tracer_recorder *RecorderCreate(vlc_object_t *obj)
+{
+    int64_t window = var_InheritInteger(obj, "tracer-recorder");
+    if (window <= 0)
+        return NULL;
+
+    struct vlc_tracer_recorder *rec = malloc(sizeof (*rec));
+    if (unlikely(rec == NULL))
+        return NULL;
+
+    if (vlc_threadvar_create(&rec->ring_key, RecorderReleaseRing))
+    {
+        free(rec);
+        return NULL;
+    }
+
+    int64_t kib = var_InheritInteger(obj, "tracer-recorder-size");
+    rec->obj = obj;
+    rec->window = vlc_tick_from_sec(window);
+    rec->size = __MAX(kib * 1024 / sizeof (struct vlc_trace_record), 1);
+    rec->path = var_InheritString(obj, "tracer-recorder-file");
+    vlc_mutex_init(&rec->lock);
+    rec->rings = NULL;
+    rec->ring_count = 0;
+    vlc_cond_init(&rec->wait);
+    rec->incident = false;
+    rec->closing = false;
+    rec->last_incident = VLC_TICK_INVALID;
+    rec->on_error = var_InheritBool(obj, "tracer-recorder-on-error");
+    if (rec->on_error
+     && vlc_clone(&rec->thread, RecorderThread, rec))
+    {
+        msg_Warn(obj, "cannot dump the flight recorder on errors");
+        rec->on_error = false;
+    }
+
+    msg_Dbg(obj, "flight recorder keeping %"PRId64" s of traces, %zu "
+            "traces per thread", window, rec->size);
+    return rec;
+}
+
+static void RecorderDestroy(struct vlc_tracer_recorder *rec)
+{
+    if (rec->on_error)
+    {
+        vlc_mutex_lock(&rec->lock);
+        rec->closing = true;
+        vlc_cond_signal(&rec->wait);
+        vlc_mutex_unlock(&rec->lock);
+        vlc_join(rec->thread, NULL);
+    }
+
+    /* Exiting threads no longer touch the rings after this */
+    vlc_threadvar_delete(&rec->ring_key);
+
+    struct vlc_trace_ring *ring = rec->rings;
+    while (ring != NULL)
+    {
+        struct vlc_trace_ring *next = ring->next;
+        free(ring);
+        ring = next;
+    }
+    free(rec->path);
+    free(rec);
+}
+
 struct vlc_tracer {
     const struct vlc_tracer_operations *ops;
+    struct vlc_tracer_recorder *recorder;
 };
 
 /**
@@ -50,12 +501,41 @@ struct vlc_tracer_module {
 void vlc_tracer_TraceWithTs(struct vlc_tracer *tracer, vlc_tick_t ts,
                             const struct vlc_tracer_trace *trace)
 {
-    assert(tracer->ops->trace != NULL);
     struct vlc_tracer_module *module =
             container_of(tracer, struct vlc_tracer_module, tracer);
 
+    if (tracer->recorder != NULL)
+        RecorderTrace(tracer->recorder, ts, trace);
+
     /* Pass message to the callback */
-    tracer->ops->trace(module->opaque, ts, trace);
+    if (tracer->ops != NULL)
+        tracer->ops->trace(module->opaque, ts, trace);
+}
+
+int vlc_tracer_Dump(struct vlc_tracer *tracer, const char *path)
+{
+    if (tracer->recorder == NULL)
+        return VLC_EGENERIC;
+    return RecorderDump(tracer->recorder, path);
+}
+
+void vlc_tracer_Incident(struct vlc_tracer *tracer)
+{
+    struct vlc_tracer_recorder *rec = tracer->recorder;
+    if (rec == NULL || !rec->on_error)
+        return;
+
+    /* Do not dump the same traces again for a burst of errors */
+    vlc_tick_t now = vlc_tick_now();
+    vlc_mutex_lock(&rec->lock);
+    if (rec->last_incident == VLC_TICK_INVALID
+     || now - rec->last_incident >= rec->window)
+    {
+        rec->last_incident = now;
+        rec->incident = true;
+        vlc_cond_signal(&rec->wait);
+    }
+    vlc_mutex_unlock(&rec->lock);
 }
 
 static int vlc_tracer_load(void *func, bool forced, va_list ap)
@@ -76,6 +556,7 @@ struct vlc_tracer *vlc_tracer_Create(vlc_object_t *parent, const char *module_na
     if (unlikely(module == NULL))
         return NULL;
 
+    module->tracer.recorder = NULL;
     if (vlc_module_load(vlc_object_logger(module), "tracer", module_name, false,
                         vlc_tracer_load, module) == NULL) {
         vlc_object_delete(VLC_OBJECT(module));
@@ -85,13 +566,40 @@ struct vlc_tracer *vlc_tracer_Create(vlc_object_t *parent, const char *module_na
     return &module->tracer;
 }
 
+struct vlc_tracer *vlc_TracerInit(libvlc_int_t *vlc)
+{
+    struct vlc_tracer_module *module;
+
+    module = vlc_custom_create(VLC_OBJECT(vlc), sizeof (*module), "tracer");
+    if (unlikely(module == NULL))
+        return NULL;
+
+    char *name = var_InheritString(vlc, "tracer");
+    if (vlc_module_load(vlc_object_logger(module), "tracer", name, false,
+                        vlc_tracer_load, module) == NULL)
+        module->tracer.ops = NULL;
+    free(name);
+
+    /* The flight recorder works without tracer module */
+    module->tracer.recorder = RecorderCreate(VLC_OBJECT(module));
+    if (module->tracer.ops == NULL && module->tracer.recorder == NULL) {
+        vlc_object_delete(VLC_OBJECT(module));
+        return NULL;
+    }
+
+    return &module->tracer;
+}
+
 void vlc_tracer_Destroy(struct vlc_tracer *tracer)
 {
     struct vlc_tracer_module *module =
         container_of(tracer, struct vlc_tracer_module, tracer);
 
-    if (module->tracer.ops->destroy != NULL)
+    if (module->tracer.ops != NULL && module->tracer.ops->destroy != NULL)
         module->tracer.ops->destroy(module->opaque);
 
+    if (module->tracer.recorder != NULL)
+        RecorderDestroy(module->tracer.recorder);
+
     vlc_object_delete(VLC_OBJECT(module));
 }
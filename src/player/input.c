@@ -25,6 +25,7 @@
 #include <vlc_common.h>
 #include <vlc_memstream.h>
 #include "player.h"
+#include "../libvlc.h"
 
 struct vlc_player_track_priv *
 vlc_player_input_FindTrackById(struct vlc_player_input *input, vlc_es_id_t *id,
@@ -352,6 +353,11 @@ vlc_player_input_HandleStateEvent(struct vlc_player_input *input,
                 /* Contrary to the input_thead_t, an error is not a state */
                 input->error = VLC_PLAYER_ERROR_GENERIC;
                 vlc_player_SendEvent(input->player, on_error_changed, input->error);
+
+                struct vlc_tracer *tracer =
+                    vlc_object_get_tracer(VLC_OBJECT(input->player));
+                if (tracer != NULL)
+                    vlc_tracer_Incident(tracer);
             }
             /* input->playing monitor the OPENING_S -> PLAYING_S transition.
              * If input->playing is false, we have an error at the opening of
@@ -1397,10 +1397,15 @@ static int PrerenderPicture(vout_thread_sys_t *sys, picture_t *filtered,
 static int RenderPicture(vout_thread_sys_t *sys, bool render_now)
 {
     vout_display_t *vd = sys->display;
+    struct vlc_tracer *tracer = GetTracer(sys);
 
     vout_chrono_Start(&sys->chrono.render);
 
+    if (tracer != NULL)
+        vlc_tracer_TraceBegin(tracer, "RENDER", sys->str_id, "filter");
     picture_t *filtered = FilterPictureInteractive(sys);
+    if (tracer != NULL)
+        vlc_tracer_TraceEnd(tracer, "RENDER", sys->str_id, "filter");
     if (!filtered)
         return VLC_EGENERIC;
 
@@ -1411,7 +1416,11 @@ static int RenderPicture(vout_thread_sys_t *sys, bool render_now)
 
     picture_t *todisplay;
     vlc_render_subpicture *subpic;
+    if (tracer != NULL)
+        vlc_tracer_TraceBegin(tracer, "RENDER", sys->str_id, "prerender");
     int ret = PrerenderPicture(sys, filtered, &todisplay, &subpic);
+    if (tracer != NULL)
+        vlc_tracer_TraceEnd(tracer, "RENDER", sys->str_id, "prerender");
     if (ret != VLC_SUCCESS)
     {
         vlc_queuedmutex_unlock(&sys->display_lock);
@@ -1436,11 +1445,16 @@ static int RenderPicture(vout_thread_sys_t *sys, bool render_now)
     const unsigned frame_rate_base = todisplay->format.i_frame_rate_base;
 
     if (vd->ops->prepare != NULL)
+    {
+        if (tracer != NULL)
+            vlc_tracer_TraceBegin(tracer, "RENDER", sys->str_id, "prepare");
         vd->ops->prepare(vd, todisplay, subpic, system_pts);
+        if (tracer != NULL)
+            vlc_tracer_TraceEnd(tracer, "RENDER", sys->str_id, "prepare");
+    }
 
     vout_chrono_Stop(&sys->chrono.render);
 
-    struct vlc_tracer *tracer = GetTracer(sys);
     system_now = vlc_tick_now();
     if (!render_now)
     {
@@ -1502,7 +1516,11 @@ static int RenderPicture(vout_thread_sys_t *sys, bool render_now)
     }
 
     /* Display the direct buffer returned by vout_RenderPicture */
+    if (tracer != NULL)
+        vlc_tracer_TraceBegin(tracer, "RENDER", sys->str_id, "display");
     vout_display_Display(vd, todisplay);
+    if (tracer != NULL)
+        vlc_tracer_TraceEnd(tracer, "RENDER", sys->str_id, "display");
     vlc_clock_Lock(sys->clock);
     vlc_tick_t drift = vlc_clock_UpdateVideo(sys->clock,
                                              vlc_tick_now(),
@@ -1789,6 +1807,22 @@ void vout_ChangeRate(vout_thread_t *vout, float rate)
     vout_control_Release(&sys->control);
 }
 
+vlc_tick_t vout_ConvertToSystem(vout_thread_t *vout, vlc_tick_t system_now,
+                                vlc_tick_t ts)
+{
+    vout_thread_sys_t *sys = VOUT_THREAD_TO_SYS(vout);
+    assert(!sys->dummy);
+
+    if (sys->clock == NULL)
+        return VLC_TICK_INVALID;
+
+    vlc_clock_Lock(sys->clock);
+    vlc_tick_t date = vlc_clock_ConvertToSystem(sys->clock, system_now, ts,
+                                                sys->rate, NULL);
+    vlc_clock_Unlock(sys->clock);
+    return date;
+}
+
 void vout_ChangeSpuDelay(vout_thread_t *vout, size_t channel_id,
                          vlc_tick_t delay)
 {
@@ -192,6 +192,15 @@ void spu_SetClockRate(spu_t *spu, size_t channel_id, float rate);
 void spu_ChangeChannelOrderMargin(spu_t *, enum vlc_vout_order, int);
 void spu_SetHighlight(spu_t *, const vlc_spu_highlight_t*);
 
+/**
+ * This function converts a stream timestamp to a system date with the clock
+ * of the vout. It must be called from the vout thread.
+ *
+ * \return VLC_TICK_INVALID if the vout has no clock
+ */
+vlc_tick_t vout_ConvertToSystem( vout_thread_t *, vlc_tick_t system_now,
+                                 vlc_tick_t ts );
+
 /**
  * This function will (un)pause the display of pictures.
  * It is thread safe
@@ -1571,29 +1571,49 @@ static void SetHighlights(spu_t *spu, const vlc_spu_highlight_t *hl)
  * Buffers allocation callbacks for the filters
  *****************************************************************************/
 
+struct sub_source_owner
+{
+    spu_t   *spu;
+    ssize_t channel;
+};
+
 static subpicture_t *sub_new_buffer(filter_t *filter)
 {
-    ssize_t channel = *(ssize_t *)filter->owner.sys;
+    const struct sub_source_owner *owner = filter->owner.sys;
 
     subpicture_t *subpicture = subpicture_New(NULL);
     if (subpicture)
-        subpicture->i_channel = channel;
+        subpicture->i_channel = owner->channel;
     return subpicture;
 }
 
+static vlc_tick_t sub_convert_ts(filter_t *filter, vlc_tick_t system_now,
+                                 vlc_tick_t ts)
+{
+    const struct sub_source_owner *owner = filter->owner.sys;
+    spu_private_t *sys = container_of(owner->spu, spu_private_t, spu);
+
+    /* Sub sources run from spu_Render(), on the vout thread */
+    if (sys->vout == NULL)
+        return VLC_TICK_INVALID;
+    return vout_ConvertToSystem(sys->vout, system_now, ts);
+}
+
 static const struct filter_subpicture_callbacks sub_cbs = {
     sub_new_buffer,
+    sub_convert_ts,
 };
 
 static int SubSourceInit(filter_t *filter, void *data)
 {
     spu_t *spu = data;
-    ssize_t *channel = malloc(sizeof (ssize_t));
-    if (unlikely(channel == NULL))
+    struct sub_source_owner *owner = malloc(sizeof (*owner));
+    if (unlikely(owner == NULL))
         return VLC_ENOMEM;
 
-    *channel = spu_RegisterChannel(spu);
-    filter->owner.sys = channel;
+    owner->spu = spu;
+    owner->channel = spu_RegisterChannel(spu);
+    filter->owner.sys = owner;
     filter->owner.sub = &sub_cbs;
     return VLC_SUCCESS;
 }
@@ -1601,10 +1621,10 @@ static int SubSourceInit(filter_t *filter, void *data)
 static int SubSourceClean(filter_t *filter, void *data)
 {
     spu_t *spu = data;
-    ssize_t *channel = filter->owner.sys;
+    struct sub_source_owner *owner = filter->owner.sys;
 
-    spu_ClearChannel(spu, *channel);
-    free(channel);
+    spu_ClearChannel(spu, owner->channel);
+    free(owner);
     return VLC_SUCCESS;
 }
 
@@ -0,0 +1,200 @@
+/*****************************************************************************
+ * ts_index.c: MPEG-TS seek index cache tests
+ *****************************************************************************
+ * Copyright (C) 2025 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include "../../../modules/demux/mpeg/ts_index.h"
+
+#include "../../libvlc/test.h"
+
+#include <vlc/vlc.h>
+
+#define PACKET 188
+#define SIZE   (UINT64_C(1) << 30)
+#define MTIME  1234
+#define MAX_ENTRIES (1 << 18) /* per program, as in the index */
+
+static ts_index_t *Build(vlc_object_t *obj)
+{
+    ts_index_t *index = ts_index_New(obj, PACKET, SIZE, MTIME);
+    assert(index != NULL);
+
+    /* program 1 played from 10s to 20s, then after a seek from 60s */
+    for (vlc_tick_t t = VLC_TICK_FROM_SEC(10); t <= VLC_TICK_FROM_SEC(20);
+         t += TS_INDEX_INTERVAL)
+        ts_index_AddPCR(index, 1, t, t / 10);
+    ts_index_AddRAP(index, 1, VLC_TICK_FROM_SEC(15), 1000);
+    ts_index_Discontinuity(index);
+    for (vlc_tick_t t = VLC_TICK_FROM_SEC(60); t <= VLC_TICK_FROM_SEC(62);
+         t += TS_INDEX_INTERVAL)
+        ts_index_AddPCR(index, 1, t, t / 10);
+
+    ts_index_bounds_t bounds = {
+        .i_first = VLC_TICK_FROM_SEC(10),
+        .i_first_dts = VLC_TICK_FROM_SEC(10),
+        .i_last_dts = VLC_TICK_FROM_SEC(100),
+        .i_last_dts_byte = SIZE - PACKET,
+    };
+    ts_index_SetBounds(index, 1, &bounds);
+    ts_index_AddPCR(index, 2, VLC_TICK_FROM_SEC(1), 0);
+    return index;
+}
+
+/* Both indexes answer the same */
+static void CheckSame(const ts_index_t *a, const ts_index_t *b)
+{
+    for (vlc_tick_t t = 0; t < VLC_TICK_FROM_SEC(100); t += VLC_TICK_FROM_MS(70))
+    {
+        uint64_t pos_a = 0, head_a = 0, tail_a = SIZE;
+        uint64_t pos_b = 0, head_b = 0, tail_b = SIZE;
+        bool found_a = ts_index_Lookup(a, 1, t, &pos_a, &head_a, &tail_a);
+        bool found_b = ts_index_Lookup(b, 1, t, &pos_b, &head_b, &tail_b);
+        assert(found_a == found_b);
+        assert(pos_a == pos_b && head_a == head_b && tail_a == tail_b);
+    }
+
+    ts_index_bounds_t bounds_a, bounds_b;
+    assert(ts_index_GetBounds(a, 1, &bounds_a));
+    assert(ts_index_GetBounds(b, 1, &bounds_b));
+    assert(!memcmp(&bounds_a, &bounds_b, sizeof(bounds_a)));
+    assert(!ts_index_GetBounds(b, 2, &bounds_b));
+}
+
+static bool Parses(vlc_object_t *obj, const uint8_t *data, size_t size,
+                   unsigned packet, uint64_t stamp_size, uint64_t stamp_mtime)
+{
+    ts_index_t *index = ts_index_New(obj, packet, stamp_size, stamp_mtime);
+    assert(index != NULL);
+    bool ret = ts_index_Parse(index, data, size);
+    if (!ret) /* left empty */
+    {
+        uint64_t pos, head = 0, tail = SIZE;
+        assert(!ts_index_Lookup(index, 1, VLC_TICK_FROM_SEC(15),
+                                &pos, &head, &tail));
+        assert(head == 0 && tail == SIZE);
+    }
+    ts_index_Close(index);
+    return ret;
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    ts_index_t *index = Build(obj);
+
+    /* played times are found, at the closest random access point */
+    uint64_t pos, head = 0, tail = SIZE;
+    assert(ts_index_Lookup(index, 1, VLC_TICK_FROM_SEC(16), &pos, &head, &tail));
+    assert(pos == 1000);
+    assert(ts_index_Lookup(index, 1, VLC_TICK_FROM_SEC(12), &pos, &head, &tail));
+    assert(pos == VLC_TICK_FROM_SEC(12) / 10);
+    /* others narrow the search */
+    assert(!ts_index_Lookup(index, 1, VLC_TICK_FROM_SEC(40), &pos, &head, &tail));
+    assert(head == VLC_TICK_FROM_SEC(20) / 10);
+    assert(tail == VLC_TICK_FROM_SEC(60) / 10);
+
+    size_t size;
+    uint8_t *data = ts_index_Serialize(index, &size);
+    assert(data != NULL);
+
+    /* round trip */
+    ts_index_t *loaded = ts_index_New(obj, PACKET, SIZE, MTIME);
+    assert(loaded != NULL);
+    assert(ts_index_Parse(loaded, data, size));
+    CheckSame(index, loaded);
+    ts_index_Close(loaded);
+
+    /* other file contents or packet size */
+    assert(Parses(obj, data, size, PACKET, SIZE, MTIME));
+    assert(!Parses(obj, data, size, 192, SIZE, MTIME));
+    assert(!Parses(obj, data, size, PACKET, SIZE + 1, MTIME));
+    assert(!Parses(obj, data, size, PACKET, SIZE, MTIME + 1));
+
+    /* truncated or extended data */
+    for (size_t i = 0; i < size; i++)
+        assert(!Parses(obj, data, i, PACKET, SIZE, MTIME));
+    uint8_t *longer = malloc(size + 1);
+    assert(longer != NULL);
+    memcpy(longer, data, size);
+    longer[size] = 0;
+    assert(!Parses(obj, longer, size + 1, PACKET, SIZE, MTIME));
+    free(longer);
+
+    /* corrupted header and counts */
+    const size_t header = 8 + 4 + 4 + 8 + 8;
+    const size_t counts = header + 4 + 4 + 1 + 4 * 8; /* first program */
+    const size_t corrupted[] = {
+        0,              /* magic */
+        8,              /* version */
+        header,         /* programs count */
+        counts,         /* spans count */
+        counts + 4,     /* entries count */
+        counts + 7,
+    };
+    for (size_t i = 0; i < ARRAY_SIZE(corrupted); i++)
+    {
+        const size_t at = corrupted[i];
+        const uint8_t saved = data[at];
+        data[at] ^= 0x80;
+        assert(!Parses(obj, data, size, PACKET, SIZE, MTIME));
+        data[at] = saved;
+    }
+
+    /* positions beyond the file */
+    assert(!Parses(obj, data, size, PACKET, VLC_TICK_FROM_SEC(20) / 10, MTIME));
+
+    /* unsorted entries: swap the times of the first two, after two spans */
+    const size_t entry0 = counts + 8 + 2 * 16;
+    uint8_t first[8];
+    memcpy(first, &data[entry0], 8);
+    memcpy(&data[entry0], &data[entry0 + 17], 8);
+    memcpy(&data[entry0 + 17], first, 8);
+    assert(!Parses(obj, data, size, PACKET, SIZE, MTIME));
+
+    free(data);
+    ts_index_Close(index);
+
+    /* past the entries limit, played times are no longer found */
+    index = ts_index_New(obj, PACKET, SIZE, MTIME);
+    assert(index != NULL);
+    const vlc_tick_t full = MAX_ENTRIES * TS_INDEX_INTERVAL;
+    for (vlc_tick_t t = 0; t < full + VLC_TICK_FROM_SEC(60); t += TS_INDEX_INTERVAL)
+        ts_index_AddPCR(index, 1, t, t / 1000);
+    head = 0, tail = SIZE;
+    assert(ts_index_Lookup(index, 1, full - VLC_TICK_FROM_SEC(1), &pos, &head, &tail));
+    assert(pos == (full - VLC_TICK_FROM_SEC(1)) / 1000);
+    assert(!ts_index_Lookup(index, 1, full + VLC_TICK_FROM_SEC(30), &pos, &head, &tail));
+    assert(head == (full - TS_INDEX_INTERVAL) / 1000 && tail == SIZE);
+    ts_index_Close(index);
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,124 @@
+/*****************************************************************************
+ * ts_workers.c: MPEG-TS worker threads tests
+ *****************************************************************************
+ * Copyright (C) 2025 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_threads.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include "../../../modules/demux/mpeg/ts_workers.h"
+
+#include "../../libvlc/test.h"
+
+#include <vlc/vlc.h>
+
+#define THREADS  4
+#define PROGRAMS 24
+#define BATCHES  200
+
+/* one job per program, pushed again once done, as the demuxer does */
+struct program
+{
+    ts_worker_job_t job;
+    unsigned i_batch;
+    unsigned i_run;
+    bool b_block;
+};
+
+static vlc_sem_t entered, resume;
+
+static void Run(ts_worker_job_t *job)
+{
+    struct program *p = container_of(job, struct program, job);
+
+    if (p->b_block)
+    {
+        vlc_sem_post(&entered);
+        vlc_sem_wait(&resume);
+    }
+
+    /* batches of a program never overlap, and run in push order */
+    assert(p->i_run == p->i_batch);
+    p->i_run++;
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    vlc_sem_init(&entered, 0);
+    vlc_sem_init(&resume, 0);
+
+    ts_workers_t *workers = ts_workers_New(obj, THREADS);
+    assert(workers != NULL);
+
+    struct program programs[PROGRAMS] = { 0 };
+    for (size_t i = 0; i < PROGRAMS; i++)
+        programs[i].job.pf_run = Run;
+
+    for (unsigned b = 0; b < BATCHES; b++)
+    {
+        for (size_t i = 0; i < PROGRAMS; i++)
+        {
+            struct program *p = &programs[i];
+            if (b > 0)
+                ts_workers_Wait(workers, &p->job);
+            p->i_batch = b;
+            ts_workers_Push(workers, &p->job);
+        }
+    }
+    for (size_t i = 0; i < PROGRAMS; i++)
+    {
+        ts_workers_Wait(workers, &programs[i].job);
+        assert(programs[i].i_run == BATCHES);
+    }
+
+    /* a running job is not done until it returns */
+    struct program *p = &programs[0];
+    p->b_block = true;
+    p->i_batch = p->i_run;
+    ts_workers_Push(workers, &p->job);
+    vlc_sem_wait(&entered);
+    assert(!ts_workers_IsDone(&p->job));
+
+    /* the other threads keep running the other programs */
+    struct program *other = &programs[1];
+    other->i_batch = other->i_run;
+    ts_workers_Push(workers, &other->job);
+    ts_workers_Wait(workers, &other->job);
+    assert(other->i_run == BATCHES + 1);
+
+    vlc_sem_post(&resume);
+    ts_workers_Wait(workers, &p->job);
+    assert(p->i_run == BATCHES + 1);
+
+    ts_workers_Delete(workers);
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,170 @@
+/*****************************************************************************
+ * whisper_ring.c: Whisper shared audio ring tests
+ *****************************************************************************
+ * Copyright (C) 2025 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdatomic.h>
+
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_threads.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../../modules/misc/whisper/whisper_shared_vlc.h"
+
+#include <vlc/vlc.h>
+
+#define READERS 3
+#define BLOCK 480 /* 30ms */
+#define TOTAL (BLOCK * 4096)
+
+/* Each sample holds its ring position, so that readers can tell torn or
+ * misplaced data. Positions below 2^24 are exact in a float. */
+static float Sample(uint64_t pos)
+{
+    return (float)(pos & 0xffffff);
+}
+
+struct reader
+{
+    whisper_ring_reader_t *reader;
+    vlc_thread_t thread;
+    bool slow;
+    uint64_t checked;
+};
+
+static atomic_bool writer_done;
+
+static void *ReaderThread(void *data)
+{
+    struct reader *r = data;
+    float buf[BLOCK * 4];
+
+    for (;;)
+    {
+        bool done = atomic_load(&writer_done);
+        size_t count;
+        uint64_t pos;
+
+        whisper_ring_Wait(r->reader, 1, vlc_tick_now() + VLC_TICK_FROM_MS(10));
+        while ((count = whisper_ring_Read(r->reader, buf, ARRAY_SIZE(buf),
+                                          &pos)) > 0)
+        {
+            for (size_t i = 0; i < count; i++)
+                assert(buf[i] == Sample(pos + i));
+            r->checked += count;
+
+            /* Timestamps are interpolated within each written block */
+            vlc_tick_t ts = whisper_ring_GetTimestamp(r->reader, pos);
+            if (ts != VLC_TICK_INVALID)
+                assert(ts == VLC_TICK_0 + vlc_tick_from_samples(pos,
+                                                    WHISPER_SAMPLE_RATE));
+            if (r->slow)
+                vlc_tick_wait(vlc_tick_now() + VLC_TICK_FROM_MS(1));
+        }
+        if (done && whisper_ring_Available(r->reader) == 0)
+            break;
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    test_setup();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    whisper_ring_t *ring = whisper_ring_Acquire(obj, "test");
+    assert(ring != NULL);
+    assert(whisper_ring_Acquire(obj, "test") == ring);
+    whisper_ring_Release(ring);
+
+    assert(whisper_ring_AttachWriter(ring) == VLC_SUCCESS);
+    assert(whisper_ring_AttachWriter(ring) == VLC_EGENERIC);
+
+    struct reader readers[READERS];
+    atomic_init(&writer_done, false);
+    for (size_t i = 0; i < READERS; i++)
+    {
+        readers[i].reader = whisper_ring_NewReader(ring);
+        assert(readers[i].reader != NULL);
+        readers[i].slow = i == 0; /* gets lapped */
+        readers[i].checked = 0;
+        int ret = vlc_clone(&readers[i].thread, ReaderThread, &readers[i]);
+        assert(ret == 0);
+    }
+
+    float buf[BLOCK];
+    for (uint64_t pos = 0; pos < TOTAL; pos += BLOCK)
+    {
+        for (size_t i = 0; i < BLOCK; i++)
+            buf[i] = Sample(pos + i);
+        whisper_ring_Write(ring, buf, BLOCK,
+                           VLC_TICK_0 + vlc_tick_from_samples(pos,
+                                                    WHISPER_SAMPLE_RATE),
+                           vlc_tick_from_samples(BLOCK, WHISPER_SAMPLE_RATE));
+        if (pos % (BLOCK * 64) == 0)
+            vlc_tick_wait(vlc_tick_now() + VLC_TICK_FROM_MS(1));
+    }
+    atomic_store(&writer_done, true);
+
+    for (size_t i = 0; i < READERS; i++)
+    {
+        vlc_join(readers[i].thread, NULL);
+
+        whisper_ring_stats_t stats;
+        whisper_ring_GetStats(readers[i].reader, &stats);
+        assert(stats.written == TOTAL);
+        assert(stats.read == readers[i].checked);
+        assert(stats.read + stats.dropped == TOTAL);
+        assert(stats.dropped == 0 || stats.overruns > 0);
+    }
+
+    /* Interrupting ends a wait that would never be satisfied */
+    whisper_ring_Interrupt(readers[1].reader);
+    assert(whisper_ring_Wait(readers[1].reader, 1, VLC_TICK_INVALID) == 0);
+
+    for (size_t i = 0; i < READERS; i++)
+        whisper_ring_DeleteReader(readers[i].reader);
+    whisper_ring_DetachWriter(ring);
+    whisper_ring_Release(ring);
+
+    /* The registry is empty again: acquiring creates new rings */
+    ring = whisper_ring_Acquire(obj, "test");
+    assert(ring != NULL);
+    whisper_ring_t *other = whisper_ring_Acquire(obj, "other");
+    assert(other != NULL && other != ring);
+    whisper_ring_Release(ring);
+    assert(whisper_ring_Acquire(obj, "other") == other);
+    whisper_ring_Release(other);
+    whisper_ring_Release(other);
+    ring = whisper_ring_Acquire(obj, "test");
+    assert(ring != NULL);
+    whisper_ring_Release(ring);
+
+    libvlc_release(vlc);
+    return 0;
+}
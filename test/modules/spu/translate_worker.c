@@ -0,0 +1,139 @@
+/*****************************************************************************
+ * translate_worker.c: caption translation worker tests
+ *****************************************************************************
+ * Copyright (C) 2025 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_threads.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../../modules/spu/translate_worker.h"
+
+#include <vlc/vlc.h>
+
+#define QUEUE   4
+#define TIMEOUT VLC_TICK_FROM_MS(100)
+
+struct job
+{
+    bool block; /* holds the worker thread in the callback */
+    bool done;
+    char *result;
+};
+
+static vlc_mutex_t lock = VLC_STATIC_MUTEX;
+static vlc_cond_t cond = VLC_STATIC_COND;
+static vlc_sem_t entered, resume;
+
+static void Done(void *opaque, char *result)
+{
+    struct job *job = opaque;
+
+    if (job->block)
+    {
+        vlc_sem_post(&entered);
+        vlc_sem_wait(&resume);
+    }
+
+    vlc_mutex_lock(&lock);
+    job->result = result;
+    job->done = true;
+    vlc_cond_broadcast(&cond);
+    vlc_mutex_unlock(&lock);
+}
+
+static void WaitDone(struct job *jobs, size_t count)
+{
+    vlc_mutex_lock(&lock);
+    for (size_t i = 0; i < count; i++)
+        while (!jobs[i].done)
+            vlc_cond_wait(&cond, &lock);
+    vlc_mutex_unlock(&lock);
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    vlc_sem_init(&entered, 0);
+    vlc_sem_init(&resume, 0);
+
+    translate_worker_cfg_t cfg = {
+        .backend = "auto",
+        .target_lang = "fr",
+        .queue_size = QUEUE,
+        .timeout = TIMEOUT,
+    };
+
+    /* the stub is never picked automatically */
+    assert(translate_worker_New(obj, &cfg) == NULL);
+
+    cfg.backend = "stub";
+    translate_worker_t *worker = translate_worker_New(obj, &cfg);
+    assert(worker != NULL);
+
+    /* the first request is translated, then holds the worker */
+    struct job first = { .block = true };
+    assert(translate_worker_Submit(worker, "hello", Done, &first) == VLC_SUCCESS);
+    vlc_sem_wait(&entered);
+
+    /* back-pressure: the queue fills up, then submission fails at once */
+    struct job queued[QUEUE] = { 0 };
+    for (size_t i = 0; i < QUEUE; i++)
+        assert(translate_worker_Submit(worker, "late", Done, &queued[i])
+               == VLC_SUCCESS);
+    struct job rejected = { 0 };
+    assert(translate_worker_Submit(worker, "rejected", Done, &rejected)
+           == VLC_EGENERIC);
+
+    /* the queued requests expire while the worker is held */
+    vlc_tick_wait(vlc_tick_now() + TIMEOUT + VLC_TICK_FROM_MS(20));
+    vlc_sem_post(&resume);
+
+    WaitDone(&first, 1);
+    assert(first.result != NULL && !strcmp(first.result, "[fr] hello"));
+    free(first.result);
+
+    WaitDone(queued, QUEUE);
+    for (size_t i = 0; i < QUEUE; i++)
+        assert(queued[i].result == NULL);
+    assert(!rejected.done);
+
+    /* the queue is available again */
+    struct job next = { 0 };
+    assert(translate_worker_Submit(worker, "again", Done, &next) == VLC_SUCCESS);
+    WaitDone(&next, 1);
+    assert(next.result != NULL && !strcmp(next.result, "[fr] again"));
+    free(next.result);
+
+    translate_worker_Delete(worker);
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*****************************************************************************
+ * whisper_model.c: shared Whisper models registry tests
+ *****************************************************************************
+ * Copyright (C) 2025 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../../modules/spu/livetranslate_whisper_model.h"
+
+#include <vlc/vlc.h>
+
+/* The registry does not depend on the model contents: fake the library */
+struct whisper_context { int dummy; };
+struct whisper_state { struct whisper_context *ctx; };
+
+static unsigned contexts;
+
+struct whisper_context_params whisper_context_default_params(void)
+{
+    struct whisper_context_params params = { 0 };
+    return params;
+}
+
+struct whisper_context *
+whisper_init_from_file_with_params_no_state(const char *path,
+                                            struct whisper_context_params params)
+{
+    VLC_UNUSED(params);
+    if (strcmp(path, "model.bin"))
+        return NULL;
+    struct whisper_context *ctx = malloc(sizeof(*ctx));
+    if (ctx)
+        contexts++;
+    return ctx;
+}
+
+void whisper_free(struct whisper_context *ctx)
+{
+    assert(contexts > 0);
+    contexts--;
+    free(ctx);
+}
+
+struct whisper_state *whisper_init_state(struct whisper_context *ctx)
+{
+    struct whisper_state *state = malloc(sizeof(*state));
+    if (state)
+        state->ctx = ctx;
+    return state;
+}
+
+void whisper_free_state(struct whisper_state *state)
+{
+    free(state);
+}
+
+int whisper_stream_Decode(whisper_stream_t *stream, struct whisper_context *ctx,
+                          struct whisper_state *state,
+                          struct whisper_full_params params)
+{
+    VLC_UNUSED(stream); VLC_UNUSED(params);
+    return state->ctx == ctx ? 0 : -1;
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    struct whisper_full_params params = { 0 };
+
+    /* loaded once, then shared */
+    whisper_model_t *model = whisper_model_Acquire(obj, "model.bin", 2);
+    assert(model != NULL);
+    assert(whisper_model_Acquire(obj, "model.bin", 2) == model);
+    assert(contexts == 1);
+    assert(whisper_model_Decode(model, NULL, params) == 0);
+
+    /* failures are not kept */
+    assert(whisper_model_Acquire(obj, "missing.bin", 1) == NULL);
+    assert(whisper_model_Acquire(obj, "missing.bin", 1) == NULL);
+
+    whisper_model_Release(model);
+    assert(contexts == 1);
+    whisper_model_Release(model);
+    assert(contexts == 0);
+
+    /* the registry is empty again: acquiring loads the model again */
+    model = whisper_model_Acquire(obj, "model.bin", 1);
+    assert(model != NULL);
+    assert(contexts == 1);
+    assert(whisper_model_Decode(model, NULL, params) == 0);
+    whisper_model_Release(model);
+    assert(contexts == 0);
+
+    libvlc_release(vlc);
+    return 0;
+}